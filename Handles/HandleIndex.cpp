@@ -0,0 +1,123 @@
+#include "HandleIndex.h"
+
+#include <algorithm>
+
+
+HandleIndex::HandleIndex():
+	fGeneration(0)
+{}
+
+
+void HandleIndex::Clear()
+{
+	fHandles.clear();
+	fFiles.clear();
+	fDevices.clear();
+}
+
+
+void HandleIndex::AddToFile(const Handle &handle)
+{
+	fFiles[FileId(handle.device, handle.node)].push_back(HandleId(handle.team, handle.fd));
+	fDevices[handle.device].insert(HandleId(handle.team, handle.fd));
+}
+
+void HandleIndex::RemoveFromFile(const Handle &handle)
+{
+	auto fileIt = fFiles.find(FileId(handle.device, handle.node));
+	if (fileIt != fFiles.end()) {
+		std::vector<HandleId> &ids = fileIt->second;
+		auto it = std::find(ids.begin(), ids.end(), HandleId(handle.team, handle.fd));
+		if (it != ids.end()) {
+			*it = ids.back();
+			ids.pop_back();
+		}
+		if (ids.empty())
+			fFiles.erase(fileIt);
+	}
+	auto deviceIt = fDevices.find(handle.device);
+	if (deviceIt != fDevices.end()) {
+		deviceIt->second.erase(HandleId(handle.team, handle.fd));
+		if (deviceIt->second.empty())
+			fDevices.erase(deviceIt);
+	}
+}
+
+
+void HandleIndex::BeginUpdate()
+{
+	fGeneration++;
+}
+
+void HandleIndex::Set(const Handle &handle)
+{
+	HandleId id(handle.team, handle.fd);
+	auto it = fHandles.find(id);
+	if (it == fHandles.end()) {
+		fHandles[id] = {handle, fGeneration};
+		AddToFile(handle);
+		return;
+	}
+	Entry &entry = it->second;
+	entry.generation = fGeneration;
+	if (entry.handle.device != handle.device || entry.handle.node != handle.node) {
+		// Descriptor number was reused for other file.
+		RemoveFromFile(entry.handle);
+		AddToFile(handle);
+	}
+	entry.handle = handle;
+}
+
+void HandleIndex::EndUpdate()
+{
+	for (auto it = fHandles.begin(); it != fHandles.end();) {
+		if (it->second.generation != fGeneration) {
+			RemoveFromFile(it->second.handle);
+			it = fHandles.erase(it);
+		} else
+			it++;
+	}
+}
+
+
+uint32_t HandleIndex::CountDeviceHandles(int64_t device) const
+{
+	auto it = fDevices.find(device);
+	if (it == fDevices.end())
+		return 0;
+	return it->second.size();
+}
+
+
+void HandleIndex::Find(int64_t device, int64_t node, std::vector<Handle> &handles) const
+{
+	handles.clear();
+	if (node == kAnyNode) {
+		auto deviceIt = fDevices.find(device);
+		if (deviceIt == fDevices.end())
+			return;
+		for (const HandleId &id: deviceIt->second)
+			handles.push_back(fHandles.find(id)->second.handle);
+		return;
+	}
+	auto fileIt = fFiles.find(FileId(device, node));
+	if (fileIt == fFiles.end())
+		return;
+	std::vector<HandleId> ids = fileIt->second;
+	std::sort(ids.begin(), ids.end());
+	for (const HandleId &id: ids)
+		handles.push_back(fHandles.find(id)->second.handle);
+}
+
+void HandleIndex::FindNode(int64_t node, std::vector<Handle> &handles) const
+{
+	handles.clear();
+	std::vector<Handle> deviceHandles;
+	for (auto &it: fDevices) {
+		Find(it.first, node, deviceHandles);
+		handles.insert(handles.end(), deviceHandles.begin(), deviceHandles.end());
+	}
+	std::sort(handles.begin(), handles.end(), [](const Handle &a, const Handle &b) {
+		return a.team != b.team ? a.team < b.team : a.fd < b.fd;
+	});
+}
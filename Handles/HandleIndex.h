@@ -0,0 +1,84 @@
+#ifndef _HANDLEINDEX_H_
+#define _HANDLEINDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+#include <unordered_map>
+
+
+// Open file descriptors of all teams indexed by file. Index is updated
+// incrementally: descriptors are reported between BeginUpdate() and
+// EndUpdate(), only changed ones touch the inverted index and descriptors
+// that were not reported are removed.
+class HandleIndex
+{
+public:
+	struct Handle {
+		int32_t team;
+		int32_t fd;
+		int64_t device;
+		int64_t node;
+		int32_t openMode;
+	};
+
+	enum {
+		kAnyNode = -1,
+	};
+
+private:
+	typedef std::pair<int32_t, int32_t> HandleId;
+	typedef std::pair<int64_t, int64_t> FileId;
+
+	struct FileIdHash {
+		size_t operator()(const FileId &id) const {return std::hash<int64_t>()(id.second)*31 + id.first;}
+	};
+
+	struct Entry {
+		Handle handle;
+		uint32_t generation;
+	};
+
+	// Ordered by team, then by fd.
+	std::map<HandleId, Entry> fHandles;
+	std::unordered_map<FileId, std::vector<HandleId>, FileIdHash> fFiles;
+	// Handles of each device, kept ordered for Find() with kAnyNode.
+	std::unordered_map<int64_t, std::set<HandleId>> fDevices;
+	uint32_t fGeneration;
+
+	void AddToFile(const Handle &handle);
+	void RemoveFromFile(const Handle &handle);
+
+public:
+	HandleIndex();
+
+	void Clear();
+
+	void BeginUpdate();
+	void Set(const Handle &handle);
+	void EndUpdate();
+
+	size_t CountHandles() const {return fHandles.size();}
+	uint32_t CountDeviceHandles(int64_t device) const;
+	size_t CountDevices() const {return fDevices.size();}
+
+	// Handles of file, node can be kAnyNode to get all handles of device.
+	// Result is ordered by team and fd.
+	void Find(int64_t device, int64_t node, std::vector<Handle> &handles) const;
+	// Handles of node on any device.
+	void FindNode(int64_t node, std::vector<Handle> &handles) const;
+
+	template<typename Visitor>
+	void ForEach(Visitor visitor) const
+	{
+		for (auto &it: fHandles)
+			visitor(it.second.handle);
+	}
+};
+
+
+#endif	// _HANDLEINDEX_H_
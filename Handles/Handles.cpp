@@ -15,12 +15,23 @@
 
 #include <Entry.h>
 #include <Node.h>
+#include <NodeMonitor.h>
+#include <String.h>
+#include <TextControl.h>
 
-#include <set>
+#include <stdlib.h>
+#include <string.h>
+#include <list>
+#include <map>
+#include <unordered_map>
+
+#include "HandleIndex.h"
+#include "RowFields.h"
 
 enum {
 	invokeMsg = 1,
 	selectMsg,
+	filterMsg,
 
 	updateMsg
 };
@@ -36,116 +47,356 @@ enum {
 	fsNameCol
 };
 
+enum {
+	kMaxCachedPaths = 65536,
+	// Paths can change by rename, so cached ones are resolved again after
+	// this time.
+	kPathTimeout = 5000000,
+};
+
+
+// Volume info of devices, entries are dropped on mount and unmount.
+class VolumeCache
+{
+private:
+	std::unordered_map<dev_t, fs_info> fVolumes;
+
+public:
+	const fs_info &Get(dev_t device)
+	{
+		auto it = fVolumes.find(device);
+		if (it != fVolumes.end())
+			return it->second;
+		fs_info &info = fVolumes[device];
+		if (fs_stat_dev(device, &info) < B_OK)
+			memset(&info, 0, sizeof(info));
+		return info;
+	}
+
+	void Invalidate(dev_t device) {fVolumes.erase(device);}
+	void Clear() {fVolumes.clear();}
+};
+
 
-BRow *FindIntRow(BColumnListView *view, BRow *parent, int32 val)
+// (device, node) -> path cache with LRU eviction. Failed lookups are cached
+// too because path can be resolved only for directories.
+class PathCache
 {
+private:
+	struct Key {
+		dev_t device;
+		ino_t node;
+
+		bool operator==(const Key &other) const {return device == other.device && node == other.node;}
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key &key) const {return std::hash<ino_t>()(key.node)*31 + key.device;}
+	};
+
+	struct Entry {
+		Key key;
+		BString path;
+		bigtime_t time;
+	};
+
+	std::list<Entry> fEntries;
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> fIndex;
+
+public:
+	const BString &Get(dev_t device, ino_t node)
+	{
+		Key key = {device, node};
+		bigtime_t now = system_time();
+		auto it = fIndex.find(key);
+		if (it != fIndex.end()) {
+			fEntries.splice(fEntries.begin(), fEntries, it->second);
+			if (now - it->second->time < kPathTimeout)
+				return it->second->path;
+		} else {
+			if (fIndex.size() >= kMaxCachedPaths) {
+				fIndex.erase(fEntries.back().key);
+				fEntries.pop_back();
+			}
+			fEntries.push_front({key, "", 0});
+			it = fIndex.emplace(key, fEntries.begin()).first;
+		}
+		Entry &entry = *it->second;
+		char path[B_PATH_NAME_LENGTH];
+		if (_kern_entry_ref_to_path(device, node, NULL, path, sizeof(path)) == B_OK)
+			entry.path = path;
+		else
+			entry.path = "";
+		entry.time = now;
+		return entry.path;
+	}
+
+	void InvalidateDevice(dev_t device)
+	{
+		for (auto it = fEntries.begin(); it != fEntries.end();) {
+			if (it->key.device == device) {
+				fIndex.erase(it->key);
+				it = fEntries.erase(it);
+			} else
+				it++;
+		}
+	}
+};
+
+
+struct TeamRows {
 	BRow *row;
-	BString name;
-	for (int32 i = 0; i < view->CountRows(parent); i++) {
-		row = view->RowAt(i, parent);
-		if (((BIntegerField*)row->GetField(idCol))->Value() == val)
-			return row;
+	std::unordered_map<int32, BRow*> fds;
+};
+
+struct HandlesState {
+	VolumeCache volumes;
+	PathCache paths;
+	HandleIndex index;
+	std::map<team_id, BString> teamNames;
+	std::unordered_map<team_id, TeamRows> teams;
+	BString filter;
+	// Volume info is cached only if mounts are watched.
+	bool watchingMounts = false;
+};
+
+
+static const char *ModeString(int32 openMode)
+{
+	switch (openMode & O_RWMASK) {
+	case O_RDONLY: return "R";
+	case O_WRONLY: return "W";
+	case O_RDWR: return "RW";
 	}
-	return NULL;
+	return "";
 }
 
-void ListHandles(BColumnListView *view, BRow *teamRow, team_id team) {
-	BString buf;
-	char path[B_OS_NAME_LENGTH];
-	fd_info info;
-	fs_info fsInfo;
-	uint32 cookie;
-	BRow *row;
-	std::set<int32> prevFds;
-	cookie = 0;
-	int i;
+// Reads descriptors of all teams into index.
+static void CollectHandles(HandlesState &state)
+{
+	team_info teamInfo;
+	int32 teamCookie = 0;
+	state.teamNames.clear();
+	state.index.BeginUpdate();
+	while (get_next_team_info(&teamCookie, &teamInfo) == B_OK) {
+		state.teamNames[teamInfo.team] = teamInfo.args;
+		fd_info info;
+		uint32 cookie = 0;
+		while (_kern_get_next_fd_info(teamInfo.team, &cookie, &info, sizeof(fd_info)) == B_OK)
+			state.index.Set({teamInfo.team, info.number, info.device, info.node, info.open_mode});
+	}
+	state.index.EndUpdate();
+}
 
-	for (int32 i = 0; i < view->CountRows(teamRow); i++) {
-		row = view->RowAt(i, teamRow);
-		prevFds.insert(((BIntegerField*)row->GetField(idCol))->Value());
+// "device" or "device:node".
+static bool ParseFileFilter(const char *filter, int64 &device, int64 &node)
+{
+	char *end;
+	device = strtoll(filter, &end, 10);
+	if (end == filter)
+		return false;
+	node = HandleIndex::kAnyNode;
+	if (*end == ':') {
+		const char *nodeStr = end + 1;
+		node = strtoll(nodeStr, &end, 10);
+		if (end == nodeStr)
+			return false;
 	}
+	return *end == '\0';
+}
 
-	while (_kern_get_next_fd_info(team, &cookie, &info, sizeof(fd_info)) == B_OK) {
-		prevFds.erase(info.number);
+// Handles that match filter grouped by team. Device and node filters are
+// answered by index, other text is matched against team name, path and
+// volume.
+static void FilterHandles(HandlesState &state, std::map<team_id, std::vector<HandleIndex::Handle>> &teams)
+{
+	teams.clear();
+	int64 device, node;
+	std::vector<HandleIndex::Handle> handles;
+	if (state.filter.IsEmpty()) {
+		for (auto &it: state.teamNames)
+			teams[it.first];
+		state.index.ForEach([&teams](const HandleIndex::Handle &handle) {
+			teams[handle.team].push_back(handle);
+		});
+	} else if (ParseFileFilter(state.filter, device, node)) {
+		state.index.Find(device, node, handles);
+		for (const HandleIndex::Handle &handle: handles)
+			teams[handle.team].push_back(handle);
+	} else {
+		state.index.ForEach([&teams, &state](const HandleIndex::Handle &handle) {
+			const fs_info &fsInfo = state.volumes.Get(handle.device);
+			if (
+				state.teamNames[handle.team].IFindFirst(state.filter) >= 0 ||
+				state.paths.Get(handle.device, handle.node).IFindFirst(state.filter) >= 0 ||
+				BString(fsInfo.volume_name).IFindFirst(state.filter) >= 0 ||
+				BString(fsInfo.device_name).IFindFirst(state.filter) >= 0
+			)
+				teams[handle.team].push_back(handle);
+		});
+	}
+}
 
-		row = FindIntRow(view, teamRow, info.number);
 
-		if (row == NULL) {
+void ListHandles(BColumnListView *view, HandlesState &state, TeamRows &teamRows, const std::vector<HandleIndex::Handle> &handles) {
+	BRow *row;
+	std::unordered_map<int32, BRow*> prevFds;
+	prevFds.swap(teamRows.fds);
+
+	for (const HandleIndex::Handle &info: handles) {
+		bool changed = false;
+		auto it = prevFds.find(info.fd);
+		if (it != prevFds.end()) {
+			row = it->second;
+			prevFds.erase(it);
+		} else {
 			row = new BRow();
-			view->AddRow(row, teamRow);
+			SetIntField(row, idCol, info.fd);
+			view->AddRow(row, teamRows.row);
 		}
+		teamRows.fds[info.fd] = row;
 
-		if (_kern_entry_ref_to_path(info.device, info.node, NULL, path, B_OS_NAME_LENGTH) == B_OK)
-			row->SetField(new BStringField(path), nameCol);
-		else
-			row->SetField(new BStringField(""), nameCol);
-
-		row->SetField(new BIntegerField(info.number), idCol);
+		changed |= SetStringField(row, nameCol, state.paths.Get(info.device, info.node));
+		changed |= SetStringField(row, modeCol, ModeString(info.openMode));
+		changed |= SetIntField(row, devCol, info.device);
+		changed |= SetIntField(row, nodeCol, info.node);
 
-		if ((info.open_mode & O_RWMASK) == O_RDONLY) {buf = "R";}
-		if ((info.open_mode & O_RWMASK) == O_WRONLY) {buf = "W";}
-		if ((info.open_mode & O_RWMASK) == O_RDWR  ) {buf = "RW";}
-		row->SetField(new BStringField(buf), modeCol);
-		row->SetField(new BIntegerField(info.device), devCol);
-		row->SetField(new BIntegerField(info.node), nodeCol);
+		const fs_info &fsInfo = state.volumes.Get(info.device);
+		changed |= SetStringField(row, devNameCol, fsInfo.device_name);
+		changed |= SetStringField(row, volNameCol, fsInfo.volume_name);
+		changed |= SetStringField(row, fsNameCol, fsInfo.fsh_name);
 
-		fs_stat_dev(info.device, &fsInfo);
-		row->SetField(new BStringField(fsInfo.device_name), devNameCol);
-		row->SetField(new BStringField(fsInfo.volume_name), volNameCol);
-		row->SetField(new BStringField(fsInfo.fsh_name), fsNameCol);
+		if (changed)
+			view->UpdateRow(row);
 	}
 
-	for (std::set<int32>::iterator it = prevFds.begin(); it != prevFds.end(); ++it) {
-		row = FindIntRow(view, teamRow, *it);
-		view->RemoveRow(row);
-		delete row;
+	for (auto &it: prevFds) {
+		view->RemoveRow(it.second);
+		delete it.second;
 	}
 }
 
-void ListTeams(BColumnListView *view) {
-	team_info info;
-	int32 cookie;
+void ListTeams(BColumnListView *view, HandlesState &state) {
 	BRow *row;
-	std::set<int32> prevTeams;
+	std::unordered_map<team_id, TeamRows> prevTeams;
+	prevTeams.swap(state.teams);
+
+	CollectHandles(state);
+	std::map<team_id, std::vector<HandleIndex::Handle>> visibleTeams;
+	FilterHandles(state, visibleTeams);
+
+	for (auto &visible: visibleTeams) {
+		team_id team = visible.first;
+		auto it = prevTeams.find(team);
+		TeamRows &teamRows = state.teams[team];
+		if (it != prevTeams.end()) {
+			teamRows = std::move(it->second);
+			prevTeams.erase(it);
+		} else {
+			teamRows.row = new BRow();
+			SetIntField(teamRows.row, idCol, team);
+			view->AddRow(teamRows.row);
+			// Show matches without expanding each team.
+			if (!state.filter.IsEmpty())
+				view->ExpandOrCollapse(teamRows.row, true);
+		}
+		row = teamRows.row;
 
-	for (int32 i = 0; i < view->CountRows(); i++) {
-		row = view->RowAt(i);
-		prevTeams.insert(((BIntegerField*)row->GetField(idCol))->Value());
+		if (SetStringField(row, nameCol, state.teamNames[team]))
+			view->UpdateRow(row);
+		ListHandles(view, state, teamRows, visible.second);
 	}
 
-	cookie = 0;
-	while (get_next_team_info(&cookie, &info) == B_OK) {
-		prevTeams.erase(info.team);
+	for (auto &it: prevTeams) {
+		// Also deletes fd rows.
+		view->RemoveRow(it.second.row);
+		delete it.second.row;
+	}
+}
 
-		row = FindIntRow(view, NULL, info.team);
 
-		if (row == NULL) {
-			row = new BRow();
-			view->AddRow(row);
-		}
+//#pragma mark Query mode
 
-		row->SetField(new BStringField(info.args), nameCol);
-		row->SetField(new BIntegerField(info.team), idCol);
-		ListHandles(view, row, info.team);
+static void WriteJsonString(const char *str)
+{
+	putchar('"');
+	for (; *str != '\0'; str++) {
+		switch (*str) {
+		case '"': printf("\\\""); break;
+		case '\\': printf("\\\\"); break;
+		case '\n': printf("\\n"); break;
+		case '\t': printf("\\t"); break;
+		default:
+			if ((uint8)*str < 0x20)
+				printf("\\u%04x", *str);
+			else
+				putchar(*str);
+		}
 	}
+	putchar('"');
+}
 
-	for (std::set<int32>::iterator it = prevTeams.begin(); it != prevTeams.end(); ++it) {
-		row = FindIntRow(view, NULL, *it);
-		view->RemoveRow(row);
-		delete row;
+static int RunQuery(bool hasDevice, int64 device, bool hasNode, int64 node, bool json)
+{
+	HandlesState state;
+	CollectHandles(state);
+
+	std::vector<HandleIndex::Handle> handles;
+	if (hasDevice)
+		state.index.Find(device, hasNode ? node : (int64)HandleIndex::kAnyNode, handles);
+	else if (hasNode)
+		state.index.FindNode(node, handles);
+	else
+		state.index.ForEach([&handles](const HandleIndex::Handle &handle) {handles.push_back(handle);});
+
+	if (json)
+		printf("[");
+	else
+		printf("%6s %-24s %5s %-4s %6s %12s %-16s %s\n", "TEAM", "NAME", "FD", "MODE", "DEVICE", "NODE", "VOLUME", "PATH");
+	for (size_t i = 0; i < handles.size(); i++) {
+		const HandleIndex::Handle &handle = handles[i];
+		const char *teamName = state.teamNames[handle.team].String();
+		const fs_info &fsInfo = state.volumes.Get(handle.device);
+		const BString &path = state.paths.Get(handle.device, handle.node);
+		if (json) {
+			printf(i == 0 ? "\n" : ",\n");
+			printf("\t{\"team\": %" B_PRId32 ", \"name\": ", handle.team);
+			WriteJsonString(teamName);
+			printf(", \"fd\": %" B_PRId32 ", \"mode\": \"%s\", \"device\": %" B_PRId64 ", \"node\": %" B_PRId64 ", \"volume\": ",
+				handle.fd, ModeString(handle.openMode), handle.device, handle.node);
+			WriteJsonString(fsInfo.volume_name);
+			printf(", \"path\": ");
+			WriteJsonString(path.String());
+			printf("}");
+		} else {
+			printf("%6" B_PRId32 " %-24.24s %5" B_PRId32 " %-4s %6" B_PRId64 " %12" B_PRId64 " %-16.16s %s\n",
+				handle.team, teamName, handle.fd, ModeString(handle.openMode), handle.device, handle.node,
+				fsInfo.volume_name, path.String());
+		}
 	}
+	if (json)
+		printf("\n]\n");
+	return 0;
+}
+
+static void Usage()
+{
+	fprintf(stderr, "usage: Handles [--device <dev>] [--node <node>] [--json]\n");
+	exit(1);
 }
 
+
 class HandlesWindow: public BWindow
 {
 private:
 	BColumnListView *view;
+	BTextControl *filterControl;
 	BMessageRunner listUpdater;
+	HandlesState state;
 public:
 	HandlesWindow(BRect frame): BWindow(frame, "Handles", B_DOCUMENT_WINDOW, B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS),
 		listUpdater(BMessenger(this), BMessage(updateMsg), 500000)
 	{
-		BRow *row1, *row2;
 		this->view = new BColumnListView("view", 0);
 		this->view->SetInvocationMessage(new BMessage(invokeMsg));
 		this->view->SetSelectionMessage(new BMessage(selectMsg));
@@ -158,9 +409,21 @@ public:
 		view->AddColumn(new BStringColumn("Volume", 96, 32, 512, B_TRUNCATE_MIDDLE, B_ALIGN_LEFT), volNameCol);
 		view->AddColumn(new BStringColumn("FS", 96, 32, 512, B_TRUNCATE_MIDDLE, B_ALIGN_LEFT), fsNameCol);
 
-		ListTeams(this->view);
+		filterControl = new BTextControl("filter", "Filter:", "", new BMessage(filterMsg));
+		filterControl->SetModificationMessage(new BMessage(filterMsg));
+		filterControl->SetToolTip("Path, volume or team name, \"device\" or \"device:node\"");
+
+		status_t res = watch_node(NULL, B_WATCH_MOUNT, this);
+		if (res < B_OK)
+			fprintf(stderr, "can't watch mounts: %s\n", strerror(res));
+		state.watchingMounts = res >= B_OK;
+		ListTeams(this->view, state);
 
 		BLayoutBuilder::Group<>(this, B_VERTICAL, 0)
+			.AddGroup(B_HORIZONTAL)
+				.Add(filterControl)
+				.SetInsets(B_USE_SMALL_SPACING)
+			.End()
 			.AddGroup(B_HORIZONTAL)
 				.Add(this->view)
 				.SetInsets(-1)
@@ -168,6 +431,11 @@ public:
 		.End();
 	}
 
+	~HandlesWindow()
+	{
+		stop_watching(this);
+	}
+
 	void MessageReceived(BMessage* msg)
 	{
 		switch (msg->what) {
@@ -175,8 +443,31 @@ public:
 		case selectMsg:
 			break;
 		case updateMsg:
-			ListTeams(this->view);
+			if (!state.watchingMounts)
+				state.volumes.Clear();
+			ListTeams(this->view, state);
+			break;
+		case filterMsg:
+			if (state.filter == filterControl->Text())
+				break;
+			state.filter = filterControl->Text();
+			ListTeams(this->view, state);
+			break;
+		case B_NODE_MONITOR: {
+			int32 opcode;
+			dev_t device;
+			if (msg->FindInt32("opcode", &opcode) < B_OK)
+				break;
+			// Device IDs can be reused after unmount.
+			if (
+				(opcode == B_DEVICE_MOUNTED && msg->FindInt32("new device", &device) >= B_OK) ||
+				(opcode == B_DEVICE_UNMOUNTED && msg->FindInt32("device", &device) >= B_OK)
+			) {
+				state.volumes.Invalidate(device);
+				state.paths.InvalidateDevice(device);
+			}
 			break;
+		}
 		default:
 			BWindow::MessageReceived(msg);
 		}
@@ -201,8 +492,25 @@ public:
 };
 
 
-int main()
+int main(int argc, char **argv)
 {
+	bool hasDevice = false, hasNode = false, json = false;
+	int64 device = 0, node = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+			hasDevice = true;
+			device = strtoll(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--node") == 0 && i + 1 < argc) {
+			hasNode = true;
+			node = strtoll(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "--json") == 0)
+			json = true;
+		else
+			Usage();
+	}
+	if (argc > 1)
+		return RunQuery(hasDevice, device, hasNode, node, json);
+
 	HandlesApplication app;
 	app.Run();
 	return 0;
@@ -0,0 +1,206 @@
+// Checks HandleIndex against brute force search over real descriptors read
+// from /proc/*/fd on Linux, and incremental updates when descriptors of this
+// process are opened, reused and closed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "../HandleIndex.h"
+#include "../../SystemManager/Tests/Check.h"
+
+
+static bool IsNumber(const char *str)
+{
+	return *str != '\0' && strspn(str, "0123456789") == strlen(str);
+}
+
+static void ReadHandles(std::vector<HandleIndex::Handle> &handles)
+{
+	handles.clear();
+	DIR *procDir = opendir("/proc");
+	if (procDir == NULL)
+		return;
+	while (dirent *teamEntry = readdir(procDir)) {
+		if (!IsNumber(teamEntry->d_name))
+			continue;
+		char path[300];
+		snprintf(path, sizeof(path), "/proc/%s/fd", teamEntry->d_name);
+		DIR *fdDir = opendir(path);
+		if (fdDir == NULL)
+			continue;
+		int fdDirFd = dirfd(fdDir);
+		while (dirent *fdEntry = readdir(fdDir)) {
+			if (!IsNumber(fdEntry->d_name))
+				continue;
+			int fd = atoi(fdEntry->d_name);
+			// Descriptor of directory that is being read.
+			if (atoi(teamEntry->d_name) == getpid() && fd == fdDirFd)
+				continue;
+			struct stat st;
+			if (fstatat(fdDirFd, fdEntry->d_name, &st, 0) < 0)
+				continue;
+			HandleIndex::Handle handle;
+			handle.team = atoi(teamEntry->d_name);
+			handle.fd = fd;
+			handle.device = st.st_dev;
+			handle.node = st.st_ino;
+			handle.openMode = 0;
+			handles.push_back(handle);
+		}
+		closedir(fdDir);
+	}
+	closedir(procDir);
+}
+
+static void Update(HandleIndex &index, const std::vector<HandleIndex::Handle> &handles)
+{
+	index.BeginUpdate();
+	for (const HandleIndex::Handle &handle: handles)
+		index.Set(handle);
+	index.EndUpdate();
+}
+
+static bool Less(const HandleIndex::Handle &a, const HandleIndex::Handle &b)
+{
+	return a.team != b.team ? a.team < b.team : a.fd < b.fd;
+}
+
+static bool Same(const std::vector<HandleIndex::Handle> &a, const std::vector<HandleIndex::Handle> &b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].team != b[i].team || a[i].fd != b[i].fd || a[i].device != b[i].device || a[i].node != b[i].node)
+			return false;
+	}
+	return true;
+}
+
+static void BruteFind(const std::vector<HandleIndex::Handle> &handles, int64_t device, int64_t node, std::vector<HandleIndex::Handle> &result)
+{
+	result.clear();
+	for (const HandleIndex::Handle &handle: handles) {
+		if ((device < 0 || handle.device == device) && (node == HandleIndex::kAnyNode || handle.node == node))
+			result.push_back(handle);
+	}
+	std::sort(result.begin(), result.end(), Less);
+}
+
+// Compares every file and device of index with brute force search.
+static void CheckIndex(const HandleIndex &index, const std::vector<HandleIndex::Handle> &handles)
+{
+	CHECK(index.CountHandles() == handles.size());
+	std::set<std::pair<int64_t, int64_t>> files;
+	std::set<int64_t> devices;
+	for (const HandleIndex::Handle &handle: handles) {
+		files.insert({handle.device, handle.node});
+		devices.insert(handle.device);
+	}
+	std::vector<HandleIndex::Handle> expected, actual;
+	bool filesOk = true;
+	for (const auto &file: files) {
+		BruteFind(handles, file.first, file.second, expected);
+		index.Find(file.first, file.second, actual);
+		filesOk &= Same(expected, actual);
+	}
+	CHECK(filesOk);
+	bool devicesOk = true;
+	for (int64_t device: devices) {
+		BruteFind(handles, device, HandleIndex::kAnyNode, expected);
+		index.Find(device, HandleIndex::kAnyNode, actual);
+		devicesOk &= Same(expected, actual) && index.CountDeviceHandles(device) == expected.size();
+	}
+	CHECK(devicesOk);
+	CHECK(index.CountDevices() == devices.size());
+	if (!files.empty()) {
+		int64_t node = files.begin()->second;
+		BruteFind(handles, -1, node, expected);
+		index.FindNode(node, actual);
+		CHECK(Same(expected, actual));
+	}
+}
+
+static size_t CountOwn(const HandleIndex &index, int64_t device, int64_t node)
+{
+	std::vector<HandleIndex::Handle> found;
+	index.Find(device, node, found);
+	return std::count_if(found.begin(), found.end(), [](const HandleIndex::Handle &handle) {
+		return handle.team == getpid();
+	});
+}
+
+
+int main()
+{
+	std::vector<HandleIndex::Handle> handles;
+	HandleIndex index;
+
+	ReadHandles(handles);
+	CHECK(!handles.empty());
+	Update(index, handles);
+	CheckIndex(index, handles);
+
+	char path[] = "/tmp/handle-index-test-XXXXXX";
+	int fd1 = mkstemp(path);
+	int fd2 = open(path, O_RDONLY);
+	CHECK(fd1 >= 0 && fd2 >= 0);
+	struct stat st;
+	fstat(fd1, &st);
+
+	ReadHandles(handles);
+	Update(index, handles);
+	CheckIndex(index, handles);
+	CHECK(CountOwn(index, st.st_dev, st.st_ino) == 2);
+
+	// Descriptor number reused for other file.
+	int nullFd = open("/dev/null", O_RDONLY);
+	dup2(nullFd, fd1);
+	close(nullFd);
+	ReadHandles(handles);
+	Update(index, handles);
+	CheckIndex(index, handles);
+	CHECK(CountOwn(index, st.st_dev, st.st_ino) == 1);
+
+	close(fd1);
+	close(fd2);
+	unlink(path);
+	ReadHandles(handles);
+	Update(index, handles);
+	CheckIndex(index, handles);
+	CHECK(CountOwn(index, st.st_dev, st.st_ino) == 0);
+
+	// Team that is not reported anymore is removed.
+	handles.erase(std::remove_if(handles.begin(), handles.end(), [](const HandleIndex::Handle &handle) {
+		return handle.team == getpid();
+	}), handles.end());
+	Update(index, handles);
+	CheckIndex(index, handles);
+
+	index.Clear();
+	CHECK(index.CountHandles() == 0);
+	CHECK(index.CountDevices() == 0);
+
+	// Unchanged update is the common case.
+	ReadHandles(handles);
+	Update(index, handles);
+	const int kUpdates = 100;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < kUpdates; i++)
+		Update(index, handles);
+	auto end = std::chrono::steady_clock::now();
+	printf("%zu handles, unchanged update: %.3f ms\n", handles.size(),
+		std::chrono::duration<double, std::milli>(end - start).count()/kUpdates);
+
+	return ReportChecks("HandleIndexTest");
+}
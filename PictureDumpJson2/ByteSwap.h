@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string.h>
+
+#include <SupportDefs.h>
+#include <ByteOrder.h>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+// Bulk in-place byte swapping of arrays of 16/32/64 bit values. Used for
+// decoding foreign-endian data where whole arrays (points, shape ops,
+// clipping rects) are read at once and converted in a single pass.
+
+#if defined(__SSSE3__)
+
+static inline void SwapArrayVector(uint8 *&data, size_t &size, __m128i mask)
+{
+	for (; size >= 16; data += 16, size -= 16) {
+		__m128i val = _mm_loadu_si128((const __m128i*)data);
+		_mm_storeu_si128((__m128i*)data, _mm_shuffle_epi8(val, mask));
+	}
+}
+
+#elif defined(__SSE2__)
+
+static inline __m128i SwapBytes16Vector(__m128i val)
+{
+	return _mm_or_si128(_mm_slli_epi16(val, 8), _mm_srli_epi16(val, 8));
+}
+
+static inline __m128i SwapWords32Vector(__m128i val)
+{
+	val = _mm_shufflelo_epi16(val, _MM_SHUFFLE(2, 3, 0, 1));
+	return _mm_shufflehi_epi16(val, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static inline __m128i SwapWords64Vector(__m128i val)
+{
+	val = _mm_shufflelo_epi16(val, _MM_SHUFFLE(0, 1, 2, 3));
+	return _mm_shufflehi_epi16(val, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+#endif
+
+
+static inline void SwapArray16(void *data, size_t count)
+{
+	uint8 *ptr = (uint8*)data;
+	size_t size = count*sizeof(uint16);
+#if defined(__SSSE3__)
+	SwapArrayVector(ptr, size, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+#elif defined(__SSE2__)
+	for (; size >= 16; ptr += 16, size -= 16) {
+		__m128i val = _mm_loadu_si128((const __m128i*)ptr);
+		_mm_storeu_si128((__m128i*)ptr, SwapBytes16Vector(val));
+	}
+#endif
+	for (; size >= sizeof(uint16); ptr += sizeof(uint16), size -= sizeof(uint16)) {
+		uint16 val;
+		memcpy(&val, ptr, sizeof(val));
+		val = __swap_int16(val);
+		memcpy(ptr, &val, sizeof(val));
+	}
+}
+
+static inline void SwapArray32(void *data, size_t count)
+{
+	uint8 *ptr = (uint8*)data;
+	size_t size = count*sizeof(uint32);
+#if defined(__SSSE3__)
+	SwapArrayVector(ptr, size, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+#elif defined(__SSE2__)
+	for (; size >= 16; ptr += 16, size -= 16) {
+		__m128i val = _mm_loadu_si128((const __m128i*)ptr);
+		_mm_storeu_si128((__m128i*)ptr, SwapWords32Vector(SwapBytes16Vector(val)));
+	}
+#endif
+	for (; size >= sizeof(uint32); ptr += sizeof(uint32), size -= sizeof(uint32)) {
+		uint32 val;
+		memcpy(&val, ptr, sizeof(val));
+		val = __swap_int32(val);
+		memcpy(ptr, &val, sizeof(val));
+	}
+}
+
+static inline void SwapArray64(void *data, size_t count)
+{
+	uint8 *ptr = (uint8*)data;
+	size_t size = count*sizeof(uint64);
+#if defined(__SSSE3__)
+	SwapArrayVector(ptr, size, _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+#elif defined(__SSE2__)
+	for (; size >= 16; ptr += 16, size -= 16) {
+		__m128i val = _mm_loadu_si128((const __m128i*)ptr);
+		_mm_storeu_si128((__m128i*)ptr, SwapWords64Vector(SwapBytes16Vector(val)));
+	}
+#endif
+	for (; size >= sizeof(uint64); ptr += sizeof(uint64), size -= sizeof(uint64)) {
+		uint64 val;
+		memcpy(&val, ptr, sizeof(val));
+		val = __swap_int64(val);
+		memcpy(ptr, &val, sizeof(val));
+	}
+}
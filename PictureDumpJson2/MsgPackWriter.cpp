@@ -0,0 +1,304 @@
+#include "MsgPackWriter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ByteOrder.h>
+#include <DataIO.h>
+
+#include "ByteSwap.h"
+
+
+MsgPackWriter::MsgPackWriter(BPositionIO &wr):
+	fWr(wr),
+	fLength(0),
+	fBufferPos(wr.Position())
+{
+}
+
+MsgPackWriter::~MsgPackWriter()
+{
+	Flush();
+}
+
+
+void MsgPackWriter::RaiseError()
+{
+	fprintf(stderr, "[!] error\n");
+	abort();
+}
+
+void MsgPackWriter::Check(bool cond)
+{
+	if (!cond) {
+		RaiseError();
+	}
+}
+
+void MsgPackWriter::CheckStatus(status_t status)
+{
+	if (status < B_OK) {
+		RaiseError();
+	}
+}
+
+void MsgPackWriter::Flush()
+{
+	if (fLength == 0) {
+		return;
+	}
+	CheckStatus(fWr.WriteExactly(fBuffer, fLength));
+	fBufferPos += fLength;
+	fLength = 0;
+}
+
+void MsgPackWriter::Write(const void *data, size_t size)
+{
+	if (fLength + size > kBufferSize) {
+		Flush();
+		if (size > kBufferSize) {
+			CheckStatus(fWr.WriteExactly(data, size));
+			fBufferPos += size;
+			return;
+		}
+	}
+	memcpy(&fBuffer[fLength], data, size);
+	fLength += size;
+}
+
+void MsgPackWriter::WriteBig16(uint16 val)
+{
+	val = B_HOST_TO_BENDIAN_INT16(val);
+	Write(&val, sizeof(val));
+}
+
+void MsgPackWriter::WriteBig32(uint32 val)
+{
+	val = B_HOST_TO_BENDIAN_INT32(val);
+	Write(&val, sizeof(val));
+}
+
+void MsgPackWriter::WriteBig64(uint64 val)
+{
+	val = B_HOST_TO_BENDIAN_INT64(val);
+	Write(&val, sizeof(val));
+}
+
+void MsgPackWriter::Patch32(off_t pos, uint32 val)
+{
+	val = B_HOST_TO_BENDIAN_INT32(val);
+	if (pos >= fBufferPos) {
+		memcpy(&fBuffer[pos - fBufferPos], &val, sizeof(val));
+		return;
+	}
+	// Already flushed, patch the stream directly.
+	Flush();
+	CheckStatus(fWr.WriteAtExactly(pos, &val, sizeof(val)));
+}
+
+
+void MsgPackWriter::BeginItem()
+{
+	if (fContainers.empty()) {
+		return;
+	}
+	Container &container = fContainers.back();
+	container.count++;
+	Check(container.expected == kUnknownCount || container.count <= container.expected);
+}
+
+void MsgPackWriter::WriteContainerHeader(uint8 fix, uint8 header16, uint8 header32, int32 count, int32 itemsPerEntry)
+{
+	BeginItem();
+	Container container = {
+		.pos = Position(),
+		.expected = count == kUnknownCount ? kUnknownCount : itemsPerEntry*count,
+		.count = 0,
+		.itemsPerEntry = itemsPerEntry
+	};
+	if (count == kUnknownCount) {
+		WriteByte(header32);
+		WriteBig32(0);
+	} else if (count < 16) {
+		WriteByte(fix | count);
+	} else if (count <= UINT16_MAX) {
+		WriteByte(header16);
+		WriteBig16(count);
+	} else {
+		WriteByte(header32);
+		WriteBig32(count);
+	}
+	fContainers.push_back(container);
+}
+
+void MsgPackWriter::EndContainer()
+{
+	Check(!fContainers.empty());
+	Container container = fContainers.back();
+	fContainers.pop_back();
+	if (container.expected == kUnknownCount) {
+		Check(container.count % container.itemsPerEntry == 0);
+		Patch32(container.pos + 1, container.count / container.itemsPerEntry);
+	} else {
+		Check(container.count == container.expected);
+	}
+}
+
+void MsgPackWriter::WriteExtHeader(int8 type, uint32 size)
+{
+	if (size <= UINT8_MAX) {
+		WriteByte(0xc7);
+		WriteByte(size);
+	} else if (size <= UINT16_MAX) {
+		WriteByte(0xc8);
+		WriteBig16(size);
+	} else {
+		WriteByte(0xc9);
+		WriteBig32(size);
+	}
+	WriteByte(type);
+}
+
+
+void MsgPackWriter::Null()
+{
+	BeginItem();
+	WriteByte(0xc0);
+}
+
+void MsgPackWriter::Bool(bool val)
+{
+	BeginItem();
+	WriteByte(val ? 0xc3 : 0xc2);
+}
+
+void MsgPackWriter::Int(int64 val)
+{
+	BeginItem();
+	if (val >= 0) {
+		if (val < 128) {
+			WriteByte(val);
+		} else if (val <= UINT8_MAX) {
+			WriteByte(0xcc);
+			WriteByte(val);
+		} else if (val <= UINT16_MAX) {
+			WriteByte(0xcd);
+			WriteBig16(val);
+		} else if (val <= UINT32_MAX) {
+			WriteByte(0xce);
+			WriteBig32(val);
+		} else {
+			WriteByte(0xcf);
+			WriteBig64(val);
+		}
+	} else {
+		if (val >= -32) {
+			WriteByte((int8)val);
+		} else if (val >= INT8_MIN) {
+			WriteByte(0xd0);
+			WriteByte((int8)val);
+		} else if (val >= INT16_MIN) {
+			WriteByte(0xd1);
+			WriteBig16((int16)val);
+		} else if (val >= INT32_MIN) {
+			WriteByte(0xd2);
+			WriteBig32((int32)val);
+		} else {
+			WriteByte(0xd3);
+			WriteBig64(val);
+		}
+	}
+}
+
+void MsgPackWriter::Float(float val)
+{
+	BeginItem();
+	uint32 bits;
+	memcpy(&bits, &val, sizeof(bits));
+	WriteByte(0xca);
+	WriteBig32(bits);
+}
+
+void MsgPackWriter::Double(double val)
+{
+	BeginItem();
+	uint64 bits;
+	memcpy(&bits, &val, sizeof(bits));
+	WriteByte(0xcb);
+	WriteBig64(bits);
+}
+
+void MsgPackWriter::String(std::string_view str)
+{
+	BeginItem();
+	size_t size = str.size();
+	if (size < 32) {
+		WriteByte(0xa0 | size);
+	} else if (size <= UINT8_MAX) {
+		WriteByte(0xd9);
+		WriteByte(size);
+	} else if (size <= UINT16_MAX) {
+		WriteByte(0xda);
+		WriteBig16(size);
+	} else {
+		WriteByte(0xdb);
+		WriteBig32(size);
+	}
+	Write(str.data(), size);
+}
+
+void MsgPackWriter::Binary(const void *data, size_t size)
+{
+	BeginItem();
+	if (size <= UINT8_MAX) {
+		WriteByte(0xc4);
+		WriteByte(size);
+	} else if (size <= UINT16_MAX) {
+		WriteByte(0xc5);
+		WriteBig16(size);
+	} else {
+		WriteByte(0xc6);
+		WriteBig32(size);
+	}
+	Write(data, size);
+}
+
+void MsgPackWriter::Point(const BPoint &pt)
+{
+	BeginItem();
+	float coords[2] = {pt.x, pt.y};
+#if B_HOST_IS_BENDIAN
+	SwapArray32(coords, 2);
+#endif
+	WriteByte(0xd7); // fixext 8
+	WriteByte(kMsgPackExtPoint);
+	Write(coords, sizeof(coords));
+}
+
+void MsgPackWriter::PointArray(const BPoint *points, int32 count)
+{
+	BeginItem();
+	WriteExtHeader(kMsgPackExtPointArray, count*sizeof(BPoint));
+#if B_HOST_IS_BENDIAN
+	for (int32 i = 0; i < count; i++) {
+		float coords[2] = {points[i].x, points[i].y};
+		SwapArray32(coords, 2);
+		Write(coords, sizeof(coords));
+	}
+#else
+	Write(points, count*sizeof(BPoint));
+#endif
+}
+
+
+void MsgPackWriter::StartMap(int32 count)
+{
+	// Map entries are key/value pairs, both are counted as items.
+	WriteContainerHeader(0x80, 0xde, 0xdf, count, 2);
+}
+
+void MsgPackWriter::StartArray(int32 count)
+{
+	WriteContainerHeader(0x90, 0xdc, 0xdd, count, 1);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <SupportDefs.h>
+#include <Point.h>
+
+#include <vector>
+#include <string_view>
+
+
+class BPositionIO;
+
+
+// MessagePack extension types used for picture data. Float data is stored
+// as little endian IEEE 754 single precision values.
+enum {
+	kMsgPackExtPointArray = 1,
+	kMsgPackExtPoint = 2,
+};
+
+
+// Streaming MessagePack encoder with bounded memory. Output is buffered and
+// maps and arrays of unknown length get a 32 bit count that is patched when
+// the container is closed, so the output stream must be seekable.
+class MsgPackWriter {
+private:
+	enum {
+		kBufferSize = 65536,
+		kUnknownCount = -1,
+	};
+
+	struct Container {
+		off_t pos;
+		int32 expected;
+		int32 count;
+		int32 itemsPerEntry;
+	};
+
+	BPositionIO &fWr;
+	uint8 fBuffer[kBufferSize];
+	size_t fLength;
+	off_t fBufferPos;
+	std::vector<Container> fContainers;
+
+	void RaiseError();
+	void Check(bool cond);
+	void CheckStatus(status_t status);
+
+	off_t Position() const {return fBufferPos + fLength;}
+	void Write(const void *data, size_t size);
+	void WriteByte(uint8 val) {if (fLength == kBufferSize) Flush(); fBuffer[fLength++] = val;}
+	void WriteBig16(uint16 val);
+	void WriteBig32(uint32 val);
+	void WriteBig64(uint64 val);
+	void Patch32(off_t pos, uint32 val);
+
+	void BeginItem();
+	void WriteContainerHeader(uint8 fix, uint8 header16, uint8 header32, int32 count, int32 itemsPerEntry);
+	void WriteExtHeader(int8 type, uint32 size);
+	void EndContainer();
+
+public:
+	MsgPackWriter(BPositionIO &wr);
+	~MsgPackWriter();
+
+	void Flush();
+
+	void Null();
+	void Bool(bool val);
+	void Int(int64 val);
+	void Float(float val);
+	void Double(double val);
+	void String(std::string_view str);
+	void Key(std::string_view str) {String(str);}
+	void Binary(const void *data, size_t size);
+	void Point(const BPoint &pt);
+	void PointArray(const BPoint *points, int32 count);
+
+	void StartMap(int32 count = kUnknownCount);
+	void EndMap() {EndContainer();}
+	void StartArray(int32 count = kUnknownCount);
+	void EndArray() {EndContainer();}
+};
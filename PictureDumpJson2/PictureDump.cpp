@@ -1,7 +1,9 @@
 #include "PictureReaderBinary.h"
 #include "PictureReaderJson.h"
+#include "PictureReaderMsgPack.h"
 #include "PictureWriterBinary.h"
 #include "PictureWriterJson.h"
+#include "PictureWriterMsgPack.h"
 #include "PictureWriterYaml.h"
 
 #include <optional>
@@ -19,6 +21,7 @@ enum class FileFormat {
 	Binary,
 	Json,
 	Yaml,
+	MsgPack,
 };
 
 
@@ -41,6 +44,9 @@ static FileFormat FileFormatFromString(std::string_view str)
 	if (str == "yaml") {
 		return FileFormat::Yaml;
 	}
+	if (str == "msgpack") {
+		return FileFormat::MsgPack;
+	}
 	throw std::runtime_error("unknown argument");
 }
 
@@ -115,6 +121,15 @@ static void Accept(Options &opts, PictureVisitor &vis)
 			throw std::runtime_error("YAML input format unimplemented");
 			break;
 		}
+		case FileFormat::MsgPack: {
+			BFile file(opts.inputPath.value().c_str(), B_READ_ONLY);
+			if (file.InitCheck() < B_OK) {
+				throw std::runtime_error("can't open input file");
+			}
+			PictureReaderMsgPack pict(file);
+			pict.Accept(vis);
+			break;
+		}
 	}
 }
 
@@ -160,6 +175,18 @@ int main(int argc, char **argv)
 				os << std::endl;
 				break;
 			}
+			case FileFormat::MsgPack: {
+				BFile file(opts.outputPath.value().c_str(), B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE);
+				if (file.InitCheck() < B_OK) {
+					throw std::runtime_error("can't open output file");
+				}
+				MsgPackWriter wr(file);
+				PictureWriterMsgPack vis(wr);
+
+				Accept(opts, vis);
+				wr.Flush();
+				break;
+			}
 		}
 	} catch (const std::runtime_error &e) {
 		std::cerr << "[!] " << e.what() << std::endl;
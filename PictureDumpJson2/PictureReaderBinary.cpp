@@ -5,6 +5,7 @@
 
 #include "PictureOpcodes.h"
 #include "PictureVisitor.h"
+#include "ByteSwap.h"
 
 #include <GradientLinear.h>
 #include <GradientRadial.h>
@@ -18,15 +19,50 @@
 
 static void ReadBool(BDataIO &rd, bool &val) {int8 x; rd.Read(&x, sizeof(x)); val = x != 0;}
 static void Read8(BDataIO &rd, int8 &val) {rd.Read(&val, sizeof(val));}
-static void Read16(BDataIO &rd, int16 &val) {rd.Read(&val, sizeof(val));}
-static void Read32(BDataIO &rd, int32 &val) {rd.Read(&val, sizeof(val));}
-static void ReadFloat(BDataIO &rd, float &val) {rd.Read(&val, sizeof(val));}
-static void ReadDouble(BDataIO &rd, double &val) {rd.Read(&val, sizeof(val));}
-static void ReadPoint(BDataIO &rd, BPoint &val) {rd.Read(&val, sizeof(val));}
-static void ReadRect(BDataIO &rd, BRect &val) {rd.Read(&val, sizeof(val));}
-static void ReadTransform(BDataIO &rd, BAffineTransform &val) {rd.Read(&val, sizeof(val));}
 static void ReadPattern(BDataIO &rd, pattern &val) {rd.Read(&val, sizeof(val));}
 
+// Multi-byte values are decoded through `swap` specializations. Byte order is
+// selected once per picture in `ReadPicture` so the native path carries no
+// per-field checks.
+
+template <bool swap>
+static void ReadArray32(BDataIO &rd, void *data, size_t count)
+{
+	rd.Read(data, count*sizeof(uint32));
+	if (swap) {
+		SwapArray32(data, count);
+	}
+}
+
+template <bool swap>
+static void Read16(BDataIO &rd, int16 &val) {rd.Read(&val, sizeof(val)); if (swap) val = __swap_int16(val);}
+template <bool swap>
+static void Read32(BDataIO &rd, int32 &val) {rd.Read(&val, sizeof(val)); if (swap) val = __swap_int32(val);}
+template <bool swap>
+static void ReadFloat(BDataIO &rd, float &val) {rd.Read(&val, sizeof(val)); if (swap) val = __swap_float(val);}
+template <bool swap>
+static void ReadDouble(BDataIO &rd, double &val) {rd.Read(&val, sizeof(val)); if (swap) val = __swap_double(val);}
+template <bool swap>
+static void ReadPoint(BDataIO &rd, BPoint &val) {ReadArray32<swap>(rd, &val, 2);}
+template <bool swap>
+static void ReadRect(BDataIO &rd, BRect &val) {ReadArray32<swap>(rd, &val, 4);}
+
+template <bool swap>
+static void ReadTransform(BDataIO &rd, BAffineTransform &val)
+{
+	if (!swap) {
+		rd.Read(&val, sizeof(val));
+		return;
+	}
+	// Matrix is stored as raw object, coefficients are the trailing doubles.
+	uint8 buf[sizeof(BAffineTransform)];
+	double coefs[6];
+	rd.Read(buf, sizeof(buf));
+	memcpy(coefs, buf + sizeof(buf) - sizeof(coefs), sizeof(coefs));
+	SwapArray64(coefs, 6);
+	val = BAffineTransform(coefs[0], coefs[1], coefs[2], coefs[3], coefs[4], coefs[5]);
+}
+
 static void ReadColor(BDataIO &rd, rgb_color& color)
 {
 	int8 val;
@@ -36,10 +72,11 @@ static void ReadColor(BDataIO &rd, rgb_color& color)
 	Read8(rd, val); color.alpha = (uint8)val;
 }
 
+template <bool swap>
 static void ReadString(BDataIO &rd, BString &val)
 {
 	int32 len;
-	Read32(rd, len);
+	Read32<swap>(rd, len);
 	val = "";
 	for (; len > 0; len--) {
 		char ch;
@@ -48,6 +85,7 @@ static void ReadString(BDataIO &rd, BString &val)
 	}
 }
 
+template <bool swap>
 static void ReadShape(BDataIO &rd, BShape &shape)
 {
 	int32 opCount;
@@ -55,40 +93,42 @@ static void ReadShape(BDataIO &rd, BShape &shape)
 	ArrayDeleter<uint32> opList;
 	ArrayDeleter<BPoint> pointList;
 
-	Read32(rd, opCount);
-	Read32(rd, pointCount);
+	Read32<swap>(rd, opCount);
+	Read32<swap>(rd, pointCount);
 	opList.SetTo(new uint32[opCount]);
 	pointList.SetTo(new BPoint[pointCount]);
-	rd.Read(opList.Get(), opCount*sizeof(uint32));
-	rd.Read(pointList.Get(), pointCount*sizeof(BPoint));
+	ReadArray32<swap>(rd, opList.Get(), opCount);
+	ReadArray32<swap>(rd, pointList.Get(), 2*pointCount);
 
 	BShape::Private(shape).SetData(opCount, pointCount, &opList[0], &pointList[0]);
 }
 
+template <bool swap>
 static void ReadGradientStops(BDataIO &rd, BGradient &gradient)
 {
 	int32 stopCount;
-	Read32(rd, stopCount);
+	Read32<swap>(rd, stopCount);
 	for (int32 i = 0; i < stopCount; i++) {
 		BGradient::ColorStop cs;
 		ReadColor(rd, cs.color);
-		ReadFloat(rd, cs.offset);
+		ReadFloat<swap>(rd, cs.offset);
 		gradient.AddColorStop(cs, i);
 	}
 }
 
+template <bool swap>
 static void ReadGradient(BDataIO &rd, ObjectDeleter<BGradient> &outGradient)
 {
 	int32 type;
-	Read32(rd, type);
+	Read32<swap>(rd, type);
 	switch (type) {
 	case BGradient::TYPE_LINEAR: {
 		ObjectDeleter<BGradientLinear> gradient(new BGradientLinear());
-		ReadGradientStops(rd, *gradient.Get());
+		ReadGradientStops<swap>(rd, *gradient.Get());
 		BPoint start;
 		BPoint end;
-		ReadPoint(rd, start);
-		ReadPoint(rd, end);
+		ReadPoint<swap>(rd, start);
+		ReadPoint<swap>(rd, end);
 		gradient->SetStart(start);
 		gradient->SetEnd(end);
 		outGradient.SetTo(gradient.Detach());
@@ -96,11 +136,11 @@ static void ReadGradient(BDataIO &rd, ObjectDeleter<BGradient> &outGradient)
 	}
 	case BGradient::TYPE_RADIAL: {
 		ObjectDeleter<BGradientRadial> gradient(new BGradientRadial());
-		ReadGradientStops(rd, *gradient.Get());
+		ReadGradientStops<swap>(rd, *gradient.Get());
 		BPoint center;
 		float radius;
-		ReadPoint(rd, center);
-		ReadFloat(rd, radius);
+		ReadPoint<swap>(rd, center);
+		ReadFloat<swap>(rd, radius);
 		gradient->SetCenter(center);
 		gradient->SetRadius(radius);
 		outGradient.SetTo(gradient.Detach());
@@ -108,13 +148,13 @@ static void ReadGradient(BDataIO &rd, ObjectDeleter<BGradient> &outGradient)
 	}
 	case BGradient::TYPE_RADIAL_FOCUS: {
 		ObjectDeleter<BGradientRadialFocus> gradient(new BGradientRadialFocus());
-		ReadGradientStops(rd, *gradient.Get());
+		ReadGradientStops<swap>(rd, *gradient.Get());
 		BPoint center;
 		BPoint focal;
 		float radius;
-		ReadPoint(rd, center);
-		ReadPoint(rd, focal);
-		ReadFloat(rd, radius);
+		ReadPoint<swap>(rd, center);
+		ReadPoint<swap>(rd, focal);
+		ReadFloat<swap>(rd, radius);
 		gradient->SetCenter(center);
 		gradient->SetFocal(focal);
 		gradient->SetRadius(radius);
@@ -123,20 +163,20 @@ static void ReadGradient(BDataIO &rd, ObjectDeleter<BGradient> &outGradient)
 	}
 	case BGradient::TYPE_DIAMOND: {
 		ObjectDeleter<BGradientDiamond> gradient(new BGradientDiamond());
-		ReadGradientStops(rd, *gradient.Get());
+		ReadGradientStops<swap>(rd, *gradient.Get());
 		BPoint center;
-		ReadPoint(rd, center);
+		ReadPoint<swap>(rd, center);
 		gradient->SetCenter(center);
 		outGradient.SetTo(gradient.Detach());
 		break;
 	}
 	case BGradient::TYPE_CONIC: {
 		ObjectDeleter<BGradientConic> gradient(new BGradientConic());
-		ReadGradientStops(rd, *gradient.Get());
+		ReadGradientStops<swap>(rd, *gradient.Get());
 		BPoint center;
 		float angle;
-		ReadPoint(rd, center);
-		ReadFloat(rd, angle);
+		ReadPoint<swap>(rd, center);
+		ReadFloat<swap>(rd, angle);
 		gradient->SetCenter(center);
 		gradient->SetAngle(angle);
 		outGradient.SetTo(gradient.Detach());
@@ -149,15 +189,17 @@ static void ReadGradient(BDataIO &rd, ObjectDeleter<BGradient> &outGradient)
 	}
 }
 
+template <bool swap>
 static void DumpOps(PictureVisitor &vis, BPositionIO &rd, int32 size);
 
+template <bool swap>
 static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 {
 	switch (op) {
 	case B_PIC_MOVE_PEN_BY: {
 		float dx, dy;
-		ReadFloat(rd, dx);
-		ReadFloat(rd, dy);
+		ReadFloat<swap>(rd, dx);
+		ReadFloat<swap>(rd, dy);
 		vis.MovePenBy(dx, dy);
 		break;
 	}
@@ -166,10 +208,10 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		bool isGradient = op == B_PIC_STROKE_LINE_GRADIENT;
 		BPoint start, end;
 		ObjectDeleter<BGradient> gradient;
-		ReadPoint(rd, start);
-		ReadPoint(rd, end);
+		ReadPoint<swap>(rd, start);
+		ReadPoint<swap>(rd, end);
 		if (isGradient) {
-			ReadGradient(rd, gradient);
+			ReadGradient<swap>(rd, gradient);
 		}
 		vis.DrawLine(start, end, {.isStroke = true, .gradient = gradient.Get()});
 		break;
@@ -182,9 +224,9 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		bool isGradient = op == B_PIC_STROKE_RECT_GRADIENT || op == B_PIC_FILL_RECT_GRADIENT;
 		BRect rect;
 		ObjectDeleter<BGradient> gradient;
-		ReadRect(rd, rect);
+		ReadRect<swap>(rd, rect);
 		if (isGradient) {
-			ReadGradient(rd, gradient);
+			ReadGradient<swap>(rd, gradient);
 		}
 		vis.DrawRect(rect, {.isStroke = isStroke, .gradient = gradient.Get()});
 		break;
@@ -198,10 +240,10 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		BRect rect;
 		BPoint radius;
 		ObjectDeleter<BGradient> gradient;
-		ReadRect(rd, rect);
-		ReadPoint(rd, radius);
+		ReadRect<swap>(rd, rect);
+		ReadPoint<swap>(rd, radius);
 		if (isGradient) {
-			ReadGradient(rd, gradient);
+			ReadGradient<swap>(rd, gradient);
 		}
 		vis.DrawRoundRect(rect, radius, {.isStroke = isStroke, .gradient = gradient.Get()});
 		break;
@@ -215,10 +257,10 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		BPoint points[4];
 		ObjectDeleter<BGradient> gradient;
 		for (int32 i = 0; i < 4; i++) {
-			ReadPoint(rd, points[i]);
+			ReadPoint<swap>(rd, points[i]);
 		}
 		if (isGradient) {
-			ReadGradient(rd, gradient);
+			ReadGradient<swap>(rd, gradient);
 		}
 		vis.DrawBezier(points, {.isStroke = isStroke, .gradient = gradient.Get()});
 		break;
@@ -233,19 +275,16 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		int32 numPoints;
 		bool isClosed;
 		ObjectDeleter<BGradient> gradient;
-		Read32(rd, numPoints);
-		for (int32 i = 0; i < numPoints; i++) {
-			BPoint point;
-			ReadPoint(rd, point);
-			points.push_back(point);
-		}
+		Read32<swap>(rd, numPoints);
+		points.resize(numPoints);
+		ReadArray32<swap>(rd, points.data(), 2*numPoints);
 		if (isStroke) {
 			ReadBool(rd, isClosed);
 		} else {
 			isClosed = true;
 		}
 		if (isGradient) {
-			ReadGradient(rd, gradient);
+			ReadGradient<swap>(rd, gradient);
 		}
 		vis.DrawPolygon(numPoints, points.data(), isClosed, {.isStroke = isStroke, .gradient = gradient.Get()});
 		break;
@@ -258,9 +297,9 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		bool isGradient = op == B_PIC_STROKE_SHAPE_GRADIENT || op == B_PIC_FILL_SHAPE_GRADIENT;
 		BShape shape;
 		ObjectDeleter<BGradient> gradient;
-		ReadShape(rd, shape);
+		ReadShape<swap>(rd, shape);
 		if (isGradient) {
-			ReadGradient(rd, gradient);
+			ReadGradient<swap>(rd, gradient);
 		}
 		vis.DrawShape(shape, {.isStroke = isStroke, .gradient = gradient.Get()});
 		break;
@@ -276,12 +315,12 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		float startTheta;
 		float arcTheta;
 		ObjectDeleter<BGradient> gradient;
-		ReadPoint(rd, center);
-		ReadPoint(rd, radius);
-		ReadFloat(rd, startTheta);
-		ReadFloat(rd, arcTheta);
+		ReadPoint<swap>(rd, center);
+		ReadPoint<swap>(rd, radius);
+		ReadFloat<swap>(rd, startTheta);
+		ReadFloat<swap>(rd, arcTheta);
 		if (isGradient) {
-			ReadGradient(rd, gradient);
+			ReadGradient<swap>(rd, gradient);
 		}
 		vis.DrawArc(center, radius, startTheta, arcTheta, {.isStroke = isStroke, .gradient = gradient.Get()});
 		break;
@@ -294,9 +333,9 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		bool isGradient = op == B_PIC_STROKE_ELLIPSE_GRADIENT || op == B_PIC_FILL_ELLIPSE_GRADIENT;
 		BRect rect;
 		ObjectDeleter<BGradient> gradient;
-		ReadRect(rd, rect);
+		ReadRect<swap>(rd, rect);
 		if (isGradient) {
-			ReadGradient(rd, gradient);
+			ReadGradient<swap>(rd, gradient);
 		}
 		vis.DrawEllipse(rect, {.isStroke = isStroke, .gradient = gradient.Get()});
 		break;
@@ -304,9 +343,9 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 	case B_PIC_DRAW_STRING: {
 		BString string;
 		escapement_delta delta;
-		ReadString(rd, string);
-		ReadFloat(rd, delta.nonspace);
-		ReadFloat(rd, delta.space);
+		ReadString<swap>(rd, string);
+		ReadFloat<swap>(rd, delta.nonspace);
+		ReadFloat<swap>(rd, delta.space);
 		vis.DrawString(string.String(), string.Length(), delta);
 		break;
 	}
@@ -321,14 +360,14 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		int32 size;
 		ArrayDeleter<uint8> data;
 
-		ReadRect(rd, srcRect);
-		ReadRect(rd, dstRect);
-		Read32(rd, width);
-		Read32(rd, height);
-		Read32(rd, bytesPerRow);
-		Read32(rd, colorSpace);
-		Read32(rd, flags);
-		Read32(rd, size);
+		ReadRect<swap>(rd, srcRect);
+		ReadRect<swap>(rd, dstRect);
+		Read32<swap>(rd, width);
+		Read32<swap>(rd, height);
+		Read32<swap>(rd, bytesPerRow);
+		Read32<swap>(rd, colorSpace);
+		Read32<swap>(rd, flags);
+		Read32<swap>(rd, size);
 		data.SetTo(new uint8[size]);
 		rd.Read(data.Get(), size*sizeof(uint8));
 
@@ -338,8 +377,8 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 	case B_PIC_DRAW_PICTURE: {
 		BPoint where;
 		int32 token;
-		ReadPoint(rd, where);
-		Read32(rd, token);
+		ReadPoint<swap>(rd, where);
+		Read32<swap>(rd, token);
 		vis.DrawPicture(where, token);
 		break;
 	}
@@ -348,10 +387,10 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		int32 pointCount;
 		ArrayDeleter<BPoint> locations;
 
-		Read32(rd, pointCount);
+		Read32<swap>(rd, pointCount);
 		locations.SetTo(new BPoint[pointCount]);
-		rd.Read(locations.Get(), pointCount*sizeof(BPoint));
-		ReadString(rd, string);
+		ReadArray32<swap>(rd, locations.Get(), 2*pointCount);
+		ReadString<swap>(rd, string);
 
 		vis.DrawString(string.String(), string.Length(), &locations[0], pointCount);
 		break;
@@ -359,29 +398,18 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 
 	case B_PIC_ENTER_STATE_CHANGE: {
 		vis.EnterStateChange();
-		DumpOps(vis, rd, opSize);
+		DumpOps<swap>(vis, rd, opSize);
 		vis.ExitStateChange();
 		break;
 	}
 	case B_PIC_SET_CLIPPING_RECTS: {
 		BRegion region;
-		clipping_rect bounds;
-		Read32(rd, bounds.left);
-		Read32(rd, bounds.top);
-		Read32(rd, bounds.right);
-		Read32(rd, bounds.bottom);
 		int32 numRects = opSize / sizeof(clipping_rect);
-		if (numRects >= 2) {
-			for (int32 i = 1; i < numRects; i++) {
-				clipping_rect rc;
-				Read32(rd, rc.left);
-				Read32(rd, rc.top);
-				Read32(rd, rc.right);
-				Read32(rd, rc.bottom);
-				region.Include(rc);
-			}
-		} else {
-			region.Include(bounds);
+		// First rect is bounds, followed by region rects.
+		ArrayDeleter<clipping_rect> rects(new clipping_rect[numRects]);
+		ReadArray32<swap>(rd, rects.Get(), 4*numRects);
+		for (int32 i = numRects >= 2 ? 1 : 0; i < numRects; i++) {
+			region.Include(rects[i]);
 		}
 		vis.SetClipping(region);
 		break;
@@ -390,8 +418,8 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		int32 token;
 		BPoint where;
 		bool inverse;
-		Read32(rd, token);
-		ReadPoint(rd, where);
+		Read32<swap>(rd, token);
+		ReadPoint<swap>(rd, where);
 		ReadBool(rd, inverse);
 		vis.ClipToPicture(token, where, inverse);
 		break;
@@ -409,7 +437,7 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		bool inverse;
 		BRect rect;
 		ReadBool(rd, inverse);
-		ReadRect(rd, rect);
+		ReadRect<swap>(rd, rect);
 		vis.ClipToRect(rect, inverse);
 		break;
 	}
@@ -417,26 +445,26 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		bool inverse;
 		BShape shape;
 		ReadBool(rd, inverse);
-		ReadShape(rd, shape);
+		ReadShape<swap>(rd, shape);
 		vis.ClipToShape(shape, inverse);
 		break;
 	}
 
 	case B_PIC_SET_ORIGIN: {
 		BPoint point;
-		ReadPoint(rd, point);
+		ReadPoint<swap>(rd, point);
 		vis.SetOrigin(point);
 		break;
 	}
 	case B_PIC_SET_PEN_LOCATION: {
 		BPoint point;
-		ReadPoint(rd, point);
+		ReadPoint<swap>(rd, point);
 		vis.SetPenLocation(point);
 		break;
 	}
 	case B_PIC_SET_DRAWING_MODE: {
 		int16 mode;
-		Read16(rd, mode);
+		Read16<swap>(rd, mode);
 		vis.SetDrawingMode((drawing_mode)mode);
 		break;
 	}
@@ -445,22 +473,22 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		int16 joinMode;
 		float miterLimit;
 
-		Read16(rd, capMode);
-		Read16(rd, joinMode);
-		ReadFloat(rd, miterLimit);
+		Read16<swap>(rd, capMode);
+		Read16<swap>(rd, joinMode);
+		ReadFloat<swap>(rd, miterLimit);
 
 		vis.SetLineMode((cap_mode)capMode, (join_mode)joinMode, miterLimit);
 		break;
 	}
 	case B_PIC_SET_PEN_SIZE: {
 		float penSize;
-		ReadFloat(rd, penSize);
+		ReadFloat<swap>(rd, penSize);
 		vis.SetPenSize(penSize);
 		break;
 	}
 	case B_PIC_SET_SCALE: {
 		float scale;
-		ReadFloat(rd, scale);
+		ReadFloat<swap>(rd, scale);
 		vis.SetScale(scale);
 		break;
 	}
@@ -484,7 +512,7 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 	}
 	case B_PIC_ENTER_FONT_STATE: {
 		vis.EnterFontState();
-		DumpOps(vis, rd, opSize);
+		DumpOps<swap>(vis, rd, opSize);
 		vis.ExitFontState();
 		break;
 	}
@@ -492,22 +520,22 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 		int16 srcAlpha;
 		int16 alphaFunc;
 
-		Read16(rd, srcAlpha);
-		Read16(rd, alphaFunc);
+		Read16<swap>(rd, srcAlpha);
+		Read16<swap>(rd, alphaFunc);
 
 		vis.SetBlendingMode((source_alpha)srcAlpha, (alpha_function)alphaFunc);
 		break;
 	}
 	case B_PIC_SET_FILL_RULE: {
 		int32 fillRule;
-		Read32(rd, fillRule);
+		Read32<swap>(rd, fillRule);
 		vis.SetFillRule(fillRule);
 		break;
 	}
 
 	case B_PIC_SET_FONT_FAMILY: {
 		BString str;
-		ReadString(rd, str);
+		ReadString<swap>(rd, str);
 		font_family family;
 		size_t len = std::min<size_t>(str.Length(), sizeof(family) - 1);
 		memcpy(family, str.String(), len);
@@ -517,7 +545,7 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 	}
 	case B_PIC_SET_FONT_STYLE: {
 		BString str;
-		ReadString(rd, str);
+		ReadString<swap>(rd, str);
 		font_style style;
 		size_t len = std::min<size_t>(str.Length(), sizeof(style) - 1);
 		memcpy(style, str.String(), len);
@@ -527,81 +555,81 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 	}
 	case B_PIC_SET_FONT_SPACING: {
 		int32 spacing;
-		Read32(rd, spacing);
+		Read32<swap>(rd, spacing);
 		vis.SetFontSpacing(spacing);
 		break;
 	}
 	case B_PIC_SET_FONT_ENCODING: {
 		int32 encoding;
-		Read32(rd, encoding);
+		Read32<swap>(rd, encoding);
 		vis.SetFontEncoding(encoding);
 		break;
 	}
 	case B_PIC_SET_FONT_FLAGS: {
 		int32 flags;
-		Read32(rd, flags);
+		Read32<swap>(rd, flags);
 		vis.SetFontFlags(flags);
 		break;
 	}
 	case B_PIC_SET_FONT_SIZE: {
 		float size;
-		ReadFloat(rd, size);
+		ReadFloat<swap>(rd, size);
 		vis.SetFontSize(size);
 		break;
 	}
 	case B_PIC_SET_FONT_ROTATE: {
 		float rotation;
-		ReadFloat(rd, rotation);
+		ReadFloat<swap>(rd, rotation);
 		vis.SetFontRotation(rotation);
 		break;
 	}
 	case B_PIC_SET_FONT_SHEAR: {
 		float shear;
-		ReadFloat(rd, shear);
+		ReadFloat<swap>(rd, shear);
 		vis.SetFontShear(shear);
 		break;
 	}
 	case B_PIC_SET_FONT_BPP: {
 		int32 bpp;
-		Read32(rd, bpp);
+		Read32<swap>(rd, bpp);
 		vis.SetFontBpp(bpp);
 		break;
 	}
 	case B_PIC_SET_FONT_FACE: {
 		int32 face;
-		Read32(rd, face);
+		Read32<swap>(rd, face);
 		vis.SetFontFace(face);
 		break;
 	}
 	case B_PIC_SET_FONT_FALSE_BOLD_WIDTH: {
 		float width;
-		ReadFloat(rd, width);
+		ReadFloat<swap>(rd, width);
 		vis.SetFontFalseBoldWidth(width);
 		break;
 	}
 	case B_PIC_SET_TRANSFORM: {
 		BAffineTransform transform;
-		ReadTransform(rd, transform);
+		ReadTransform<swap>(rd, transform);
 		vis.SetTransform(transform);
 		break;
 	}
 	case B_PIC_AFFINE_TRANSLATE: {
 		double x, y;
-		ReadDouble(rd, x);
-		ReadDouble(rd, y);
+		ReadDouble<swap>(rd, x);
+		ReadDouble<swap>(rd, y);
 		vis.TranslateBy(x, y);
 		break;
 	}
 	case B_PIC_AFFINE_SCALE: {
 		double x, y;
-		ReadDouble(rd, x);
-		ReadDouble(rd, y);
+		ReadDouble<swap>(rd, x);
+		ReadDouble<swap>(rd, y);
 		vis.ScaleBy(x, y);
 		break;
 	}
 	case B_PIC_AFFINE_ROTATE: {
 		double angleRadians;
-		ReadDouble(rd, angleRadians);
+		ReadDouble<swap>(rd, angleRadians);
 		vis.RotateBy(angleRadians);
 		break;
 	}
@@ -615,42 +643,70 @@ static void DumpOp(PictureVisitor &vis, BPositionIO &rd, int16 op, int32 opSize)
 	}
 }
 
+template <bool swap>
 static void DumpOps(PictureVisitor &vis, BPositionIO &rd, int32 size)
 {
 	off_t beg = rd.Position();
 	while (rd.Position() - beg < size) {
 		int16 op;
 		int32 opSize;
-		Read16(rd, op);
-		Read32(rd, opSize);
+		Read16<swap>(rd, op);
+		Read32<swap>(rd, opSize);
 		off_t pos = rd.Position();
-		DumpOp(vis, rd, op, opSize);
+		DumpOp<swap>(vis, rd, op, opSize);
 		rd.Seek(pos + opSize, SEEK_SET);
 	}
 }
 
+static void ReadPicture(PictureVisitor &vis, BPositionIO &rd);
 
-status_t PictureReaderBinary::Accept(PictureVisitor &vis) const
+template <bool swap>
+static void ReadPictureBody(PictureVisitor &vis, BPositionIO &rd)
 {
-	int32 version;
-	int32 endian;
 	int32 count;
 	int32 size;
-	Read32(fRd, version);
-	Read32(fRd, endian);
-	vis.EnterPicture(version, endian);
-	Read32(fRd, count);
+	Read32<swap>(rd, count);
 	if (count > 0) {
 		vis.EnterPictures(count);
 		for (int32 i = 0; i < count; i++) {
-			Accept(vis);
+			ReadPicture(vis, rd);
 		}
 		vis.ExitPictures();
 	}
-	Read32(fRd, size);
+	Read32<swap>(rd, size);
 	vis.EnterOps();
-	DumpOps(vis, fRd, size);
+	DumpOps<swap>(vis, rd, size);
 	vis.ExitOps();
+}
+
+static void ReadPicture(PictureVisitor &vis, BPositionIO &rd)
+{
+	int32 version;
+	int32 endian;
+	Read32<false>(rd, version);
+	Read32<false>(rd, endian);
+
+	// Endian field is 0 for little endian and 1 for big endian pictures, so
+	// any non-zero value in host order means big endian regardless of host.
+	bool isBigEndian = endian != 0;
+	bool swap = isBigEndian != B_HOST_IS_BENDIAN;
+	if (swap) {
+		version = __swap_int32(version);
+	}
+
+	// Visitors receive decoded values in host byte order.
+	vis.EnterPicture(version, B_HOST_IS_BENDIAN);
+	if (swap) {
+		ReadPictureBody<true>(vis, rd);
+	} else {
+		ReadPictureBody<false>(vis, rd);
+	}
 	vis.ExitPicture();
+}
+
+
+status_t PictureReaderBinary::Accept(PictureVisitor &vis) const
+{
+	ReadPicture(vis, fRd);
 	return B_OK;
 }
@@ -109,19 +109,54 @@ public:
 };
 
 
+class RapidJsonTokenReader final: public JsonTokenReader {
+private:
+	rapidjson::IStreamWrapper fStream;
+	rapidjson::Reader fRd;
+
+public:
+	RapidJsonTokenReader(std::istream &is): fStream(is) {}
+
+	void Init() final
+	{
+		fRd.IterativeParseInit();
+	}
+
+	bool IsComplete() final
+	{
+		return fRd.IterativeParseComplete();
+	}
+
+	bool Read(JsonToken &token) final
+	{
+		JsonTokenHandler handler(token);
+		return fRd.IterativeParseNext<rapidjson::kParseDefaultFlags>(fStream, handler);
+	}
+};
+
+
 PictureReaderJson::PictureReaderJson(std::istream &is):
-	fStream(is)
+	fOwnedTokens(new RapidJsonTokenReader(is)),
+	fTokens(*fOwnedTokens)
+{
+}
+
+PictureReaderJson::PictureReaderJson(JsonTokenReader &tokens):
+	fTokens(tokens)
+{
+}
+
+PictureReaderJson::~PictureReaderJson()
 {
 }
 
 void PictureReaderJson::ReadToken()
 {
-	JsonTokenHandler handler(fToken);
-	if (fRd.IterativeParseComplete()) {
+	if (fTokens.IsComplete()) {
 		fToken.kind = JsonTokenKind::Eos;
 		return;
 	}
-	if (!fRd.IterativeParseNext<rapidjson::kParseDefaultFlags>(fStream, handler)) {
+	if (!fTokens.Read(fToken)) {
 		RaiseError();
 	}
 }
@@ -153,7 +188,7 @@ void PictureReaderJson::AssumeToken(JsonTokenKind tokenKind)
 
 void PictureReaderJson::Accept(PictureVisitor &vis)
 {
-	fRd.IterativeParseInit();
+	fTokens.Init();
 	ReadToken();
 	ReadPicture(vis);
 }
@@ -1160,12 +1195,17 @@ void PictureReaderJson::ReadDrawBitmap(PictureVisitor &vis)
 		} else if (fToken.strVal == "data") {
 			ReadToken();
 			isSet.data = true;
-			AssumeToken(JsonTokenKind::StartArray); ReadToken();
-			while (fToken.kind != JsonTokenKind::EndArray) {
-				uint8 val = ReadUint8();
-				data.push_back(val);
+			if (fToken.kind == JsonTokenKind::Binary) {
+				data.assign(fToken.strVal.begin(), fToken.strVal.end());
+				ReadToken();
+			} else {
+				AssumeToken(JsonTokenKind::StartArray); ReadToken();
+				while (fToken.kind != JsonTokenKind::EndArray) {
+					uint8 val = ReadUint8();
+					data.push_back(val);
+				}
+				AssumeToken(JsonTokenKind::EndArray); ReadToken();
 			}
-			AssumeToken(JsonTokenKind::EndArray); ReadToken();
 		} else {
 			RaiseError();
 		}
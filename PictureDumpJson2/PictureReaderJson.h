@@ -3,6 +3,7 @@
 #include <math.h>
 
 #include <iostream>
+#include <memory>
 
 #include <rapidjson/reader.h>
 #include <rapidjson/istreamwrapper.h>
@@ -28,6 +29,7 @@ enum class JsonTokenKind {
 	EndObject,
 	StartArray,
 	EndArray,
+	Binary,
 };
 
 
@@ -101,10 +103,22 @@ struct JsonToken {
 };
 
 
+// Source of JSON-like tokens. Allows reading the JSON picture schema from
+// other self-describing encodings.
+class JsonTokenReader {
+public:
+	virtual ~JsonTokenReader() = default;
+
+	virtual void Init() = 0;
+	virtual bool IsComplete() = 0;
+	virtual bool Read(JsonToken &token) = 0;
+};
+
+
 class PictureReaderJson {
 private:
-	rapidjson::IStreamWrapper fStream;
-	rapidjson::Reader fRd;
+	std::unique_ptr<JsonTokenReader> fOwnedTokens;
+	JsonTokenReader &fTokens;
 	JsonToken fToken;
 
 	void ReadToken();
@@ -202,6 +216,8 @@ private:
 
 public:
 	PictureReaderJson(std::istream &is);
+	PictureReaderJson(JsonTokenReader &tokens);
+	~PictureReaderJson();
 
 	void Accept(PictureVisitor &vis);
 };
@@ -0,0 +1,469 @@
+#include "PictureReaderMsgPack.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <ByteOrder.h>
+#include <DataIO.h>
+
+#include "ByteSwap.h"
+#include "MsgPackWriter.h"
+
+
+MsgPackTokenReader::MsgPackTokenReader(BDataIO &rd):
+	fRd(rd),
+	fPos(0),
+	fLength(0),
+	fComplete(false),
+	fExpanding(false),
+	fInPointArray(false),
+	fPointsLeft(0),
+	fPointStep(-1)
+{
+}
+
+void MsgPackTokenReader::Init()
+{
+	fContainers.clear();
+	fComplete = false;
+	fExpanding = false;
+}
+
+bool MsgPackTokenReader::IsComplete()
+{
+	return fComplete;
+}
+
+
+bool MsgPackTokenReader::ReadBytes(void *data, size_t size)
+{
+	uint8 *dst = (uint8*)data;
+	while (size > 0) {
+		if (fPos == fLength) {
+			ssize_t res = fRd.Read(fBuffer, kBufferSize);
+			if (res <= 0) {
+				return false;
+			}
+			fPos = 0;
+			fLength = res;
+		}
+		size_t chunk = std::min(size, fLength - fPos);
+		memcpy(dst, &fBuffer[fPos], chunk);
+		fPos += chunk;
+		dst += chunk;
+		size -= chunk;
+	}
+	return true;
+}
+
+bool MsgPackTokenReader::ReadByte(uint8 &val)
+{
+	if (fPos < fLength) {
+		val = fBuffer[fPos++];
+		return true;
+	}
+	return ReadBytes(&val, sizeof(val));
+}
+
+bool MsgPackTokenReader::ReadBig16(uint16 &val)
+{
+	if (!ReadBytes(&val, sizeof(val))) {
+		return false;
+	}
+	val = B_BENDIAN_TO_HOST_INT16(val);
+	return true;
+}
+
+bool MsgPackTokenReader::ReadBig32(uint32 &val)
+{
+	if (!ReadBytes(&val, sizeof(val))) {
+		return false;
+	}
+	val = B_BENDIAN_TO_HOST_INT32(val);
+	return true;
+}
+
+bool MsgPackTokenReader::ReadBig64(uint64 &val)
+{
+	if (!ReadBytes(&val, sizeof(val))) {
+		return false;
+	}
+	val = B_BENDIAN_TO_HOST_INT64(val);
+	return true;
+}
+
+bool MsgPackTokenReader::ReadString(std::string &str, size_t size)
+{
+	str.resize(size);
+	return ReadBytes(str.data(), size);
+}
+
+bool MsgPackTokenReader::ReadPointData(BPoint &pt)
+{
+	float coords[2];
+	if (!ReadBytes(coords, sizeof(coords))) {
+		return false;
+	}
+#if B_HOST_IS_BENDIAN
+	SwapArray32(coords, 2);
+#endif
+	pt.Set(coords[0], coords[1]);
+	return true;
+}
+
+
+void MsgPackTokenReader::ItemDone()
+{
+	if (fContainers.empty()) {
+		fComplete = true;
+		return;
+	}
+	fContainers.back().remaining--;
+}
+
+bool MsgPackTokenReader::StartContainer(JsonToken &token, uint32 count, bool isMap)
+{
+	token.kind = isMap ? JsonTokenKind::StartObject : JsonTokenKind::StartArray;
+	fContainers.push_back({.remaining = isMap ? 2*count : count, .isMap = isMap});
+	return true;
+}
+
+bool MsgPackTokenReader::StartExt(JsonToken &token, int8 type, uint32 size)
+{
+	switch (type) {
+		case kMsgPackExtPoint:
+			if (size != sizeof(BPoint)) {
+				return false;
+			}
+			fExpanding = true;
+			fInPointArray = false;
+			fPointsLeft = 1;
+			fPointStep = -1;
+			return ReadExpanded(token);
+		case kMsgPackExtPointArray:
+			if (size % sizeof(BPoint) != 0) {
+				return false;
+			}
+			token.kind = JsonTokenKind::StartArray;
+			fExpanding = true;
+			fInPointArray = true;
+			fPointsLeft = size / sizeof(BPoint);
+			fPointStep = -1;
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool MsgPackTokenReader::ReadExpanded(JsonToken &token)
+{
+	if (fPointStep < 0) {
+		if (fPointsLeft == 0) {
+			// Only reached for point arrays, single point ends with its object.
+			fExpanding = false;
+			token.kind = JsonTokenKind::EndArray;
+			ItemDone();
+			return true;
+		}
+		if (!ReadPointData(fPoint)) {
+			return false;
+		}
+		fPointsLeft--;
+		fPointStep = 0;
+	}
+	switch (fPointStep++) {
+		case 0:
+			token.kind = JsonTokenKind::StartObject;
+			break;
+		case 1:
+			token.kind = JsonTokenKind::Key;
+			token.strVal = "x";
+			break;
+		case 2:
+			token.kind = JsonTokenKind::Double;
+			token.doubleVal = fPoint.x;
+			break;
+		case 3:
+			token.kind = JsonTokenKind::Key;
+			token.strVal = "y";
+			break;
+		case 4:
+			token.kind = JsonTokenKind::Double;
+			token.doubleVal = fPoint.y;
+			break;
+		case 5:
+			token.kind = JsonTokenKind::EndObject;
+			fPointStep = -1;
+			if (!fInPointArray) {
+				fExpanding = false;
+				ItemDone();
+			}
+			break;
+	}
+	return true;
+}
+
+bool MsgPackTokenReader::ReadKey(JsonToken &token, uint8 type)
+{
+	uint32 size;
+	if (type >= 0xa0 && type <= 0xbf) {
+		size = type & 0x1f;
+	} else if (type == 0xd9) {
+		uint8 size8;
+		if (!ReadByte(size8)) {
+			return false;
+		}
+		size = size8;
+	} else if (type == 0xda) {
+		uint16 size16;
+		if (!ReadBig16(size16)) {
+			return false;
+		}
+		size = size16;
+	} else if (type == 0xdb) {
+		if (!ReadBig32(size)) {
+			return false;
+		}
+	} else {
+		return false;
+	}
+	token.kind = JsonTokenKind::Key;
+	fContainers.back().remaining--;
+	return ReadString(token.strVal, size);
+}
+
+bool MsgPackTokenReader::Read(JsonToken &token)
+{
+	if (fExpanding) {
+		return ReadExpanded(token);
+	}
+	if (!fContainers.empty() && fContainers.back().remaining == 0) {
+		token.kind = fContainers.back().isMap ? JsonTokenKind::EndObject : JsonTokenKind::EndArray;
+		fContainers.pop_back();
+		ItemDone();
+		return true;
+	}
+
+	uint8 type;
+	if (!ReadByte(type)) {
+		return false;
+	}
+
+	if (!fContainers.empty() && fContainers.back().isMap && fContainers.back().remaining % 2 == 0) {
+		return ReadKey(token, type);
+	}
+
+	if (type <= 0x7f) {
+		token.kind = JsonTokenKind::UInt64;
+		token.uint64Val = type;
+		ItemDone();
+		return true;
+	}
+	if (type >= 0xe0) {
+		token.kind = JsonTokenKind::Int64;
+		token.int64Val = (int8)type;
+		ItemDone();
+		return true;
+	}
+	if (type >= 0x80 && type <= 0x8f) {
+		return StartContainer(token, type & 0x0f, true);
+	}
+	if (type >= 0x90 && type <= 0x9f) {
+		return StartContainer(token, type & 0x0f, false);
+	}
+	if (type >= 0xa0 && type <= 0xbf) {
+		token.kind = JsonTokenKind::String;
+		ItemDone();
+		return ReadString(token.strVal, type & 0x1f);
+	}
+
+	switch (type) {
+		case 0xc0:
+			token.kind = JsonTokenKind::Null;
+			ItemDone();
+			return true;
+		case 0xc2:
+		case 0xc3:
+			token.kind = JsonTokenKind::Bool;
+			token.boolVal = type == 0xc3;
+			ItemDone();
+			return true;
+		case 0xc4:
+		case 0xc5:
+		case 0xc6:
+		case 0xd9:
+		case 0xda:
+		case 0xdb: {
+			bool isBinary = type <= 0xc6;
+			uint32 size;
+			switch (isBinary ? type - 0xc4 : type - 0xd9) {
+				case 0: {
+					uint8 size8;
+					if (!ReadByte(size8)) {
+						return false;
+					}
+					size = size8;
+					break;
+				}
+				case 1: {
+					uint16 size16;
+					if (!ReadBig16(size16)) {
+						return false;
+					}
+					size = size16;
+					break;
+				}
+				default:
+					if (!ReadBig32(size)) {
+						return false;
+					}
+					break;
+			}
+			token.kind = isBinary ? JsonTokenKind::Binary : JsonTokenKind::String;
+			ItemDone();
+			return ReadString(token.strVal, size);
+		}
+		case 0xc7:
+		case 0xc8:
+		case 0xc9: {
+			uint32 size;
+			uint8 extType;
+			if (type == 0xc7) {
+				uint8 size8;
+				if (!ReadByte(size8)) {
+					return false;
+				}
+				size = size8;
+			} else if (type == 0xc8) {
+				uint16 size16;
+				if (!ReadBig16(size16)) {
+					return false;
+				}
+				size = size16;
+			} else {
+				if (!ReadBig32(size)) {
+					return false;
+				}
+			}
+			if (!ReadByte(extType)) {
+				return false;
+			}
+			return StartExt(token, (int8)extType, size);
+		}
+		case 0xd4:
+		case 0xd5:
+		case 0xd6:
+		case 0xd7:
+		case 0xd8: {
+			uint8 extType;
+			if (!ReadByte(extType)) {
+				return false;
+			}
+			return StartExt(token, (int8)extType, 1 << (type - 0xd4));
+		}
+		case 0xca: {
+			uint32 bits;
+			float val;
+			if (!ReadBig32(bits)) {
+				return false;
+			}
+			memcpy(&val, &bits, sizeof(val));
+			token.kind = JsonTokenKind::Double;
+			token.doubleVal = val;
+			ItemDone();
+			return true;
+		}
+		case 0xcb: {
+			uint64 bits;
+			if (!ReadBig64(bits)) {
+				return false;
+			}
+			memcpy(&token.doubleVal, &bits, sizeof(token.doubleVal));
+			token.kind = JsonTokenKind::Double;
+			ItemDone();
+			return true;
+		}
+		case 0xcc:
+		case 0xcd:
+		case 0xce:
+		case 0xcf:
+		case 0xd0:
+		case 0xd1:
+		case 0xd2:
+		case 0xd3: {
+			bool isSigned = type >= 0xd0;
+			uint64 val;
+			switch ((type - 0xcc) % 4) {
+				case 0: {
+					uint8 val8;
+					if (!ReadByte(val8)) {
+						return false;
+					}
+					val = isSigned ? (uint64)(int8)val8 : val8;
+					break;
+				}
+				case 1: {
+					uint16 val16;
+					if (!ReadBig16(val16)) {
+						return false;
+					}
+					val = isSigned ? (uint64)(int16)val16 : val16;
+					break;
+				}
+				case 2: {
+					uint32 val32;
+					if (!ReadBig32(val32)) {
+						return false;
+					}
+					val = isSigned ? (uint64)(int32)val32 : val32;
+					break;
+				}
+				default:
+					if (!ReadBig64(val)) {
+						return false;
+					}
+					break;
+			}
+			if (isSigned) {
+				token.kind = JsonTokenKind::Int64;
+				token.int64Val = (int64)val;
+			} else {
+				token.kind = JsonTokenKind::UInt64;
+				token.uint64Val = val;
+			}
+			ItemDone();
+			return true;
+		}
+		case 0xdc: {
+			uint16 count;
+			return ReadBig16(count) && StartContainer(token, count, false);
+		}
+		case 0xdd: {
+			uint32 count;
+			return ReadBig32(count) && StartContainer(token, count, false);
+		}
+		case 0xde: {
+			uint16 count;
+			return ReadBig16(count) && StartContainer(token, count, true);
+		}
+		case 0xdf: {
+			uint32 count;
+			return ReadBig32(count) && StartContainer(token, count, true);
+		}
+		default:
+			return false;
+	}
+}
+
+
+PictureReaderMsgPack::PictureReaderMsgPack(BDataIO &rd):
+	fTokens(rd),
+	fReader(fTokens)
+{
+}
+
+void PictureReaderMsgPack::Accept(PictureVisitor &vis)
+{
+	fReader.Accept(vis);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "PictureReaderJson.h"
+
+
+class BDataIO;
+
+
+// Decodes MessagePack stream into the token sequence of equivalent JSON
+// document. Point extensions are expanded into `{"x": ..., "y": ...}`
+// objects, binary data is reported as single `Binary` token.
+class MsgPackTokenReader final: public JsonTokenReader {
+private:
+	enum {
+		kBufferSize = 65536,
+	};
+
+	struct Container {
+		uint32 remaining;
+		bool isMap;
+	};
+
+	BDataIO &fRd;
+	uint8 fBuffer[kBufferSize];
+	size_t fPos;
+	size_t fLength;
+	std::vector<Container> fContainers;
+	bool fComplete;
+
+	bool fExpanding;
+	bool fInPointArray;
+	uint32 fPointsLeft;
+	int32 fPointStep;
+	BPoint fPoint;
+
+	bool ReadBytes(void *data, size_t size);
+	bool ReadByte(uint8 &val);
+	bool ReadBig16(uint16 &val);
+	bool ReadBig32(uint32 &val);
+	bool ReadBig64(uint64 &val);
+	bool ReadString(std::string &str, size_t size);
+	bool ReadPointData(BPoint &pt);
+
+	void ItemDone();
+	bool StartContainer(JsonToken &token, uint32 count, bool isMap);
+	bool StartExt(JsonToken &token, int8 type, uint32 size);
+	bool ReadExpanded(JsonToken &token);
+	bool ReadKey(JsonToken &token, uint8 type);
+
+public:
+	MsgPackTokenReader(BDataIO &rd);
+
+	void Init() final;
+	bool IsComplete() final;
+	bool Read(JsonToken &token) final;
+};
+
+
+class PictureReaderMsgPack {
+private:
+	MsgPackTokenReader fTokens;
+	PictureReaderJson fReader;
+
+public:
+	PictureReaderMsgPack(BDataIO &rd);
+
+	void Accept(PictureVisitor &vis);
+};
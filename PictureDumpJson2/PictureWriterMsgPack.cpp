@@ -0,0 +1,6 @@
+#include "PictureWriterMsgPack.h"
+
+#include "PictureWriterStructuredImpl.h"
+
+
+template class PictureWriterStructured<MsgPackWriter&>;
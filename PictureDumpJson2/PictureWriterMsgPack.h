@@ -0,0 +1,13 @@
+#pragma once
+
+#include "PictureWriterStructured.h"
+
+#include "MsgPackWriter.h"
+
+
+// MsgPackWriter already has encoder interface, points and bitmap data use
+// compact extension and binary types.
+class PictureWriterMsgPack final: public PictureWriterStructured<MsgPackWriter&> {
+public:
+	PictureWriterMsgPack(MsgPackWriter &wr): PictureWriterStructured<MsgPackWriter&>(wr) {}
+};
@@ -0,0 +1,995 @@
+#pragma once
+
+#include "PictureWriterStructured.h"
+
+#include <stdio.h>
+
+#include <GradientLinear.h>
+#include <GradientRadial.h>
+#include <GradientRadialFocus.h>
+#include <GradientConic.h>
+#include <GradientDiamond.h>
+
+
+template<typename Encoder>
+class PictureWriterStructured<Encoder>::ShapeIterator final: public BShapeIterator {
+private:
+	PictureWriterStructured &fBase;
+
+public:
+	virtual ~ShapeIterator() = default;
+
+	ShapeIterator(PictureWriterStructured &base): fBase(base) {}
+
+
+	status_t IterateMoveTo(BPoint* point) final
+	{
+		fBase.fWr.StartMap(1);
+		fBase.fWr.Key("MoveTo");
+		fBase.fWr.Point(*point);
+		fBase.fWr.EndMap();
+		return B_OK;
+	}
+
+	status_t IterateLineTo(int32 lineCount, BPoint* linePoints) final
+	{
+		fBase.fWr.StartMap(1);
+		fBase.fWr.Key("LineTo");
+		fBase.fWr.PointArray(linePoints, lineCount);
+		fBase.fWr.EndMap();
+		return B_OK;
+	}
+
+	status_t IterateBezierTo(int32 bezierCount, BPoint* bezierPoints) final
+	{
+		fBase.fWr.StartMap(1);
+		fBase.fWr.Key("BezierTo");
+		fBase.fWr.PointArray(bezierPoints, 3*bezierCount);
+		fBase.fWr.EndMap();
+		return B_OK;
+	}
+
+	status_t IterateClose()
+	{
+		fBase.fWr.StartMap(1);
+		fBase.fWr.Key("Close");
+		fBase.fWr.StartMap(0);
+		fBase.fWr.EndMap();
+		fBase.fWr.EndMap();
+		return B_OK;
+	}
+
+	status_t IterateArcTo(
+		float& rx, float& ry,
+		float& angle, bool largeArc,
+		bool counterClockWise, BPoint& point
+	)
+	{
+		fBase.fWr.StartMap(1);
+		fBase.fWr.Key("ArcTo");
+		fBase.fWr.StartMap(6);
+		fBase.fWr.Key("rx"); fBase.fWr.Float(rx);
+		fBase.fWr.Key("ry"); fBase.fWr.Float(ry);
+		fBase.fWr.Key("angle"); fBase.fWr.Float(angle);
+		fBase.fWr.Key("largeArc"); fBase.fWr.Bool(largeArc);
+		fBase.fWr.Key("ccw"); fBase.fWr.Bool(counterClockWise);
+		fBase.fWr.Key("point"); fBase.fWr.Point(point);
+		fBase.fWr.EndMap();
+		fBase.fWr.EndMap();
+		return B_OK;
+	}
+};
+
+
+template<typename Encoder>
+PictureWriterStructured<Encoder>::PictureWriterStructured(Encoder wr):
+	fWr(wr)
+{
+}
+
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::WriteColor(const rgb_color &c)
+{
+	char buf[64];
+	sprintf(buf, "#%02x%02x%02x%02x",
+		c.alpha,
+		c.red,
+		c.green,
+		c.blue
+	);
+	fWr.String(buf);
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::WriteRect(const BRect &rc)
+{
+	fWr.StartMap(4);
+	fWr.Key("left");   fWr.Float(rc.left);
+	fWr.Key("top");    fWr.Float(rc.top);
+	fWr.Key("right");  fWr.Float(rc.right);
+	fWr.Key("bottom"); fWr.Float(rc.bottom);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::WriteShape(const BShape &shape)
+{
+	ShapeIterator iter(*this);
+	fWr.StartArray();
+	iter.Iterate(const_cast<BShape*>(&shape));
+	fWr.EndArray();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::WriteGradient(const BGradient &gradient)
+{
+	fWr.StartMap(1);
+	switch (gradient.GetType()) {
+		case BGradient::TYPE_LINEAR:
+			fWr.Key("BGradientLinear");
+			fWr.StartMap(3);
+			break;
+		case BGradient::TYPE_RADIAL:
+			fWr.Key("BGradientRadial");
+			fWr.StartMap(3);
+			break;
+		case BGradient::TYPE_RADIAL_FOCUS:
+			fWr.Key("BGradientRadialFocus");
+			fWr.StartMap(4);
+			break;
+		case BGradient::TYPE_DIAMOND:
+			fWr.Key("BGradientDiamond");
+			fWr.StartMap(2);
+			break;
+		case BGradient::TYPE_CONIC:
+			fWr.Key("BGradientConic");
+			fWr.StartMap(3);
+			break;
+		default:
+			fWr.Key("BGradient");
+			fWr.StartMap(1);
+			break;
+	}
+	fWr.Key("stops");
+	fWr.StartArray(gradient.CountColorStops());
+	for (int32 i = 0; i < gradient.CountColorStops(); i++) {
+		BGradient::ColorStop *cs = gradient.ColorStopAt(i);
+		fWr.StartMap(2);
+		fWr.Key("color"); WriteColor(cs->color);
+		fWr.Key("offset"); fWr.Float(cs->offset);
+		fWr.EndMap();
+	}
+	fWr.EndArray();
+	switch (gradient.GetType()) {
+	case BGradient::TYPE_LINEAR: {
+		const BGradientLinear &grad = static_cast<const BGradientLinear &>(gradient);
+		fWr.Key("start"); fWr.Point(grad.Start());
+		fWr.Key("end"); fWr.Point(grad.End());
+		break;
+	}
+	case BGradient::TYPE_RADIAL: {
+		const BGradientRadial &grad = static_cast<const BGradientRadial &>(gradient);
+		fWr.Key("center"); fWr.Point(grad.Center());
+		fWr.Key("radius"); fWr.Float(grad.Radius());
+		break;
+	}
+	case BGradient::TYPE_RADIAL_FOCUS: {
+		const BGradientRadialFocus &grad = static_cast<const BGradientRadialFocus &>(gradient);
+		fWr.Key("center"); fWr.Point(grad.Center());
+		fWr.Key("focus"); fWr.Point(grad.Focal());
+		fWr.Key("radius"); fWr.Float(grad.Radius());
+		break;
+	}
+	case BGradient::TYPE_DIAMOND: {
+		const BGradientDiamond &grad = static_cast<const BGradientDiamond &>(gradient);
+		fWr.Key("center"); fWr.Point(grad.Center());
+		break;
+	}
+	case BGradient::TYPE_CONIC: {
+		const BGradientConic &grad = static_cast<const BGradientConic &>(gradient);
+		fWr.Key("center"); fWr.Point(grad.Center());
+		fWr.Key("angle"); fWr.Float(grad.Angle());
+		break;
+	}
+	case BGradient::TYPE_NONE:
+		break;
+	}
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::WriteTransform(const BAffineTransform& tr)
+{
+	fWr.StartMap(6);
+	fWr.Key("tx");  fWr.Double(tr.tx);
+	fWr.Key("ty");  fWr.Double(tr.ty);
+	fWr.Key("sx");  fWr.Double(tr.sx);
+	fWr.Key("sy");  fWr.Double(tr.sy);
+	fWr.Key("shy"); fWr.Double(tr.shy);
+	fWr.Key("shx"); fWr.Double(tr.shx);
+	fWr.EndMap();
+}
+
+
+
+// #pragma mark - Meta
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::EnterPicture(int32 version, int32 endian)
+{
+	fWr.StartMap();
+	fWr.Key("version"); fWr.Int(version);
+	fWr.Key("endian"); fWr.Int(endian);
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ExitPicture()
+{
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::EnterPictures(int32 count)
+{
+	fWr.Key("pictures");
+	fWr.StartArray();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ExitPictures()
+{
+	fWr.EndArray();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::EnterOps()
+{
+	fWr.Key("ops");
+	fWr.StartArray();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ExitOps()
+{
+	fWr.EndArray();
+}
+
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::EnterStateChange()
+{
+	fWr.StartMap(1);
+	fWr.Key("ENTER_STATE_CHANGE");
+	fWr.StartArray();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ExitStateChange()
+{
+	fWr.EndArray();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::EnterFontState()
+{
+	fWr.StartMap(1);
+	fWr.Key("ENTER_FONT_STATE");
+	fWr.StartArray();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ExitFontState()
+{
+	fWr.EndArray();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::PushState()
+{
+	fWr.StartMap(1);
+	fWr.Key("GROUP");
+	fWr.StartArray();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::PopState()
+{
+	fWr.EndArray();
+	fWr.EndMap();
+}
+
+
+// #pragma mark - State Absolute
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetDrawingMode(drawing_mode mode)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_DRAWING_MODE");
+	switch (mode) {
+		case B_OP_COPY: fWr.String("B_OP_COPY"); break;
+		case B_OP_OVER: fWr.String("B_OP_OVER"); break;
+		case B_OP_ERASE: fWr.String("B_OP_ERASE"); break;
+		case B_OP_INVERT: fWr.String("B_OP_INVERT"); break;
+		case B_OP_ADD: fWr.String("B_OP_ADD"); break;
+		case B_OP_SUBTRACT: fWr.String("B_OP_SUBTRACT"); break;
+		case B_OP_BLEND: fWr.String("B_OP_BLEND"); break;
+		case B_OP_MIN: fWr.String("B_OP_MIN"); break;
+		case B_OP_MAX: fWr.String("B_OP_MAX"); break;
+		case B_OP_SELECT: fWr.String("B_OP_SELECT"); break;
+		case B_OP_ALPHA: fWr.String("B_OP_ALPHA"); break;
+		default: fWr.Int(mode);
+	}
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetLineMode(cap_mode cap,
+							join_mode join,
+							float miterLimit)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_LINE_MODE");
+	fWr.StartMap(3);
+	fWr.Key("capMode");
+	switch (cap) {
+		case B_ROUND_CAP: fWr.String("B_ROUND_CAP"); break;
+		case B_BUTT_CAP: fWr.String("B_BUTT_CAP"); break;
+		case B_SQUARE_CAP: fWr.String("B_SQUARE_CAP"); break;
+		default: fWr.Int(cap);
+	}
+	fWr.Key("joinMode");
+	switch (join) {
+		case B_ROUND_JOIN: fWr.String("B_ROUND_JOIN"); break;
+		case B_MITER_JOIN: fWr.String("B_MITER_JOIN"); break;
+		case B_BEVEL_JOIN: fWr.String("B_BEVEL_JOIN"); break;
+		case B_BUTT_JOIN: fWr.String("B_BUTT_JOIN"); break;
+		case B_SQUARE_JOIN: fWr.String("B_SQUARE_JOIN"); break;
+		default: fWr.Int(join);
+	}
+	fWr.Key("miterLimit"); fWr.Float(miterLimit);
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetPenSize(float penSize)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_PEN_SIZE");
+	fWr.Float(penSize);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetHighColor(const rgb_color& color)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FORE_COLOR");
+	WriteColor(color);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetLowColor(const rgb_color& color)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_BACK_COLOR");
+	WriteColor(color);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetPattern(const ::pattern& pat)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_STIPLE_PATTERN");
+	if (memcmp(&pat, &B_SOLID_HIGH, sizeof(pattern)) == 0)
+		fWr.String("B_SOLID_HIGH");
+	else if (memcmp(&pat, &B_SOLID_LOW, sizeof(pattern)) == 0)
+		fWr.String("B_SOLID_LOW");
+	else if (memcmp(&pat, &B_MIXED_COLORS, sizeof(pattern)) == 0)
+		fWr.String("B_MIXED_COLORS");
+	else {
+		fWr.StartArray(8);
+		for (int32 i = 0; i < 8; i++) {
+			fWr.Int((uint8)pat.data[i]);
+		}
+		fWr.EndArray();
+	}
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetBlendingMode(source_alpha srcAlpha,
+							alpha_function alphaFunc)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_BLENDING_MODE");
+	fWr.StartMap(2);
+	fWr.Key("srcAlpha");
+	switch (srcAlpha) {
+		case B_PIXEL_ALPHA: fWr.String("B_PIXEL_ALPHA"); break;
+		case B_CONSTANT_ALPHA: fWr.String("B_CONSTANT_ALPHA"); break;
+		default: fWr.Int(srcAlpha);
+	}
+	fWr.Key("alphaFunc");
+	switch (alphaFunc) {
+		case B_ALPHA_OVERLAY: fWr.String("B_ALPHA_OVERLAY"); break;
+		case B_ALPHA_COMPOSITE: fWr.String("B_ALPHA_COMPOSITE"); break;
+		case B_ALPHA_COMPOSITE_SOURCE_IN: fWr.String("B_ALPHA_COMPOSITE_SOURCE_IN"); break;
+		case B_ALPHA_COMPOSITE_SOURCE_OUT: fWr.String("B_ALPHA_COMPOSITE_SOURCE_OUT"); break;
+		case B_ALPHA_COMPOSITE_SOURCE_ATOP: fWr.String("B_ALPHA_COMPOSITE_SOURCE_ATOP"); break;
+		case B_ALPHA_COMPOSITE_DESTINATION_OVER: fWr.String("B_ALPHA_COMPOSITE_DESTINATION_OVER"); break;
+		case B_ALPHA_COMPOSITE_DESTINATION_IN: fWr.String("B_ALPHA_COMPOSITE_DESTINATION_IN"); break;
+		case B_ALPHA_COMPOSITE_DESTINATION_OUT: fWr.String("B_ALPHA_COMPOSITE_DESTINATION_OUT"); break;
+		case B_ALPHA_COMPOSITE_DESTINATION_ATOP: fWr.String("B_ALPHA_COMPOSITE_DESTINATION_ATOP"); break;
+		case B_ALPHA_COMPOSITE_XOR: fWr.String("B_ALPHA_COMPOSITE_XOR"); break;
+		case B_ALPHA_COMPOSITE_CLEAR: fWr.String("B_ALPHA_COMPOSITE_CLEAR"); break;
+		case B_ALPHA_COMPOSITE_DIFFERENCE: fWr.String("B_ALPHA_COMPOSITE_DIFFERENCE"); break;
+		case B_ALPHA_COMPOSITE_LIGHTEN: fWr.String("B_ALPHA_COMPOSITE_LIGHTEN"); break;
+		case B_ALPHA_COMPOSITE_DARKEN: fWr.String("B_ALPHA_COMPOSITE_DARKEN"); break;
+		default: fWr.Int(alphaFunc);
+	}
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFillRule(int32 fillRule)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FILL_RULE");
+	switch (fillRule) {
+		case B_EVEN_ODD: fWr.String("B_EVEN_ODD"); break;
+		case B_NONZERO: fWr.String("B_NONZERO"); break;
+		default: fWr.Int(fillRule);
+	}
+	fWr.EndMap();
+}
+
+
+// #pragma mark - State Relative
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetOrigin(const BPoint& point)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_ORIGIN");
+	fWr.Point(point);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetScale(float scale)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_SCALE");
+	fWr.Float(scale);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetPenLocation(const BPoint& point)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_PEN_LOCATION");
+	fWr.Point(point);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetTransform(const BAffineTransform& transform)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_TRANSFORM");
+	WriteTransform(transform);
+	fWr.EndMap();
+}
+
+
+// #pragma mark - Clipping
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetClipping(const BRegion& region)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_CLIPPING_RECTS");
+	fWr.StartArray(region.CountRects());
+	for (int32 i = 0; i < region.CountRects(); i++) {
+		WriteRect(region.RectAt(i));
+	}
+	fWr.EndArray();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ClearClipping()
+{
+	fWr.StartMap(1);
+	fWr.Key("CLEAR_CLIPPING_RECTS");
+	fWr.StartMap(0);
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ClipToPicture(int32 pictureToken, const BPoint& origin, bool inverse)
+{
+	fWr.StartMap(1);
+	fWr.Key("CLIP_TO_PICTURE");
+	fWr.StartMap(3);
+	fWr.Key("token"); fWr.Int(pictureToken);
+	fWr.Key("where"); fWr.Point(origin);
+	fWr.Key("inverse"); fWr.Bool(inverse);
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ClipToRect(const BRect& rect, bool inverse)
+{
+	fWr.StartMap(1);
+	fWr.Key("CLIP_TO_RECT");
+	fWr.StartMap(2);
+	fWr.Key("inverse"); fWr.Bool(inverse);
+	fWr.Key("rect"); WriteRect(rect);
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ClipToShape(const BShape& shape, bool inverse)
+{
+	fWr.StartMap(1);
+	fWr.Key("CLIP_TO_SHAPE");
+	fWr.StartMap(2);
+	fWr.Key("inverse"); fWr.Bool(inverse);
+	fWr.Key("shape"); WriteShape(shape);
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+
+// #pragma mark - Font
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontFamily(const font_family family)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_FAMILY");
+	fWr.String(family);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontStyle(const font_style style)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_STYLE");
+	fWr.String(style);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontSpacing(int32 spacing)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_SPACING");
+	switch (spacing) {
+		case B_CHAR_SPACING: fWr.String("B_CHAR_SPACING"); break;
+		case B_STRING_SPACING: fWr.String("B_STRING_SPACING"); break;
+		case B_BITMAP_SPACING: fWr.String("B_BITMAP_SPACING"); break;
+		case B_FIXED_SPACING: fWr.String("B_FIXED_SPACING"); break;
+		default: fWr.Int(spacing);
+	}
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontSize(float size)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_SIZE");
+	fWr.Float(size);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontRotation(float rotation)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_ROTATE");
+	fWr.Float(rotation);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontEncoding(int32 encoding)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_ENCODING");
+	switch (encoding) {
+		case B_UNICODE_UTF8: fWr.String("B_UNICODE_UTF8"); break;
+		case B_ISO_8859_1: fWr.String("B_ISO_8859_1"); break;
+		case B_ISO_8859_2: fWr.String("B_ISO_8859_2"); break;
+		case B_ISO_8859_3: fWr.String("B_ISO_8859_3"); break;
+		case B_ISO_8859_4: fWr.String("B_ISO_8859_4"); break;
+		case B_ISO_8859_5: fWr.String("B_ISO_8859_5"); break;
+		case B_ISO_8859_6: fWr.String("B_ISO_8859_6"); break;
+		case B_ISO_8859_7: fWr.String("B_ISO_8859_7"); break;
+		case B_ISO_8859_8: fWr.String("B_ISO_8859_8"); break;
+		case B_ISO_8859_9: fWr.String("B_ISO_8859_9"); break;
+		case B_ISO_8859_10: fWr.String("B_ISO_8859_10"); break;
+		case B_MACINTOSH_ROMAN: fWr.String("B_MACINTOSH_ROMAN"); break;
+		default: fWr.Int(encoding);
+	}
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontFlags(int32 flags)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_FLAGS");
+	fWr.StartArray();
+	for (uint32 i = 0; i < 32; i++) {
+		if ((1U << i) & (uint32)flags) {
+			switch (i) {
+				case 0: fWr.String("B_DISABLE_ANTIALIASING"); break;
+				case 1: fWr.String("B_FORCE_ANTIALIASING"); break;
+				default: fWr.Int(i);
+			}
+		}
+	}
+	fWr.EndArray();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontShear(float shear)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_SHEAR");
+	fWr.Float(shear);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontBpp(int32 bpp)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_BPP");
+	fWr.Int(bpp);
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontFace(int32 face)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_FACE");
+	fWr.StartArray();
+	for (uint32 i = 0; i < 32; i++) {
+		if ((1U << i) & (uint32)face) {
+			switch (i) {
+				case 0: fWr.String("B_ITALIC_FACE"); break;
+				case 1: fWr.String("B_UNDERSCORE_FACE"); break;
+				case 2: fWr.String("B_NEGATIVE_FACE"); break;
+				case 3: fWr.String("B_OUTLINED_FACE"); break;
+				case 4: fWr.String("B_STRIKEOUT_FACE"); break;
+				case 5: fWr.String("B_BOLD_FACE"); break;
+				case 6: fWr.String("B_REGULAR_FACE"); break;
+				case 7: fWr.String("B_CONDENSED_FACE"); break;
+				case 8: fWr.String("B_LIGHT_FACE"); break;
+				case 9: fWr.String("B_HEAVY_FACE"); break;
+				default: fWr.Int(i);
+			}
+		}
+	}
+	fWr.EndArray();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::SetFontFalseBoldWidth(float width)
+{
+	fWr.StartMap(1);
+	fWr.Key("SET_FONT_FALSE_BOLD_WIDTH");
+	fWr.Float(width);
+	fWr.EndMap();
+}
+
+
+// #pragma mark - State (delta)
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::MovePenBy(float dx, float dy)
+{
+	fWr.StartMap(1);
+	fWr.Key("MOVE_PEN_BY");
+	fWr.Point(BPoint(dx, dy));
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::TranslateBy(double x, double y)
+{
+	fWr.StartMap(1);
+	fWr.Key("AFFINE_TRANSLATE");
+	fWr.StartMap(2);
+	fWr.Key("x"); fWr.Double(x);
+	fWr.Key("y"); fWr.Double(y);
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::ScaleBy(double x, double y)
+{
+	fWr.StartMap(1);
+	fWr.Key("AFFINE_SCALE");
+	fWr.StartMap(2);
+	fWr.Key("x"); fWr.Double(x);
+	fWr.Key("y"); fWr.Double(y);
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::RotateBy(double angleRadians)
+{
+	fWr.StartMap(1);
+	fWr.Key("AFFINE_ROTATE");
+	fWr.Double(angleRadians);
+	fWr.EndMap();
+}
+
+
+// #pragma mark - Geometry
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawLine(const BPoint& start, const BPoint& end, const DrawGeometryInfo &drawInfo)
+{
+	fWr.StartMap(1);
+	fWr.Key(drawInfo.gradient == NULL ? "STROKE_LINE" : "STROKE_LINE_GRADIENT");
+	fWr.StartMap(drawInfo.gradient == NULL ? 2 : 3);
+	fWr.Key("start"); fWr.Point(start);
+	fWr.Key("end"); fWr.Point(end);
+	if (drawInfo.gradient != NULL) {
+		fWr.Key("gradient"); WriteGradient(*drawInfo.gradient);
+	}
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawRect(const BRect& rect, const DrawGeometryInfo &drawInfo)
+{
+	fWr.StartMap(1);
+	if (drawInfo.gradient == NULL) {
+		fWr.Key(drawInfo.isStroke ? "STROKE_RECT" : "FILL_RECT");
+		WriteRect(rect);
+	} else {
+		fWr.Key(drawInfo.isStroke ? "STROKE_RECT_GRADIENT" : "FILL_RECT_GRADIENT");
+		fWr.StartMap(2);
+		fWr.Key("rect"); WriteRect(rect);
+		fWr.Key("gradient"); WriteGradient(*drawInfo.gradient);
+		fWr.EndMap();
+	}
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawRoundRect(const BRect& rect, const BPoint& radius, const DrawGeometryInfo &drawInfo)
+{
+	fWr.StartMap(1);
+	if (drawInfo.gradient == NULL) {
+		fWr.Key(drawInfo.isStroke ? "STROKE_ROUND_RECT" : "FILL_ROUND_RECT");
+	} else {
+		fWr.Key(drawInfo.isStroke ? "STROKE_ROUND_RECT_GRADIENT" : "FILL_ROUND_RECT_GRADIENT");
+	}
+	fWr.StartMap(drawInfo.gradient == NULL ? 2 : 3);
+	fWr.Key("rect"); WriteRect(rect);
+	fWr.Key("radius"); fWr.Point(radius);
+	if (drawInfo.gradient != NULL) {
+		fWr.Key("gradient"); WriteGradient(*drawInfo.gradient);
+	}
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawBezier(const BPoint points[4], const DrawGeometryInfo &drawInfo)
+{
+	fWr.StartMap(1);
+	if (drawInfo.gradient == NULL) {
+		fWr.Key(drawInfo.isStroke ? "STROKE_BEZIER" : "FILL_BEZIER");
+		fWr.PointArray(points, 4);
+	} else {
+		fWr.Key(drawInfo.isStroke ? "STROKE_BEZIER_GRADIENT" : "FILL_BEZIER_GRADIENT");
+		fWr.StartMap(2);
+		fWr.Key("points"); fWr.PointArray(points, 4);
+		fWr.Key("gradient"); WriteGradient(*drawInfo.gradient);
+		fWr.EndMap();
+	}
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawPolygon(int32 numPoints, const BPoint* points, bool isClosed, const DrawGeometryInfo &drawInfo)
+{
+	fWr.StartMap(1);
+	if (drawInfo.gradient == NULL) {
+		fWr.Key(drawInfo.isStroke ? "STROKE_POLYGON" : "FILL_POLYGON");
+	} else {
+		fWr.Key(drawInfo.isStroke ? "STROKE_POLYGON_GRADIENT" : "FILL_POLYGON_GRADIENT");
+	}
+	if (drawInfo.isStroke || drawInfo.gradient != NULL) {
+		fWr.StartMap(1 + (drawInfo.isStroke ? 1 : 0) + (drawInfo.gradient != NULL ? 1 : 0));
+		fWr.Key("points"); fWr.PointArray(points, numPoints);
+		if (drawInfo.isStroke) {
+			fWr.Key("isClosed"); fWr.Bool(isClosed);
+		}
+		if (drawInfo.gradient != NULL) {
+			fWr.Key("gradient"); WriteGradient(*drawInfo.gradient);
+		}
+		fWr.EndMap();
+	} else {
+		fWr.PointArray(points, numPoints);
+	}
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawShape(const BShape& shape, const DrawGeometryInfo &drawInfo)
+{
+	fWr.StartMap(1);
+	if (drawInfo.gradient == NULL) {
+		fWr.Key(drawInfo.isStroke ? "STROKE_SHAPE" : "FILL_SHAPE");
+		WriteShape(shape);
+	} else {
+		fWr.Key(drawInfo.isStroke ? "STROKE_SHAPE_GRADIENT" : "FILL_SHAPE_GRADIENT");
+		fWr.StartMap(2);
+		fWr.Key("shape"); WriteShape(shape);
+		fWr.Key("gradient"); WriteGradient(*drawInfo.gradient);
+		fWr.EndMap();
+	}
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawArc(
+	const BPoint& center,
+	const BPoint& radius,
+	float startTheta,
+	float arcTheta,
+	const DrawGeometryInfo &drawInfo
+)
+{
+	fWr.StartMap(1);
+	if (drawInfo.gradient == NULL) {
+		fWr.Key(drawInfo.isStroke ? "STROKE_ARC" : "FILL_ARC");
+	} else {
+		fWr.Key(drawInfo.isStroke ? "STROKE_ARC_GRADIENT" : "FILL_ARC_GRADIENT");
+	}
+	fWr.StartMap(drawInfo.gradient == NULL ? 4 : 5);
+	fWr.Key("center"); fWr.Point(center);
+	fWr.Key("radius"); fWr.Point(radius);
+	fWr.Key("startTheta"); fWr.Float(startTheta);
+	fWr.Key("arcTheta"); fWr.Float(arcTheta);
+	if (drawInfo.gradient != NULL) {
+		fWr.Key("gradient"); WriteGradient(*drawInfo.gradient);
+	}
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawEllipse(const BRect& rect, const DrawGeometryInfo &drawInfo)
+{
+	fWr.StartMap(1);
+	if (drawInfo.gradient == NULL) {
+		fWr.Key(drawInfo.isStroke ? "STROKE_ELLIPSE" : "FILL_ELLIPSE");
+		WriteRect(rect);
+	} else {
+		fWr.Key(drawInfo.isStroke ? "STROKE_ELLIPSE_GRADIENT" : "FILL_ELLIPSE_GRADIENT");
+		fWr.StartMap(2);
+		fWr.Key("rect"); WriteRect(rect);
+		fWr.Key("gradient"); WriteGradient(*drawInfo.gradient);
+		fWr.EndMap();
+	}
+	fWr.EndMap();
+}
+
+
+// #pragma mark - Draw
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawString(
+							const char* string, int32 length,
+							const escapement_delta& delta)
+{
+	bool hasDelta = delta.nonspace != 0 || delta.space != 0;
+	fWr.StartMap(1);
+	fWr.Key("DRAW_STRING");
+	fWr.StartMap(hasDelta ? 2 : 1);
+	fWr.Key("string"); fWr.String(std::string_view(string, length));
+	if (hasDelta) {
+		fWr.Key("delta"); fWr.StartMap(2);
+		fWr.Key("nonspace"); fWr.Float(delta.nonspace);
+		fWr.Key("space"); fWr.Float(delta.space);
+		fWr.EndMap();
+	}
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawString(const char* string,
+							int32 length, const BPoint* locations,
+							int32 locationCount)
+{
+	fWr.StartMap(1);
+	fWr.Key("DRAW_STRING_LOCATIONS");
+	fWr.StartMap(2);
+	fWr.Key("locations"); fWr.PointArray(locations, locationCount);
+	fWr.Key("string"); fWr.String(std::string_view(string, length));
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawBitmap(const BRect& srcRect,
+							const BRect& dstRect, int32 width,
+							int32 height,
+							int32 bytesPerRow,
+							int32 colorSpace,
+							int32 flags,
+							const void* data, int32 length)
+{
+	fWr.StartMap(1);
+	fWr.Key("DRAW_PIXELS");
+	fWr.StartMap(8);
+	fWr.Key("sourceRect"); WriteRect(srcRect);
+	fWr.Key("destinationRect"); WriteRect(dstRect);
+	fWr.Key("width"); fWr.Int(width);
+	fWr.Key("height"); fWr.Int(height);
+	fWr.Key("bytesPerRow"); fWr.Int(bytesPerRow);
+	fWr.Key("colorSpace"); fWr.Int(colorSpace);
+	fWr.Key("flags"); fWr.Int(flags);
+	fWr.Key("data"); fWr.Binary(data, length);
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::DrawPicture(const BPoint& where,
+							int32 token)
+{
+	fWr.StartMap(1);
+	fWr.Key("DRAW_PICTURE");
+	fWr.StartMap(2);
+	fWr.Key("where"); fWr.Point(where);
+	fWr.Key("token"); fWr.Int(token);
+	fWr.EndMap();
+	fWr.EndMap();
+}
+
+
+template<typename Encoder>
+void PictureWriterStructured<Encoder>::BlendLayer(Layer* layer)
+{
+	fWr.StartMap(1);
+	fWr.Key("BLEND_LAYER");
+	fWr.StartMap(0);
+	// Layer content is not available to visitors, only marker is written.
+	fWr.EndMap();
+	fWr.EndMap();
+}
@@ -2,11 +2,14 @@
 
 #include <algorithm>
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <View.h>
 #include <Bitmap.h>
+#include <Picture.h>
 #include <GradientLinear.h>
 #include <GradientRadial.h>
 #include <GradientRadialFocus.h>
@@ -19,7 +22,21 @@
 
 
 PictureWriterView::PictureWriterView(BView &view):
-	fView(view)
+	fView(view),
+	fBatchKind(BatchKind::None),
+	fBatchCount(0)
+{
+	fState = {
+		.drawingMode = view.DrawingMode(),
+		.highColor = view.HighColor(),
+		.lowColor = view.LowColor(),
+		.pattern = B_SOLID_HIGH,
+		.scale = view.Scale(),
+		.isTransformIdentity = view.Transform().IsIdentity()
+	};
+}
+
+PictureWriterView::~PictureWriterView()
 {
 }
 
@@ -50,25 +67,118 @@ void PictureWriterView::CheckStatus(status_t status)
 	}
 }
 
+BPicture *PictureWriterView::LookupPicture(int32 token)
+{
+	Check(!fPictureStack.empty());
+	PictureLevel &level = fPictureStack.back();
+	Check(token >= 0 && (size_t)token < level.pictures.size());
+	return level.pictures[token];
+}
+
+
+bool PictureWriterView::IsSolidPattern(rgb_color &color) const
+{
+	if (memcmp(&fState.pattern, &B_SOLID_HIGH, sizeof(::pattern)) == 0) {
+		color = fState.highColor;
+		return true;
+	}
+	if (memcmp(&fState.pattern, &B_SOLID_LOW, sizeof(::pattern)) == 0) {
+		color = fState.lowColor;
+		return true;
+	}
+	return false;
+}
+
+// Overlapping parts of merged primitives are drawn once instead of multiple
+// times, that gives the same result only for modes that do not read the
+// destination.
+bool PictureWriterView::IsOverdrawSafe() const
+{
+	return fState.drawingMode == B_OP_COPY || fState.drawingMode == B_OP_OVER;
+}
+
+void PictureWriterView::BeginBatch(BatchKind kind)
+{
+	if (fBatchKind != kind) {
+		FlushBatch();
+		fBatchKind = kind;
+	}
+}
+
+void PictureWriterView::FlushBatch()
+{
+	switch (fBatchKind) {
+		case BatchKind::None:
+			return;
+		case BatchKind::Lines:
+			fView.BeginLineArray(fBatchLines.size());
+			for (const BatchLine &line: fBatchLines) {
+				fView.AddLine(line.start, line.end, line.color);
+			}
+			fView.EndLineArray();
+			// StrokeLine() leaves pen at the end point, line array does not.
+			fView.MovePenTo(fBatchLines.back().end);
+			fBatchLines.clear();
+			break;
+		case BatchKind::FillRects:
+			fView.FillRegion(&fBatchRegion, fState.pattern);
+			fBatchRegion.MakeEmpty();
+			break;
+		case BatchKind::StrokePolygons:
+			fView.StrokeShape(&fBatchShape, fState.pattern);
+			fBatchShape.Clear();
+			break;
+		case BatchKind::FillPolygons:
+			fView.FillShape(&fBatchShape, fState.pattern);
+			fBatchShape.Clear();
+			fBatchBounds.clear();
+			break;
+	}
+	fBatchKind = BatchKind::None;
+	fBatchCount = 0;
+}
+
 
 // #pragma mark - Meta
 
 void PictureWriterView::EnterPicture(int32 version, int32 endian)
 {
+	FlushBatch();
+	BPicture *recording = NULL;
+	if (!fPictureStack.empty()) {
+		fPictures.emplace_back(new BPicture());
+		recording = fPictures.back().get();
+		fView.PushState();
+		fView.BeginPicture(recording);
+	}
+	fPictureStack.push_back({
+		.recording = recording,
+		.savedState = fState,
+		.savedStateDepth = fStateStack.size()
+	});
 }
 
 void PictureWriterView::ExitPicture()
 {
+	FlushBatch();
+	PictureLevel &level = fPictureStack.back();
+	BPicture *recording = level.recording;
+	Check(fStateStack.size() == level.savedStateDepth);
+	fState = level.savedState;
+	fPictureStack.pop_back();
+	if (recording != NULL) {
+		fView.EndPicture();
+		fView.PopState();
+		fPictureStack.back().pictures.push_back(recording);
+	}
 }
 
 void PictureWriterView::EnterPictures(int32 count)
 {
-	RaiseUnimplemented();
 }
 
 void PictureWriterView::ExitPictures()
 {
-	RaiseUnimplemented();
 }
 
 void PictureWriterView::EnterOps()
@@ -77,6 +187,7 @@ void PictureWriterView::EnterOps()
 
 void PictureWriterView::ExitOps()
 {
+	FlushBatch();
 }
 
 
@@ -98,12 +209,18 @@ void PictureWriterView::ExitFontState()
 
 void PictureWriterView::PushState()
 {
+	FlushBatch();
 	fView.PushState();
+	fStateStack.push_back(fState);
 }
 
 void PictureWriterView::PopState()
 {
+	FlushBatch();
 	fView.PopState();
+	Check(!fStateStack.empty());
+	fState = fStateStack.back();
+	fStateStack.pop_back();
 }
 
 
@@ -111,7 +228,9 @@ void PictureWriterView::PopState()
 
 void PictureWriterView::SetDrawingMode(drawing_mode mode)
 {
+	FlushBatch();
 	fView.SetDrawingMode(mode);
+	fState.drawingMode = mode;
 }
 
 void PictureWriterView::SetLineMode(
@@ -120,38 +239,56 @@ void PictureWriterView::SetLineMode(
 	float miterLimit
 )
 {
+	FlushBatch();
 	fView.SetLineMode(cap, join, miterLimit);
 }
 
 void PictureWriterView::SetPenSize(float penSize)
 {
+	FlushBatch();
 	fView.SetPenSize(penSize);
 }
 
+// Lines in batch carry their own colors, so color and pattern changes do not
+// need to flush them.
+
 void PictureWriterView::SetHighColor(const rgb_color& color)
 {
+	if (fBatchKind != BatchKind::Lines) {
+		FlushBatch();
+	}
 	fView.SetHighColor(color);
+	fState.highColor = color;
 }
 
 void PictureWriterView::SetLowColor(const rgb_color& color)
 {
+	if (fBatchKind != BatchKind::Lines) {
+		FlushBatch();
+	}
 	fView.SetLowColor(color);
+	fState.lowColor = color;
 }
 
 void PictureWriterView::SetPattern(const ::pattern& pat)
 {
-	fPattern = pat;
+	if (fBatchKind != BatchKind::Lines) {
+		FlushBatch();
+	}
+	fState.pattern = pat;
 }
 
 void PictureWriterView::SetBlendingMode(
 	source_alpha srcAlpha, alpha_function alphaFunc
 )
 {
+	FlushBatch();
 	fView.SetBlendingMode(srcAlpha, alphaFunc);
 }
 
 void PictureWriterView::SetFillRule(int32 fillRule)
 {
+	FlushBatch();
 	fView.SetFillRule(fillRule);
 }
 
@@ -160,22 +297,30 @@ void PictureWriterView::SetFillRule(int32 fillRule)
 
 void PictureWriterView::SetOrigin(const BPoint& point)
 {
+	FlushBatch();
 	fView.SetOrigin(point);
 }
 
 void PictureWriterView::SetScale(float scale)
 {
+	FlushBatch();
 	fView.SetScale(scale);
+	// Scale is combined with scale of previous states.
+	fState.scale = scale*(fStateStack.empty() ? 1 : fStateStack.back().scale);
 }
 
 void PictureWriterView::SetPenLocation(const BPoint& point)
 {
+	FlushBatch();
 	fView.MovePenTo(point);
 }
 
 void PictureWriterView::SetTransform(const BAffineTransform& transform)
 {
+	FlushBatch();
 	fView.SetTransform(transform);
+	fState.isTransformIdentity = transform.IsIdentity()
+		&& (fStateStack.empty() || fStateStack.back().isTransformIdentity);
 }
 
 
@@ -183,21 +328,32 @@ void PictureWriterView::SetTransform(const BAffineTransform& transform)
 
 void PictureWriterView::SetClipping(const BRegion& region)
 {
+	FlushBatch();
 	fView.ConstrainClippingRegion(const_cast<BRegion*>(&region));
 }
 
 void PictureWriterView::ClearClipping()
 {
+	FlushBatch();
 	fView.ConstrainClippingRegion(NULL);
 }
 
+// Mask is not cached: app_server rasterizes picture into new alpha mask on
+// each call. Only picture recording is reused.
 void PictureWriterView::ClipToPicture(int32 pictureToken, const BPoint& origin, bool inverse)
 {
-	RaiseUnimplemented();
+	FlushBatch();
+	BPicture *picture = LookupPicture(pictureToken);
+	if (inverse) {
+		fView.ClipToInversePicture(picture, origin, false);
+	} else {
+		fView.ClipToPicture(picture, origin, false);
+	}
 }
 
 void PictureWriterView::ClipToRect(const BRect& rect, bool inverse)
 {
+	FlushBatch();
 	if (inverse) {
 		fView.ClipToRect(rect);
 	} else {
@@ -207,6 +363,7 @@ void PictureWriterView::ClipToRect(const BRect& rect, bool inverse)
 
 void PictureWriterView::ClipToShape(const BShape& shape, bool inverse)
 {
+	FlushBatch();
 	if (inverse) {
 		fView.ClipToShape(const_cast<BShape*>(&shape));
 	} else {
@@ -272,22 +429,29 @@ void PictureWriterView::SetFontFace(int32 face)
 
 void PictureWriterView::MovePenBy(float dx, float dy)
 {
+	FlushBatch();
 	fView.MovePenBy(dx, dy);
 }
 
 void PictureWriterView::TranslateBy(double x, double y)
 {
+	FlushBatch();
 	fView.TranslateBy(x, y);
+	fState.isTransformIdentity = false;
 }
 
 void PictureWriterView::ScaleBy(double x, double y)
 {
+	FlushBatch();
 	fView.ScaleBy(x, y);
+	fState.isTransformIdentity = false;
 }
 
 void PictureWriterView::RotateBy(double angleRadians)
 {
+	FlushBatch();
 	fView.RotateBy(angleRadians);
+	fState.isTransformIdentity = false;
 }
 
 
@@ -295,8 +459,18 @@ void PictureWriterView::RotateBy(double angleRadians)
 
 void PictureWriterView::DrawLine(const BPoint& start, const BPoint& end, const DrawGeometryInfo &drawInfo)
 {
+	rgb_color color;
+	if (drawInfo.gradient == NULL && IsSolidPattern(color)) {
+		BeginBatch(BatchKind::Lines);
+		fBatchLines.push_back({.start = start, .end = end, .color = color});
+		if (++fBatchCount >= kMaxBatchCount) {
+			FlushBatch();
+		}
+		return;
+	}
+	FlushBatch();
 	if (drawInfo.gradient == NULL) {
-		fView.StrokeLine(start, end, fPattern);
+		fView.StrokeLine(start, end, fState.pattern);
 	} else {
 		fView.StrokeLine(start, end, *drawInfo.gradient);
 	}
@@ -304,11 +478,28 @@ void PictureWriterView::DrawLine(const BPoint& start, const BPoint& end, const D
 
 void PictureWriterView::DrawRect(const BRect& rect, const DrawGeometryInfo &drawInfo)
 {
+	// Region is pixel based, so only pixel aligned rectangles without
+	// scaling can be merged into it.
+	if (
+		drawInfo.gradient == NULL && !drawInfo.isStroke && IsOverdrawSafe() &&
+		fState.scale == 1 && fState.isTransformIdentity &&
+		rect.IsValid() &&
+		rect.left == floorf(rect.left) && rect.top == floorf(rect.top) &&
+		rect.right == floorf(rect.right) && rect.bottom == floorf(rect.bottom)
+	) {
+		BeginBatch(BatchKind::FillRects);
+		fBatchRegion.Include(rect);
+		if (++fBatchCount >= kMaxBatchCount) {
+			FlushBatch();
+		}
+		return;
+	}
+	FlushBatch();
 	if (drawInfo.gradient == NULL) {
 		if (drawInfo.isStroke) {
-			fView.StrokeRect(rect, fPattern);
+			fView.StrokeRect(rect, fState.pattern);
 		} else {
-			fView.FillRect(rect, fPattern);
+			fView.FillRect(rect, fState.pattern);
 		}
 	} else {
 		if (drawInfo.isStroke) {
@@ -321,11 +512,12 @@ void PictureWriterView::DrawRect(const BRect& rect, const DrawGeometryInfo &draw
 
 void PictureWriterView::DrawRoundRect(const BRect& rect, const BPoint& radius, const DrawGeometryInfo &drawInfo)
 {
+	FlushBatch();
 	if (drawInfo.gradient == NULL) {
 		if (drawInfo.isStroke) {
-			fView.StrokeRoundRect(rect, radius.x, radius.y, fPattern);
+			fView.StrokeRoundRect(rect, radius.x, radius.y, fState.pattern);
 		} else {
-			fView.FillRoundRect(rect, radius.x, radius.y, fPattern);
+			fView.FillRoundRect(rect, radius.x, radius.y, fState.pattern);
 		}
 	} else {
 		if (drawInfo.isStroke) {
@@ -338,11 +530,12 @@ void PictureWriterView::DrawRoundRect(const BRect& rect, const BPoint& radius, c
 
 void PictureWriterView::DrawBezier(const BPoint points[4], const DrawGeometryInfo &drawInfo)
 {
+	FlushBatch();
 	if (drawInfo.gradient == NULL) {
 		if (drawInfo.isStroke) {
-			fView.StrokeBezier(const_cast<BPoint*>(points), fPattern);
+			fView.StrokeBezier(const_cast<BPoint*>(points), fState.pattern);
 		} else {
-			fView.FillBezier(const_cast<BPoint*>(points), fPattern);
+			fView.FillBezier(const_cast<BPoint*>(points), fState.pattern);
 		}
 	} else {
 		if (drawInfo.isStroke) {
@@ -355,11 +548,48 @@ void PictureWriterView::DrawBezier(const BPoint points[4], const DrawGeometryInf
 
 void PictureWriterView::DrawPolygon(int32 numPoints, const BPoint* points, bool isClosed, const DrawGeometryInfo &drawInfo)
 {
+	if (drawInfo.gradient == NULL && numPoints > 0 && IsOverdrawSafe()) {
+		if (drawInfo.isStroke) {
+			BeginBatch(BatchKind::StrokePolygons);
+		} else {
+			// Overlapping subpaths of one shape interact through fill rule,
+			// so only polygons with disjoint bounds are merged.
+			BRect bounds(points[0], points[0]);
+			for (int32 i = 1; i < numPoints; i++) {
+				bounds.left = std::min(bounds.left, points[i].x);
+				bounds.top = std::min(bounds.top, points[i].y);
+				bounds.right = std::max(bounds.right, points[i].x);
+				bounds.bottom = std::max(bounds.bottom, points[i].y);
+			}
+			if (fBatchKind == BatchKind::FillPolygons) {
+				for (const BRect &other: fBatchBounds) {
+					if (other.Intersects(bounds)) {
+						FlushBatch();
+						break;
+					}
+				}
+			}
+			BeginBatch(BatchKind::FillPolygons);
+			fBatchBounds.push_back(bounds);
+		}
+		fBatchShape.MoveTo(points[0]);
+		for (int32 i = 1; i < numPoints; i++) {
+			fBatchShape.LineTo(points[i]);
+		}
+		if (isClosed || !drawInfo.isStroke) {
+			fBatchShape.Close();
+		}
+		if (++fBatchCount >= kMaxBatchCount) {
+			FlushBatch();
+		}
+		return;
+	}
+	FlushBatch();
 	if (drawInfo.gradient == NULL) {
 		if (drawInfo.isStroke) {
-			fView.StrokePolygon(points, numPoints, isClosed, fPattern);
+			fView.StrokePolygon(points, numPoints, isClosed, fState.pattern);
 		} else {
-			fView.FillPolygon(points, numPoints, fPattern);
+			fView.FillPolygon(points, numPoints, fState.pattern);
 		}
 	} else {
 		if (drawInfo.isStroke) {
@@ -372,11 +602,12 @@ void PictureWriterView::DrawPolygon(int32 numPoints, const BPoint* points, bool
 
 void PictureWriterView::DrawShape(const BShape& shape, const DrawGeometryInfo &drawInfo)
 {
+	FlushBatch();
 	if (drawInfo.gradient == NULL) {
 		if (drawInfo.isStroke) {
-			fView.StrokeShape(const_cast<BShape*>(&shape), fPattern);
+			fView.StrokeShape(const_cast<BShape*>(&shape), fState.pattern);
 		} else {
-			fView.FillShape(const_cast<BShape*>(&shape), fPattern);
+			fView.FillShape(const_cast<BShape*>(&shape), fState.pattern);
 		}
 	} else {
 		if (drawInfo.isStroke) {
@@ -395,11 +626,12 @@ void PictureWriterView::DrawArc(
 	const DrawGeometryInfo &drawInfo
 )
 {
+	FlushBatch();
 	if (drawInfo.gradient == NULL) {
 		if (drawInfo.isStroke) {
-			fView.StrokeArc(center, radius.x, radius.y, startTheta, arcTheta, fPattern);
+			fView.StrokeArc(center, radius.x, radius.y, startTheta, arcTheta, fState.pattern);
 		} else {
-			fView.FillArc(center, radius.x, radius.y, startTheta, arcTheta, fPattern);
+			fView.FillArc(center, radius.x, radius.y, startTheta, arcTheta, fState.pattern);
 		}
 	} else {
 		if (drawInfo.isStroke) {
@@ -412,11 +644,12 @@ void PictureWriterView::DrawArc(
 
 void PictureWriterView::DrawEllipse(const BRect& rect, const DrawGeometryInfo &drawInfo)
 {
+	FlushBatch();
 	if (drawInfo.gradient == NULL) {
 		if (drawInfo.isStroke) {
-			fView.StrokeEllipse(rect, fPattern);
+			fView.StrokeEllipse(rect, fState.pattern);
 		} else {
-			fView.FillEllipse(rect, fPattern);
+			fView.FillEllipse(rect, fState.pattern);
 		}
 	} else {
 		if (drawInfo.isStroke) {
@@ -435,6 +668,7 @@ void PictureWriterView::DrawString(
 	const escapement_delta& delta
 )
 {
+	FlushBatch();
 	fView.DrawString(string, length, const_cast<escapement_delta*>(&delta));
 }
 
@@ -443,6 +677,7 @@ void PictureWriterView::DrawString(
 	const BPoint* locations, int32 locationCount
 )
 {
+	FlushBatch();
 	fView.DrawString(string, length, locations, locationCount);
 }
 
@@ -457,6 +692,7 @@ void PictureWriterView::DrawBitmap(
 	const void* data, int32 length
 )
 {
+	FlushBatch();
 	BBitmap bitmap(BRect(0, 0, width - 1, height - 1), 0, (color_space)colorSpace);
 	uint8 *dstBits = (uint8*)bitmap.Bits();
 	const uint8 *srcBits = (const uint8*)data;
@@ -471,7 +707,8 @@ void PictureWriterView::DrawBitmap(
 
 void PictureWriterView::DrawPicture(const BPoint& where, int32 token)
 {
-	RaiseUnimplemented();
+	FlushBatch();
+	fView.DrawPicture(LookupPicture(token), where);
 }
 
 
@@ -3,16 +3,72 @@
 #include "PictureVisitor.h"
 
 #include <vector>
+#include <memory>
 #include <string_view>
 
 #include <DataIO.h>
+#include <Region.h>
+#include <Shape.h>
 
 
 class PictureWriterView final: public PictureVisitor {
 private:
+	// Consecutive primitives that can be merged without changing the result
+	// are collected here and submitted to app_server as one drawing call.
+	enum class BatchKind {
+		None,
+		Lines,
+		FillRects,
+		StrokePolygons,
+		FillPolygons,
+	};
+
+	enum {
+		kMaxBatchCount = 256,
+	};
+
+	struct BatchLine {
+		BPoint start;
+		BPoint end;
+		rgb_color color;
+	};
+
+	// View state that decides whether primitive can be batched. It is tracked
+	// here to avoid querying view.
+	struct DrawState {
+		drawing_mode drawingMode;
+		rgb_color highColor;
+		rgb_color lowColor;
+		::pattern pattern;
+		float scale;
+		bool isTransformIdentity;
+	};
+
+	// Sub-pictures are recorded once into BPicture objects and replayed from
+	// there. Token of sub-picture is its index in pictures list of parent.
+	// Recording draws into the same view, so view state and tracked state
+	// are saved before it and restored after it.
+	struct PictureLevel {
+		BPicture *recording;
+		std::vector<BPicture*> pictures;
+		DrawState savedState;
+		size_t savedStateDepth;
+	};
+
 	BView &fView;
 
-	::pattern fPattern;
+	DrawState fState;
+	std::vector<DrawState> fStateStack;
+
+	BatchKind fBatchKind;
+	int32 fBatchCount;
+	std::vector<BatchLine> fBatchLines;
+	BRegion fBatchRegion;
+	BShape fBatchShape;
+	std::vector<BRect> fBatchBounds;
+
+	std::vector<std::unique_ptr<BPicture>> fPictures;
+	std::vector<PictureLevel> fPictureStack;
 
 	void RaiseUnimplemented();
 	void RaiseError();
@@ -22,8 +78,16 @@ private:
 	void BeginChunk(int16 op);
 	void EndChunk();
 
+	BPicture *LookupPicture(int32 token);
+
+	bool IsSolidPattern(rgb_color &color) const;
+	bool IsOverdrawSafe() const;
+	void BeginBatch(BatchKind kind);
+	void FlushBatch();
+
 public:
 	PictureWriterView(BView &fView);
+	~PictureWriterView();
 
 	// Meta
 	void			EnterPicture(int32 version, int32 endian) final;
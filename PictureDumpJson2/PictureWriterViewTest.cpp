@@ -0,0 +1,112 @@
+// Replays picture with nested sub-pictures through PictureWriterView into
+// offscreen bitmap and checks pixels. Sub-pictures change colors, origin and
+// pattern, that must not leak to later ops of outer picture, and they are
+// referenced by index in reverse order of definition.
+
+#include "PictureWriterView.h"
+
+#include <stdio.h>
+
+#include <Application.h>
+#include <Bitmap.h>
+#include <View.h>
+
+
+static int gFailed = 0;
+static int gChecks = 0;
+
+static const rgb_color kWhite = {255, 255, 255, 255};
+static const rgb_color kRed = {255, 0, 0, 255};
+static const rgb_color kGreen = {0, 255, 0, 255};
+static const rgb_color kBlue = {0, 0, 255, 255};
+
+
+static void CheckPixel(BBitmap &bitmap, int32 x, int32 y, rgb_color expected)
+{
+	const uint8 *pixel = (const uint8*)bitmap.Bits() + y*bitmap.BytesPerRow() + 4*x;
+	gChecks++;
+	if (pixel[2] != expected.red || pixel[1] != expected.green || pixel[0] != expected.blue) {
+		printf("FAIL pixel (%" B_PRId32 ", %" B_PRId32 "): %u %u %u, expected %u %u %u\n", x, y,
+			pixel[2], pixel[1], pixel[0], expected.red, expected.green, expected.blue);
+		gFailed++;
+	}
+}
+
+static void FillRect(PictureVisitor &vis, BRect rect)
+{
+	vis.DrawRect(rect, {.isStroke = false, .gradient = NULL});
+}
+
+// Sub-picture 0 fills red rectangle at its origin, sub-picture 1 fills
+// green one. Both change state without restoring it.
+static void VisitPicture(PictureVisitor &vis)
+{
+	vis.EnterPicture(2, B_HOST_IS_BENDIAN);
+	vis.EnterPictures(2);
+
+	vis.EnterPicture(2, B_HOST_IS_BENDIAN);
+	vis.EnterOps();
+	vis.SetHighColor(kRed);
+	vis.SetOrigin(BPoint(40, 0));
+	FillRect(vis, BRect(0, 0, 9, 9));
+	vis.ExitOps();
+	vis.ExitPicture();
+
+	vis.EnterPicture(2, B_HOST_IS_BENDIAN);
+	vis.EnterOps();
+	vis.SetHighColor(kGreen);
+	vis.SetPenSize(5);
+	vis.SetPattern(B_SOLID_LOW);
+	vis.SetLowColor(kGreen);
+	FillRect(vis, BRect(0, 0, 9, 9));
+	vis.ExitOps();
+	vis.ExitPicture();
+
+	vis.ExitPictures();
+
+	vis.EnterOps();
+	vis.SetHighColor(kBlue);
+	vis.DrawPicture(BPoint(0, 20), 1);
+	vis.DrawPicture(BPoint(0, 40), 0);
+	// Blue rectangles are batched into region before and after nested
+	// picture is drawn.
+	FillRect(vis, BRect(0, 0, 9, 9));
+	vis.DrawPicture(BPoint(0, 60), 1);
+	FillRect(vis, BRect(20, 0, 29, 9));
+	vis.ExitOps();
+	vis.ExitPicture();
+}
+
+
+int main()
+{
+	BApplication app("application/x-vnd.Test.PictureWriterViewTest");
+
+	BBitmap bitmap(BRect(0, 0, 99, 99), B_BITMAP_ACCEPTS_VIEWS, B_RGBA32);
+	BView *view = new BView(bitmap.Bounds(), "view", B_FOLLOW_NONE, B_WILL_DRAW);
+	bitmap.AddChild(view);
+	bitmap.Lock();
+	view->SetHighColor(kWhite);
+	view->FillRect(view->Bounds());
+	view->SetHighColor(0, 0, 0);
+	{
+		PictureWriterView vis(*view);
+		VisitPicture(vis);
+	}
+	view->Sync();
+
+	// Outer ops keep blue color and zero origin.
+	CheckPixel(bitmap, 5, 5, kBlue);
+	CheckPixel(bitmap, 25, 5, kBlue);
+	CheckPixel(bitmap, 45, 5, kWhite);
+	// Token 1 is green picture, token 0 is red one drawn at its own origin.
+	CheckPixel(bitmap, 5, 25, kGreen);
+	CheckPixel(bitmap, 45, 45, kRed);
+	CheckPixel(bitmap, 5, 45, kWhite);
+	CheckPixel(bitmap, 5, 65, kGreen);
+
+	bitmap.Unlock();
+
+	printf("PictureWriterViewTest: %d checks, %d failed\n", gChecks, gFailed);
+	return gFailed == 0 ? 0 : 1;
+}
@@ -3,12 +3,18 @@
 #include <View.h>
 #include <Rect.h>
 #include <Picture.h>
+#include <Bitmap.h>
 #include <Entry.h>
 #include <File.h>
 #include <stdio.h>
 #include <math.h>
 
+#include <vector>
+
 #include <private/shared/AutoDeleter.h>
+#include <private/shared/AutoLocker.h>
+
+#include "TileCache.h"
 
 enum {
 	appWindowClosedMsg = 1,
@@ -28,6 +34,7 @@ class TestView: public BView
 {
 private:
 	ObjectDeleter<BPicture> fPict;
+	ObjectDeleter<TileCache> fTiles;
 	BPoint fOffset;
 	float fScale;
 	float fRotation;
@@ -46,18 +53,132 @@ public:
 
 	void SetPicture(BPicture *pict)
 	{
+		fTiles.Unset();
 		fPict.SetTo(pict);
+		if (pict != NULL) {
+			// Renderer thread gets its own copy of the picture.
+			fTiles.SetTo(new TileCache(new BPicture(*pict), BMessenger(this)));
+		}
 		Invalidate();
 	}
 
+	// Tiles of zoom level are placed at view coordinates
+	// TileOrigin() + (x, y)*kTileSize*TileRatio(level).
+	BPoint TileOrigin()
+	{
+		return BPoint(roundf(fScale*fOffset.x), roundf(fScale*fOffset.y));
+	}
+
+	float TileRatio(int32 level)
+	{
+		return fScale/TileCache::LevelScale(level);
+	}
+
+	BRect TileRect(const TileKey &key)
+	{
+		BPoint origin = TileOrigin();
+		float size = TileCache::kTileSize*TileRatio(key.level);
+		BRect rect(0, 0, size - 1, size - 1);
+		rect.OffsetTo(origin.x + key.x*size, origin.y + key.y*size);
+		return rect;
+	}
+
+	void TileRange(int32 level, BRect rect, int32 &x0, int32 &y0, int32 &x1, int32 &y1)
+	{
+		BPoint origin = TileOrigin();
+		float size = TileCache::kTileSize*TileRatio(level);
+		x0 = (int32)floorf((rect.left - origin.x)/size);
+		y0 = (int32)floorf((rect.top - origin.y)/size);
+		x1 = (int32)floorf((rect.right - origin.x)/size);
+		y1 = (int32)floorf((rect.bottom - origin.y)/size);
+	}
+
+	// Blits cached tiles of current zoom level. Missing tiles are requested
+	// from renderer and meanwhile filled with scaled tiles of nearest zoom
+	// level that has any.
+	void DrawTiles(BRect dirty)
+	{
+		int32 level = TileCache::ZoomLevel(fScale);
+		int32 x0, y0, x1, y1;
+
+		AutoLocker<TileCache> lock(fTiles.Get());
+
+		std::vector<TileKey> requests;
+		TileRange(level, Bounds(), x0, y0, x1, y1);
+		for (int32 y = y0; y <= y1; y++) {
+			for (int32 x = x0; x <= x1; x++) {
+				TileKey key = {.level = level, .x = x, .y = y};
+				if (fTiles->Lookup(key) == NULL) {
+					requests.push_back(key);
+				}
+			}
+		}
+		fTiles->Request(requests);
+
+		BRect missing;
+		std::vector<std::pair<BBitmap*, BRect>> hits;
+		TileRange(level, dirty, x0, y0, x1, y1);
+		for (int32 y = y0; y <= y1; y++) {
+			for (int32 x = x0; x <= x1; x++) {
+				TileKey key = {.level = level, .x = x, .y = y};
+				BBitmap *bitmap = fTiles->Lookup(key);
+				if (bitmap != NULL) {
+					hits.emplace_back(bitmap, TileRect(key));
+				} else if (!missing.IsValid()) {
+					missing = TileRect(key);
+				} else {
+					missing = missing | TileRect(key);
+				}
+			}
+		}
+
+		if (missing.IsValid()) {
+			missing = missing & dirty;
+			for (int32 dist = 1; dist <= 4; dist++) {
+				bool found = false;
+				for (int32 fallbackLevel: {level - dist, level + dist}) {
+					TileRange(fallbackLevel, missing, x0, y0, x1, y1);
+					for (int32 y = y0; y <= y1; y++) {
+						for (int32 x = x0; x <= x1; x++) {
+							TileKey key = {.level = fallbackLevel, .x = x, .y = y};
+							BBitmap *bitmap = fTiles->Lookup(key);
+							if (bitmap != NULL) {
+								DrawBitmapAsync(bitmap, bitmap->Bounds(), TileRect(key), B_FILTER_BITMAP_BILINEAR);
+								found = true;
+							}
+						}
+					}
+					if (found) {
+						break;
+					}
+				}
+				if (found) {
+					break;
+				}
+			}
+		}
+
+		for (const auto &hit: hits) {
+			DrawBitmapAsync(hit.first, hit.second);
+		}
+		// Tiles can be dropped from cache after unlocking, make sure that
+		// app_server is done with them.
+		Sync();
+	}
+
 	void Draw(BRect dirty)
 	{
-		if (fPict.Get() != NULL) {
-			ScaleBy(fScale, fScale);
-			RotateBy(fRotation);
-			TranslateBy(fOffset.x, fOffset.y);
-			DrawPicture(fPict.Get());
+		if (fPict.Get() == NULL) {
+			return;
+		}
+		if (fTiles.Get() != NULL && fRotation == 0) {
+			DrawTiles(dirty);
+			return;
 		}
+		ScaleBy(fScale, fScale);
+		RotateBy(fRotation);
+		TranslateBy(fOffset.x, fOffset.y);
+		DrawPicture(fPict.Get());
 	}
 
 	void MouseDown(BPoint where)
@@ -91,6 +212,18 @@ public:
 	void MessageReceived(BMessage *msg)
 	{
 		switch (msg->what) {
+		case tileReadyMsg: {
+			TileKey key;
+			if (
+				msg->FindInt32("level", &key.level) < B_OK ||
+				msg->FindInt32("x", &key.x) < B_OK ||
+				msg->FindInt32("y", &key.y) < B_OK
+			)
+				return;
+			if (key.level == TileCache::ZoomLevel(fScale))
+				Invalidate(TileRect(key));
+			break;
+		}
 		case B_MOUSE_WHEEL_CHANGED: {
 			float deltaY = 0;
 			if (msg->FindFloat("be:wheel_delta_y", &deltaY) != B_OK || deltaY == 0)
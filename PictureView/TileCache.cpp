@@ -0,0 +1,161 @@
+#include "TileCache.h"
+
+#include <math.h>
+
+#include <AffineTransform.h>
+#include <Autolock.h>
+#include <Bitmap.h>
+#include <Message.h>
+#include <Picture.h>
+#include <View.h>
+
+
+static const bigtime_t kSendTimeout = 100000;
+
+TileCache::TileCache(BPicture *picture, const BMessenger &target, size_t memoryBudget):
+	fLocker("tile cache"),
+	fPicture(picture),
+	fTarget(target),
+	fMemoryBudget(memoryBudget),
+	fMemoryUsed(0),
+	fNextRequest(0),
+	fQuitting(false)
+{
+	fRequestSem = create_sem(0, "tile requests");
+	fThread = spawn_thread(ThreadEntry, "tile renderer", B_LOW_PRIORITY, this);
+	resume_thread(fThread);
+}
+
+TileCache::~TileCache()
+{
+	{
+		BAutolock lock(fLocker);
+		fQuitting = true;
+	}
+	release_sem(fRequestSem);
+	status_t res;
+	wait_for_thread(fThread, &res);
+	delete_sem(fRequestSem);
+	for (Tile &tile: fTiles) {
+		delete tile.bitmap;
+	}
+}
+
+
+int32 TileCache::ZoomLevel(float scale)
+{
+	return (int32)roundf(2*log2f(scale));
+}
+
+float TileCache::LevelScale(int32 level)
+{
+	return powf(2, level/2.0f);
+}
+
+
+BBitmap *TileCache::Lookup(const TileKey &key)
+{
+	auto it = fTileIndex.find(key);
+	if (it == fTileIndex.end()) {
+		return NULL;
+	}
+	fTiles.splice(fTiles.begin(), fTiles, it->second);
+	return it->second->bitmap;
+}
+
+void TileCache::Request(const std::vector<TileKey> &keys)
+{
+	fRequests = keys;
+	fNextRequest = 0;
+	release_sem(fRequestSem);
+}
+
+void TileCache::Insert(const TileKey &key, BBitmap *bitmap)
+{
+	fTiles.push_front({.key = key, .bitmap = bitmap});
+	fTileIndex[key] = fTiles.begin();
+	fMemoryUsed += bitmap->BitsLength();
+	while (fMemoryUsed > fMemoryBudget && fTiles.size() > 1) {
+		Tile &tile = fTiles.back();
+		fMemoryUsed -= tile.bitmap->BitsLength();
+		fTileIndex.erase(tile.key);
+		delete tile.bitmap;
+		fTiles.pop_back();
+	}
+}
+
+
+status_t TileCache::ThreadEntry(void *arg)
+{
+	((TileCache*)arg)->Run();
+	return B_OK;
+}
+
+void TileCache::Run()
+{
+	BBitmap canvas(BRect(0, 0, kTileSize - 1, kTileSize - 1), B_BITMAP_ACCEPTS_VIEWS, B_RGBA32);
+	BView *view = new BView(canvas.Bounds(), "tile", B_FOLLOW_NONE, B_SUBPIXEL_PRECISE);
+	canvas.AddChild(view);
+
+	for (;;) {
+		while (acquire_sem(fRequestSem) == B_INTERRUPTED) {}
+		for (;;) {
+			TileKey key;
+			{
+				BAutolock lock(fLocker);
+				if (fQuitting) {
+					return;
+				}
+				if (fNextRequest >= fRequests.size()) {
+					break;
+				}
+				key = fRequests[fNextRequest++];
+				if (fTileIndex.find(key) != fTileIndex.end()) {
+					continue;
+				}
+			}
+			BBitmap *bitmap = Render(canvas, view, key);
+			{
+				BAutolock lock(fLocker);
+				Insert(key, bitmap);
+			}
+			BMessage msg(tileReadyMsg);
+			msg.AddInt32("level", key.level);
+			msg.AddInt32("x", key.x);
+			msg.AddInt32("y", key.y);
+			// Destructor waits for this thread with window locked, so sending
+			// must not block forever if port of target is full.
+			for (;;) {
+				status_t res = fTarget.SendMessage(&msg, (BHandler*)NULL, kSendTimeout);
+				if (res != B_TIMED_OUT && res != B_WOULD_BLOCK) {
+					break;
+				}
+				BAutolock lock(fLocker);
+				if (fQuitting) {
+					return;
+				}
+			}
+		}
+	}
+}
+
+BBitmap *TileCache::Render(BBitmap &canvas, BView *view, const TileKey &key)
+{
+	float scale = LevelScale(key.level);
+	BAffineTransform transform;
+	transform.ScaleBy(scale, scale);
+	transform.TranslateBy(-(double)key.x*kTileSize, -(double)key.y*kTileSize);
+
+	canvas.Lock();
+	view->SetTransform(BAffineTransform());
+	view->SetHighColor(255, 255, 255);
+	view->FillRect(view->Bounds());
+	view->SetTransform(transform);
+	view->DrawPicture(fPicture.Get());
+	view->Sync();
+	canvas.Unlock();
+
+	BBitmap *tile = new BBitmap(canvas.Bounds(), 0, B_RGBA32);
+	tile->ImportBits(&canvas);
+	return tile;
+}
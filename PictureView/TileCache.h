@@ -0,0 +1,97 @@
+#pragma once
+
+#include <SupportDefs.h>
+#include <OS.h>
+#include <Locker.h>
+#include <Messenger.h>
+#include <Rect.h>
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+#include <private/shared/AutoDeleter.h>
+
+class BBitmap;
+class BPicture;
+class BView;
+
+
+enum {
+	tileReadyMsg = 'tlrd',
+};
+
+
+struct TileKey {
+	int32 level;
+	int32 x;
+	int32 y;
+
+	bool operator==(const TileKey &other) const
+	{
+		return level == other.level && x == other.x && y == other.y;
+	}
+};
+
+struct TileKeyHash {
+	size_t operator()(const TileKey &key) const
+	{
+		return ((size_t)(uint32)key.level * 73856093) ^ ((size_t)(uint32)key.x * 19349663) ^ ((size_t)(uint32)key.y * 83492791);
+	}
+};
+
+
+// Renders picture into fixed size bitmap tiles on background thread. Zoom
+// levels are sqrt(2) steps, tile (level, x, y) covers picture area scaled by
+// LevelScale(level) starting at (x, y)*kTileSize. Tiles are kept up to
+// memory budget, least recently used ones are dropped first. tileReadyMsg
+// with "level", "x" and "y" fields is sent to target when tile is rendered.
+//
+// Lookup() and Request() must be called with cache locked.
+class TileCache {
+public:
+	enum {
+		kTileSize = 256,
+	};
+
+private:
+	struct Tile {
+		TileKey key;
+		BBitmap *bitmap;
+	};
+	typedef std::list<Tile> TileList;
+
+	BLocker fLocker;
+	ObjectDeleter<BPicture> fPicture;
+	BMessenger fTarget;
+	size_t fMemoryBudget;
+	size_t fMemoryUsed;
+	TileList fTiles; // most recently used first
+	std::unordered_map<TileKey, TileList::iterator, TileKeyHash> fTileIndex;
+
+	std::vector<TileKey> fRequests;
+	size_t fNextRequest;
+	bool fQuitting;
+	sem_id fRequestSem;
+	thread_id fThread;
+
+	static status_t ThreadEntry(void *arg);
+	void Run();
+	BBitmap *Render(BBitmap &canvas, BView *view, const TileKey &key);
+	void Insert(const TileKey &key, BBitmap *bitmap);
+
+public:
+	TileCache(BPicture *picture, const BMessenger &target, size_t memoryBudget = 64*1024*1024);
+	~TileCache();
+
+	static int32 ZoomLevel(float scale);
+	static float LevelScale(int32 level);
+
+	bool Lock() {return fLocker.Lock();}
+	void Unlock() {fLocker.Unlock();}
+
+	BBitmap *Lookup(const TileKey &key);
+	// Replaces pending requests, tiles that are no longer requested are not
+	// rendered.
+	void Request(const std::vector<TileKey> &keys);
+};
@@ -3,12 +3,15 @@
 #include <Window.h>
 #include <View.h>
 #include <MessageRunner.h>
+#include <Roster.h>
 #include <MenuBar.h>
 #include <MenuItem.h>
 #include <LayoutBuilder.h>
 #include <Rect.h>
 #include <OS.h>
+#include <String.h>
 #include <StringList.h>
+#include <StringView.h>
 #include <private/app/LaunchRoster.h>
 #include <private/interface/ColumnListView.h>
 #include <private/interface/ColumnTypes.h>
@@ -20,13 +23,20 @@
 #include <Entry.h>
 #include <NodeInfo.h>
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "Resources.h"
+#include "IconCache.h"
+#include "RowFields.h"
 
 enum {
 	invokeMsg = 1,
 	selectMsg,
 
 	updateMsg,
+	updateJobMsg,
 
 	startMsg,
 	stopMsg,
@@ -34,6 +44,13 @@ enum {
 	enableMsg
 };
 
+enum {
+	// Changes are applied from events, full refresh only catches missed ones.
+	kReconcileInterval = 5000000,
+	// launch_daemon updates job state asynchronously after request.
+	kRecheckDelay = 50000,
+};
+
 enum {
 	nameCol,
 	kindCol,
@@ -63,11 +80,16 @@ public:
 class IconStringField: public BStringField
 {
 private:
-	ObjectDeleter<BBitmap> fIcon;
+	BReference<IconCache::Icon> fIcon;
+	BString fPath;
 
 public:
-	IconStringField(BBitmap *icon, const char *string): BStringField(string), fIcon(icon) {}
-	BBitmap *Icon() {return fIcon.Get();}
+	IconStringField(IconCache::Icon *icon, const char *string, const char *path = NULL): BStringField(string), fIcon(icon), fPath(path) {}
+	BBitmap *Icon() {return fIcon->Bitmap();}
+	IconCache::Icon *GetIcon() {return fIcon.Get();}
+	void SetIcon(IconCache::Icon *icon) {fIcon.SetTo(icon);}
+	const BString &Path() {return fPath;}
+	void SetPath(const char *path) {fPath = path;}
 };
 
 class IconStringColumn: public BStringColumn
@@ -104,174 +126,240 @@ public:
 };
 
 
-static BRow *FindStringRow(BColumnListView *view, BRow *parent, const char *str)
-{
+struct TargetRows {
 	BRow *row;
+	std::unordered_map<std::string, BRow*> jobs;
+};
+
+// Rows of targets and their jobs by name.
+struct ServicesList {
+	BColumnListView *view;
+	std::unordered_map<std::string, TargetRows> targets;
+	int32 jobCount;
+};
+
+struct JobInfo {
 	BString name;
-	for (int32 i = 0; i < view->CountRows(parent); i++) {
-		row = view->RowAt(i, parent);
-		name = ((BStringField*)row->GetField(nameCol))->String();
-		if (name == BString(str))
-			return row;
-	}
-	return NULL;
-}
+	BMessage info;
+};
 
-static void ListJobs(BColumnListView *view, BRow *parent, const char *target, BStringList &jobs)
+
+static const char *kNoTarget = "<no target>";
+
+
+// Gets info of each job once and groups jobs by target, jobs without target
+// are grouped under "".
+static void FetchJobs(std::unordered_map<std::string, std::vector<JobInfo>> &targetJobs, int32 &jobCount)
 {
 	BLaunchRoster roster;
-	BRow *row;
-	BStringList prevNames;
-	BMessage info;
-	bool boolVal;
-	BString strVal;
-	team_id team;
+	BStringList jobs;
 	status_t status;
 
-	for (int32 i = 0; i < view->CountRows(parent); i++) {
-		row = view->RowAt(i, parent);
-		prevNames.Add(((BStringField*)row->GetField(nameCol))->String());
-	}
-
+	jobCount = 0;
+	roster.GetJobs(NULL, jobs);
 	for (int32 i = 0; i < jobs.CountStrings(); i++) {
-		const char *name = jobs.StringAt(i).String();
-		prevNames.Remove(name);
-		if ((status = roster.GetJobInfo(name, info)) != B_OK) {
-			printf("%s: can't get info (%d)\n", name, status);
+		JobInfo job;
+		job.name = jobs.StringAt(i);
+		if ((status = roster.GetJobInfo(job.name, job.info)) != B_OK) {
+			printf("%s: can't get info (%d)\n", job.name.String(), status);
 			continue;
 		}
+		const char *target;
+		if (job.info.FindString("target", &target) < B_OK) target = "";
+		targetJobs[target].push_back(std::move(job));
+		jobCount++;
+	}
+}
 
-		const char *curTarget;
-		if (info.FindString("target", &curTarget) < B_OK) curTarget = "";
-
-		if (!(
-			((target == NULL) && (curTarget == NULL)) ||
-			((target != NULL) && (curTarget != NULL) && (strcmp(target, curTarget) == 0))
-		)) continue;
-
-		row = FindStringRow(view, parent, name);
-
-		if (row == NULL) {
-			row = new BRow();
-			view->AddRow(row, parent);
-		}
+static const char *BoolString(const BMessage &info, const char *name, const char *trueStr, const char *falseStr)
+{
+	bool boolVal;
+	if (info.FindBool(name, &boolVal) != B_OK)
+		return "-";
+	return boolVal ? trueStr : falseStr;
+}
 
-		BBitmap* icon = new BBitmap(BRect(0, 0, B_MINI_ICON - 1, B_MINI_ICON - 1), B_RGBA32);
+static bool SetJobFields(BRow *row, const char *name, const BMessage &info)
+{
+	bool changed = false;
+	BString strVal;
+	team_id team;
 
-		const char *path;
-		BEntry entry;
-		entry_ref ref;
+	const char *path;
+	if (info.FindString("launch", &path) < B_OK) path = NULL;
 
-		status = info.FindString("launch", &path);
+	IconStringField *nameField = static_cast<IconStringField*>(row->GetField(nameCol));
+	if (nameField == NULL || nameField->Path() != BString(path)) {
+		row->SetField(new IconStringField(IconCache::Default().Get(path).Get(), name, path), nameCol);
+		changed = true;
+	}
 
-		if (status == B_OK) {
-			entry.SetTo(path, true);
-			status = entry.GetRef(&ref);
-		}
+	changed |= SetStringField(row, kindCol, BoolString(info, "service", "service", "job"));
+	changed |= SetStringField(row, enabledCol, BoolString(info, "enabled", "yes", "no"));
+	changed |= SetStringField(row, runningCol, BoolString(info, "running", "yes", "no"));
+
+	const char *arg;
+	strVal = "";
+	for (int32 j = 0; info.FindString("launch", j, &arg) >= B_OK; j++) {
+		if (j > 0) strVal += " ";
+		size_t k = 0; while (arg[k] != '\0' && !(arg[k] == ' ')) k++;
+		bool needQuotes = arg[k] != '\0';
+		if (needQuotes) strVal += '"';
+		strVal += arg;
+		if (needQuotes) strVal += '"';
+	}
+	changed |= SetStringField(row, launchCol, strVal);
+	if (info.FindInt32("team", &team) != B_OK)
+		team = -1;
+	changed |= SetIntField(row, pidCol, team);
+
+	strVal = "";
+	for (int32 j = 0; info.FindString("requires", j, &arg) >= B_OK; j++) {
+		if (j > 0) strVal += ", ";
+		strVal += arg;
+	}
+	changed |= SetStringField(row, requiresCol, strVal);
+	return changed;
+}
 
-		if (status == B_OK)
-			status = BNodeInfo::GetTrackerIcon(&ref, icon, B_MINI_ICON);
-		if (status != B_OK) {
-			BMimeType genericAppType(B_APP_MIME_TYPE);
-			status = genericAppType.GetIcon(icon, B_MINI_ICON);
+static void ListJobs(BColumnListView *view, TargetRows &targetRows, const std::vector<JobInfo> &jobs)
+{
+	BRow *row;
+	std::unordered_map<std::string, BRow*> prevJobs;
+	prevJobs.swap(targetRows.jobs);
+
+	for (const JobInfo &job: jobs) {
+		const char *name = job.name.String();
+		bool isNew = false;
+
+		auto it = prevJobs.find(name);
+		if (it != prevJobs.end()) {
+			row = it->second;
+			prevJobs.erase(it);
+		} else {
+			row = new BRow();
+			isNew = true;
 		}
+		targetRows.jobs[name] = row;
 
-		row->SetField(new IconStringField(icon, name), nameCol);
-		if (info.FindBool("service", &boolVal) == B_OK)
-			row->SetField(new BStringField(boolVal? "service": "job"), kindCol);
-		else
-			row->SetField(new BStringField("-"), kindCol);
-		if (info.FindBool("enabled", &boolVal) == B_OK)
-			row->SetField(new BStringField(boolVal? "yes": "no"), enabledCol);
-		else
-			row->SetField(new BStringField("-"), enabledCol);
-		if (info.FindBool("running", &boolVal) == B_OK)
-			row->SetField(new BStringField(boolVal? "yes": "no"), runningCol);
-		else
-			row->SetField(new BStringField("-"), runningCol);
-
-		const char *arg;
-		strVal = "";
-		for (int32 j = 0; info.FindString("launch", j, &arg) >= B_OK; j++) {
-			if (j > 0) strVal += " ";
-			size_t k = 0; while (arg[k] != '\0' && !(arg[k] == ' ')) k++;
-			bool needQuotes = arg[k] != '\0';
-			if (needQuotes) strVal += '"';
-			strVal += arg;
-			if (needQuotes) strVal += '"';
-		}
-		row->SetField(new BStringField(strVal), launchCol);
-		if (info.FindInt32("team", &team) != B_OK)
-			team = -1;
-		row->SetField(new BIntegerField(team), pidCol);
-
-		strVal = "";
-		for (int32 j = 0; info.FindString("requires", j, &arg) >= B_OK; j++) {
-			if (j > 0) strVal += ", ";
-			strVal += arg;
-		}
-		row->SetField(new BStringField(strVal), requiresCol);
+		bool changed = SetJobFields(row, name, job.info);
+		if (isNew)
+			view->AddRow(row, targetRows.row);
+		else if (changed)
+			view->UpdateRow(row);
 	}
 
-	for (int32 i = 0; i < prevNames.CountStrings(); i++) {
-		row = FindStringRow(view, parent, prevNames.StringAt(i));
-		view->RemoveRow(row);
-		delete row;
+	for (auto &it: prevJobs) {
+		view->RemoveRow(it.second);
+		delete it.second;
 	}
 }
 
-static void ListServices(BColumnListView *view) {
+static void ListServices(ServicesList &list) {
 	BLaunchRoster roster;
+	BColumnListView *view = list.view;
 	BRow *row;
-	BStringList names, jobs;
-	BStringList prevNames, prevJobs;
+	BStringList names;
 	BString name;
-	BMessage info;
-	BString strVal, path;
-	status_t status;
-
-	for (int32 i = 0; i < view->CountRows(); i++) {
-		row = view->RowAt(i);
-		prevNames.Add(((BStringField*)row->GetField(nameCol))->String());
-	}
+	std::unordered_map<std::string, TargetRows> prevTargets;
+	prevTargets.swap(list.targets);
 
-	status = roster.GetJobs(NULL, jobs);
+	std::unordered_map<std::string, std::vector<JobInfo>> targetJobs;
+	FetchJobs(targetJobs, list.jobCount);
 
-	status = roster.GetTargets(names);
-	names.Add("<no target>", 0);
+	roster.GetTargets(names);
+	names.Add(kNoTarget, 0);
 
 	for (int32 i = 0; i < names.CountStrings(); i++) {
 		name = names.StringAt(i).String();
-		prevNames.Remove(name);
-
-		row = FindStringRow(view, NULL, name);
 
-		if (row == NULL) {
-			row = new BRow();
+		auto it = prevTargets.find(name.String());
+		TargetRows &targetRows = list.targets[name.String()];
+		if (it != prevTargets.end()) {
+			targetRows = std::move(it->second);
+			prevTargets.erase(it);
+		} else {
+			targetRows.row = row = new BRow();
+			row->SetField(new IconStringField(IconCache::Default().Placeholder().Get(), name), nameCol);
+			row->SetField(new BStringField("target"), kindCol);
 			view->AddRow(row);
 			view->ExpandOrCollapse(row, true);
 		}
-
-		BBitmap* icon = new BBitmap(BRect(0, 0, B_MINI_ICON - 1, B_MINI_ICON - 1), B_RGBA32);
-		BMimeType genericAppType(B_APP_MIME_TYPE);
-		status = genericAppType.GetIcon(icon, B_MINI_ICON);
-
-		row->SetField(new IconStringField(icon, name), nameCol);
-		row->SetField(new BStringField("target"), kindCol);
 /*
 		row->SetField(new BStringField("-"), enabledCol);
 		row->SetField(new BStringField("-"), runningCol);
 		row->SetField(new BStringField("-"), launchCol);
 		row->SetField(new BIntegerField(-1), pidCol);
 */
-		ListJobs(view, row, (i == 0)? "": name, jobs);
+		static const std::vector<JobInfo> noJobs;
+		auto jobsIt = targetJobs.find((i == 0)? "": name.String());
+		ListJobs(view, targetRows, jobsIt != targetJobs.end() ? jobsIt->second : noJobs);
+	}
+
+	for (auto &it: prevTargets) {
+		// Also deletes job rows.
+		view->RemoveRow(it.second.row);
+		delete it.second.row;
+	}
+}
+
+static BRow *FindJobRow(ServicesList &list, const char *name, const char **target = NULL)
+{
+	for (auto &it: list.targets) {
+		auto jobIt = it.second.jobs.find(name);
+		if (jobIt != it.second.jobs.end()) {
+			if (target != NULL) *target = it.first.c_str();
+			return jobIt->second;
+		}
 	}
+	return NULL;
+}
 
-	for (int32 i = 0; i < prevNames.CountStrings(); i++) {
-		row = FindStringRow(view, NULL, prevNames.StringAt(i));
-		view->RemoveRow(row);
-		delete row;
+static BRow *FindTeamJobRow(ServicesList &list, team_id team)
+{
+	for (auto &it: list.targets) {
+		for (auto &jobIt: it.second.jobs) {
+			if (static_cast<BIntegerField*>(jobIt.second->GetField(pidCol))->Value() == team)
+				return jobIt.second;
+		}
 	}
+	return NULL;
+}
+
+// Updates row of single job. Returns false if job was added, removed or
+// moved to other target, so whole list should be refreshed.
+static bool UpdateJob(ServicesList &list, const char *name)
+{
+	BLaunchRoster roster;
+	BMessage info;
+	const char *prevTarget;
+	BRow *row = FindJobRow(list, name, &prevTarget);
+	if (roster.GetJobInfo(name, info) != B_OK)
+		return row == NULL;
+	if (row == NULL)
+		return false;
+
+	const char *target;
+	if (info.FindString("target", &target) < B_OK || target[0] == '\0') target = kNoTarget;
+	if (strcmp(target, prevTarget) != 0)
+		return false;
+
+	if (SetJobFields(row, name, info))
+		list.view->UpdateRow(row);
+	return true;
+}
+
+static void SendDelayed(BMessenger target, BMessage *msg, bigtime_t delay)
+{
+	BMessageRunner::StartSending(target, msg, delay, 1);
+	delete msg;
+}
+
+static BMessage *NewUpdateJobMsg(const char *name)
+{
+	BMessage *msg = new BMessage(updateJobMsg);
+	msg->AddString("name", name);
+	return msg;
 }
 
 static void InitList(BColumnListView *view) {
@@ -282,8 +370,6 @@ static void InitList(BColumnListView *view) {
 	view->AddColumn(new BStringColumn("Launch", 256, 32, 4096, B_TRUNCATE_MIDDLE), launchCol);
 	view->AddColumn(new BIntegerColumn("PID", 64, 32, 128, B_ALIGN_LEFT), pidCol);
 	view->AddColumn(new BStringColumn("Requires", 256, 32, 4096, B_TRUNCATE_MIDDLE), requiresCol);
-
-	ListServices(view);
 }
 
 class IconMenuItem: public BMenuItem
@@ -346,12 +432,37 @@ class ServicesWindow: public BWindow
 {
 private:
 	BColumnListView *fView;
+	BStringView *fStatusView;
 	BMenuItem *fEnabledItem;
 	BMessageRunner fListUpdater;
+	ServicesList fList;
+	bigtime_t fRefreshTime;
+	bigtime_t fMaxRefreshTime;
+	uint64 fRefreshCount;
+
+	void Refresh()
+	{
+		bigtime_t start = system_time();
+		ListServices(fList);
+		bigtime_t time = system_time() - start;
+
+		fRefreshTime += time;
+		fRefreshCount++;
+		if (time > fMaxRefreshTime)
+			fMaxRefreshTime = time;
+		BString str;
+		str.SetToFormat("%" B_PRId32 " jobs, %" B_PRIuSIZE " targets, refresh %.1f ms (avg %.1f ms, max %.1f ms)",
+			fList.jobCount, fList.targets.size(),
+			time/1000.0, fRefreshTime/1000.0/fRefreshCount, fMaxRefreshTime/1000.0);
+		fStatusView->SetText(str);
+	}
 
 public:
 	ServicesWindow(BRect frame): BWindow(frame, "Services", B_DOCUMENT_WINDOW, B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS),
-		fListUpdater(BMessenger(this), BMessage(updateMsg), 500000)
+		fListUpdater(BMessenger(this), BMessage(updateMsg), kReconcileInterval),
+		fRefreshTime(0),
+		fMaxRefreshTime(0),
+		fRefreshCount(0)
 	{
 		BMenuBar *menubar, *toolbar;
 
@@ -371,10 +482,21 @@ public:
 			.AddItem(new IconMenuItem(LoadIcon(resRestartIcon, 16, 16), new BMessage(restartMsg)))
 		.End();
 
+		IconCache::Default().SetTarget(BMessenger(this));
+
 		fView = new BColumnListView("view", 0);
 		fView->SetInvocationMessage(new BMessage(invokeMsg));
 		fView->SetSelectionMessage(new BMessage(selectMsg));
 		InitList(fView);
+		fList.view = fView;
+		fList.jobCount = 0;
+
+		fStatusView = new BStringView("status", "");
+		Refresh();
+		// launch_daemon has no job change notifications, most jobs are
+		// servers registered in roster, so their start and exit are
+		// watched there.
+		be_roster->StartWatching(BMessenger(this), B_REQUEST_LAUNCHED | B_REQUEST_QUIT);
 
 		BLayoutBuilder::Group<>(this, B_VERTICAL, 0)
 			.Add(menubar)
@@ -383,11 +505,41 @@ public:
 				.Add(fView)
 				.SetInsets(-1)
 			.End()
+			.AddGroup(B_HORIZONTAL)
+				.Add(fStatusView)
+				.AddGlue()
+				.SetInsets(B_USE_SMALL_SPACING)
+			.End()
 		.End();
 
 		SetKeyMenuBar(menubar);
 	}
 
+	~ServicesWindow()
+	{
+		be_roster->StopWatching(BMessenger(this));
+	}
+
+	void UpdateJob(const char *name)
+	{
+		if (!::UpdateJob(fList, name))
+			Refresh();
+	}
+
+	// Job state is checked immediately and after launch_daemon had time
+	// to process the request.
+	void JobChanged(const char *name, bool isTarget)
+	{
+		if (isTarget) {
+			SendDelayed(BMessenger(this), new BMessage(updateMsg), kRecheckDelay);
+			return;
+		}
+		// Name can point to row field that is deleted by refresh.
+		BString jobName(name);
+		UpdateJob(jobName);
+		SendDelayed(BMessenger(this), NewUpdateJobMsg(jobName), kRecheckDelay);
+	}
+
 	void MenusBeginning()
 	{
 		fEnabledItem->SetEnabled(false);
@@ -418,8 +570,48 @@ public:
 		case selectMsg:
 			break;
 		case updateMsg:
-			ListServices(fView);
+			Refresh();
 			break;
+		case updateJobMsg: {
+			const char *name;
+			if (msg->FindString("name", &name) >= B_OK)
+				UpdateJob(name);
+			break;
+		}
+		case B_SOME_APP_LAUNCHED:
+		case B_SOME_APP_QUIT: {
+			const char *signature;
+			team_id team;
+			BRow *row = NULL;
+			// Job names are lowercase app signatures without type.
+			if (msg->FindString("be:signature", &signature) >= B_OK) {
+				BString name(signature);
+				name.ToLower();
+				name.RemoveFirst("application/");
+				row = FindJobRow(fList, name);
+			}
+			if (row == NULL && msg->FindInt32("be:team", &team) >= B_OK)
+				row = FindTeamJobRow(fList, team);
+			if (row != NULL)
+				JobChanged(((BStringField*)row->GetField(nameCol))->String(), false);
+			break;
+		}
+		case iconCacheLoadedMsg: {
+			const char *path;
+			if (msg->FindString("path", &path) < B_OK)
+				break;
+			for (auto &it: fList.targets) {
+				for (auto &jobIt: it.second.jobs) {
+					BRow *row = jobIt.second;
+					IconStringField *field = static_cast<IconStringField*>(row->GetField(nameCol));
+					if (field->Path() != path)
+						continue;
+					field->SetIcon(IconCache::Default().Get(path).Get());
+					fView->UpdateRow(row);
+				}
+			}
+			break;
+		}
 		case startMsg:
 		case stopMsg:
 		case restartMsg: {
@@ -442,6 +634,7 @@ public:
 					}
 					break;
 			}
+			JobChanged(name, isTarget);
 			break;
 		}
 		case enableMsg: {
@@ -455,6 +648,7 @@ public:
 			bool isTarget = parent == NULL;
 			if (isTarget) return;
 			roster.SetEnabled(name, !fEnabledItem->IsMarked());
+			JobChanged(name, false);
 			break;
 		}
 		default:
@@ -1,17 +1,34 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <OS.h>
 #include <errno.h>
 #include <string.h>
 #include <libgen.h>
 #include <private/debug/debug_support.h>
+#include <private/system/syscall_process_info.h>
+#include <private/system/syscalls.h>
 
-#include <cxxabi.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AddressMap.h"
+
+enum {
+	kMaxFrames = 400,
+	kStopTimeout = 500000,
+	kMaxWorkers = 8,
+	kMinAddressesPerWorker = 64,
+};
 
 team_id team;
 thread_id thread;
 port_id debuggerPort, nubPort;
 debug_context debugContext;
+AddressMap addressMap;
 
 status_t Check(status_t res, const char *msg = NULL, bool fatal = true)
 {
@@ -45,13 +62,6 @@ void WriteAddress(addr_t adr)
 }
 
 
-char *CppDemangle(const char *abiName)
-{
-  int status;
-  char *ret = abi::__cxa_demangle(abiName, 0, 0, &status);
-  return ret;
-}
-
 void _LookupSymbolAddress(
 	debug_symbol_lookup_context *lookupContext, const void *address,
 	char *buffer, int32 bufferSize)
@@ -75,14 +85,11 @@ void _LookupSymbolAddress(
 
 		// we were able to look something up
 		if (strlen(symbolName) > 0) {
-			char *demangledName = CppDemangle(symbolName);
-			if (demangledName != NULL) {
-				strcpy(symbolName, demangledName);
-				free(demangledName);
-			}
+			std::string demangledName = DemangleCache::Default().Demangle(symbolName);
 
 			// we even got a symbol
-			snprintf(buffer, bufferSize, "<%s> %s + %ld%s", imageName, symbolName,
+			snprintf(buffer, bufferSize, "<%s> %s + %ld%s", imageName,
+				demangledName.c_str(),
 				(addr_t)address - (addr_t)baseAddress,
 				(exactMatch ? "" : " (closest symbol)"));
 
@@ -94,20 +101,11 @@ void _LookupSymbolAddress(
 
 	} else {
 		// lookup failed: find area containing the IP
-		bool useAreaInfo = false;
-		area_info info;
-		ssize_t cookie = 0;
-		while (get_next_area_info(team, &cookie, &info) == B_OK) {
-			if ((addr_t)info.address <= (addr_t)address
-				&& (addr_t)info.address + info.size > (addr_t)address) {
-				useAreaInfo = true;
-				break;
-			}
-		}
+		const AddressMap::Range *area = addressMap.FindArea((addr_t)address);
 
-		if (useAreaInfo) {
-			snprintf(buffer, bufferSize, "<area: %s> + %#lx", info.name,
-				(addr_t)address - (addr_t)info.address);
+		if (area != NULL) {
+			snprintf(buffer, bufferSize, "<area: %s> + %#lx", area->name.c_str(),
+				(addr_t)address - area->start);
 		} else if (bufferSize > 0)
 			buffer[0] = '\0';
 	}
@@ -176,18 +174,254 @@ status_t DebugThread(void *arg)
 	return B_OK;
 }
 
+
+//#pragma mark Team dump
+
+struct ThreadStack {
+	thread_id thread;
+	std::string name;
+	std::vector<addr_t> addresses;
+};
+
+struct SymbolizeJob {
+	const std::vector<addr_t> *addresses;
+	std::vector<std::string> *names;
+	size_t start, end;
+};
+
+static status_t SymbolizeThread(void *arg)
+{
+	SymbolizeJob &job = *(SymbolizeJob*)arg;
+	// Lookup context is not shared between threads.
+	debug_symbol_lookup_context *lookupContext = NULL;
+	Check(debug_create_symbol_lookup_context(team, -1, &lookupContext), "can't create symbol lookup context", false);
+	char symbolBuffer[2048];
+	for (size_t i = job.start; i < job.end; i++) {
+		_LookupSymbolAddress(lookupContext, (const void*)(*job.addresses)[i], symbolBuffer, sizeof(symbolBuffer) - 1);
+		(*job.names)[i] = symbolBuffer;
+	}
+	if (lookupContext)
+		debug_delete_symbol_lookup_context(lookupContext);
+	return B_OK;
+}
+
+// Resolves each unique address once, work is split between threads.
+static void SymbolizeAddresses(const std::vector<addr_t> &addresses, std::vector<std::string> &names)
+{
+	names.resize(addresses.size());
+	// Take snapshot before workers start, it is read-only after that.
+	addressMap.FindArea(0);
+
+	system_info sysInfo;
+	int32 workerCount = 1;
+	if (get_system_info(&sysInfo) >= B_OK)
+		workerCount = std::min<int32>(sysInfo.cpu_count, kMaxWorkers);
+	workerCount = std::max<int32>(1, std::min<int32>(workerCount, addresses.size() / kMinAddressesPerWorker));
+
+	std::vector<SymbolizeJob> jobs(workerCount);
+	std::vector<thread_id> workers(workerCount, -1);
+	for (int32 i = 0; i < workerCount; i++) {
+		jobs[i] = {&addresses, &names, addresses.size()*i/workerCount, addresses.size()*(i + 1)/workerCount};
+		if (i > 0) {
+			workers[i] = spawn_thread(SymbolizeThread, "symbolizer", B_NORMAL_PRIORITY, &jobs[i]);
+			if (workers[i] >= B_OK)
+				resume_thread(workers[i]);
+		}
+	}
+	SymbolizeThread(&jobs[0]);
+	for (int32 i = 1; i < workerCount; i++) {
+		status_t res;
+		if (workers[i] >= B_OK)
+			wait_for_thread(workers[i], &res);
+		else
+			SymbolizeThread(&jobs[i]);
+	}
+}
+
+static void WalkStack(thread_id thread, std::vector<addr_t> &addresses)
+{
+	void *ip = NULL, *fp = NULL;
+	if (Check(debug_get_instruction_pointer(&debugContext, thread, &ip, &fp), "can't get IP and FP", false) < B_OK)
+		return;
+	addresses.push_back((addr_t)ip);
+	while (fp != NULL && addresses.size() < kMaxFrames) {
+		debug_stack_frame_info stackFrameInfo;
+		if (debug_get_stack_frame(&debugContext, fp, &stackFrameInfo) < B_OK)
+			break;
+		addresses.push_back((addr_t)stackFrameInfo.return_address);
+		fp = stackFrameInfo.parent_frame;
+	}
+}
+
+// Stops all threads and collects their stacks. Threads stay stopped until
+// debugger is removed.
+static void CollectStacks(std::vector<ThreadStack> &stacks)
+{
+	std::unordered_map<thread_id, std::string> pending;
+	thread_info threadInfo;
+	int32 cookie = 0;
+	while (get_next_thread_info(team, &cookie, &threadInfo) >= B_OK) {
+		if (debug_thread(threadInfo.thread) >= B_OK)
+			pending[threadInfo.thread] = threadInfo.name;
+	}
+
+	while (!pending.empty()) {
+		int32 code;
+		debug_debugger_message_data message;
+		ssize_t res = read_port_etc(debuggerPort, &code, &message, sizeof(message), B_RELATIVE_TIMEOUT, kStopTimeout);
+		if (res == B_INTERRUPTED) continue;
+		if (Check(res, "timeout waiting for threads to stop", false) < B_OK) break;
+		switch (code) {
+		case B_DEBUGGER_MESSAGE_TEAM_DELETED:
+			return;
+		case B_DEBUGGER_MESSAGE_THREAD_DELETED:
+			pending.erase(message.origin.thread);
+			break;
+		case B_DEBUGGER_MESSAGE_PROFILER_UPDATE:
+		case B_DEBUGGER_MESSAGE_HANDED_OVER:
+			break;
+		default: {
+			// Any other event also means that thread is stopped.
+			auto it = pending.find(message.origin.thread);
+			if (it == pending.end()) break;
+			stacks.push_back({it->first, it->second, {}});
+			pending.erase(it);
+		}
+		}
+	}
+
+	for (ThreadStack &stack: stacks)
+		WalkStack(stack.thread, stack.addresses);
+}
+
+static void WriteTeamStacks(std::vector<ThreadStack> &stacks)
+{
+	std::vector<addr_t> addresses;
+	for (ThreadStack &stack: stacks)
+		addresses.insert(addresses.end(), stack.addresses.begin(), stack.addresses.end());
+	std::sort(addresses.begin(), addresses.end());
+	addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+
+	std::vector<std::string> names;
+	SymbolizeAddresses(addresses, names);
+
+	// Group threads with identical stacks, largest groups first.
+	std::map<std::vector<addr_t>, std::vector<const ThreadStack*>> groupMap;
+	for (const ThreadStack &stack: stacks)
+		groupMap[stack.addresses].push_back(&stack);
+	std::vector<std::pair<const std::vector<addr_t>*, std::vector<const ThreadStack*>*>> groups;
+	for (auto &it: groupMap)
+		groups.push_back({&it.first, &it.second});
+	std::stable_sort(groups.begin(), groups.end(), [](const auto &a, const auto &b) {
+		return a.second->size() > b.second->size();
+	});
+
+	for (auto &group: groups) {
+		printf("%zu thread%s:", group.second->size(), group.second->size() == 1 ? "" : "s");
+		for (const ThreadStack *stack: *group.second)
+			printf(" %" B_PRId32 " \"%s\"", stack->thread, stack->name.c_str());
+		printf("\n");
+		for (addr_t address: *group.first) {
+			size_t index = std::lower_bound(addresses.begin(), addresses.end(), address) - addresses.begin();
+			printf("  IP: "); WriteAddress(address);
+			printf(", %s\n", names[index].c_str());
+		}
+		printf("\n");
+	}
+}
+
+static status_t DumpTeam(team_id id)
+{
+	team = id;
+	addressMap.SetTeam(team);
+
+	team_info teamInfo;
+	status_t res = Check(get_team_info(team, &teamInfo), "team not found", false);
+	if (res < B_OK)
+		return res;
+	printf("team %" B_PRId32 " (%s)\n\n", team, teamInfo.args);
+
+	debuggerPort = Check(create_port(10, "debugger port"), NULL, false);
+	if (debuggerPort < B_OK)
+		return debuggerPort;
+	nubPort = Check(install_team_debugger(team, debuggerPort), "can't install debugger", false);
+	if (nubPort < B_OK) {
+		delete_port(debuggerPort);
+		return nubPort;
+	}
+	std::vector<ThreadStack> stacks;
+	res = Check(init_debug_context(&debugContext, team, nubPort), NULL, false);
+	if (res >= B_OK) {
+		CollectStacks(stacks);
+		destroy_debug_context(&debugContext);
+	}
+	// Resume threads before symbolizing and printing, symbol lookup context
+	// and address map don't need debugger.
+	remove_team_debugger(team);
+	delete_port(debuggerPort);
+	if (res >= B_OK)
+		WriteTeamStacks(stacks);
+	return res;
+}
+
+// Teams this process runs in, such as shell and Terminal. Stopping them
+// while writing to their pty can deadlock.
+static std::vector<team_id> AncestorTeams()
+{
+	std::vector<team_id> teams;
+	team_id team = getpid();
+	while (team > B_SYSTEM_TEAM) {
+		teams.push_back(team);
+		pid_t parent = _kern_process_info(team, PARENT_ID);
+		if (parent < B_OK || parent == team)
+			break;
+		team = parent;
+	}
+	return teams;
+}
+
+static void Usage()
+{
+	fprintf(stderr, "usage: StackTrace <thread id>\n");
+	fprintf(stderr, "       StackTrace --team <team id>\n");
+	fprintf(stderr, "       StackTrace --all\n");
+	exit(1);
+}
+
+
 int main(int argCnt, char **args)
 {
 	thread_info threadInfo;
 	status_t res;
 
-	if (argCnt != 2)
-		FatalError("thread id should be provided\n");
+	if (argCnt == 3 && strcmp(args[1], "--team") == 0) {
+		if (DumpTeam(strtol(args[2], NULL, 10)) < B_OK)
+			return 1;
+		return 0;
+	}
+	if (argCnt == 2 && strcmp(args[1], "--all") == 0) {
+		std::vector<team_id> ancestors = AncestorTeams();
+		team_info teamInfo;
+		int32 cookie = 0;
+		int exitCode = 0;
+		while (get_next_team_info(&cookie, &teamInfo) >= B_OK) {
+			if (teamInfo.team == B_SYSTEM_TEAM
+				|| std::find(ancestors.begin(), ancestors.end(), teamInfo.team) != ancestors.end())
+				continue;
+			// Continue with other teams, but report failure.
+			if (DumpTeam(teamInfo.team) < B_OK)
+				exitCode = 1;
+		}
+		return exitCode;
+	}
+	if (argCnt != 2 || args[1][0] == '-')
+		Usage();
 
 	thread = strtol(args[1], NULL, 10);
 	
 	Check(get_thread_info(thread, &threadInfo), "thread not found");
 	team = threadInfo.team;
+	addressMap.SetTeam(team);
 
 	debuggerPort = Check(create_port(10, "debugger port"));
 	nubPort = Check(install_team_debugger(team, debuggerPort), "can't install debugger");
@@ -0,0 +1,106 @@
+#include "AddressMap.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include <cxxabi.h>
+
+
+AddressMap::AddressMap(team_id team):
+	fTeam(team),
+	fValid(false)
+{}
+
+
+void AddressMap::SetTeam(team_id team)
+{
+	fTeam = team;
+	fValid = false;
+}
+
+
+void AddressMap::Update()
+{
+	fImages.clear();
+	fAreas.clear();
+
+	image_info imageInfo;
+	int32 imageCookie = 0;
+	while (get_next_image_info(fTeam, &imageCookie, &imageInfo) >= B_OK) {
+		addr_t text = (addr_t)imageInfo.text;
+		addr_t data = (addr_t)imageInfo.data;
+		if (imageInfo.text_size > 0)
+			fImages.push_back({text, text + imageInfo.text_size, textKind, imageInfo.id, text, imageInfo.name});
+		if (imageInfo.data_size > 0)
+			fImages.push_back({data, data + imageInfo.data_size, dataKind, imageInfo.id, text, imageInfo.name});
+	}
+
+	area_info areaInfo;
+	ssize_t areaCookie = 0;
+	while (get_next_area_info(fTeam, &areaCookie, &areaInfo) >= B_OK) {
+		addr_t address = (addr_t)areaInfo.address;
+		fAreas.push_back({address, address + areaInfo.size, areaKind, areaInfo.area, 0, areaInfo.name});
+	}
+
+	auto byStart = [](const Range &a, const Range &b) {return a.start < b.start;};
+	std::sort(fImages.begin(), fImages.end(), byStart);
+	std::sort(fAreas.begin(), fAreas.end(), byStart);
+	fValid = true;
+}
+
+const AddressMap::Range *AddressMap::Find(const std::vector<Range> &ranges, addr_t address)
+{
+	auto it = std::upper_bound(ranges.begin(), ranges.end(), address, [](addr_t address, const Range &range) {
+		return address < range.start;
+	});
+	if (it == ranges.begin())
+		return NULL;
+	--it;
+	if (address >= it->end)
+		return NULL;
+	return &*it;
+}
+
+
+const AddressMap::Range *AddressMap::FindImage(addr_t address)
+{
+	if (!fValid)
+		Update();
+	return Find(fImages, address);
+}
+
+const AddressMap::Range *AddressMap::FindArea(addr_t address)
+{
+	if (!fValid)
+		Update();
+	return Find(fAreas, address);
+}
+
+
+//#pragma mark DemangleCache
+
+DemangleCache &DemangleCache::Default()
+{
+	static DemangleCache cache;
+	return cache;
+}
+
+
+std::string DemangleCache::Demangle(const char *name)
+{
+	std::lock_guard<std::mutex> lock(fLock);
+	auto it = fNames.find(name);
+	if (it == fNames.end()) {
+		if (fNames.size() >= kMaxNames)
+			fNames.clear();
+		int status;
+		char *demangled = abi::__cxa_demangle(name, 0, 0, &status);
+		// Empty string marks names that can't be demangled.
+		it = fNames.emplace(name, demangled != NULL ? demangled : "").first;
+		free(demangled);
+	}
+	if (it->second.empty())
+		return name;
+	return it->second;
+}
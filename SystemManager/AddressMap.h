@@ -0,0 +1,77 @@
+#ifndef _ADDRESSMAP_H_
+#define _ADDRESSMAP_H_
+
+#include <OS.h>
+#include <image.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+
+// Sorted snapshot of team image segments and areas for address lookup.
+// It is taken on first lookup after Invalidate(), so stack trace costs one
+// enumeration instead of one per frame. Stack tracers don't request image
+// events, the map is taken once per trace after thread is stopped.
+class AddressMap
+{
+public:
+	enum Kind {
+		textKind,
+		dataKind,
+		areaKind,
+	};
+
+	struct Range {
+		addr_t start;
+		addr_t end;
+		Kind kind;
+		int32 id;
+		// Image text base for segments.
+		addr_t base;
+		std::string name;
+	};
+
+private:
+	team_id fTeam;
+	bool fValid;
+	std::vector<Range> fImages;
+	std::vector<Range> fAreas;
+
+	void Update();
+	static const Range *Find(const std::vector<Range> &ranges, addr_t address);
+
+public:
+	AddressMap(team_id team = -1);
+
+	void SetTeam(team_id team);
+	// Must be called when images are loaded or unloaded.
+	void Invalidate() {fValid = false;}
+
+	// Image text or data segment containing address.
+	const Range *FindImage(addr_t address);
+	const Range *FindArea(addr_t address);
+};
+
+
+// Demangled C++ names shared by all threads. Names that are not mangled
+// are returned as is. Cache is cleared when it grows over kMaxNames.
+class DemangleCache
+{
+private:
+	enum {
+		kMaxNames = 4096,
+	};
+
+	std::mutex fLock;
+	std::unordered_map<std::string, std::string> fNames;
+
+public:
+	static DemangleCache &Default();
+
+	std::string Demangle(const char *name);
+};
+
+
+#endif	// _ADDRESSMAP_H_
@@ -0,0 +1,97 @@
+#include "CallTree.h"
+
+#include <inttypes.h>
+
+
+CallTree::CallTree()
+{
+	Clear();
+}
+
+
+void CallTree::Clear()
+{
+	fNames.clear();
+	fNameIndex.clear();
+	fNodes.clear();
+	fNames.push_back("");
+	fNodes.push_back({.name = 0, .parent = kRoot, .self = 0, .total = 0, .children = {}});
+}
+
+
+uint32_t CallTree::AddName(const std::string &name)
+{
+	auto it = fNameIndex.find(name);
+	if (it != fNameIndex.end())
+		return it->second;
+	uint32_t index = fNames.size();
+	fNames.push_back(name);
+	fNameIndex[name] = index;
+	return index;
+}
+
+uint32_t CallTree::Child(uint32_t node, uint32_t name)
+{
+	auto it = fNodes[node].children.find(name);
+	if (it != fNodes[node].children.end())
+		return it->second;
+	uint32_t child = fNodes.size();
+	// fNodes can be reallocated, don't keep references over push_back.
+	fNodes.push_back({.name = name, .parent = node, .self = 0, .total = 0, .children = {}});
+	fNodes[node].children[name] = child;
+	return child;
+}
+
+
+void CallTree::AddStack(const uint32_t *frames, size_t count, uint64_t weight)
+{
+	uint32_t node = kRoot;
+	fNodes[node].total += weight;
+	for (size_t i = 0; i < count; i++) {
+		node = Child(node, frames[i]);
+		fNodes[node].total += weight;
+	}
+	fNodes[node].self += weight;
+}
+
+
+CallTree CallTree::Inverted() const
+{
+	CallTree tree;
+	tree.fNames = fNames;
+	tree.fNameIndex = fNameIndex;
+	std::vector<uint32_t> frames;
+	for (uint32_t i = 0; i < fNodes.size(); i++) {
+		if (fNodes[i].self == 0 || i == kRoot)
+			continue;
+		frames.clear();
+		for (uint32_t node = i; node != kRoot; node = fNodes[node].parent)
+			frames.push_back(fNodes[node].name);
+		tree.AddStack(frames.data(), frames.size(), fNodes[i].self);
+	}
+	return tree;
+}
+
+
+bool CallTree::WriteFolded(FILE *file) const
+{
+	std::vector<uint32_t> path;
+	std::string line;
+	for (uint32_t i = 0; i < fNodes.size(); i++) {
+		if (fNodes[i].self == 0 || i == kRoot)
+			continue;
+		path.clear();
+		for (uint32_t node = i; node != kRoot; node = fNodes[node].parent)
+			path.push_back(fNodes[node].name);
+		line.clear();
+		for (size_t j = path.size(); j > 0; j--) {
+			if (j < path.size())
+				line += ';';
+			// Separator can't appear in frame names.
+			for (char c: fNames[path[j - 1]])
+				line += c == ';' ? ':' : c;
+		}
+		fprintf(file, "%s %" PRIu64 "\n", line.c_str(), fNodes[i].self);
+	}
+	return ferror(file) == 0;
+}
@@ -0,0 +1,62 @@
+#ifndef _CALLTREE_H_
+#define _CALLTREE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+
+// Trie of sampled call stacks. Each node counts samples whose stack passes
+// through it (total) and samples where it is the innermost frame (self).
+// Frame names are interned, stacks are given as name indices from root
+// (outermost) frame.
+class CallTree
+{
+public:
+	enum {
+		kRoot = 0,
+	};
+
+	struct Node {
+		uint32_t name;
+		uint32_t parent;
+		uint64_t self;
+		uint64_t total;
+		std::unordered_map<uint32_t, uint32_t> children;
+	};
+
+private:
+	std::vector<std::string> fNames;
+	std::unordered_map<std::string, uint32_t> fNameIndex;
+	std::vector<Node> fNodes;
+
+	uint32_t Child(uint32_t node, uint32_t name);
+
+public:
+	CallTree();
+
+	void Clear();
+
+	uint32_t AddName(const std::string &name);
+	const std::string &Name(uint32_t name) const {return fNames[name];}
+
+	void AddStack(const uint32_t *frames, size_t count, uint64_t weight = 1);
+
+	size_t CountNodes() const {return fNodes.size();}
+	const Node &NodeAt(uint32_t node) const {return fNodes[node];}
+	uint64_t TotalSamples() const {return fNodes[kRoot].total;}
+
+	// Tree of callers: each innermost frame becomes child of root and its
+	// callers become its descendants.
+	CallTree Inverted() const;
+
+	// One line per unique stack: frames from root separated by ';', then
+	// space and sample count. This is input format of flamegraph.pl.
+	bool WriteFolded(FILE *file) const;
+};
+
+
+#endif	// _CALLTREE_H_
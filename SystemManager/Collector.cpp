@@ -0,0 +1,338 @@
+#include "Collector.h"
+
+#include <string.h>
+#include <fcntl.h>
+
+#include <drivers/KernelExport.h>
+#include <private/kernel/util/KMessage.h>
+#include <private/system/extended_system_info_defs.h>
+#include <private/libroot/extended_system_info.h>
+#include <private/system/syscall_process_info.h>
+#include <private/system/syscalls.h>
+
+#include <unordered_map>
+
+
+void Collector::SampleTeamMemory(TeamSample &team)
+{
+	area_info info;
+	ssize_t cookie = 0;
+
+	team.memSize = 0; team.memAlloc = 0;
+	while (get_next_area_info(team.id, &cookie, &info) >= B_OK) {
+		team.memSize += info.size;
+		team.memAlloc += info.ram_size;
+		fMemoryClassifier.AddArea({
+			.address = (addr_t)info.address,
+			.size = info.size,
+			.ram = info.ram_size,
+			.name = info.name,
+			.writable = (info.protection & B_WRITE_AREA) != 0,
+			.cloneable = (info.protection & B_CLONEABLE_AREA) != 0,
+		});
+	}
+}
+
+static void SampleSystem(SystemSample &sample)
+{
+	system_info info;
+	if (get_system_info(&info) < B_OK)
+		return;
+
+	sample.bootTime = info.boot_time;
+	sample.cpuCount = info.cpu_count;
+	sample.pageSize = B_PAGE_SIZE;
+	sample.usedPages = info.used_pages;
+	sample.maxPages = info.max_pages;
+	sample.cachedPages = info.cached_pages;
+	sample.blockCachePages = info.block_cache_pages;
+	sample.ignoredPages = info.ignored_pages;
+	sample.neededMemory = info.needed_memory;
+	sample.freeMemory = info.free_memory;
+	sample.maxSwapPages = info.max_swap_pages;
+	sample.freeSwapPages = info.free_swap_pages;
+	sample.pageFaults = info.page_faults;
+	sample.usedSems = info.used_sems;
+	sample.maxSems = info.max_sems;
+	sample.usedPorts = info.used_ports;
+	sample.maxPorts = info.max_ports;
+	sample.usedThreads = info.used_threads;
+	sample.maxThreads = info.max_threads;
+	sample.usedTeams = info.used_teams;
+	sample.maxTeams = info.max_teams;
+	sample.kernelName = info.kernel_name;
+	sample.kernelBuildDate = info.kernel_build_date;
+	sample.kernelBuildTime = info.kernel_build_time;
+}
+
+// Single team is returned once instead of iterating all teams.
+static bool NextTeam(team_id team, bool allTeams, int32 &cookie, team_info &info)
+{
+	if (allTeams)
+		return get_next_team_info(&cookie, &info) == B_OK;
+	if (cookie++ != 0)
+		return false;
+	return get_team_info(team, &info) == B_OK;
+}
+
+void Collector::Sample(Snapshot &snapshot, uint32 fields, team_id selectedTeam)
+{
+	bool cpu = (fields & (collectSystem | collectTeams | collectThreads)) != 0;
+	bool memory = (fields & collectMemory) != 0;
+	bool allThreads = (fields & collectThreads) != 0 || memory;
+
+	// Many threads usually wait on the same semaphore. Value is latest
+	// holder and count.
+	std::unordered_map<sem_id, std::pair<thread_id, int32>> semHolders;
+
+	snapshot.Clear();
+	snapshot.time = system_time();
+	// CPU count is needed to compute usage.
+	if (cpu || memory)
+		SampleSystem(snapshot.system);
+
+	team_info teamInfo;
+	int32 teamCookie = 0;
+	bool allTeams = selectedTeam < 0 || (fields & collectSystem) != 0;
+	while (NextTeam(selectedTeam, allTeams, teamCookie, teamInfo)) {
+		TeamSample team = {};
+		team.id = teamInfo.team;
+		team.uid = -1; team.gid = -1;
+		bool selected = selectedTeam < 0 || team.id == selectedTeam;
+
+		if (selected && (fields & collectTeams) != 0) {
+			team.parent = _kern_process_info(team.id, PARENT_ID);
+			team.session = _kern_process_info(team.id, SESSION_ID);
+			team.group = _kern_process_info(team.id, GROUP_ID);
+
+			KMessage extInfo;
+			if (get_extended_team_info(team.id, B_TEAM_INFO_BASIC, extInfo) >= B_OK) {
+				if (extInfo.FindInt32("uid", &team.uid) < B_OK) team.uid = -1;
+				if (extInfo.FindInt32("gid", &team.gid) < B_OK) team.gid = -1;
+			}
+		}
+
+		if (selected && memory)
+			fMemoryClassifier.BeginTeam();
+		if (selected && ((fields & collectTeams) != 0 || memory)) {
+			int32 imageCookie = 0;
+			image_info imageInfo;
+			while (get_next_image_info(team.id, &imageCookie, &imageInfo) >= B_OK) {
+				if (team.path.empty())
+					team.path = imageInfo.name;
+				if (!memory)
+					break;
+				fMemoryClassifier.AddImage(imageInfo.name,
+					(addr_t)imageInfo.text, imageInfo.text_size,
+					(addr_t)imageInfo.data, imageInfo.data_size);
+			}
+		}
+
+		if (cpu) {
+			team_usage_info usage;
+			if (get_team_usage_info(team.id, B_TEAM_USAGE_SELF, &usage) >= B_OK) {
+				team.userTime = usage.user_time;
+				team.kernelTime = usage.kernel_time;
+			}
+		}
+
+		team.firstThread = snapshot.threads.size();
+		thread_info threadInfo;
+		int32 threadCookie = 0;
+		while (((selected && allThreads) || (cpu && team.id == B_SYSTEM_TEAM))
+			&& get_next_thread_info(team.id, &threadCookie, &threadInfo) == B_OK) {
+			ThreadSample thread = {};
+			thread.id = threadInfo.thread;
+			thread.team = threadInfo.team;
+			thread.name = threadInfo.name;
+			thread.state = threadInfo.state;
+			thread.priority = threadInfo.priority;
+			thread.sem = threadInfo.sem;
+			thread.semHolder = -1;
+			if (selected && thread.sem >= B_OK && (fields & collectThreads) != 0) {
+				auto it = semHolders.find(thread.sem);
+				if (it == semHolders.end()) {
+					sem_info semInfo;
+					if (get_sem_info(thread.sem, &semInfo) >= B_OK)
+						it = semHolders.emplace(thread.sem, std::make_pair(semInfo.latest_holder, semInfo.count)).first;
+					else
+						it = semHolders.emplace(thread.sem, std::make_pair(-1, 0)).first;
+				}
+				thread.semHolder = it->second.first;
+				thread.semCount = it->second.second;
+			}
+			thread.userTime = threadInfo.user_time;
+			thread.kernelTime = threadInfo.kernel_time;
+			thread.stackBase = (addr_t)threadInfo.stack_base;
+			thread.stackEnd = (addr_t)threadInfo.stack_end;
+			thread.isIdle = team.id == B_SYSTEM_TEAM && strncmp(threadInfo.name, "idle thread", strlen("idle thread")) == 0;
+			snapshot.threads.push_back(thread);
+		}
+		team.threadCount = snapshot.threads.size() - team.firstThread;
+
+		if (selected && memory) {
+			for (size_t i = team.firstThread; i < snapshot.threads.size(); i++)
+				fMemoryClassifier.AddStack(snapshot.threads[i].stackBase, snapshot.threads[i].stackEnd);
+			SampleTeamMemory(team);
+			fMemoryClassifier.EndTeam(snapshot, team);
+		}
+
+		snapshot.teams.push_back(team);
+	}
+
+	snapshot.BuildIndex();
+	if (memory)
+		SumSystemMemory(snapshot);
+}
+
+
+void CollectImages(team_id team, std::vector<image_info> &images)
+{
+	int32 cookie = 0;
+	image_info info;
+
+	images.clear();
+	while (get_next_image_info(team, &cookie, &info) >= B_OK)
+		images.push_back(info);
+}
+
+void CollectAreas(team_id team, std::vector<area_info> &areas)
+{
+	ssize_t cookie = 0;
+	area_info info;
+
+	areas.clear();
+	while (get_next_area_info(team, &cookie, &info) >= B_OK)
+		areas.push_back(info);
+}
+
+void CollectPorts(team_id team, std::vector<port_info> &ports)
+{
+	int32 cookie = 0;
+	port_info info;
+
+	ports.clear();
+	while (get_next_port_info(team, &cookie, &info) >= B_OK)
+		ports.push_back(info);
+}
+
+void CollectSems(team_id team, std::vector<sem_info> &sems)
+{
+	int32 cookie = 0;
+	sem_info info;
+
+	sems.clear();
+	while (get_next_sem_info(team, &cookie, &info) >= B_OK)
+		sems.push_back(info);
+}
+
+void CollectFiles(team_id team, std::vector<FileSample> &files)
+{
+	uint32 cookie = 0;
+	fd_info info;
+
+	files.clear();
+	while (_kern_get_next_fd_info(team, &cookie, &info, sizeof(fd_info)) >= B_OK) {
+		files.resize(files.size() + 1);
+		FileSample &file = files.back();
+		file.info = info;
+		if (_kern_entry_ref_to_path(info.device, info.node, NULL, file.path, sizeof(file.path)) < B_OK)
+			file.path[0] = '\0';
+		if (fs_stat_dev(info.device, &file.fs) < B_OK)
+			memset(&file.fs, 0, sizeof(file.fs));
+	}
+}
+
+void CollectTeamObjects(team_id team, uint32 fields, TeamObjects &objects)
+{
+	objects.team = team;
+	objects.fields = fields;
+	objects.images.clear();
+	objects.areas.clear();
+	objects.ports.clear();
+	objects.sems.clear();
+	objects.files.clear();
+	if ((fields & collectImages) != 0)
+		CollectImages(team, objects.images);
+	if ((fields & collectAreas) != 0)
+		CollectAreas(team, objects.areas);
+	if ((fields & collectPorts) != 0)
+		CollectPorts(team, objects.ports);
+	if ((fields & collectSems) != 0)
+		CollectSems(team, objects.sems);
+	if ((fields & collectFiles) != 0)
+		CollectFiles(team, objects.files);
+}
+
+
+const char *ImageTypeName(int32 type)
+{
+	switch (type) {
+	case B_APP_IMAGE: return "app";
+	case B_LIBRARY_IMAGE: return "lib";
+	case B_ADD_ON_IMAGE: return "addon";
+	case B_SYSTEM_IMAGE: return "sys";
+	}
+	return NULL;
+}
+
+const char *ThreadStateName(int32 state)
+{
+	switch (state) {
+	case B_THREAD_RUNNING: return "running";
+	case B_THREAD_READY: return "ready";
+	case B_THREAD_RECEIVING: return "receiving";
+	case B_THREAD_ASLEEP: return "asleep";
+	case B_THREAD_SUSPENDED: return "suspended";
+	case B_THREAD_WAITING: return "waiting";
+	}
+	return NULL;
+}
+
+const char *AreaLockName(uint32 lock)
+{
+	switch (lock) {
+	case B_NO_LOCK: return "no";
+	case B_LAZY_LOCK: return "lazy";
+	case B_FULL_LOCK: return "full";
+	case B_CONTIGUOUS: return "contiguous";
+	case B_LOMEM: return "lomem";
+	case B_32_BIT_FULL_LOCK: return "32 bit full";
+	case B_32_BIT_CONTIGUOUS: return "32 bit contiguous";
+	case 7: return "already wired";
+	}
+	return NULL;
+}
+
+const char *OpenModeName(int32 openMode)
+{
+	switch (openMode & O_RWMASK) {
+	case O_RDONLY: return "R";
+	case O_WRONLY: return "W";
+	case O_RDWR: return "RW";
+	}
+	return NULL;
+}
+
+void GetAreaProtectionString(char *buf, uint32 protection)
+{
+	static const struct {
+		uint32 flag;
+		char letter;
+	} kFlags[] = {
+		{B_READ_AREA, 'R'},
+		{B_WRITE_AREA, 'W'},
+		{B_EXECUTE_AREA, 'X'},
+		{B_STACK_AREA, 'S'},
+		{B_KERNEL_READ_AREA, 'r'},
+		{B_KERNEL_WRITE_AREA, 'w'},
+		{B_KERNEL_EXECUTE_AREA, 'x'},
+		{B_KERNEL_STACK_AREA, 's'},
+		{B_CLONEABLE_AREA, 'C'},
+	};
+	for (size_t i = 0; i < sizeof(kFlags)/sizeof(kFlags[0]); i++) {
+		if ((protection & kFlags[i].flag) != 0)
+			*buf++ = kFlags[i].letter;
+	}
+	*buf = '\0';
+}
@@ -0,0 +1,96 @@
+#ifndef _COLLECTOR_H_
+#define _COLLECTOR_H_
+
+#include <OS.h>
+#include <image.h>
+#include <fs_info.h>
+#include <private/system/vfs_defs.h>
+
+#include <vector>
+
+#include "Snapshot.h"
+#include "MemoryUsage.h"
+
+
+// Parts of system state that can be collected. Parts that are not
+// requested are not queried from kernel.
+enum {
+	collectSystem  = 1 << 0,
+	collectTeams   = 1 << 1,
+	collectThreads = 1 << 2,
+	collectMemory  = 1 << 3,
+	collectImages  = 1 << 4,
+	collectAreas   = 1 << 5,
+	collectPorts   = 1 << 6,
+	collectSems    = 1 << 7,
+	collectFiles   = 1 << 8,
+
+	collectSnapshot = collectSystem | collectTeams | collectThreads | collectMemory,
+	collectAll = collectSnapshot | collectImages | collectAreas | collectPorts | collectSems | collectFiles,
+};
+
+struct FileSample
+{
+	fd_info info;
+	// Empty if path can't be resolved.
+	char path[B_PATH_NAME_LENGTH];
+	fs_info fs;
+};
+
+
+// Fills snapshots from kernel queries. It has no UI dependencies and is
+// used both by background sampler and by headless streaming mode.
+class Collector
+{
+private:
+	MemoryClassifier fMemoryClassifier;
+
+	void SampleTeamMemory(TeamSample &team);
+
+public:
+	// Only snapshot parts in fields are filled. Teams are always listed,
+	// threads of other teams than kernel are listed only for collectThreads
+	// and collectMemory. CPU usage of kernel team needs its idle threads.
+	// If team is not -1, only that team is sampled, other teams are listed
+	// with their CPU times only if collectSystem is set, because system CPU
+	// usage is summed from teams.
+	void Sample(Snapshot &snapshot, uint32 fields = collectSnapshot, team_id team = -1);
+};
+
+
+// Objects of one team. Vectors are cleared, not freed, so they can be
+// reused without allocations.
+void CollectImages(team_id team, std::vector<image_info> &images);
+void CollectAreas(team_id team, std::vector<area_info> &areas);
+void CollectPorts(team_id team, std::vector<port_info> &ports);
+void CollectSems(team_id team, std::vector<sem_info> &sems);
+void CollectFiles(team_id team, std::vector<FileSample> &files);
+
+// Object lists of one team selected by collectImages, collectAreas,
+// collectPorts, collectSems and collectFiles. Lists that are not in fields
+// are empty.
+struct TeamObjects
+{
+	team_id team;
+	uint32 fields;
+	std::vector<image_info> images;
+	std::vector<area_info> areas;
+	std::vector<port_info> ports;
+	std::vector<sem_info> sems;
+	std::vector<FileSample> files;
+};
+
+void CollectTeamObjects(team_id team, uint32 fields, TeamObjects &objects);
+
+
+// Names of kernel constants, NULL if value is unknown.
+const char *ImageTypeName(int32 type);
+const char *ThreadStateName(int32 state);
+const char *AreaLockName(uint32 lock);
+const char *OpenModeName(int32 openMode);
+
+// Writes flags as letters, buf must have at least 16 bytes.
+void GetAreaProtectionString(char *buf, uint32 protection);
+
+
+#endif	// _COLLECTOR_H_
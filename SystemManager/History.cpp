@@ -0,0 +1,297 @@
+#include "History.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+
+static const char *kSeriesNames[History::seriesCount] = {
+	"cpu",
+	"memory",
+	"cached",
+	"swap",
+	"pageFaults",
+	"sems",
+	"ports",
+	"threads",
+	"teams",
+};
+
+
+// Replaced team tables and histories are not freed while reader is active.
+// Reader is registered before it loads team table, so reader that was not
+// registered when writer checked fReaders sees only current table.
+class History::ReadScope
+{
+private:
+	std::atomic<int32_t> &fReaders;
+
+public:
+	ReadScope(std::atomic<int32_t> &readers): fReaders(readers) {fReaders.fetch_add(1);}
+	~ReadScope() {fReaders.fetch_sub(1);}
+};
+
+
+History::History(size_t capacity):
+	fCapacity(std::max<size_t>(capacity, 2)),
+	fStarted(0),
+	fCount(0),
+	fReaders(0),
+	fTimes(fCapacity),
+	fTeamTable(new TeamTable()),
+	fLastTime(0),
+	fLastPageFaults(0)
+{
+	fSeries.reserve(seriesCount);
+	for (int32_t series = 0; series < seriesCount; series++)
+		fSeries.emplace_back(fCapacity);
+}
+
+History::~History()
+{
+	FreeRetired();
+	delete fTeamTable.load();
+	for (auto &it: fTeams)
+		delete it.second;
+}
+
+
+const char *History::SeriesName(Series series)
+{
+	return kSeriesNames[series];
+}
+
+
+void History::FreeRetired()
+{
+	for (const TeamTable *table: fRetiredTables)
+		delete table;
+	fRetiredTables.clear();
+	for (TeamHistory *team: fRetiredTeams)
+		delete team;
+	fRetiredTeams.clear();
+}
+
+void History::Record(const Snapshot &snapshot)
+{
+	const SystemSample &system = snapshot.system;
+	uint64_t index = fCount.load(std::memory_order_relaxed);
+
+	// Page faults per second since previous sample.
+	double pageFaults = 0;
+	if (fLastTime != 0 && snapshot.time > fLastTime)
+		pageFaults = (system.pageFaults - fLastPageFaults)*1000000.0/(snapshot.time - fLastTime);
+	fLastTime = snapshot.time;
+	fLastPageFaults = system.pageFaults;
+
+	bool teamsChanged = false;
+	for (auto it = fTeams.begin(); it != fTeams.end();) {
+		if (snapshot.FindTeam(it->first) == NULL) {
+			fRetiredTeams.push_back(it->second);
+			it = fTeams.erase(it);
+			teamsChanged = true;
+		} else
+			it++;
+	}
+	for (const TeamSample &team: snapshot.teams) {
+		TeamHistory *&history = fTeams[team.id];
+		if (history == NULL || history->path != team.path) {
+			// New team or exec, start over.
+			if (history != NULL)
+				fRetiredTeams.push_back(history);
+			history = new TeamHistory(index, team.path, fCapacity);
+			teamsChanged = true;
+		}
+	}
+
+	// Slots of sample index - capacity are overwritten from now on.
+	fStarted.store(index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	fTimes.Set(index, snapshot.time);
+	fSeries[cpuSeries].Set(index, system.cpuUsage);
+	fSeries[memorySeries].Set(index, system.maxPages*system.pageSize - system.freeMemory);
+	fSeries[cachedSeries].Set(index, system.cachedPages*system.pageSize);
+	fSeries[swapSeries].Set(index, (system.maxSwapPages - system.freeSwapPages)*system.pageSize);
+	fSeries[pageFaultsSeries].Set(index, pageFaults);
+	fSeries[semsSeries].Set(index, system.usedSems);
+	fSeries[portsSeries].Set(index, system.usedPorts);
+	fSeries[threadsSeries].Set(index, system.usedThreads);
+	fSeries[teamsSeries].Set(index, system.usedTeams);
+	for (const TeamSample &team: snapshot.teams) {
+		TeamHistory *history = fTeams[team.id];
+		history->cpu.Set(index, team.cpuUsage);
+		history->memory.Set(index, team.memAlloc);
+	}
+
+	if (teamsChanged) {
+		TeamTable *table = new TeamTable();
+		table->reserve(fTeams.size());
+		for (const auto &it: fTeams)
+			table->push_back({it.first, it.second});
+		std::sort(table->begin(), table->end());
+		fRetiredTables.push_back(fTeamTable.exchange(table));
+	}
+
+	fCount.store(index + 1, std::memory_order_release);
+
+	if (fReaders.load() == 0)
+		FreeRetired();
+}
+
+
+uint64_t History::FirstReadable(uint64_t count) const
+{
+	return count < fCapacity ? 0 : count - fCapacity;
+}
+
+// Must be called after values from start were copied.
+bool History::IsOverwritten(uint64_t start) const
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return start + fCapacity < fStarted.load(std::memory_order_relaxed);
+}
+
+void History::Copy(std::vector<double> &values, const HistoryRing &ring, uint64_t start, uint64_t end) const
+{
+	values.resize(end - start);
+	for (uint64_t i = start; i < end; i++)
+		values[i - start] = ring.At(i);
+}
+
+void History::CopyAll(HistoryCopy &copy) const
+{
+	ReadScope scope(fReaders);
+	uint64_t count, start;
+	do {
+		count = fCount.load(std::memory_order_acquire);
+		const TeamTable &teams = *fTeamTable.load();
+		start = FirstReadable(count);
+		Copy(copy.times, fTimes, start, count);
+		for (int32_t series = 0; series < seriesCount; series++)
+			Copy(copy.series[series], fSeries[series], start, count);
+		copy.teams.resize(teams.size());
+		for (size_t i = 0; i < teams.size(); i++) {
+			TeamCopy &team = copy.teams[i];
+			const TeamHistory &history = *teams[i].history;
+			uint64_t teamStart = std::min(std::max(start, history.start), count);
+			team.id = teams[i].id;
+			team.path = history.path;
+			team.start = teamStart - start;
+			Copy(team.cpu, history.cpu, teamStart, count);
+			Copy(team.memory, history.memory, teamStart, count);
+		}
+	} while (IsOverwritten(start));
+}
+
+
+void History::Read(Series series, std::vector<double> &values, size_t maxCount) const
+{
+	uint64_t count, start;
+	do {
+		count = fCount.load(std::memory_order_acquire);
+		start = std::max(FirstReadable(count), count - std::min<uint64_t>(count, maxCount));
+		Copy(values, fSeries[series], start, count);
+	} while (IsOverwritten(start));
+}
+
+bool History::ReadTeam(int32_t id, std::vector<double> &cpu, std::vector<double> &memory, size_t maxCount) const
+{
+	ReadScope scope(fReaders);
+	uint64_t count, start;
+	do {
+		count = fCount.load(std::memory_order_acquire);
+		const TeamTable &teams = *fTeamTable.load();
+		auto it = std::lower_bound(teams.begin(), teams.end(), TeamEntry{id, NULL});
+		if (it == teams.end() || it->id != id) {
+			cpu.clear();
+			memory.clear();
+			return false;
+		}
+		start = std::max(FirstReadable(count), count - std::min<uint64_t>(count, maxCount));
+		start = std::min(std::max(start, it->history->start), count);
+		Copy(cpu, it->history->cpu, start, count);
+		Copy(memory, it->history->memory, start, count);
+	} while (IsOverwritten(start));
+	return true;
+}
+
+
+//#pragma mark Export
+
+// Long format: one line per value, team is empty for system series.
+bool History::WriteCsv(FILE *file) const
+{
+	HistoryCopy copy;
+	CopyAll(copy);
+
+	fprintf(file, "time,team,series,value\n");
+	for (size_t i = 0; i < copy.times.size(); i++) {
+		int64_t time = (int64_t)copy.times[i];
+		for (int32_t series = 0; series < seriesCount; series++)
+			fprintf(file, "%" PRId64 ",,%s,%.17g\n", time, kSeriesNames[series], copy.series[series][i]);
+		for (const TeamCopy &team: copy.teams) {
+			if (i < team.start)
+				continue;
+			fprintf(file, "%" PRId64 ",%" PRId32 ",cpu,%.17g\n", time, team.id, team.cpu[i - team.start]);
+			fprintf(file, "%" PRId64 ",%" PRId32 ",memory,%.17g\n", time, team.id, team.memory[i - team.start]);
+		}
+	}
+	return ferror(file) == 0;
+}
+
+
+static void WriteJsonString(FILE *file, const std::string &str)
+{
+	fputc('"', file);
+	for (char c: str) {
+		switch (c) {
+		case '"': fputs("\\\"", file); break;
+		case '\\': fputs("\\\\", file); break;
+		default:
+			if ((uint8_t)c < 0x20)
+				fprintf(file, "\\u%04x", c);
+			else
+				fputc(c, file);
+		}
+	}
+	fputc('"', file);
+}
+
+static void WriteJsonArray(FILE *file, const std::vector<double> &values)
+{
+	fputc('[', file);
+	for (size_t i = 0; i < values.size(); i++) {
+		if (i > 0) fputc(',', file);
+		fprintf(file, "%.17g", values[i]);
+	}
+	fputc(']', file);
+}
+
+bool History::WriteJson(FILE *file) const
+{
+	HistoryCopy copy;
+	CopyAll(copy);
+
+	fprintf(file, "{\n\t\"time\": ");
+	WriteJsonArray(file, copy.times);
+	fprintf(file, ",\n\t\"system\": {");
+	for (int32_t series = 0; series < seriesCount; series++) {
+		fprintf(file, "%s\n\t\t\"%s\": ", series > 0 ? "," : "", kSeriesNames[series]);
+		WriteJsonArray(file, copy.series[series]);
+	}
+	fprintf(file, "\n\t},\n\t\"teams\": [");
+	bool first = true;
+	for (const TeamCopy &team: copy.teams) {
+		fprintf(file, "%s\n\t\t{\"id\": %" PRId32 ", \"path\": ", first ? "" : ",", team.id);
+		WriteJsonString(file, team.path);
+		fprintf(file, ", \"start\": %zu, \"cpu\": ", team.start);
+		WriteJsonArray(file, team.cpu);
+		fprintf(file, ", \"memory\": ");
+		WriteJsonArray(file, team.memory);
+		fputc('}', file);
+		first = false;
+	}
+	fprintf(file, "\n\t]\n}\n");
+	return ferror(file) == 0;
+}
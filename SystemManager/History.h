@@ -0,0 +1,140 @@
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "Snapshot.h"
+
+
+// Fixed size storage of values indexed by sample number. Slot of sample i
+// is reused by sample i + capacity. Slots are atomic, so they can be read
+// while writer stores new values.
+class HistoryRing
+{
+private:
+	std::vector<std::atomic<double>> fValues;
+
+public:
+	HistoryRing(size_t capacity): fValues(capacity) {}
+
+	void Set(uint64_t index, double value) {fValues[index % fValues.size()].store(value, std::memory_order_relaxed);}
+	double At(uint64_t index) const {return fValues[index % fValues.size()].load(std::memory_order_relaxed);}
+};
+
+
+// Keeps last capacity samples of system statistics and of CPU and memory
+// usage of each team. Memory is allocated only when team appears.
+//
+// Record() is called from single writer thread and never waits for
+// readers. Writer publishes number of started sample before it overwrites
+// slots and number of complete samples after that. Readers copy values
+// without lock and retry if slots they copied were overwritten meanwhile.
+// Team list is published as immutable table that is replaced when teams
+// change, replaced tables and histories of removed teams are freed by
+// writer when no reader is active.
+class History
+{
+public:
+	enum Series {
+		cpuSeries,
+		memorySeries,
+		cachedSeries,
+		swapSeries,
+		pageFaultsSeries,
+		semsSeries,
+		portsSeries,
+		threadsSeries,
+		teamsSeries,
+		seriesCount
+	};
+
+	enum {
+		kDefaultCapacity = 1200,
+	};
+
+private:
+	struct TeamHistory {
+		uint64_t start;
+		std::string path;
+		HistoryRing cpu;
+		HistoryRing memory;
+
+		TeamHistory(uint64_t start, const std::string &path, size_t capacity):
+			start(start), path(path), cpu(capacity), memory(capacity) {}
+	};
+
+	struct TeamEntry {
+		int32_t id;
+		TeamHistory *history;
+
+		bool operator<(const TeamEntry &other) const {return id < other.id;}
+	};
+
+	// Ordered by team ID.
+	typedef std::vector<TeamEntry> TeamTable;
+
+	struct TeamCopy {
+		int32_t id;
+		std::string path;
+		// Index of first value in copy of time series.
+		size_t start;
+		std::vector<double> cpu;
+		std::vector<double> memory;
+	};
+
+	struct HistoryCopy {
+		std::vector<double> times;
+		std::vector<double> series[seriesCount];
+		std::vector<TeamCopy> teams;
+	};
+
+	class ReadScope;
+
+	size_t fCapacity;
+	std::atomic<uint64_t> fStarted;
+	std::atomic<uint64_t> fCount;
+	mutable std::atomic<int32_t> fReaders;
+	HistoryRing fTimes;
+	std::vector<HistoryRing> fSeries;
+	std::atomic<const TeamTable*> fTeamTable;
+
+	// Used only by writer.
+	int64_t fLastTime;
+	uint32_t fLastPageFaults;
+	std::unordered_map<int32_t, TeamHistory*> fTeams;
+	std::vector<const TeamTable*> fRetiredTables;
+	std::vector<TeamHistory*> fRetiredTeams;
+
+	void FreeRetired();
+
+	uint64_t FirstReadable(uint64_t count) const;
+	bool IsOverwritten(uint64_t start) const;
+	void Copy(std::vector<double> &values, const HistoryRing &ring, uint64_t start, uint64_t end) const;
+	void CopyAll(HistoryCopy &copy) const;
+
+public:
+	History(size_t capacity = kDefaultCapacity);
+	~History();
+
+	static const char *SeriesName(Series series);
+
+	size_t Capacity() const {return fCapacity;}
+
+	void Record(const Snapshot &snapshot);
+
+	// Copy up to maxCount most recent values, oldest first.
+	void Read(Series series, std::vector<double> &values, size_t maxCount) const;
+	bool ReadTeam(int32_t id, std::vector<double> &cpu, std::vector<double> &memory, size_t maxCount) const;
+
+	bool WriteCsv(FILE *file) const;
+	bool WriteJson(FILE *file) const;
+};
+
+
+#endif	// _HISTORY_H_
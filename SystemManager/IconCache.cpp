@@ -0,0 +1,156 @@
+#include "IconCache.h"
+
+#include <sys/stat.h>
+
+#include <Autolock.h>
+#include <Bitmap.h>
+#include <Entry.h>
+#include <Message.h>
+#include <Mime.h>
+#include <NodeInfo.h>
+
+
+static BBitmap *NewMiniIconBitmap()
+{
+	return new BBitmap(BRect(0, 0, B_MINI_ICON - 1, B_MINI_ICON - 1), B_RGBA32);
+}
+
+
+IconCache::IconCache(size_t maxCount):
+	fLocker("icon cache"),
+	fMaxCount(maxCount),
+	fRequestSem(-1),
+	fThread(-1),
+	fQuitting(false)
+{
+	BBitmap *icon = NewMiniIconBitmap();
+	BMimeType genericAppType(B_APP_MIME_TYPE);
+	genericAppType.GetIcon(icon, B_MINI_ICON);
+	fPlaceholder.SetTo(new Icon(icon), true);
+}
+
+IconCache::~IconCache()
+{
+	if (fThread >= B_OK) {
+		{
+			BAutolock lock(fLocker);
+			fQuitting = true;
+		}
+		release_sem(fRequestSem);
+		status_t res;
+		wait_for_thread(fThread, &res);
+		delete_sem(fRequestSem);
+	}
+}
+
+IconCache &IconCache::Default()
+{
+	static IconCache cache;
+	return cache;
+}
+
+
+void IconCache::SetTarget(const BMessenger &target)
+{
+	BAutolock lock(fLocker);
+	fTarget = target;
+}
+
+
+BReference<IconCache::Icon> IconCache::Get(const char *path)
+{
+	struct stat st;
+	if (path == NULL || path[0] == '\0' || stat(path, &st) < 0)
+		return fPlaceholder;
+
+	Key key = {
+		.device = st.st_dev,
+		.node = st.st_ino,
+		.modified = (bigtime_t)st.st_mtim.tv_sec*1000000 + st.st_mtim.tv_nsec/1000
+	};
+
+	BAutolock lock(fLocker);
+	auto it = fIndex.find(key);
+	if (it != fIndex.end()) {
+		fEntries.splice(fEntries.begin(), fEntries, it->second);
+		return it->second->icon;
+	}
+
+	if (fPending.insert(key).second) {
+		fRequests.push_back({key, path});
+		if (fThread < B_OK) {
+			fRequestSem = create_sem(0, "icon requests");
+			fThread = spawn_thread(ThreadEntry, "icon loader", B_LOW_PRIORITY, this);
+			resume_thread(fThread);
+		}
+		release_sem(fRequestSem);
+	}
+	return fPlaceholder;
+}
+
+
+void IconCache::Insert(const Key &key, Icon *icon)
+{
+	fEntries.push_front({key, BReference<Icon>(icon, true)});
+	fIndex[key] = fEntries.begin();
+	while (fEntries.size() > fMaxCount) {
+		fIndex.erase(fEntries.back().key);
+		fEntries.pop_back();
+	}
+}
+
+IconCache::Icon *IconCache::Load(const char *path)
+{
+	BEntry entry(path, true);
+	entry_ref ref;
+	if (entry.GetRef(&ref) < B_OK)
+		return NULL;
+	ObjectDeleter<BBitmap> icon(NewMiniIconBitmap());
+	if (BNodeInfo::GetTrackerIcon(&ref, icon.Get(), B_MINI_ICON) < B_OK)
+		return NULL;
+	return new Icon(icon.Detach());
+}
+
+
+status_t IconCache::ThreadEntry(void *arg)
+{
+	((IconCache*)arg)->Run();
+	return B_OK;
+}
+
+void IconCache::Run()
+{
+	for (;;) {
+		while (acquire_sem(fRequestSem) == B_INTERRUPTED) {}
+		Request request;
+		{
+			BAutolock lock(fLocker);
+			if (fQuitting)
+				return;
+			if (fRequests.empty())
+				continue;
+			request = fRequests.front();
+			fRequests.pop_front();
+		}
+
+		// Failed lookups are cached as placeholder to not retry them on each
+		// refresh.
+		Icon *icon = Load(request.path);
+		BMessenger target;
+		{
+			BAutolock lock(fLocker);
+			fPending.erase(request.key);
+			if (icon != NULL)
+				Insert(request.key, icon);
+			else {
+				fPlaceholder->AcquireReference();
+				Insert(request.key, fPlaceholder.Get());
+			}
+			target = fTarget;
+		}
+
+		BMessage msg(iconCacheLoadedMsg);
+		msg.AddString("path", request.path);
+		target.SendMessage(&msg);
+	}
+}
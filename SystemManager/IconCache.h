@@ -0,0 +1,107 @@
+#ifndef _ICONCACHE_H_
+#define _ICONCACHE_H_
+
+#include <OS.h>
+#include <Locker.h>
+#include <Messenger.h>
+#include <Referenceable.h>
+#include <String.h>
+#include <private/shared/AutoDeleter.h>
+
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
+class BBitmap;
+
+
+enum {
+	iconCacheLoadedMsg = 'iclo',
+};
+
+
+// Mini icons of executables keyed by device, node and modification time of
+// the file, so a lookup does no I/O except stat(). Icons that are not cached
+// yet are loaded on a background thread. Meanwhile Get() returns placeholder
+// icon and when loading is done, iconCacheLoadedMsg with "path" field is sent
+// to the target.
+class IconCache
+{
+public:
+	class Icon: public BReferenceable
+	{
+	private:
+		ObjectDeleter<BBitmap> fBitmap;
+
+	public:
+		Icon(BBitmap *bitmap): fBitmap(bitmap) {}
+		inline BBitmap *Bitmap() {return fBitmap.Get();}
+	};
+
+private:
+	struct Key
+	{
+		dev_t device;
+		ino_t node;
+		bigtime_t modified;
+
+		bool operator==(const Key &other) const
+		{
+			return device == other.device && node == other.node && modified == other.modified;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key &key) const
+		{
+			return std::hash<ino_t>()(key.node) ^ ((size_t)key.device << 20) ^ (size_t)key.modified;
+		}
+	};
+
+	struct Entry
+	{
+		Key key;
+		BReference<Icon> icon;
+	};
+
+	struct Request
+	{
+		Key key;
+		BString path;
+	};
+
+	typedef std::list<Entry> EntryList;
+
+	BLocker fLocker;
+	BMessenger fTarget;
+	size_t fMaxCount;
+	BReference<Icon> fPlaceholder;
+	EntryList fEntries; // most recently used first
+	std::unordered_map<Key, EntryList::iterator, KeyHash> fIndex;
+	std::deque<Request> fRequests;
+	std::unordered_set<Key, KeyHash> fPending;
+	sem_id fRequestSem;
+	thread_id fThread;
+	bool fQuitting;
+
+	static status_t ThreadEntry(void *arg);
+	void Run();
+	Icon *Load(const char *path);
+	void Insert(const Key &key, Icon *icon);
+
+public:
+	IconCache(size_t maxCount = 256);
+	~IconCache();
+
+	static IconCache &Default();
+
+	void SetTarget(const BMessenger &target);
+
+	BReference<Icon> Placeholder() {return fPlaceholder;}
+	BReference<Icon> Get(const char *path);
+};
+
+
+#endif	// _ICONCACHE_H_
@@ -0,0 +1,89 @@
+#include "MemoryList.h"
+
+#include <private/interface/ColumnListView.h>
+#include <private/interface/ColumnTypes.h>
+
+#include "UIUtils.h"
+#include "MemoryUsage.h"
+
+
+enum {
+	memoryKindCol = 0,
+	memoryNameCol,
+	memoryTeamsCol,
+	memoryAreasCol,
+	memorySizeCol,
+	memoryRamCol,
+	memorySharedCol,
+	memoryDeltaCol,
+};
+
+
+static bool SetSizeField(BRow *row, int32 col, off_t value)
+{
+	BSizeField *field = static_cast<BSizeField*>(row->GetField(col));
+	if (field->Size() == value)
+		return false;
+	field->SetSize(value);
+	return true;
+}
+
+
+void ListMemoryGroups(RowIndex &rows, const MemoryGroupSample *groups, size_t count)
+{
+	BColumnListView *view = rows.View();
+	BRow *row;
+
+	rows.BeginUpdate();
+
+	for (size_t i = 0; i < count; i++) {
+		const MemoryGroupSample &group = groups[i];
+		row = rows.Touch(group.id);
+		bool isNew = row == NULL;
+		bool changed = false;
+		if (isNew) {
+			row = new BRow();
+			row->SetField(new BStringField(MemoryKindName(group.kind)), memoryKindCol);
+			row->SetField(new BStringField(group.name.c_str()), memoryNameCol);
+			row->SetField(new BIntegerField(0), memoryTeamsCol);
+			row->SetField(new BIntegerField(0), memoryAreasCol);
+			row->SetField(new BSizeField(0), memorySizeCol);
+			row->SetField(new BSizeField(0), memoryRamCol);
+			row->SetField(new BSizeField(0), memorySharedCol);
+			row->SetField(new Int64Field(0), memoryDeltaCol);
+		}
+
+		changed |= SetIntField(row, memoryTeamsCol, group.teamCount);
+		changed |= SetIntField(row, memoryAreasCol, group.areaCount);
+		changed |= SetSizeField(row, memorySizeCol, group.size);
+		changed |= SetSizeField(row, memoryRamCol, group.ram);
+		changed |= SetSizeField(row, memorySharedCol, group.sharedRam);
+		changed |= SetInt64Field(row, memoryDeltaCol, group.ramDelta);
+
+		if (isNew)
+			rows.Add(group.id, row);
+		else if (changed)
+			view->UpdateRow(row);
+	}
+
+	rows.EndUpdate();
+}
+
+BColumnListView *NewMemoryGroupsView(RowIndex &rows, bool showTeams)
+{
+	BColumnListView *view;
+	view = new BColumnListView("Memory", B_NAVIGABLE);
+	view->AddColumn(new BStringColumn("Kind", 80, 32, 128, B_TRUNCATE_END), memoryKindCol);
+	view->AddColumn(new BStringColumn("Owner", 250, 50, 1024, B_TRUNCATE_MIDDLE), memoryNameCol);
+	view->AddColumn(new BIntegerColumn("Teams", 64, 32, 128, B_ALIGN_RIGHT), memoryTeamsCol);
+	view->AddColumn(new BIntegerColumn("Areas", 64, 32, 128, B_ALIGN_RIGHT), memoryAreasCol);
+	view->AddColumn(new BSizeColumn("Size", 96, 32, 256, B_ALIGN_RIGHT), memorySizeCol);
+	view->AddColumn(new BSizeColumn("RAM", 96, 32, 256, B_ALIGN_RIGHT), memoryRamCol);
+	view->AddColumn(new BSizeColumn("Shared", 96, 32, 256, B_ALIGN_RIGHT), memorySharedCol);
+	view->AddColumn(new SizeDeltaColumn("Change", 96, 32, 256), memoryDeltaCol);
+	if (!showTeams)
+		view->ColumnAt(memoryTeamsCol)->SetVisible(false);
+	view->SetSortColumn(view->ColumnAt(memoryDeltaCol), false, false);
+	rows.SetView(view);
+	return view;
+}
@@ -0,0 +1,18 @@
+#ifndef _MEMORYLIST_H_
+#define _MEMORYLIST_H_
+
+#include <stddef.h>
+
+#include "RowIndex.h"
+#include "Snapshot.h"
+
+class BColumnListView;
+
+
+// List of memory groups of team or of whole system, sorted by RAM change
+// so growing owners are on top.
+BColumnListView *NewMemoryGroupsView(RowIndex &rows, bool showTeams);
+void ListMemoryGroups(RowIndex &rows, const MemoryGroupSample *groups, size_t count);
+
+
+#endif	// _MEMORYLIST_H_
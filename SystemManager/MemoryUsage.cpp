@@ -0,0 +1,206 @@
+#include "MemoryUsage.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include <algorithm>
+
+
+static const char *kMemoryKindNames[memoryKindCount] = {
+	"text",
+	"data",
+	"heap",
+	"stack",
+	"anonymous",
+};
+
+static const char *kHeapName = "heap";
+static const char *kStackName = "stacks";
+
+
+static uint64_t GroupId(uint8_t kind, const std::string &name)
+{
+	return std::hash<std::string>()(name)*memoryKindCount + kind;
+}
+
+static bool IsHeapName(const char *name)
+{
+	char lower[64];
+	size_t i = 0;
+	for (; name[i] != '\0' && i < sizeof(lower) - 1; i++)
+		lower[i] = tolower(name[i]);
+	lower[i] = '\0';
+	return strstr(lower, "heap") != NULL || strstr(lower, "malloc") != NULL;
+}
+
+
+MemoryClassifier::MemoryClassifier():
+	fSorted(true)
+{}
+
+
+void MemoryClassifier::BeginTeam()
+{
+	fRanges.clear();
+	fSorted = true;
+	fGroups.clear();
+	for (auto &index: fGroupIndex)
+		index.clear();
+}
+
+void MemoryClassifier::AddImage(const char *path, uint64_t textStart, uint64_t textSize, uint64_t dataStart, uint64_t dataSize)
+{
+	if (textSize > 0)
+		fRanges.push_back({textStart, textStart + textSize, textMemory, path});
+	if (dataSize > 0)
+		fRanges.push_back({dataStart, dataStart + dataSize, dataMemory, path});
+	fSorted = false;
+}
+
+void MemoryClassifier::AddStack(uint64_t start, uint64_t end)
+{
+	if (end > start) {
+		fRanges.push_back({start, end, stackMemory, kStackName});
+		fSorted = false;
+	}
+}
+
+
+// Ranges do not overlap, so only the last range that starts before end of
+// area can intersect it.
+const MemoryClassifier::Range *MemoryClassifier::FindRange(uint64_t start, uint64_t end)
+{
+	if (!fSorted) {
+		std::sort(fRanges.begin(), fRanges.end(), [](const Range &a, const Range &b) {
+			return a.start < b.start;
+		});
+		fSorted = true;
+	}
+	auto it = std::lower_bound(fRanges.begin(), fRanges.end(), end, [](const Range &range, uint64_t end) {
+		return range.start < end;
+	});
+	if (it == fRanges.begin())
+		return NULL;
+	--it;
+	if (it->end <= start)
+		return NULL;
+	return &*it;
+}
+
+void MemoryClassifier::AddArea(const Area &area)
+{
+	uint8_t kind;
+	const char *owner;
+	const Range *range = FindRange(area.address, area.address + area.size);
+	if (range != NULL) {
+		kind = range->kind;
+		owner = range->owner.c_str();
+	} else if (IsHeapName(area.name)) {
+		kind = heapMemory;
+		owner = kHeapName;
+	} else {
+		kind = anonymousMemory;
+		owner = area.name;
+	}
+
+	auto it = fGroupIndex[kind].find(owner);
+	MemoryGroupSample *group;
+	if (it == fGroupIndex[kind].end()) {
+		fGroupIndex[kind][owner] = fGroups.size();
+		fGroups.push_back({});
+		group = &fGroups.back();
+		group->kind = kind;
+		group->name = owner;
+		group->id = GroupId(kind, group->name);
+		group->teamCount = 1;
+	} else
+		group = &fGroups[it->second];
+
+	group->areaCount++;
+	group->size += area.size;
+	group->ram += area.ram;
+	// Read-only segments are mapped from file cache and shared between
+	// teams that use the same image.
+	if (area.cloneable || (kind == textMemory && !area.writable))
+		group->sharedRam += area.ram;
+}
+
+void MemoryClassifier::EndTeam(Snapshot &snapshot, TeamSample &team)
+{
+	team.firstMemoryGroup = snapshot.memoryGroups.size();
+	team.memoryGroupCount = fGroups.size();
+	for (MemoryGroupSample &group: fGroups) {
+		group.team = team.id;
+		snapshot.memoryGroups.push_back(std::move(group));
+	}
+	fGroups.clear();
+}
+
+
+const char *MemoryKindName(uint8_t kind)
+{
+	if (kind >= memoryKindCount)
+		return "?";
+	return kMemoryKindNames[kind];
+}
+
+
+void SumSystemMemory(Snapshot &snapshot)
+{
+	std::unordered_map<uint64_t, size_t> index;
+	std::vector<MemoryGroupSample> &groups = snapshot.systemMemoryGroups;
+	groups.clear();
+	for (const MemoryGroupSample &teamGroup: snapshot.memoryGroups) {
+		auto it = index.find(teamGroup.id);
+		if (it == index.end()) {
+			index[teamGroup.id] = groups.size();
+			groups.push_back(teamGroup);
+			groups.back().team = -1;
+			continue;
+		}
+		MemoryGroupSample &group = groups[it->second];
+		group.teamCount++;
+		group.areaCount += teamGroup.areaCount;
+		group.size += teamGroup.size;
+		// Private parts are summed, shared part is mapped by each team.
+		group.ram = group.ram - group.sharedRam + teamGroup.ram - teamGroup.sharedRam;
+		group.sharedRam = std::max(group.sharedRam, teamGroup.sharedRam);
+		group.ram += group.sharedRam;
+	}
+}
+
+
+static void ComputeDeltas(MemoryGroupSample *cur, size_t curCount, const MemoryGroupSample *prev, size_t prevCount)
+{
+	std::unordered_map<uint64_t, const MemoryGroupSample*> prevIndex;
+	prevIndex.reserve(prevCount);
+	for (size_t i = 0; i < prevCount; i++)
+		prevIndex[prev[i].id] = &prev[i];
+	for (size_t i = 0; i < curCount; i++) {
+		auto it = prevIndex.find(cur[i].id);
+		cur[i].ramDelta = cur[i].ram;
+		if (it != prevIndex.end())
+			cur[i].ramDelta -= it->second->ram;
+	}
+}
+
+void ComputeMemoryDeltas(Snapshot &cur, const Snapshot &prev)
+{
+	// All memory is not new in the first snapshot.
+	if (prev.time == 0) {
+		for (MemoryGroupSample &group: cur.memoryGroups)
+			group.ramDelta = 0;
+		for (MemoryGroupSample &group: cur.systemMemoryGroups)
+			group.ramDelta = 0;
+		return;
+	}
+	ComputeDeltas(cur.systemMemoryGroups.data(), cur.systemMemoryGroups.size(),
+		prev.systemMemoryGroups.data(), prev.systemMemoryGroups.size());
+
+	for (TeamSample &team: cur.teams) {
+		const TeamSample *prevTeam = prev.FindTeam(team.id);
+		ComputeDeltas(cur.memoryGroups.data() + team.firstMemoryGroup, team.memoryGroupCount,
+			prevTeam != NULL ? prev.memoryGroups.data() + prevTeam->firstMemoryGroup : NULL,
+			prevTeam != NULL ? prevTeam->memoryGroupCount : 0);
+	}
+}
@@ -0,0 +1,67 @@
+#ifndef _MEMORYUSAGE_H_
+#define _MEMORYUSAGE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "Snapshot.h"
+
+
+// Attributes areas of one team to their owners: text and data segments of
+// images, heap, thread stacks or anonymous memory named by area. Owner
+// ranges are sorted once per team, so each area is classified by binary
+// search.
+class MemoryClassifier
+{
+public:
+	struct Area {
+		uint64_t address;
+		uint64_t size;
+		uint64_t ram;
+		const char *name;
+		bool writable;
+		bool cloneable;
+	};
+
+private:
+	struct Range {
+		uint64_t start;
+		uint64_t end;
+		uint8_t kind;
+		std::string owner;
+	};
+
+	std::vector<Range> fRanges;
+	bool fSorted;
+	std::vector<MemoryGroupSample> fGroups;
+	std::unordered_map<std::string, size_t> fGroupIndex[memoryKindCount];
+
+	const Range *FindRange(uint64_t start, uint64_t end);
+
+public:
+	MemoryClassifier();
+
+	void BeginTeam();
+	void AddImage(const char *path, uint64_t textStart, uint64_t textSize, uint64_t dataStart, uint64_t dataSize);
+	void AddStack(uint64_t start, uint64_t end);
+	void AddArea(const Area &area);
+	// Appends groups to snapshot and sets group range of team.
+	void EndTeam(Snapshot &snapshot, TeamSample &team);
+};
+
+
+const char *MemoryKindName(uint8_t kind);
+
+// Merges groups of all teams into Snapshot::systemMemoryGroups. Shared
+// memory of the same owner is counted once.
+void SumSystemMemory(Snapshot &snapshot);
+
+// Sets ram deltas of cur groups against prev. Groups that are not in prev
+// get delta equal to their ram.
+void ComputeMemoryDeltas(Snapshot &cur, const Snapshot &prev);
+
+
+#endif	// _MEMORYUSAGE_H_
@@ -0,0 +1,313 @@
+#include "ProfileWindow.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <map>
+
+#include <Application.h>
+#include <Autolock.h>
+#include <FilePanel.h>
+#include <LayoutBuilder.h>
+#include <Menu.h>
+#include <MenuBar.h>
+#include <MenuItem.h>
+#include <Path.h>
+#include <String.h>
+#include <StringView.h>
+#include <image.h>
+#include <private/interface/ColumnListView.h>
+#include <private/interface/ColumnTypes.h>
+#include <private/shared/AutoLocker.h>
+
+#include "Errors.h"
+#include "Utils.h"
+#include "UIUtils.h"
+
+
+enum {
+	nodeNameCol = 0,
+	nodeTotalCol,
+	nodeSelfCol,
+	nodePercentCol,
+};
+
+enum {
+	startStopMsg = 1,
+	resetMsg,
+	refreshMsg,
+	statusUpdateMsg,
+	setFrequencyMsg,
+	setViewMsg,
+	saveFoldedMsg,
+	saveFoldedPanelMsg,
+};
+
+enum {
+	kStatusUpdateInterval = 500000,
+	// Nodes below this fraction of all samples are not shown.
+	kMinPermille = 1,
+};
+
+
+static BMessage *NewSetFrequencyMsg(int32 frequency)
+{
+	BMessage *msg = new BMessage(setFrequencyMsg);
+	msg->SetInt32("val", frequency);
+	return msg;
+}
+
+static BMessage *NewSetViewMsg(bool bottomUp)
+{
+	BMessage *msg = new BMessage(setViewMsg);
+	msg->SetBool("val", bottomUp);
+	return msg;
+}
+
+
+static void AddNodeRows(BColumnListView *view, const CallTree &tree, uint32 node, BRow *parent)
+{
+	uint64 rootTotal = tree.TotalSamples();
+	std::vector<uint32> children;
+	for (auto &it: tree.NodeAt(node).children) {
+		if (tree.NodeAt(it.second).total*1000 >= rootTotal*kMinPermille)
+			children.push_back(it.second);
+	}
+	std::sort(children.begin(), children.end(), [&tree](uint32 a, uint32 b) {
+		return tree.NodeAt(a).total > tree.NodeAt(b).total;
+	});
+	for (uint32 child: children) {
+		const CallTree::Node &info = tree.NodeAt(child);
+		BRow *row = new BRow();
+		row->SetField(new BStringField(tree.Name(info.name).c_str()), nodeNameCol);
+		row->SetField(new BIntegerField(info.total), nodeTotalCol);
+		row->SetField(new BIntegerField(info.self), nodeSelfCol);
+		row->SetField(new FloatField(100.0f*info.total/rootTotal), nodePercentCol);
+		view->AddRow(row, parent);
+		AddNodeRows(view, tree, child, row);
+		// Expand hot paths.
+		if (info.total*10 >= rootTotal)
+			view->ExpandOrCollapse(row, true);
+	}
+}
+
+
+void ProfileWindow::UpdateStatus()
+{
+	Profiler::Stats stats;
+	{
+		AutoLocker<Profiler> lock(fProfiler);
+		stats = fProfiler.GetStats();
+	}
+	BString str;
+	str.SetToFormat("%s, %" B_PRIu64 " samples, %" B_PRIu64 " ticks", fProfiler.IsRunning() ? "Running" : "Stopped", stats.samples, stats.ticks);
+	if (stats.ticks > 0) {
+		str << BString().SetToFormat(", tick time avg %" B_PRId64 " us, max %" B_PRId64 " us",
+			stats.tickTime/stats.ticks, stats.maxTickTime);
+	}
+	if (stats.runTime > 0)
+		str << BString().SetToFormat(", overhead %.2f%%", 100.0*stats.tickTime/stats.runTime);
+	fStatusView->SetText(str);
+	fStartItem->SetLabel(fProfiler.IsRunning() ? "Stop" : "Start");
+
+	if (!fProfiler.IsRunning() && stats.samples != fShownSamples)
+		UpdateTree();
+}
+
+void ProfileWindow::UpdateTree()
+{
+	CallTree tree;
+	{
+		AutoLocker<Profiler> lock(fProfiler);
+		tree = fProfiler.Tree();
+		fShownSamples = fProfiler.GetStats().samples;
+	}
+	if (fBottomUp)
+		tree = tree.Inverted();
+
+	fView->Clear();
+	if (tree.TotalSamples() == 0)
+		return;
+	AddNodeRows(fView, tree, CallTree::kRoot, NULL);
+}
+
+void ProfileWindow::SaveFolded(const char *path)
+{
+	CallTree tree;
+	{
+		AutoLocker<Profiler> lock(fProfiler);
+		tree = fProfiler.Tree();
+	}
+	FILE *file = fopen(path, "w");
+	if (file == NULL)
+		CheckErrno(-1, "Can't create file.");
+	bool ok = tree.WriteFolded(file);
+	if (fclose(file) != 0) ok = false;
+	if (!ok)
+		Check(B_IO_ERROR, "Can't write folded stacks.");
+}
+
+
+std::map<team_id, ProfileWindow*> profileWindows;
+BLocker profileWindowsLocker;
+
+void OpenProfileWindow(team_id team, BPoint center)
+{
+	AutoLocker<BLocker> locker(profileWindowsLocker);
+	auto it = profileWindows.find(team);
+	if (it != profileWindows.end()) {
+		it->second->Activate();
+	} else {
+		ProfileWindow *wnd = new ProfileWindow(team);
+		profileWindows[team] = wnd;
+		BRect frame = wnd->Frame();
+		wnd->MoveTo(center.x - frame.Width()/2, center.y - frame.Height()/2);
+		wnd->Show();
+	}
+}
+
+ProfileWindow::ProfileWindow(team_id team): BWindow(BRect(0, 0, 800, 480), "Profile", B_DOCUMENT_WINDOW, B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS),
+	fUpdater(BMessenger(this), BMessage(statusUpdateMsg), kStatusUpdateInterval),
+	fProfiler(team),
+	fFrequency(100),
+	fBottomUp(false),
+	fShownSamples(0),
+	fTeam(team)
+{
+	BMenuBar *menuBar;
+	BMenu *frequencyMenu, *viewMenu;
+
+	int32 cookie = 0;
+	image_info imageInfo;
+	BString title;
+	if (get_next_image_info(fTeam, &cookie, &imageInfo) >= B_OK)
+		title.SetToFormat("Profile: %s (%" B_PRId32 ")", GetFileName(imageInfo.name), fTeam);
+	else
+		title.SetToFormat("Profile: team %" B_PRId32, fTeam);
+	SetTitle(title.String());
+
+	menuBar = new BMenuBar("menu", B_ITEMS_IN_ROW, true);
+	BLayoutBuilder::Menu<>(menuBar)
+		.AddMenu(new BMenu("File"))
+			.AddItem(new BMenuItem("Save folded stacks" B_UTF8_ELLIPSIS, new BMessage(saveFoldedMsg), 'S'))
+			.AddSeparator()
+			.AddItem(new BMenuItem("Close", new BMessage(B_QUIT_REQUESTED), 'W'))
+		.End()
+		.AddMenu(new BMenu("Profile"))
+			.AddItem(fStartItem = new BMenuItem("Start", new BMessage(startStopMsg), 'P'))
+			.AddItem(new BMenuItem("Reset", new BMessage(resetMsg)))
+			.AddMenu(frequencyMenu = new BMenu("Sampling rate"))
+				.AddItem(new BMenuItem("10 Hz", NewSetFrequencyMsg(10)))
+				.AddItem(new BMenuItem("50 Hz", NewSetFrequencyMsg(50)))
+				.AddItem(new BMenuItem("100 Hz", NewSetFrequencyMsg(100)))
+				.AddItem(new BMenuItem("250 Hz", NewSetFrequencyMsg(250)))
+				.AddItem(new BMenuItem("1000 Hz", NewSetFrequencyMsg(1000)))
+			.End()
+		.End()
+		.AddMenu(viewMenu = new BMenu("View"))
+			.AddItem(new BMenuItem("Top-down", NewSetViewMsg(false)))
+			.AddItem(new BMenuItem("Bottom-up", NewSetViewMsg(true)))
+			.AddSeparator()
+			.AddItem(new BMenuItem("Refresh", new BMessage(refreshMsg), 'R'))
+		.End()
+	.End();
+
+	frequencyMenu->SetRadioMode(true);
+	frequencyMenu->ItemAt(2)->SetMarked(true);
+	viewMenu->SetRadioMode(true);
+	viewMenu->ItemAt(0)->SetMarked(true);
+
+	fView = new BColumnListView("Calls", B_NAVIGABLE);
+	fView->AddColumn(new BStringColumn("Function", 512, 50, 2048, B_TRUNCATE_MIDDLE), nodeNameCol);
+	fView->AddColumn(new BIntegerColumn("Total", 80, 32, 256, B_ALIGN_RIGHT), nodeTotalCol);
+	fView->AddColumn(new BIntegerColumn("Self", 80, 32, 256, B_ALIGN_RIGHT), nodeSelfCol);
+	fView->AddColumn(new PercentColumn("Total %", 80, 32, 256), nodePercentCol);
+
+	fStatusView = new BStringView("status", "");
+
+	BLayoutBuilder::Group<>(this, B_VERTICAL, 0)
+		.Add(menuBar)
+		.AddGroup(B_VERTICAL, 0)
+			.Add(fView)
+			.SetInsets(-1)
+		.End()
+		.AddGroup(B_HORIZONTAL)
+			.Add(fStatusView)
+			.AddGlue()
+			.SetInsets(B_USE_SMALL_SPACING)
+		.End()
+	.End();
+
+	UpdateStatus();
+}
+
+ProfileWindow::~ProfileWindow()
+{
+	fProfiler.Stop();
+	AutoLocker<BLocker> locker(profileWindowsLocker);
+	profileWindows.erase(fTeam);
+}
+
+
+void ProfileWindow::MessageReceived(BMessage *msg)
+{
+	try {
+		switch (msg->what) {
+		case startStopMsg: {
+			if (fProfiler.IsRunning())
+				fProfiler.Stop();
+			else
+				Check(fProfiler.Start(fFrequency), "Can't start profiling.");
+			UpdateStatus();
+			return;
+		}
+		case resetMsg: {
+			fProfiler.Reset();
+			UpdateTree();
+			UpdateStatus();
+			return;
+		}
+		case refreshMsg: {
+			UpdateTree();
+			return;
+		}
+		case statusUpdateMsg: {
+			UpdateStatus();
+			return;
+		}
+		case setFrequencyMsg: {
+			CheckRetVoid(msg->FindInt32("val", &fFrequency));
+			fProfiler.SetFrequency(fFrequency);
+			return;
+		}
+		case setViewMsg: {
+			CheckRetVoid(msg->FindBool("val", &fBottomUp));
+			UpdateTree();
+			return;
+		}
+		case saveFoldedMsg: {
+			if (!fSavePanel.IsSet()) {
+				fSavePanel.SetTo(new BFilePanel(B_SAVE_PANEL, new BMessenger(this)));
+				BMessage panelMsg(saveFoldedPanelMsg);
+				fSavePanel->SetMessage(&panelMsg);
+				fSavePanel->SetSaveText("profile.folded");
+			}
+			fSavePanel->Show();
+			return;
+		}
+		case saveFoldedPanelMsg: {
+			entry_ref dirRef;
+			const char *name;
+			CheckRetVoid(msg->FindRef("directory", &dirRef));
+			CheckRetVoid(msg->FindString("name", &name));
+			BPath path(&dirRef);
+			Check(path.Append(name));
+			SaveFolded(path.Path());
+			return;
+		}
+		}
+	} catch (StatusError &err) {
+		ShowError(err);
+		return;
+	}
+	BWindow::MessageReceived(msg);
+}
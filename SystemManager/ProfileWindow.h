@@ -0,0 +1,44 @@
+#ifndef _PROFILEWINDOW_H_
+#define _PROFILEWINDOW_H_
+
+#include <Window.h>
+#include <OS.h>
+#include <MessageRunner.h>
+#include <private/shared/AutoDeleter.h>
+
+#include "Profiler.h"
+
+class BColumnListView;
+class BStringView;
+class BMenuItem;
+class BFilePanel;
+
+class ProfileWindow: public BWindow
+{
+private:
+	BColumnListView *fView;
+	BStringView *fStatusView;
+	BMenuItem *fStartItem;
+	BMessageRunner fUpdater;
+	ObjectDeleter<BFilePanel> fSavePanel;
+	Profiler fProfiler;
+	int32 fFrequency;
+	bool fBottomUp;
+	uint64 fShownSamples;
+
+	void UpdateStatus();
+	void UpdateTree();
+	void SaveFolded(const char *path);
+
+public:
+	team_id fTeam;
+
+	ProfileWindow(team_id team);
+	~ProfileWindow();
+
+	void MessageReceived(BMessage *msg);
+};
+
+void OpenProfileWindow(team_id team, BPoint center);
+
+#endif	// _PROFILEWINDOW_H_
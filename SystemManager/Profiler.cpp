@@ -0,0 +1,316 @@
+#include "Profiler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <Autolock.h>
+#include <String.h>
+#include <image.h>
+
+
+enum {
+	kStopTimeout = 100000,
+};
+
+
+Profiler::Profiler(team_id team):
+	fLocker("profiler"),
+	fTeam(team),
+	fFrequency(100),
+	fStats(),
+	fDebuggerPort(-1),
+	fNubPort(-1),
+	fLookupContext(NULL),
+	fAddressMap(team),
+	fTeamDeleted(false),
+	fRunning(false),
+	fQuitSem(-1),
+	fThread(-1)
+{}
+
+Profiler::~Profiler()
+{
+	Stop();
+}
+
+
+status_t Profiler::Attach()
+{
+	fDebuggerPort = create_port(10, "profiler debugger port");
+	if (fDebuggerPort < B_OK)
+		return fDebuggerPort;
+	fNubPort = install_team_debugger(fTeam, fDebuggerPort);
+	if (fNubPort < B_OK) {
+		status_t res = fNubPort;
+		delete_port(fDebuggerPort);
+		fDebuggerPort = -1;
+		return res;
+	}
+	// Image events keep symbol names valid, thread events remove exited
+	// threads from pending list instead of waiting for timeout.
+	debug_nub_set_team_flags flagsMessage;
+	flagsMessage.flags = B_TEAM_DEBUG_IMAGES | B_TEAM_DEBUG_THREADS;
+	status_t res = write_port(fNubPort, B_DEBUG_MESSAGE_SET_TEAM_FLAGS, &flagsMessage, sizeof(flagsMessage));
+	if (res >= B_OK)
+		res = init_debug_context(&fDebugContext, fTeam, fNubPort);
+	if (res < B_OK) {
+		remove_team_debugger(fTeam);
+		delete_port(fDebuggerPort);
+		fDebuggerPort = -1;
+		fNubPort = -1;
+		return res;
+	}
+	if (debug_create_symbol_lookup_context(&fDebugContext, -1, &fLookupContext) < B_OK)
+		fLookupContext = NULL;
+	fAddressMap.SetTeam(fTeam);
+	fAddressNames.clear();
+	fTeamDeleted = false;
+	return B_OK;
+}
+
+void Profiler::Detach()
+{
+	if (fLookupContext != NULL) {
+		debug_delete_symbol_lookup_context(fLookupContext);
+		fLookupContext = NULL;
+	}
+	destroy_debug_context(&fDebugContext);
+	// Also resumes threads that are still stopped.
+	remove_team_debugger(fTeam);
+	delete_port(fDebuggerPort);
+	fDebuggerPort = -1;
+	fNubPort = -1;
+}
+
+
+status_t Profiler::Start(int32 frequency)
+{
+	if (IsRunning())
+		return B_BUSY;
+	// Thread can be left after team termination.
+	Stop();
+	SetFrequency(frequency);
+	status_t res = Attach();
+	if (res < B_OK)
+		return res;
+	fQuitSem = create_sem(0, "profiler quit");
+	fThread = spawn_thread(ThreadEntry, "profiler", B_URGENT_DISPLAY_PRIORITY, this);
+	if (fThread < B_OK) {
+		res = fThread;
+		delete_sem(fQuitSem);
+		fQuitSem = -1;
+		Detach();
+		return res;
+	}
+	fRunning = true;
+	resume_thread(fThread);
+	return B_OK;
+}
+
+void Profiler::Stop()
+{
+	if (fThread < B_OK)
+		return;
+	release_sem(fQuitSem);
+	status_t res;
+	wait_for_thread(fThread, &res);
+	delete_sem(fQuitSem);
+	fQuitSem = -1;
+	fThread = -1;
+}
+
+bool Profiler::IsRunning()
+{
+	BAutolock lock(fLocker);
+	return fRunning;
+}
+
+void Profiler::SetFrequency(int32 frequency)
+{
+	BAutolock lock(fLocker);
+	fFrequency = frequency < 1 ? 1 : frequency;
+}
+
+void Profiler::Reset()
+{
+	BAutolock lock(fLocker);
+	fTree.Clear();
+	fStats = Stats();
+}
+
+
+status_t Profiler::ThreadEntry(void *arg)
+{
+	((Profiler*)arg)->Run();
+	return B_OK;
+}
+
+void Profiler::Run()
+{
+	bigtime_t next = system_time();
+	bigtime_t last = next;
+	for (;;) {
+		bigtime_t start = system_time();
+		Tick();
+		bigtime_t now = system_time();
+		bigtime_t period;
+		{
+			BAutolock lock(fLocker);
+			fStats.ticks++;
+			fStats.tickTime += now - start;
+			if (now - start > fStats.maxTickTime)
+				fStats.maxTickTime = now - start;
+			fStats.runTime += now - last;
+			period = 1000000 / fFrequency;
+		}
+		last = now;
+		if (fTeamDeleted)
+			break;
+
+		// Drop ticks that are already missed instead of catching up.
+		next += period;
+		if (next < now)
+			next = now;
+		status_t res;
+		do {
+			res = acquire_sem_etc(fQuitSem, 1, B_ABSOLUTE_TIMEOUT, next);
+		} while (res == B_INTERRUPTED);
+		if (res == B_OK)
+			break;
+	}
+	Detach();
+	BAutolock lock(fLocker);
+	fRunning = false;
+}
+
+
+void Profiler::ContinueThread(thread_id thread)
+{
+	debug_nub_continue_thread message;
+	message.thread = thread;
+	message.handle_event = B_THREAD_DEBUG_HANDLE_EVENT;
+	message.single_step = false;
+	write_port(fNubPort, B_DEBUG_MESSAGE_CONTINUE_THREAD, &message, sizeof(message));
+}
+
+void Profiler::WalkStack(thread_id thread, std::vector<addr_t> &addresses)
+{
+	addresses.clear();
+	void *ip = NULL, *fp = NULL;
+	if (debug_get_instruction_pointer(&fDebugContext, thread, &ip, &fp) < B_OK)
+		return;
+	addresses.push_back((addr_t)ip);
+	while (fp != NULL && addresses.size() < kMaxFrames) {
+		debug_stack_frame_info frameInfo;
+		if (debug_get_stack_frame(&fDebugContext, fp, &frameInfo) < B_OK)
+			break;
+		// Point into call instruction, return address can belong to next
+		// function.
+		addresses.push_back((addr_t)frameInfo.return_address - 1);
+		fp = frameInfo.parent_frame;
+	}
+}
+
+
+void Profiler::Tick()
+{
+	std::unordered_map<thread_id, std::string> pending;
+	thread_info threadInfo;
+	int32 cookie = 0;
+	while (get_next_thread_info(fTeam, &cookie, &threadInfo) >= B_OK) {
+		if (debug_thread(threadInfo.thread) >= B_OK)
+			pending[threadInfo.thread] = threadInfo.name;
+	}
+
+	std::vector<std::pair<thread_id, std::string>> stopped;
+	while (!pending.empty()) {
+		int32 code;
+		debug_debugger_message_data message;
+		ssize_t res = read_port_etc(fDebuggerPort, &code, &message, sizeof(message), B_RELATIVE_TIMEOUT, kStopTimeout);
+		if (res == B_INTERRUPTED) continue;
+		// Threads that stop later are sampled on next tick.
+		if (res < B_OK) break;
+		switch (code) {
+			case B_DEBUGGER_MESSAGE_THREAD_DEBUGGED: {
+				thread_id thread = message.origin.thread;
+				auto it = pending.find(thread);
+				if (it != pending.end()) {
+					stopped.push_back(*it);
+					pending.erase(it);
+				} else
+					ContinueThread(thread);
+				break;
+			}
+			case B_DEBUGGER_MESSAGE_THREAD_DELETED:
+				pending.erase(message.origin.thread);
+				break;
+			case B_DEBUGGER_MESSAGE_TEAM_DELETED:
+				fTeamDeleted = true;
+				return;
+			case B_DEBUGGER_MESSAGE_PROFILER_UPDATE:
+			case B_DEBUGGER_MESSAGE_HANDED_OVER:
+				break;
+			case B_DEBUGGER_MESSAGE_IMAGE_CREATED:
+			case B_DEBUGGER_MESSAGE_IMAGE_DELETED:
+				fAddressMap.Invalidate();
+				fAddressNames.clear();
+				if (fLookupContext != NULL)
+					debug_delete_symbol_lookup_context(fLookupContext);
+				if (debug_create_symbol_lookup_context(&fDebugContext, -1, &fLookupContext) < B_OK)
+					fLookupContext = NULL;
+				ContinueThread(message.origin.thread);
+				break;
+			default:
+				// Other events stop thread too, let them proceed as usual.
+				ContinueThread(message.origin.thread);
+		}
+	}
+
+	// Walk all stacks first to keep threads stopped as short as possible.
+	std::vector<std::vector<addr_t>> stacks(stopped.size());
+	for (size_t i = 0; i < stopped.size(); i++) {
+		WalkStack(stopped[i].first, stacks[i]);
+		ContinueThread(stopped[i].first);
+	}
+
+	std::vector<uint32> frames;
+	for (size_t i = 0; i < stopped.size(); i++) {
+		// Resolve names before locking, symbol lookup can be slow.
+		for (addr_t address: stacks[i])
+			ResolveAddress(address);
+		BAutolock lock(fLocker);
+		frames.clear();
+		frames.push_back(fTree.AddName(stopped[i].second));
+		for (size_t j = stacks[i].size(); j > 0; j--)
+			frames.push_back(fTree.AddName(fAddressNames[stacks[i][j - 1]]));
+		fTree.AddStack(frames.data(), frames.size());
+		fStats.samples++;
+	}
+}
+
+
+void Profiler::ResolveAddress(addr_t address)
+{
+	if (fAddressNames.find(address) != fAddressNames.end())
+		return;
+
+	BString name;
+	void *baseAddress;
+	char symbolName[1024];
+	char imagePath[B_PATH_NAME_LENGTH];
+	bool exactMatch;
+	if (fLookupContext != NULL && debug_lookup_symbol_address(fLookupContext, (const void*)address,
+		&baseAddress, symbolName, sizeof(symbolName), imagePath, sizeof(imagePath), &exactMatch) >= B_OK
+		&& symbolName[0] != '\0'
+	) {
+		name = DemangleCache::Default().Demangle(symbolName).c_str();
+	} else {
+		const AddressMap::Range *image = fAddressMap.FindImage(address);
+		if (image != NULL) {
+			const char *leaf = strrchr(image->name.c_str(), '/');
+			name.SetToFormat("[%s+%#" B_PRIxADDR "]", leaf != NULL ? leaf + 1 : image->name.c_str(), address - image->base);
+		} else
+			name.SetToFormat("[%#" B_PRIxADDR "]", address);
+	}
+	fAddressNames[address] = name.String();
+}
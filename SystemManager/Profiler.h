@@ -0,0 +1,85 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <OS.h>
+#include <Locker.h>
+#include <private/debug/debug_support.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "CallTree.h"
+#include "AddressMap.h"
+
+
+// Samples stacks of all threads of team at given frequency. On each tick
+// all threads are stopped through team debugger, their stacks are walked
+// and threads are continued. Addresses are symbolized once and stacks are
+// aggregated into call tree with thread name as root frame.
+//
+// Tree and statistics must be accessed with profiler locked.
+class Profiler
+{
+public:
+	struct Stats {
+		uint64 ticks;
+		uint64 samples;
+		bigtime_t runTime;
+		bigtime_t tickTime;
+		bigtime_t maxTickTime;
+	};
+
+	enum {
+		kMaxFrames = 256,
+	};
+
+private:
+	BLocker fLocker;
+	team_id fTeam;
+	int32 fFrequency;
+	CallTree fTree;
+	Stats fStats;
+
+	port_id fDebuggerPort;
+	port_id fNubPort;
+	debug_context fDebugContext;
+	debug_symbol_lookup_context *fLookupContext;
+	AddressMap fAddressMap;
+	std::unordered_map<addr_t, std::string> fAddressNames;
+	bool fTeamDeleted;
+	bool fRunning;
+
+	sem_id fQuitSem;
+	thread_id fThread;
+
+	static status_t ThreadEntry(void *arg);
+	void Run();
+	void Tick();
+	void ContinueThread(thread_id thread);
+	void WalkStack(thread_id thread, std::vector<addr_t> &addresses);
+	void ResolveAddress(addr_t address);
+
+	status_t Attach();
+	void Detach();
+
+public:
+	Profiler(team_id team);
+	~Profiler();
+
+	bool Lock() {return fLocker.Lock();}
+	void Unlock() {fLocker.Unlock();}
+
+	team_id Team() {return fTeam;}
+	status_t Start(int32 frequency);
+	void Stop();
+	bool IsRunning();
+	void SetFrequency(int32 frequency);
+	void Reset();
+
+	const CallTree &Tree() {return fTree;}
+	const Stats &GetStats() {return fStats;}
+};
+
+
+#endif	// _PROFILER_H_
@@ -0,0 +1,38 @@
+#ifndef _ROWFIELDS_H_
+#define _ROWFIELDS_H_
+
+#include <string.h>
+
+#include <private/interface/ColumnListView.h>
+#include <private/interface/ColumnTypes.h>
+
+
+// Field setters return true if value was changed, so unchanged rows are
+// not updated. Missing field is created.
+
+static inline bool SetIntField(BRow *row, int32 col, int32 value)
+{
+	BIntegerField *field = static_cast<BIntegerField*>(row->GetField(col));
+	if (field != NULL && field->Value() == value)
+		return false;
+	if (field != NULL)
+		field->SetValue(value);
+	else
+		row->SetField(new BIntegerField(value), col);
+	return true;
+}
+
+static inline bool SetStringField(BRow *row, int32 col, const char *value)
+{
+	BStringField *field = static_cast<BStringField*>(row->GetField(col));
+	if (field != NULL && strcmp(field->String(), value) == 0)
+		return false;
+	if (field != NULL)
+		field->SetString(value);
+	else
+		row->SetField(new BStringField(value), col);
+	return true;
+}
+
+
+#endif	// _ROWFIELDS_H_
@@ -0,0 +1,163 @@
+#include "RowIndex.h"
+
+#include <vector>
+
+#include <private/interface/ColumnListView.h>
+#include <private/interface/ColumnTypes.h>
+#include <private/shared/AutoDeleter.h>
+
+#include "UIUtils.h"
+
+
+RowIndex::RowIndex(BColumnListView *view):
+	fView(view),
+	fGeneration(0)
+{}
+
+
+BRow *RowIndex::Find(int64 id)
+{
+	auto it = fRows.find(id);
+	if (it == fRows.end())
+		return NULL;
+	return it->second.row;
+}
+
+
+void RowIndex::BeginUpdate()
+{
+	fGeneration++;
+}
+
+
+BRow *RowIndex::Touch(int64 id)
+{
+	auto it = fRows.find(id);
+	if (it == fRows.end())
+		return NULL;
+	it->second.generation = fGeneration;
+	return it->second.row;
+}
+
+
+void RowIndex::Add(int64 id, BRow *row, BRow *parent)
+{
+	fRows[id] = {row, fGeneration};
+	fView->AddRow(row, parent);
+}
+
+
+void RowIndex::EndUpdate()
+{
+	std::vector<BRow*> staleRows;
+	for (auto it = fRows.begin(); it != fRows.end();) {
+		if (it->second.generation != fGeneration) {
+			staleRows.push_back(it->second.row);
+			it = fRows.erase(it);
+		} else
+			it++;
+	}
+
+	for (BRow *row: staleRows) {
+		// Keep children, they are still listed.
+		BRow *parent;
+		fView->FindParent(row, &parent, NULL);
+		while (fView->CountRows(row) > 0)
+			SetRowParent(fView, fView->RowAt(0, row), parent);
+		fView->RemoveRow(row);
+		delete row;
+	}
+}
+
+
+//#pragma mark -
+
+struct RowTree
+{
+	ObjectDeleter<RowTree> next, down;
+	ObjectDeleter<BRow> row;
+};
+
+
+static void BuildRowTree(ObjectDeleter<RowTree> &tree, BColumnListView *view, BRow *row)
+{
+	tree.SetTo(new RowTree());
+	tree->row.SetTo(row);
+	RowTree *last = NULL;
+	ObjectDeleter<RowTree> newNode;
+	int32 count = view->CountRows(row);
+	for (int32 i = 0; i < count; i++) {
+		BuildRowTree(newNode, view, view->RowAt(i, row));
+		if (last == NULL) {
+			tree->down.SetTo(newNode.Detach());
+			last = tree->down.Get();
+		} else {
+			last->next.SetTo(newNode.Detach());
+			last = last->next.Get();
+		}
+	}
+}
+
+static void RemoveRow(BColumnListView *view, BRow *row, ObjectDeleter<RowTree> &tree)
+{
+	BuildRowTree(tree, view, row);
+	view->RemoveRow(row);
+}
+
+static void InsertRow(BColumnListView *view, BRow *parent, ObjectDeleter<RowTree> &tree)
+{
+	if (tree.Get() == NULL) return;
+
+	BRow *row = tree->row.Detach();
+	view->AddRow(row, parent);
+	if (parent != NULL)
+		view->ExpandOrCollapse(parent, true);
+	ObjectDeleter<RowTree> list(tree->down.Detach());
+	while (list.Get() != NULL) {
+		ObjectDeleter<RowTree> next(list->next.Detach());
+		InsertRow(view, row, list);
+		list.SetTo(next.Detach());
+	}
+	tree.Unset();
+}
+
+void SetRowParent(BColumnListView *view, BRow *row, BRow *newParent)
+{
+	BRow *oldParent;
+	view->FindParent(row, &oldParent, NULL);
+	if (newParent != oldParent) {
+		ObjectDeleter<RowTree> tree;
+		RemoveRow(view, row, tree);
+		InsertRow(view, newParent, tree);
+	}
+}
+
+
+//#pragma mark -
+
+bool SetInt64Field(BRow *row, int32 col, int64 value)
+{
+	Int64Field *field = static_cast<Int64Field*>(row->GetField(col));
+	if (field->Value() == value)
+		return false;
+	field->SetValue(value);
+	return true;
+}
+
+bool SetFloatField(BRow *row, int32 col, float value)
+{
+	FloatField *field = static_cast<FloatField*>(row->GetField(col));
+	if (field->Value() == value)
+		return false;
+	field->SetValue(value);
+	return true;
+}
+
+bool SetHighlightField(BRow *row, int32 col, bool highlight)
+{
+	HighlightStringField *field = static_cast<HighlightStringField*>(row->GetField(col));
+	if (field->Highlight() == highlight)
+		return false;
+	field->SetHighlight(highlight);
+	return true;
+}
@@ -0,0 +1,52 @@
+#ifndef _ROWINDEX_H_
+#define _ROWINDEX_H_
+
+#include <SupportDefs.h>
+
+#include <unordered_map>
+
+#include "RowFields.h"
+
+class BColumnListView;
+class BRow;
+
+
+// ID -> row map of BColumnListView that is kept across list refreshes.
+// Rows that were not looked up with Touch() or added since BeginUpdate()
+// are removed by EndUpdate().
+class RowIndex
+{
+private:
+	struct Entry
+	{
+		BRow *row;
+		uint32 generation;
+	};
+
+	BColumnListView *fView;
+	std::unordered_map<int64, Entry> fRows;
+	uint32 fGeneration;
+
+public:
+	RowIndex(BColumnListView *view = NULL);
+
+	inline BColumnListView *View() {return fView;}
+	inline void SetView(BColumnListView *view) {fView = view;}
+
+	BRow *Find(int64 id);
+
+	void BeginUpdate();
+	BRow *Touch(int64 id);
+	void Add(int64 id, BRow *row, BRow *parent = NULL);
+	void EndUpdate();
+};
+
+
+void SetRowParent(BColumnListView *view, BRow *row, BRow *newParent);
+
+// Setters for field types from UIUtils.h, see RowFields.h.
+bool SetInt64Field(BRow *row, int32 col, int64 value);
+bool SetFloatField(BRow *row, int32 col, float value);
+bool SetHighlightField(BRow *row, int32 col, bool highlight);
+
+#endif	// _ROWINDEX_H_
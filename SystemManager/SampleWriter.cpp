@@ -0,0 +1,306 @@
+#include "SampleWriter.h"
+
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#include <algorithm>
+
+
+static const char *kKindNames[recordKindCount] = {
+	"system",
+	"team",
+	"thread",
+	"memory",
+	"image",
+	"area",
+	"port",
+	"sem",
+	"file",
+};
+
+
+static uint64_t HashBytes(const void *data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ ((const uint8_t*)data)[i])*1099511628211ULL;
+	return hash;
+}
+
+
+bool SampleWriter::Key::operator<(const Key &other) const
+{
+	if (kind != other.kind) return kind < other.kind;
+	if (team != other.team) return team < other.team;
+	return id < other.id;
+}
+
+// Hash is not compared, so previous value of field can be found by its key.
+bool SampleWriter::Entry::operator<(const Entry &other) const
+{
+	if (!(key == other.key)) return key < other.key;
+	return field < other.field;
+}
+
+
+SampleWriter::SampleWriter(FILE *file, Format format, bool delta):
+	fFile(file),
+	fFormat(format),
+	fDelta(delta),
+	fBuffer(kBufferSize),
+	fLength(0),
+	fHeaderWritten(false),
+	fTime(0),
+	fKey(),
+	fField(0),
+	fRecordStart(0),
+	fRecordChanged(false)
+{}
+
+SampleWriter::~SampleWriter()
+{
+	Flush();
+}
+
+
+const char *SampleWriter::KindName(uint8_t kind)
+{
+	return kind < recordKindCount ? kKindNames[kind] : "?";
+}
+
+
+void SampleWriter::Flush()
+{
+	if (fLength > 0)
+		fwrite(fBuffer.data(), 1, fLength, fFile);
+	fLength = 0;
+	fflush(fFile);
+}
+
+// Record that does not fit is flushed in parts. Only changed record can be
+// flushed, because fields are appended after fRecordChanged is set, so it is
+// never rewound to fRecordStart after that.
+void SampleWriter::Append(const char *str, size_t len)
+{
+	if (len > fBuffer.size() - fLength) {
+		Flush();
+		fRecordStart = 0;
+		if (len > fBuffer.size()) {
+			fwrite(str, 1, len, fFile);
+			return;
+		}
+	}
+	memcpy(fBuffer.data() + fLength, str, len);
+	fLength += len;
+}
+
+void SampleWriter::Append(const char *str)
+{
+	Append(str, strlen(str));
+}
+
+void SampleWriter::AppendInt(int64_t value)
+{
+	char buf[32];
+	Append(buf, snprintf(buf, sizeof(buf), "%" PRId64, value));
+}
+
+void SampleWriter::AppendUInt(uint64_t value)
+{
+	char buf[32];
+	Append(buf, snprintf(buf, sizeof(buf), "%" PRIu64, value));
+}
+
+void SampleWriter::AppendString(const char *str)
+{
+	if (fFormat == csvFormat) {
+		if (strpbrk(str, ",\"\r\n") == NULL) {
+			Append(str);
+			return;
+		}
+		Append("\"", 1);
+		for (; *str != '\0'; str++) {
+			if (*str == '"')
+				Append("\"", 1);
+			Append(str, 1);
+		}
+		Append("\"", 1);
+		return;
+	}
+
+	Append("\"", 1);
+	for (; *str != '\0'; str++) {
+		switch (*str) {
+		case '"': Append("\\\"", 2); break;
+		case '\\': Append("\\\\", 2); break;
+		default:
+			if ((uint8_t)*str < 0x20) {
+				char buf[8];
+				Append(buf, snprintf(buf, sizeof(buf), "\\u%04x", *str));
+			} else
+				Append(str, 1);
+		}
+	}
+	Append("\"", 1);
+}
+
+// JSON record starts with key, CSV key starts each field line.
+void SampleWriter::AppendKey(const Key &key)
+{
+	if (fFormat == csvFormat) {
+		AppendInt(fTime);
+		Append(",", 1);
+		Append(KindName(key.kind));
+		Append(",", 1);
+		AppendInt(key.team);
+		Append(",", 1);
+		AppendUInt(key.id);
+		Append(",", 1);
+		return;
+	}
+	Append("{\"time\":");
+	AppendInt(fTime);
+	Append(",\"kind\":\"");
+	Append(KindName(key.kind));
+	Append("\",\"team\":");
+	AppendInt(key.team);
+	Append(",\"id\":");
+	AppendUInt(key.id);
+}
+
+bool SampleWriter::BeginField(const char *name, const void *value, size_t size)
+{
+	uint32_t field = fField++;
+	if (fDelta) {
+		Entry entry = {fKey, field, HashBytes(value, size)};
+		fCur.push_back(entry);
+		auto it = std::lower_bound(fPrev.begin(), fPrev.end(), entry);
+		if (it != fPrev.end() && it->key == fKey && it->field == field && it->hash == entry.hash)
+			return false;
+	}
+	fRecordChanged = true;
+	if (fFormat == csvFormat) {
+		AppendKey(fKey);
+		Append(name);
+		Append(",", 1);
+	} else {
+		Append(",\"", 2);
+		Append(name);
+		Append("\":", 2);
+	}
+	return true;
+}
+
+void SampleWriter::WriteRemoved(const Key &key)
+{
+	if (fBuffer.size() - fLength < kRecordReserve)
+		Flush();
+	AppendKey(key);
+	if (fFormat == csvFormat)
+		Append("removed,1\n");
+	else
+		Append(",\"removed\":true}\n");
+}
+
+
+void SampleWriter::BeginSample(int64_t time)
+{
+	fTime = time;
+	fCur.clear();
+	if (fFormat == csvFormat && !fHeaderWritten) {
+		Append("time,kind,team,id,field,value\n");
+		fHeaderWritten = true;
+	}
+}
+
+void SampleWriter::BeginRecord(uint8_t kind, int32_t team, uint64_t id)
+{
+	if (fBuffer.size() - fLength < kRecordReserve)
+		Flush();
+	fKey = {kind, team, id};
+	fField = 0;
+	fRecordStart = fLength;
+	fRecordChanged = false;
+	if (fFormat == jsonFormat)
+		AppendKey(fKey);
+}
+
+void SampleWriter::Int(const char *name, int64_t value)
+{
+	if (!BeginField(name, &value, sizeof(value)))
+		return;
+	AppendInt(value);
+	if (fFormat == csvFormat)
+		Append("\n", 1);
+}
+
+void SampleWriter::UInt(const char *name, uint64_t value)
+{
+	if (!BeginField(name, &value, sizeof(value)))
+		return;
+	AppendUInt(value);
+	if (fFormat == csvFormat)
+		Append("\n", 1);
+}
+
+// Formatted text is compared, so changes below printed precision are not
+// reported. NaN and infinity are not valid JSON numbers, they are written as
+// null, or as empty value in CSV.
+void SampleWriter::Float(const char *name, double value)
+{
+	char buf[32];
+	int len;
+	if (isfinite(value))
+		len = snprintf(buf, sizeof(buf), "%.6g", value);
+	else
+		len = snprintf(buf, sizeof(buf), "%s", fFormat == csvFormat ? "" : "null");
+	if (!BeginField(name, buf, len))
+		return;
+	Append(buf, len);
+	if (fFormat == csvFormat)
+		Append("\n", 1);
+}
+
+void SampleWriter::String(const char *name, const char *value)
+{
+	if (value == NULL)
+		value = "";
+	if (!BeginField(name, value, strlen(value)))
+		return;
+	AppendString(value);
+	if (fFormat == csvFormat)
+		Append("\n", 1);
+}
+
+void SampleWriter::EndRecord()
+{
+	if (fFormat == csvFormat)
+		return;
+	if (!fRecordChanged) {
+		fLength = fRecordStart;
+		return;
+	}
+	Append("}\n", 2);
+}
+
+bool SampleWriter::EndSample()
+{
+	if (fDelta) {
+		// Records of previous sample that have no fields now were removed.
+		std::sort(fCur.begin(), fCur.end());
+		size_t cur = 0;
+		for (size_t i = 0; i < fPrev.size(); i++) {
+			const Key &key = fPrev[i].key;
+			if (i > 0 && fPrev[i - 1].key == key)
+				continue;
+			while (cur < fCur.size() && fCur[cur].key < key)
+				cur++;
+			if (cur == fCur.size() || !(fCur[cur].key == key))
+				WriteRemoved(key);
+		}
+		fPrev.swap(fCur);
+	}
+	Flush();
+	return ferror(fFile) == 0;
+}
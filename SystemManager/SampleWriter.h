@@ -0,0 +1,116 @@
+#ifndef _SAMPLEWRITER_H_
+#define _SAMPLEWRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+
+enum {
+	systemRecord,
+	teamRecord,
+	threadRecord,
+	memoryRecord,
+	imageRecord,
+	areaRecord,
+	portRecord,
+	semRecord,
+	fileRecord,
+	recordKindCount
+};
+
+
+// Streams samples as newline delimited JSON objects, one per record, or as
+// CSV lines "time,kind,team,id,field,value", one per field. Records are
+// identified by kind, team and ID, fields must be written in the same order
+// in each sample.
+//
+// In delta mode only fields that changed since previous sample are written,
+// records without changes are skipped and records that disappeared are
+// written with "removed" field. Values are compared by hashes kept in two
+// sorted arrays that are swapped after each sample.
+//
+// Output is formatted in fixed buffer that is flushed between records, so
+// nothing is allocated per sample once arrays have grown to number of
+// fields.
+class SampleWriter
+{
+public:
+	enum Format {
+		jsonFormat,
+		csvFormat,
+	};
+
+	enum {
+		kBufferSize = 128*1024,
+		// Buffer is flushed before record if less space is left. Longer
+		// records are flushed in parts.
+		kRecordReserve = 32*1024,
+	};
+
+private:
+	struct Key {
+		uint8_t kind;
+		int32_t team;
+		uint64_t id;
+
+		bool operator==(const Key &other) const {return kind == other.kind && team == other.team && id == other.id;}
+		bool operator<(const Key &other) const;
+	};
+
+	struct Entry {
+		Key key;
+		uint32_t field;
+		uint64_t hash;
+
+		bool operator<(const Entry &other) const;
+	};
+
+	FILE *fFile;
+	Format fFormat;
+	bool fDelta;
+	std::vector<char> fBuffer;
+	size_t fLength;
+	bool fHeaderWritten;
+
+	int64_t fTime;
+	Key fKey;
+	uint32_t fField;
+	size_t fRecordStart;
+	bool fRecordChanged;
+
+	std::vector<Entry> fPrev;
+	std::vector<Entry> fCur;
+
+	void Flush();
+	void Append(const char *str, size_t len);
+	void Append(const char *str);
+	void AppendInt(int64_t value);
+	void AppendUInt(uint64_t value);
+	void AppendString(const char *str);
+	void AppendKey(const Key &key);
+	bool BeginField(const char *name, const void *value, size_t size);
+	void WriteRemoved(const Key &key);
+
+public:
+	SampleWriter(FILE *file, Format format, bool delta);
+	~SampleWriter();
+
+	static const char *KindName(uint8_t kind);
+
+	void BeginSample(int64_t time);
+	void BeginRecord(uint8_t kind, int32_t team, uint64_t id);
+	void Int(const char *name, int64_t value);
+	void UInt(const char *name, uint64_t value);
+	void Float(const char *name, double value);
+	// NULL is written as empty string.
+	void String(const char *name, const char *value);
+	void EndRecord();
+	// Returns false on write error.
+	bool EndSample();
+};
+
+
+#endif	// _SAMPLEWRITER_H_
@@ -0,0 +1,195 @@
+#include "Sampler.h"
+
+#include <Autolock.h>
+#include <Message.h>
+
+
+Sampler::Sampler(bigtime_t interval):
+	fLocker("sampler"),
+	fInterval(interval),
+	fNotifyPending(false),
+	fFront(std::make_shared<Snapshot>()),
+	fBack(std::make_shared<Snapshot>()),
+	fQuitting(false)
+{
+	fWakeSem = create_sem(0, "sampler wake");
+	fThread = spawn_thread(ThreadEntry, "sampler", B_LOW_PRIORITY, this);
+	resume_thread(fThread);
+}
+
+Sampler::~Sampler()
+{
+	{
+		BAutolock lock(fLocker);
+		fQuitting = true;
+	}
+	release_sem(fWakeSem);
+	status_t res;
+	wait_for_thread(fThread, &res);
+	delete_sem(fWakeSem);
+}
+
+Sampler &Sampler::Default()
+{
+	static Sampler sampler;
+	return sampler;
+}
+
+
+void Sampler::SetTarget(const BMessenger &target)
+{
+	BAutolock lock(fLocker);
+	fTarget = target;
+}
+
+bigtime_t Sampler::Interval()
+{
+	BAutolock lock(fLocker);
+	return fInterval;
+}
+
+void Sampler::SetInterval(bigtime_t interval)
+{
+	{
+		BAutolock lock(fLocker);
+		fInterval = interval;
+	}
+	release_sem(fWakeSem);
+}
+
+std::shared_ptr<const Snapshot> Sampler::Latest()
+{
+	BAutolock lock(fLocker);
+	fNotifyPending = false;
+	return fFront;
+}
+
+void Sampler::WatchTeam(team_id team, uint32 fields)
+{
+	{
+		BAutolock lock(fLocker);
+		if (fields == 0) {
+			fWatchedTeams.erase(team);
+			return;
+		}
+		WatchedTeam &watched = fWatchedTeams[team];
+		bool added = (fields & ~watched.fields) != 0;
+		watched.fields = fields;
+		if (!added)
+			return;
+	}
+	release_sem(fWakeSem);
+}
+
+std::shared_ptr<const TeamObjects> Sampler::LatestObjects(team_id team)
+{
+	BAutolock lock(fLocker);
+	auto it = fWatchedTeams.find(team);
+	if (it == fWatchedTeams.end())
+		return NULL;
+	return it->second.objects;
+}
+
+
+status_t Sampler::ThreadEntry(void *arg)
+{
+	((Sampler*)arg)->Run();
+	return B_OK;
+}
+
+void Sampler::Run()
+{
+	for (;;) {
+		// Only this thread replaces fFront, so it can be read without lock.
+		fCollector.Sample(*fBack);
+		ComputeCpuUsage(*fBack, *fFront);
+		ComputeMemoryDeltas(*fBack, *fFront);
+		AnalyzeWaits(*fBack);
+		fHistory.Record(*fBack);
+		std::vector<std::shared_ptr<TeamObjects>> objects;
+		SampleWatchedTeams(objects);
+
+		BMessenger target;
+		bool notify;
+		bigtime_t interval;
+		{
+			BAutolock lock(fLocker);
+			if (fQuitting)
+				return;
+			fFront.swap(fBack);
+			for (const std::shared_ptr<TeamObjects> &teamObjects: objects) {
+				auto it = fWatchedTeams.find(teamObjects->team);
+				if (it != fWatchedTeams.end())
+					it->second.objects = teamObjects;
+			}
+			notify = !fNotifyPending;
+			fNotifyPending = true;
+			target = fTarget;
+			interval = fInterval;
+		}
+
+		// Previous snapshot becomes back buffer unless some reader still
+		// holds it.
+		if (fBack.use_count() > 1)
+			fBack = std::make_shared<Snapshot>();
+
+		if (notify)
+			target.SendMessage(samplerUpdatedMsg);
+
+		status_t res;
+		do {
+			res = acquire_sem_etc(fWakeSem, 1, B_RELATIVE_TIMEOUT, interval);
+		} while (res == B_INTERRUPTED);
+		{
+			BAutolock lock(fLocker);
+			if (fQuitting)
+				return;
+		}
+	}
+}
+
+
+// Kernel is queried without lock, so watch list is copied first. Objects
+// of teams that stopped being watched meanwhile are dropped on publish.
+void Sampler::SampleWatchedTeams(std::vector<std::shared_ptr<TeamObjects>> &objects)
+{
+	std::vector<std::pair<team_id, uint32>> watched;
+	{
+		BAutolock lock(fLocker);
+		for (const auto &it: fWatchedTeams)
+			watched.emplace_back(it.first, it.second.fields);
+	}
+	for (const auto &it: watched) {
+		std::shared_ptr<TeamObjects> teamObjects = std::make_shared<TeamObjects>();
+		CollectTeamObjects(it.first, it.second, *teamObjects);
+		objects.push_back(teamObjects);
+	}
+}
+
+
+// Ports are not included: read_port() waits on condition variable, so
+// thread info does not tell which port thread is blocked on.
+//
+// Kernel only reports latest holder of semaphore, not current owners. It is
+// used as approximation of owner only when semaphore has no free units and
+// holder is blocked too. Holder that runs will release semaphore or has
+// already released it, and semaphores with free units don't block. Edges
+// can still be wrong for semaphores released by other thread than the one
+// that acquired them, kConfirmUpdates filters short lived false cycles.
+void Sampler::AnalyzeWaits(Snapshot &snapshot)
+{
+	fWaitGraph.BeginUpdate();
+	for (const ThreadSample &thread: snapshot.threads) {
+		if (thread.state != B_THREAD_WAITING || thread.semHolder < B_OK || thread.semCount > 0)
+			continue;
+		const ThreadSample *holder = snapshot.FindThread(thread.semHolder);
+		if (holder == NULL || holder->state != B_THREAD_WAITING)
+			continue;
+		fWaitGraph.AddEdge(thread.id, thread.semHolder);
+	}
+	fWaitGraph.EndUpdate();
+
+	for (ThreadSample &thread: snapshot.threads)
+		thread.waitState = fWaitGraph.StateOf(thread.id);
+	snapshot.system.deadlockCount = fWaitGraph.CountDeadlocks();
+}
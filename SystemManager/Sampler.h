@@ -0,0 +1,80 @@
+#ifndef _SAMPLER_H_
+#define _SAMPLER_H_
+
+#include <OS.h>
+#include <Locker.h>
+#include <Messenger.h>
+
+#include <map>
+#include <memory>
+
+#include "Snapshot.h"
+#include "History.h"
+#include "WaitGraph.h"
+#include "Collector.h"
+
+
+enum {
+	samplerUpdatedMsg = 'smup',
+};
+
+
+// Takes snapshots of teams, threads and system state on a background thread
+// at configured interval. New snapshot is filled in back buffer and then
+// swapped with the published one, so readers never wait for kernel queries.
+// samplerUpdatedMsg is sent to target when new snapshot is published. Each
+// snapshot is also recorded to history, its areas are attributed to their
+// owners and wait graph of its threads is
+// checked for deadlocks.
+//
+// Object lists of watched teams are collected after each snapshot and
+// published with it, so team windows don't enumerate them on window thread.
+class Sampler
+{
+private:
+	struct WatchedTeam {
+		uint32 fields;
+		std::shared_ptr<const TeamObjects> objects;
+	};
+
+	BLocker fLocker;
+	BMessenger fTarget;
+	bigtime_t fInterval;
+	bool fNotifyPending;
+	std::shared_ptr<Snapshot> fFront;
+	std::shared_ptr<Snapshot> fBack;
+	std::map<team_id, WatchedTeam> fWatchedTeams;
+	History fHistory;
+	WaitGraph fWaitGraph;
+	Collector fCollector;
+	sem_id fWakeSem;
+	thread_id fThread;
+	bool fQuitting;
+
+	static status_t ThreadEntry(void *arg);
+	void Run();
+	void AnalyzeWaits(Snapshot &snapshot);
+	void SampleWatchedTeams(std::vector<std::shared_ptr<TeamObjects>> &objects);
+
+public:
+	Sampler(bigtime_t interval = 500000);
+	~Sampler();
+
+	static Sampler &Default();
+
+	void SetTarget(const BMessenger &target);
+	bigtime_t Interval();
+	void SetInterval(bigtime_t interval);
+
+	std::shared_ptr<const Snapshot> Latest();
+
+	// Objects of team in fields are collected until fields are set to 0.
+	// Sampler is woken up if new fields are requested.
+	void WatchTeam(team_id team, uint32 fields);
+	// NULL if objects of team were not collected yet.
+	std::shared_ptr<const TeamObjects> LatestObjects(team_id team);
+	History &GetHistory() {return fHistory;}
+};
+
+
+#endif	// _SAMPLER_H_
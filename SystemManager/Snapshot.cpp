@@ -0,0 +1,90 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+
+
+Snapshot::Snapshot():
+	time(0),
+	system()
+{}
+
+
+void Snapshot::Clear()
+{
+	time = 0;
+	system = SystemSample();
+	teams.clear();
+	threads.clear();
+	memoryGroups.clear();
+	systemMemoryGroups.clear();
+	fTeamIndex.clear();
+	fThreadIndex.clear();
+}
+
+
+void Snapshot::BuildIndex()
+{
+	fTeamIndex.clear();
+	fThreadIndex.clear();
+	fTeamIndex.reserve(teams.size());
+	fThreadIndex.reserve(threads.size());
+	for (size_t i = 0; i < teams.size(); i++)
+		fTeamIndex[teams[i].id] = i;
+	for (size_t i = 0; i < threads.size(); i++)
+		fThreadIndex[threads[i].id] = i;
+}
+
+
+const TeamSample *Snapshot::FindTeam(int32_t id) const
+{
+	auto it = fTeamIndex.find(id);
+	if (it == fTeamIndex.end())
+		return NULL;
+	return &teams[it->second];
+}
+
+
+const ThreadSample *Snapshot::FindThread(int32_t id) const
+{
+	auto it = fThreadIndex.find(id);
+	if (it == fThreadIndex.end())
+		return NULL;
+	return &threads[it->second];
+}
+
+
+void ComputeCpuUsage(Snapshot &cur, const Snapshot &prev)
+{
+	int64_t capacity = (cur.time - prev.time)*std::max<int64_t>(cur.system.cpuCount, 1);
+	bool valid = prev.time != 0 && capacity > 0;
+
+	cur.system.cpuUsage = 0;
+	for (TeamSample &team: cur.teams) {
+		team.cpuUsage = 0;
+		int64_t idleTime = 0;
+		for (size_t i = team.firstThread; i < team.firstThread + team.threadCount; i++) {
+			ThreadSample &thread = cur.threads[i];
+			thread.cpuUsage = 0;
+			const ThreadSample *prevThread = valid ? prev.FindThread(thread.id) : NULL;
+			if (prevThread == NULL)
+				continue;
+			int64_t used = (thread.userTime + thread.kernelTime) - (prevThread->userTime + prevThread->kernelTime);
+			if (used <= 0)
+				continue;
+			thread.cpuUsage = 100.0f*used/capacity;
+			if (thread.isIdle)
+				idleTime += used;
+		}
+
+		const TeamSample *prevTeam = valid ? prev.FindTeam(team.id) : NULL;
+		if (prevTeam == NULL)
+			continue;
+		// Team times also include threads that exited since previous snapshot.
+		int64_t used = (team.userTime + team.kernelTime) - (prevTeam->userTime + prevTeam->kernelTime) - idleTime;
+		if (used <= 0)
+			continue;
+		team.cpuUsage = std::min(100.0f*used/capacity, 100.0f);
+		cur.system.cpuUsage += team.cpuUsage;
+	}
+	cur.system.cpuUsage = std::min(cur.system.cpuUsage, 100.0f);
+}
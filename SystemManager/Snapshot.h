@@ -0,0 +1,155 @@
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+
+// Sampled system state. Times are in microseconds.
+
+struct ThreadSample
+{
+	int32_t id;
+	int32_t team;
+	std::string name;
+	int32_t state;
+	int32_t priority;
+	int32_t sem;
+	// Latest holder of sem, -1 if thread does not wait on semaphore.
+	int32_t semHolder;
+	// Count of sem, 0 if thread does not wait on semaphore.
+	int32_t semCount;
+	int64_t userTime;
+	int64_t kernelTime;
+	uint64_t stackBase;
+	uint64_t stackEnd;
+	bool isIdle;
+
+	// Percent of total CPU capacity used since previous snapshot.
+	float cpuUsage;
+	// WaitGraph::State of thread.
+	uint8_t waitState;
+};
+
+enum MemoryKind
+{
+	textMemory,
+	dataMemory,
+	heapMemory,
+	stackMemory,
+	anonymousMemory,
+	memoryKindCount
+};
+
+// Areas of team (or of all teams if team is -1) with the same owner.
+struct MemoryGroupSample
+{
+	uint64_t id;
+	int32_t team;
+	uint8_t kind;
+	// Image path for text and data, area name for anonymous memory.
+	std::string name;
+	uint32_t areaCount;
+	uint32_t teamCount;
+	uint64_t size;
+	uint64_t ram;
+	// Part of ram that can be mapped by other teams too.
+	uint64_t sharedRam;
+	// Change of ram since previous snapshot.
+	int64_t ramDelta;
+};
+
+struct TeamSample
+{
+	int32_t id;
+	int32_t parent;
+	int32_t session;
+	int32_t group;
+	int32_t uid;
+	int32_t gid;
+	std::string path;
+	uint64_t memSize;
+	uint64_t memAlloc;
+	int64_t userTime;
+	int64_t kernelTime;
+
+	// Threads of team are Snapshot::threads[firstThread, firstThread + threadCount).
+	size_t firstThread;
+	size_t threadCount;
+	// Memory groups of team are Snapshot::memoryGroups[firstMemoryGroup, firstMemoryGroup + memoryGroupCount).
+	size_t firstMemoryGroup;
+	size_t memoryGroupCount;
+
+	// Percent of total CPU capacity used since previous snapshot, idle
+	// threads are not counted.
+	float cpuUsage;
+};
+
+struct SystemSample
+{
+	int64_t bootTime;
+	uint32_t cpuCount;
+	uint64_t pageSize;
+	uint64_t usedPages;
+	uint64_t maxPages;
+	uint64_t cachedPages;
+	uint64_t blockCachePages;
+	uint64_t ignoredPages;
+	uint64_t neededMemory;
+	uint64_t freeMemory;
+	uint64_t maxSwapPages;
+	uint64_t freeSwapPages;
+	uint32_t pageFaults;
+	uint32_t usedSems;
+	uint32_t maxSems;
+	uint32_t usedPorts;
+	uint32_t maxPorts;
+	uint32_t usedThreads;
+	uint32_t maxThreads;
+	uint32_t usedTeams;
+	uint32_t maxTeams;
+	std::string kernelName;
+	std::string kernelBuildDate;
+	std::string kernelBuildTime;
+
+	// Percent of total CPU capacity used by non-idle threads.
+	float cpuUsage;
+	// Number of confirmed wait cycles between threads.
+	uint32_t deadlockCount;
+};
+
+class Snapshot
+{
+private:
+	std::unordered_map<int32_t, size_t> fTeamIndex;
+	std::unordered_map<int32_t, size_t> fThreadIndex;
+
+public:
+	int64_t time;
+	SystemSample system;
+	std::vector<TeamSample> teams;
+	std::vector<ThreadSample> threads;
+	std::vector<MemoryGroupSample> memoryGroups;
+	// Groups of all teams merged by owner, shared memory is counted once.
+	std::vector<MemoryGroupSample> systemMemoryGroups;
+
+	Snapshot();
+
+	void Clear();
+	// Must be called after teams and threads are filled.
+	void BuildIndex();
+
+	const TeamSample *FindTeam(int32_t id) const;
+	const ThreadSample *FindThread(int32_t id) const;
+};
+
+
+// Sets CPU usage of cur from time deltas against prev. Teams and threads
+// that are not in prev get zero usage.
+void ComputeCpuUsage(Snapshot &cur, const Snapshot &prev);
+
+
+#endif	// _SNAPSHOT_H_
@@ -22,12 +22,12 @@
 
 #include <private/debug/debug_support.h>
 
-#include <cxxabi.h>
 #include <map>
 
 #include "Errors.h"
 #include "Utils.h"
 #include "UIUtils.h"
+#include "Symbolizer.h"
 
 
 enum {
@@ -35,6 +35,7 @@ enum {
 	frameIpCol,
 	frameImageCol,
 	frameFunctionCol,
+	frameSourceCol,
 };
 
 enum {
@@ -49,62 +50,60 @@ struct StackFrameRow: public BRow {
 	BString fImagePath;
 	addr_t fImageBase{};
 	addr_t fIp{};
+	BString fSourcePath;
+	uint32 fSourceLine = 0;
 };
 
 
-static char *CppDemangle(const char *abiName)
+static void LookupSourceLine(StackFrameRow *row, BString &sourceStr)
 {
-  int status;
-  char *ret = abi::__cxa_demangle(abiName, 0, 0, &status);
-  return ret;
+	sourceStr.SetTo("");
+	if (row->fImage < B_OK)
+		return;
+	std::shared_ptr<const SymbolImage> image = Symbolizer::Default().Get(row->fImagePath);
+	if (!image)
+		return;
+	SymbolImage::SourceLocation location;
+	if (!image->LookupLine(row->fIp - row->fImageBase + image->TextBase(), location))
+		return;
+	row->fSourcePath = location.path;
+	row->fSourceLine = location.line;
+	sourceStr.SetToFormat("%s:%" B_PRIu32, GetFileName(location.path), location.line);
 }
 
-static status_t Addr2Line(BString &srcPath, uint32 &line, uint32 &col, const char *imgPath, addr_t address)
+static bool LookupImageSymbol(StackFrameRow *row, const void *address, BString &imageStr, BString &symbolStr)
 {
-	BString command;
-	command.SetToFormat("addr2line -e \"%s\" %#" B_PRIxADDR, imgPath, address);
-	FILE *out = popen(command.String(), "r");
-	if (out == NULL) {
-		return errno;
-	}
-	BString outStr;
-	size_t len;
-	for (;;) {
-		size_t oldLen = outStr.Length();
-		len = fread(outStr.LockBuffer(oldLen + 256) + oldLen, 1, 256, out);
-		outStr.UnlockBuffer(oldLen + len);
-		if (len == 0) break;
-	}
-	fclose(out);
-	outStr.Truncate(outStr.FindFirst('\n'));
-	int32 colonPos = outStr.FindLast(':');
-	BString buf;
-	outStr.CopyInto(buf, colonPos + 1, outStr.Length() - (colonPos + 1));
-	line = strtol(buf.String(), NULL, 0);
-	col = 1;
-	outStr.CopyInto(srcPath, 0, colonPos);
-	return B_OK;
+	if (row->fImage < B_OK)
+		return false;
+	std::shared_ptr<const SymbolImage> image = Symbolizer::Default().Get(row->fImagePath);
+	if (!image)
+		return false;
+	bool exactMatch;
+	const SymbolImage::Symbol *symbol = image->LookupSymbol((addr_t)address - row->fImageBase + image->TextBase(), &exactMatch);
+	if (symbol == NULL)
+		return false;
+	std::string demangledName = DemangleCache::Default().Demangle(symbol->name.c_str());
+	imageStr.SetTo(GetFileName(row->fImagePath));
+	symbolStr.SetToFormat("%s + %ld%s",
+		demangledName.c_str(),
+		(addr_t)address - row->fImageBase + image->TextBase() - symbol->address,
+		exactMatch ? "" : " (closest symbol)"
+	);
+	return true;
 }
 
-
 static void LookupSymbolAddress(
 	StackWindow *wnd,
 	debug_symbol_lookup_context *lookupContext, const void *address,
 	BString &imageStr, BString &symbolStr,
 	StackFrameRow *row
 ) {
-	{
-		int32 cookie = 0;
-		image_info info;
-		while (get_next_image_info(wnd->fTeam, &cookie, &info) >= B_OK) {
-			if ((addr_t)address >= (addr_t)info.text && (addr_t)address <= (addr_t)info.text + info.text_size - 1) {
-				row->fImage = info.id;
-				row->fImagePath = info.name;
-				row->fImageBase = (addr_t)info.text;
-				row->fIp = (addr_t)address - 1;
-				break;
-			}
-		}
+	const AddressMap::Range *image = wnd->fAddressMap.FindImage((addr_t)address);
+	if (image != NULL && image->kind == AddressMap::textKind) {
+		row->fImage = image->id;
+		row->fImagePath = image->name.c_str();
+		row->fImageBase = image->base;
+		row->fIp = (addr_t)address - 1;
 	}
 
 	// symbol table
@@ -121,15 +120,11 @@ static void LookupSymbolAddress(
 			imageName = basename(imageNameBuf);
 	
 			if (strlen(symbolName) > 0) {
-				char *demangledName = CppDemangle(symbolName);
-				if (demangledName != NULL) {
-					strcpy(symbolName, demangledName);
-					free(demangledName);
-				}
+				std::string demangledName = DemangleCache::Default().Demangle(symbolName);
 	
 				imageStr.SetTo(imageName);
 				symbolStr.SetToFormat("%s + %ld%s",
-					symbolName,
+					demangledName.c_str(),
 					(addr_t)address - (addr_t)baseAddress,
 					exactMatch ? "" : " (closest symbol)"
 				);
@@ -141,33 +136,23 @@ static void LookupSymbolAddress(
 		}
 	}
 
+	// symbol table of image file
+	if (LookupImageSymbol(row, address, imageStr, symbolStr))
+		return;
+
 	// image
-	image_info imageInfo;
-	int32 imageCookie = 0;
-	while (get_next_image_info(wnd->fTeam, &imageCookie, &imageInfo) >= B_OK) {
-		if ((addr_t)address >= (addr_t)imageInfo.text && (addr_t)address < (addr_t)imageInfo.text + imageInfo.text_size) {
-			imageStr.SetToFormat("<%s>", GetFileName(imageInfo.name));
-			symbolStr.SetToFormat(".text + %#lx", (addr_t)address - (addr_t)imageInfo.text);
-			return;
-		}
-		if ((addr_t)address >= (addr_t)imageInfo.data && (addr_t)address < (addr_t)imageInfo.data + imageInfo.data_size) {
-			imageStr.SetToFormat("<%s>", GetFileName(imageInfo.name));
-			symbolStr.SetToFormat(".data + %#lx", (addr_t)address - (addr_t)imageInfo.data);
-			return;
-		}
+	if (image != NULL) {
+		imageStr.SetToFormat("<%s>", GetFileName(image->name.c_str()));
+		symbolStr.SetToFormat("%s + %#lx", image->kind == AddressMap::textKind ? ".text" : ".data", (addr_t)address - image->start);
+		return;
 	}
 
 	// area
-	area_info info;
-	ssize_t cookie = 0;
-	while (get_next_area_info(wnd->fTeam, &cookie, &info) == B_OK) {
-		if ((addr_t)info.address <= (addr_t)address &&
-			(addr_t)info.address + info.size > (addr_t)address
-		) {
-			imageStr.SetToFormat("<area %" B_PRId32 ": %s>", info.area, info.name);
-			symbolStr.SetToFormat("%#lx", (addr_t)address - (addr_t)info.address);
-			return;
-		}
+	const AddressMap::Range *area = wnd->fAddressMap.FindArea((addr_t)address);
+	if (area != NULL) {
+		imageStr.SetToFormat("<area %" B_PRId32 ": %s>", area->id, area->name.c_str());
+		symbolStr.SetToFormat("%#lx", (addr_t)address - area->start);
+		return;
 	}
 
 	imageStr.SetTo("");
@@ -187,7 +172,7 @@ static void WriteStackTrace(StackWindow *wnd)
 	StackFrameRow *row;
 	BString str;
 
-	BString imageStr, symbolStr;
+	BString imageStr, symbolStr, sourceStr;
 	row = new StackFrameRow();
 	LookupSymbolAddress(wnd, lookupContext, ip, imageStr, symbolStr, row);
 
@@ -195,6 +180,8 @@ static void WriteStackTrace(StackWindow *wnd)
 	row->SetField(new Int64Field((addr_t)ip), frameIpCol);
 	row->SetField(new BStringField(imageStr), frameImageCol);
 	row->SetField(new BStringField(symbolStr), frameFunctionCol);
+	LookupSourceLine(row, sourceStr);
+	row->SetField(new BStringField(sourceStr), frameSourceCol);
 	wnd->fView->AddRow(row);
 
 	for (int32 i = 0; i < 400; i++) {
@@ -214,6 +201,8 @@ static void WriteStackTrace(StackWindow *wnd)
 		row->SetField(new Int64Field((addr_t)ip), frameIpCol);
 		row->SetField(new BStringField(imageStr), frameImageCol);
 		row->SetField(new BStringField(symbolStr), frameFunctionCol);
+		LookupSourceLine(row, sourceStr);
+		row->SetField(new BStringField(sourceStr), frameSourceCol);
 		wnd->fView->AddRow(row);
 
 		if (fp == NULL)
@@ -259,6 +248,7 @@ static void ListFrames(StackWindow *wnd, BColumnListView *view)
 
 	Check(get_thread_info(wnd->fId, &threadInfo), "thread not found");
 	wnd->fTeam = threadInfo.team;
+	wnd->fAddressMap.SetTeam(wnd->fTeam);
 
 	wnd->fDebuggerPort = Check(create_port(10, "debugger port"));
 	HandleDeleter<port_id, status_t, delete_port> portDeleter(wnd->fDebuggerPort);
@@ -286,6 +276,7 @@ static void NewFramesView(StackWindow *wnd)
 	view->AddColumn(new HexIntegerColumn("IP", 128, 50, 500, B_ALIGN_RIGHT), frameIpCol);
 	view->AddColumn(new BStringColumn("Image", 150, 50, 500, B_TRUNCATE_END), frameImageCol);
 	view->AddColumn(new BStringColumn("Function", 512, 50, 1024, B_TRUNCATE_END), frameFunctionCol);
+	view->AddColumn(new BStringColumn("Source", 150, 50, 1024, B_TRUNCATE_MIDDLE), frameSourceCol);
 	wnd->fView = view;
 	ListFrames(wnd, view);
 }
@@ -356,18 +347,14 @@ void StackWindow::MessageReceived(BMessage *msg)
 	case invokeMsg: {
 		auto row = (StackFrameRow*)fView->CurrentSelection(NULL);
 		if (row == NULL) return;
-		if (row->fImage < B_OK) return;
-		BString srcPath;
-		uint32 line, col;
-		if (Addr2Line(srcPath, line, col, row->fImagePath, row->fIp - row->fImageBase) < B_OK) return;
-		printf("%s:%" B_PRIu32 "\n", srcPath.String(), line);
-		BEntry entry(srcPath);
+		if (row->fSourcePath.IsEmpty()) return;
+		BEntry entry(row->fSourcePath);
 		if (!entry.Exists()) return;
 		entry_ref ref;
 		entry.GetRef(&ref);
 		BMessage message(B_REFS_RECEIVED);
 		message.AddRef("refs", &ref);
-		message.AddInt32("be:line", line);
+		message.AddInt32("be:line", row->fSourceLine);
 		BMessenger("application/x-vnd.Be-TRAK").SendMessage(&message);
 		return;
 	}
@@ -6,6 +6,8 @@
 #include <private/debug/debug_support.h>
 #include <private/shared/AutoDeleter.h>
 
+#include "AddressMap.h"
+
 class BColumnListView;
 
 class StackWindow: public BWindow
@@ -18,6 +20,7 @@ public:
 	team_id fTeam;
 	port_id fDebuggerPort, fNubPort;
 	debug_context fDebugContext;
+	AddressMap fAddressMap;
 
 	StackWindow(thread_id id);
 	~StackWindow();
@@ -0,0 +1,291 @@
+#include "Stream.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Collector.h"
+#include "Snapshot.h"
+#include "MemoryUsage.h"
+
+
+static const struct {
+	const char *name;
+	uint32 field;
+} kFieldNames[] = {
+	{"system", collectSystem},
+	{"teams", collectTeams},
+	{"threads", collectThreads},
+	{"memory", collectMemory},
+	{"images", collectImages},
+	{"areas", collectAreas},
+	{"ports", collectPorts},
+	{"sems", collectSems},
+	{"files", collectFiles},
+	{"all", collectAll},
+};
+
+
+StreamOptions::StreamOptions():
+	fields(collectSystem | collectTeams),
+	format(SampleWriter::jsonFormat),
+	delta(false),
+	interval(1000000),
+	count(0),
+	team(-1)
+{}
+
+
+bool ParseStreamFields(const char *str, uint32 &fields)
+{
+	fields = 0;
+	while (*str != '\0') {
+		size_t len = strcspn(str, ",");
+		bool found = false;
+		for (size_t i = 0; i < sizeof(kFieldNames)/sizeof(kFieldNames[0]); i++) {
+			if (strlen(kFieldNames[i].name) == len && strncmp(kFieldNames[i].name, str, len) == 0) {
+				fields |= kFieldNames[i].field;
+				found = true;
+				break;
+			}
+		}
+		if (!found)
+			return false;
+		str += len;
+		if (*str == ',')
+			str++;
+	}
+	return fields != 0;
+}
+
+
+static void WriteSystem(SampleWriter &writer, const SystemSample &system)
+{
+	writer.BeginRecord(systemRecord, -1, 0);
+	writer.Float("cpu", system.cpuUsage);
+	writer.UInt("cpuCount", system.cpuCount);
+	writer.UInt("pageSize", system.pageSize);
+	writer.UInt("usedPages", system.usedPages);
+	writer.UInt("maxPages", system.maxPages);
+	writer.UInt("cachedPages", system.cachedPages);
+	writer.UInt("blockCachePages", system.blockCachePages);
+	writer.UInt("neededMemory", system.neededMemory);
+	writer.UInt("freeMemory", system.freeMemory);
+	writer.UInt("usedSwapPages", system.maxSwapPages - system.freeSwapPages);
+	writer.UInt("maxSwapPages", system.maxSwapPages);
+	writer.UInt("pageFaults", system.pageFaults);
+	writer.UInt("usedSems", system.usedSems);
+	writer.UInt("usedPorts", system.usedPorts);
+	writer.UInt("usedThreads", system.usedThreads);
+	writer.UInt("usedTeams", system.usedTeams);
+	writer.EndRecord();
+}
+
+static void WriteTeam(SampleWriter &writer, const TeamSample &team, uint32 fields)
+{
+	writer.BeginRecord(teamRecord, team.id, team.id);
+	writer.String("path", team.path.c_str());
+	writer.Int("parent", team.parent);
+	writer.Int("session", team.session);
+	writer.Int("group", team.group);
+	writer.Int("uid", team.uid);
+	writer.Int("gid", team.gid);
+	writer.Float("cpu", team.cpuUsage);
+	writer.Int("userTime", team.userTime);
+	writer.Int("kernelTime", team.kernelTime);
+	if ((fields & collectMemory) != 0) {
+		writer.UInt("memSize", team.memSize);
+		writer.UInt("memAlloc", team.memAlloc);
+	}
+	writer.EndRecord();
+}
+
+static void WriteThread(SampleWriter &writer, const ThreadSample &thread)
+{
+	writer.BeginRecord(threadRecord, thread.team, thread.id);
+	writer.String("name", thread.name.c_str());
+	const char *state = ThreadStateName(thread.state);
+	if (state != NULL)
+		writer.String("state", state);
+	else
+		writer.Int("state", thread.state);
+	writer.Int("priority", thread.priority);
+	writer.Int("sem", thread.sem);
+	writer.Int("semHolder", thread.semHolder);
+	writer.Float("cpu", thread.cpuUsage);
+	writer.Int("userTime", thread.userTime);
+	writer.Int("kernelTime", thread.kernelTime);
+	writer.UInt("stackBase", thread.stackBase);
+	writer.UInt("stackEnd", thread.stackEnd);
+	writer.EndRecord();
+}
+
+static void WriteMemoryGroup(SampleWriter &writer, const MemoryGroupSample &group)
+{
+	writer.BeginRecord(memoryRecord, group.team, group.id);
+	writer.String("kind", MemoryKindName(group.kind));
+	writer.String("name", group.name.c_str());
+	writer.UInt("areas", group.areaCount);
+	writer.UInt("teams", group.teamCount);
+	writer.UInt("size", group.size);
+	writer.UInt("ram", group.ram);
+	writer.UInt("sharedRam", group.sharedRam);
+	writer.Int("ramDelta", group.ramDelta);
+	writer.EndRecord();
+}
+
+static void WriteImages(SampleWriter &writer, team_id team, const std::vector<image_info> &images)
+{
+	for (const image_info &info: images) {
+		writer.BeginRecord(imageRecord, team, info.id);
+		const char *type = ImageTypeName(info.type);
+		if (type != NULL)
+			writer.String("type", type);
+		else
+			writer.Int("type", info.type);
+		writer.UInt("text", (addr_t)info.text);
+		writer.UInt("textSize", info.text_size);
+		writer.UInt("data", (addr_t)info.data);
+		writer.UInt("dataSize", info.data_size);
+		writer.String("path", info.name);
+		writer.EndRecord();
+	}
+}
+
+static void WriteAreas(SampleWriter &writer, team_id team, const std::vector<area_info> &areas)
+{
+	char protection[16];
+	for (const area_info &info: areas) {
+		writer.BeginRecord(areaRecord, team, info.area);
+		writer.String("name", info.name);
+		writer.UInt("address", (addr_t)info.address);
+		writer.UInt("size", info.size);
+		writer.UInt("ram", info.ram_size);
+		GetAreaProtectionString(protection, info.protection);
+		writer.String("protection", protection);
+		const char *lock = AreaLockName(info.lock);
+		if (lock != NULL)
+			writer.String("lock", lock);
+		else
+			writer.UInt("lock", info.lock);
+		writer.EndRecord();
+	}
+}
+
+static void WritePorts(SampleWriter &writer, team_id team, const std::vector<port_info> &ports)
+{
+	for (const port_info &info: ports) {
+		writer.BeginRecord(portRecord, team, info.port);
+		writer.String("name", info.name);
+		writer.Int("capacity", info.capacity);
+		writer.Int("queued", info.queue_count);
+		writer.Int("total", info.total_count);
+		writer.EndRecord();
+	}
+}
+
+static void WriteSems(SampleWriter &writer, team_id team, const std::vector<sem_info> &sems)
+{
+	for (const sem_info &info: sems) {
+		writer.BeginRecord(semRecord, team, info.sem);
+		writer.String("name", info.name);
+		writer.Int("count", info.count);
+		writer.Int("latestHolder", info.latest_holder);
+		writer.EndRecord();
+	}
+}
+
+static void WriteFiles(SampleWriter &writer, team_id team, const std::vector<FileSample> &files)
+{
+	for (const FileSample &file: files) {
+		writer.BeginRecord(fileRecord, team, file.info.number);
+		writer.String("path", file.path);
+		writer.String("mode", OpenModeName(file.info.open_mode));
+		writer.Int("device", file.info.device);
+		writer.Int("node", file.info.node);
+		writer.String("deviceName", file.fs.device_name);
+		writer.String("volume", file.fs.volume_name);
+		writer.String("fs", file.fs.fsh_name);
+		writer.EndRecord();
+	}
+}
+
+
+int RunStream(const StreamOptions &options)
+{
+	uint32 fields = options.fields;
+	Collector collector;
+	Snapshot snapshots[2];
+	Snapshot *cur = &snapshots[0], *prev = &snapshots[1];
+	SampleWriter writer(stdout, options.format, options.delta);
+
+	// Object lists are reused for all teams and samples.
+	std::vector<image_info> images;
+	std::vector<area_info> areas;
+	std::vector<port_info> ports;
+	std::vector<sem_info> sems;
+	std::vector<FileSample> files;
+
+	bigtime_t nextTime = system_time();
+	for (int64 i = 0; options.count <= 0 || i < options.count; i++) {
+		if (i > 0) {
+			nextTime = std::max(nextTime + options.interval, system_time());
+			snooze_until(nextTime, B_SYSTEM_TIMEBASE);
+		}
+
+		collector.Sample(*cur, fields, options.team);
+		ComputeCpuUsage(*cur, *prev);
+		if ((fields & collectMemory) != 0)
+			ComputeMemoryDeltas(*cur, *prev);
+
+		writer.BeginSample(cur->time);
+		if ((fields & collectSystem) != 0)
+			WriteSystem(writer, cur->system);
+		if ((fields & collectMemory) != 0 && options.team < 0) {
+			for (const MemoryGroupSample &group: cur->systemMemoryGroups)
+				WriteMemoryGroup(writer, group);
+		}
+		for (const TeamSample &team: cur->teams) {
+			if (options.team >= 0 && team.id != options.team)
+				continue;
+			if ((fields & collectTeams) != 0)
+				WriteTeam(writer, team, fields);
+			if ((fields & collectThreads) != 0) {
+				for (size_t j = team.firstThread; j < team.firstThread + team.threadCount; j++)
+					WriteThread(writer, cur->threads[j]);
+			}
+			if ((fields & collectMemory) != 0) {
+				for (size_t j = team.firstMemoryGroup; j < team.firstMemoryGroup + team.memoryGroupCount; j++)
+					WriteMemoryGroup(writer, cur->memoryGroups[j]);
+			}
+			if ((fields & collectImages) != 0) {
+				CollectImages(team.id, images);
+				WriteImages(writer, team.id, images);
+			}
+			if ((fields & collectAreas) != 0) {
+				CollectAreas(team.id, areas);
+				WriteAreas(writer, team.id, areas);
+			}
+			if ((fields & collectPorts) != 0) {
+				CollectPorts(team.id, ports);
+				WritePorts(writer, team.id, ports);
+			}
+			if ((fields & collectSems) != 0) {
+				CollectSems(team.id, sems);
+				WriteSems(writer, team.id, sems);
+			}
+			if ((fields & collectFiles) != 0) {
+				CollectFiles(team.id, files);
+				WriteFiles(writer, team.id, files);
+			}
+		}
+		if (!writer.EndSample()) {
+			fprintf(stderr, "can't write samples\n");
+			return 1;
+		}
+
+		std::swap(cur, prev);
+	}
+	return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+#include <OS.h>
+
+#include "SampleWriter.h"
+
+
+struct StreamOptions
+{
+	// Collector fields, only selected parts are gathered and written.
+	uint32 fields;
+	SampleWriter::Format format;
+	bool delta;
+	bigtime_t interval;
+	// Unlimited if 0.
+	int64 count;
+	// All teams if -1.
+	team_id team;
+
+	StreamOptions();
+};
+
+
+// Parses comma separated list of field names or "all".
+bool ParseStreamFields(const char *str, uint32 &fields);
+
+// Periodically writes samples to stdout without creating application.
+// Returns exit code.
+int RunStream(const StreamOptions &options);
+
+
+#endif	// _STREAM_H_
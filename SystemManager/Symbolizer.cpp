@@ -0,0 +1,690 @@
+#include "Symbolizer.h"
+
+#include <elf.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#ifndef NT_GNU_BUILD_ID
+#define NT_GNU_BUILD_ID 3
+#endif
+
+#ifndef SHF_COMPRESSED
+#define SHF_COMPRESSED (1 << 11)
+#endif
+
+
+enum {
+	DW_LNS_copy = 1,
+	DW_LNS_advance_pc,
+	DW_LNS_advance_line,
+	DW_LNS_set_file,
+	DW_LNS_set_column,
+	DW_LNS_negate_stmt,
+	DW_LNS_set_basic_block,
+	DW_LNS_const_add_pc,
+	DW_LNS_fixed_advance_pc,
+	DW_LNS_set_prologue_end,
+	DW_LNS_set_epilogue_begin,
+	DW_LNS_set_isa,
+};
+
+enum {
+	DW_LNE_end_sequence = 1,
+	DW_LNE_set_address,
+	DW_LNE_define_file,
+	DW_LNE_set_discriminator,
+};
+
+enum {
+	DW_LNCT_path = 1,
+	DW_LNCT_directory_index,
+};
+
+enum {
+	DW_FORM_block2 = 0x03,
+	DW_FORM_block4 = 0x04,
+	DW_FORM_data2 = 0x05,
+	DW_FORM_data4 = 0x06,
+	DW_FORM_data8 = 0x07,
+	DW_FORM_string = 0x08,
+	DW_FORM_block = 0x09,
+	DW_FORM_block1 = 0x0a,
+	DW_FORM_data1 = 0x0b,
+	DW_FORM_sdata = 0x0d,
+	DW_FORM_strp = 0x0e,
+	DW_FORM_udata = 0x0f,
+	DW_FORM_data16 = 0x1e,
+	DW_FORM_line_strp = 0x1f,
+};
+
+
+// Bounds checked little helper for reading DWARF data. Reads past end set
+// error flag and return zero.
+class DataReader
+{
+private:
+	const uint8_t *fPos;
+	const uint8_t *fEnd;
+	bool fError;
+
+public:
+	DataReader(const uint8_t *data, size_t size): fPos(data), fEnd(data + size), fError(false) {}
+
+	bool IsError() const {return fError;}
+	bool AtEnd() const {return fPos >= fEnd;}
+	const uint8_t *Pos() const {return fPos;}
+	size_t Left() const {return fEnd - fPos;}
+
+	void Seek(const uint8_t *pos)
+	{
+		if (pos > fEnd) {
+			fError = true;
+			pos = fEnd;
+		}
+		fPos = pos;
+	}
+
+	void Skip(uint64_t size)
+	{
+		if (size > Left()) {
+			fError = true;
+			fPos = fEnd;
+			return;
+		}
+		fPos += size;
+	}
+
+	template<typename T> T Read()
+	{
+		T val = 0;
+		if (sizeof(T) > Left()) {
+			fError = true;
+			fPos = fEnd;
+			return val;
+		}
+		memcpy(&val, fPos, sizeof(T));
+		fPos += sizeof(T);
+		return val;
+	}
+
+	uint64_t ReadSized(size_t size)
+	{
+		switch (size) {
+			case 1: return Read<uint8_t>();
+			case 2: return Read<uint16_t>();
+			case 4: return Read<uint32_t>();
+			case 8: return Read<uint64_t>();
+		}
+		fError = true;
+		return 0;
+	}
+
+	uint64_t ReadULeb()
+	{
+		uint64_t val = 0;
+		uint32_t shift = 0;
+		for (;;) {
+			uint8_t byte = Read<uint8_t>();
+			if (shift < 64)
+				val |= (uint64_t)(byte & 0x7f) << shift;
+			shift += 7;
+			if ((byte & 0x80) == 0 || fError)
+				return val;
+		}
+	}
+
+	int64_t ReadSLeb()
+	{
+		int64_t val = 0;
+		uint32_t shift = 0;
+		uint8_t byte;
+		do {
+			byte = Read<uint8_t>();
+			if (shift < 64)
+				val |= (int64_t)(byte & 0x7f) << shift;
+			shift += 7;
+		} while ((byte & 0x80) != 0 && !fError);
+		if (shift < 64 && (byte & 0x40) != 0)
+			val |= -((int64_t)1 << shift);
+		return val;
+	}
+
+	const char *ReadString()
+	{
+		const uint8_t *end = (const uint8_t*)memchr(fPos, 0, Left());
+		if (end == NULL) {
+			fError = true;
+			fPos = fEnd;
+			return "";
+		}
+		const char *str = (const char*)fPos;
+		fPos = end + 1;
+		return str;
+	}
+};
+
+
+static const char *SectionString(const uint8_t *data, size_t size, uint64_t offset)
+{
+	if (data == NULL || offset >= size || memchr(data + offset, 0, size - offset) == NULL)
+		return "";
+	return (const char*)data + offset;
+}
+
+static std::string JoinPath(const char *dir, const char *name)
+{
+	if (name[0] == '/' || dir[0] == '\0')
+		return name;
+	std::string path = dir;
+	if (path.back() != '/')
+		path += '/';
+	return path + name;
+}
+
+
+struct Elf32Class {
+	typedef Elf32_Ehdr Ehdr;
+	typedef Elf32_Phdr Phdr;
+	typedef Elf32_Shdr Shdr;
+	typedef Elf32_Sym Sym;
+	enum {kClass = ELFCLASS32};
+	static uint8_t SymbolType(uint8_t info) {return ELF32_ST_TYPE(info);}
+};
+
+struct Elf64Class {
+	typedef Elf64_Ehdr Ehdr;
+	typedef Elf64_Phdr Phdr;
+	typedef Elf64_Shdr Shdr;
+	typedef Elf64_Sym Sym;
+	enum {kClass = ELFCLASS64};
+	static uint8_t SymbolType(uint8_t info) {return ELF64_ST_TYPE(info);}
+};
+
+
+//#pragma mark SymbolImage
+
+std::shared_ptr<SymbolImage> SymbolImage::Load(const char *path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size < EI_NIDENT) {
+		close(fd);
+		return NULL;
+	}
+	size_t size = st.st_size;
+	void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+
+	std::shared_ptr<SymbolImage> image(new SymbolImage());
+	image->fPath = path;
+	image->fTextBase = 0;
+	const uint8_t *ident = (const uint8_t*)data;
+	bool ok = false;
+	if (memcmp(ident, ELFMAG, SELFMAG) == 0) {
+		switch (ident[EI_CLASS]) {
+			case ELFCLASS32: ok = image->Parse<Elf32Class>(ident, size); break;
+			case ELFCLASS64: ok = image->Parse<Elf64Class>(ident, size); break;
+		}
+	}
+	munmap(data, size);
+	if (!ok)
+		return NULL;
+	return image;
+}
+
+
+template<typename Elf>
+bool SymbolImage::Parse(const uint8_t *data, size_t size)
+{
+	typedef typename Elf::Ehdr Ehdr;
+	typedef typename Elf::Phdr Phdr;
+	typedef typename Elf::Shdr Shdr;
+	typedef typename Elf::Sym Sym;
+
+	static const uint16_t byteOrderProbe = 1;
+	uint8_t hostData = *(const uint8_t*)&byteOrderProbe == 1 ? ELFDATA2LSB : ELFDATA2MSB;
+	if (size < sizeof(Ehdr) || data[EI_DATA] != hostData)
+		return false;
+
+	Ehdr ehdr;
+	memcpy(&ehdr, data, sizeof(ehdr));
+
+	if (ehdr.e_phoff != 0 && ehdr.e_phentsize == sizeof(Phdr) && ehdr.e_phoff + (uint64_t)ehdr.e_phnum*sizeof(Phdr) <= size) {
+		for (uint32_t i = 0; i < ehdr.e_phnum; i++) {
+			Phdr phdr;
+			memcpy(&phdr, data + ehdr.e_phoff + i*sizeof(Phdr), sizeof(phdr));
+			if (phdr.p_type == PT_LOAD) {
+				fTextBase = phdr.p_vaddr & ~(uint64_t)0xfff;
+				break;
+			}
+		}
+	}
+
+	if (ehdr.e_shoff == 0 || ehdr.e_shentsize != sizeof(Shdr) || ehdr.e_shoff + (uint64_t)ehdr.e_shnum*sizeof(Shdr) > size)
+		return false;
+	std::vector<Shdr> sections(ehdr.e_shnum);
+	memcpy(sections.data(), data + ehdr.e_shoff, ehdr.e_shnum*sizeof(Shdr));
+
+	auto sectionData = [&](const Shdr &shdr, size_t &sectionSize) -> const uint8_t* {
+		sectionSize = 0;
+		if (shdr.sh_type == SHT_NOBITS || (shdr.sh_flags & SHF_COMPRESSED) != 0)
+			return NULL;
+		if (shdr.sh_offset > size || shdr.sh_size > size - shdr.sh_offset)
+			return NULL;
+		sectionSize = shdr.sh_size;
+		return data + shdr.sh_offset;
+	};
+
+	const uint8_t *names = NULL;
+	size_t namesSize = 0;
+	if (ehdr.e_shstrndx < sections.size())
+		names = sectionData(sections[ehdr.e_shstrndx], namesSize);
+
+	const Shdr *symtab = NULL, *dynsym = NULL;
+	const uint8_t *lineData = NULL, *lineStrData = NULL, *strData = NULL;
+	size_t lineSize = 0, lineStrSize = 0, strSize = 0;
+
+	for (const Shdr &shdr: sections) {
+		const char *name = SectionString(names, namesSize, shdr.sh_name);
+		switch (shdr.sh_type) {
+			case SHT_SYMTAB: symtab = &shdr; break;
+			case SHT_DYNSYM: dynsym = &shdr; break;
+			case SHT_NOTE: {
+				size_t noteSize;
+				const uint8_t *note = sectionData(shdr, noteSize);
+				DataReader rd(note, noteSize);
+				while (fBuildId.empty() && rd.Left() >= 12) {
+					uint32_t nameSize = rd.Read<uint32_t>();
+					uint32_t descSize = rd.Read<uint32_t>();
+					uint32_t type = rd.Read<uint32_t>();
+					const uint8_t *noteName = rd.Pos();
+					rd.Skip((nameSize + 3) & ~3);
+					const uint8_t *desc = rd.Pos();
+					rd.Skip((descSize + 3) & ~3);
+					if (rd.IsError())
+						break;
+					if (type == NT_GNU_BUILD_ID && nameSize == 4 && memcmp(noteName, "GNU", 4) == 0) {
+						static const char digits[] = "0123456789abcdef";
+						for (uint32_t i = 0; i < descSize; i++) {
+							fBuildId += digits[desc[i] >> 4];
+							fBuildId += digits[desc[i] & 0xf];
+						}
+					}
+				}
+				break;
+			}
+			default:
+				if (strcmp(name, ".debug_line") == 0)
+					lineData = sectionData(shdr, lineSize);
+				else if (strcmp(name, ".debug_line_str") == 0)
+					lineStrData = sectionData(shdr, lineStrSize);
+				else if (strcmp(name, ".debug_str") == 0)
+					strData = sectionData(shdr, strSize);
+		}
+	}
+
+	// Full symbol table is missing in stripped files.
+	const Shdr *symbols = symtab != NULL ? symtab : dynsym;
+	if (symbols != NULL && symbols->sh_link < sections.size()) {
+		size_t symSize, symStrSize;
+		const uint8_t *symData = sectionData(*symbols, symSize);
+		const uint8_t *symStrData = sectionData(sections[symbols->sh_link], symStrSize);
+		for (size_t i = 0; i + sizeof(Sym) <= symSize; i += sizeof(Sym)) {
+			Sym sym;
+			memcpy(&sym, symData + i, sizeof(sym));
+			uint8_t type = Elf::SymbolType(sym.st_info);
+			if ((type != STT_FUNC && type != STT_OBJECT) || sym.st_shndx == SHN_UNDEF || sym.st_value == 0)
+				continue;
+			fSymbols.push_back({sym.st_value, sym.st_size, SectionString(symStrData, symStrSize, sym.st_name)});
+		}
+		std::stable_sort(fSymbols.begin(), fSymbols.end(), [](const Symbol &a, const Symbol &b) {
+			return a.address < b.address;
+		});
+		fSymbols.erase(std::unique(fSymbols.begin(), fSymbols.end(), [](const Symbol &a, const Symbol &b) {
+			return a.address == b.address;
+		}), fSymbols.end());
+		fSymbols.shrink_to_fit();
+	}
+
+	if (lineData != NULL)
+		ParseLineTable(lineData, lineSize, lineStrData, lineStrSize, strData, strSize);
+
+	return true;
+}
+
+
+bool SymbolImage::ParseLineTable(const uint8_t *data, size_t size, const uint8_t *lineStr, size_t lineStrSize, const uint8_t *str, size_t strSize)
+{
+	std::unordered_map<std::string, uint32_t> fileIndex;
+	auto addFile = [&](const std::string &path) -> uint32_t {
+		auto it = fileIndex.find(path);
+		if (it != fileIndex.end())
+			return it->second;
+		uint32_t index = fFiles.size();
+		fFiles.push_back(path);
+		fileIndex[path] = index;
+		return index;
+	};
+
+	DataReader rd(data, size);
+	while (!rd.AtEnd() && !rd.IsError()) {
+		bool is64 = false;
+		uint64_t unitLength = rd.Read<uint32_t>();
+		if (unitLength == 0xffffffff) {
+			is64 = true;
+			unitLength = rd.Read<uint64_t>();
+		}
+		if (rd.IsError() || unitLength > rd.Left())
+			return false;
+		const uint8_t *unitEnd = rd.Pos() + unitLength;
+
+		uint16_t version = rd.Read<uint16_t>();
+		if (version < 2 || version > 5) {
+			rd.Seek(unitEnd);
+			continue;
+		}
+		uint8_t addressSize = 0;
+		if (version >= 5) {
+			addressSize = rd.Read<uint8_t>();
+			rd.Read<uint8_t>(); // segment selector size
+		}
+		uint64_t headerLength = is64 ? rd.Read<uint64_t>() : rd.Read<uint32_t>();
+		const uint8_t *programStart = rd.Pos() + headerLength;
+		uint8_t minInstLength = rd.Read<uint8_t>();
+		if (version >= 4)
+			rd.Read<uint8_t>(); // maximum operations per instruction
+		bool defaultIsStmt = rd.Read<uint8_t>() != 0;
+		(void)defaultIsStmt;
+		int8_t lineBase = rd.Read<int8_t>();
+		uint8_t lineRange = rd.Read<uint8_t>();
+		uint8_t opcodeBase = rd.Read<uint8_t>();
+		std::vector<uint8_t> opcodeLengths(opcodeBase);
+		for (uint32_t i = 1; i < opcodeBase; i++)
+			opcodeLengths[i] = rd.Read<uint8_t>();
+		if (lineRange == 0 || opcodeBase == 0) {
+			rd.Seek(unitEnd);
+			continue;
+		}
+
+		std::vector<std::string> dirs;
+		std::vector<uint32_t> files;
+		if (version < 5) {
+			// Directory 0 and file 0 are compilation directory and are not
+			// listed.
+			dirs.push_back("");
+			for (;;) {
+				const char *dir = rd.ReadString();
+				if (*dir == '\0' || rd.IsError()) break;
+				dirs.push_back(dir);
+			}
+			files.push_back(UINT32_MAX);
+			for (;;) {
+				const char *name = rd.ReadString();
+				if (*name == '\0' || rd.IsError()) break;
+				uint64_t dir = rd.ReadULeb();
+				rd.ReadULeb(); // modification time
+				rd.ReadULeb(); // size
+				files.push_back(addFile(JoinPath(dir < dirs.size() ? dirs[dir].c_str() : "", name)));
+			}
+		} else {
+			auto readEntries = [&](bool isFile) {
+				uint8_t formatCount = rd.Read<uint8_t>();
+				std::vector<std::pair<uint64_t, uint64_t>> formats(formatCount);
+				for (auto &format: formats) {
+					format.first = rd.ReadULeb();
+					format.second = rd.ReadULeb();
+				}
+				uint64_t count = rd.ReadULeb();
+				for (uint64_t i = 0; i < count && !rd.IsError(); i++) {
+					const char *path = "";
+					uint64_t dir = 0;
+					for (auto &format: formats) {
+						const char *strVal = NULL;
+						uint64_t intVal = 0;
+						switch (format.second) {
+							case DW_FORM_string: strVal = rd.ReadString(); break;
+							case DW_FORM_line_strp: strVal = SectionString(lineStr, lineStrSize, is64 ? rd.Read<uint64_t>() : rd.Read<uint32_t>()); break;
+							case DW_FORM_strp: strVal = SectionString(str, strSize, is64 ? rd.Read<uint64_t>() : rd.Read<uint32_t>()); break;
+							case DW_FORM_udata: intVal = rd.ReadULeb(); break;
+							case DW_FORM_sdata: intVal = rd.ReadSLeb(); break;
+							case DW_FORM_data1: intVal = rd.Read<uint8_t>(); break;
+							case DW_FORM_data2: intVal = rd.Read<uint16_t>(); break;
+							case DW_FORM_data4: intVal = rd.Read<uint32_t>(); break;
+							case DW_FORM_data8: intVal = rd.Read<uint64_t>(); break;
+							case DW_FORM_data16: rd.Skip(16); break;
+							case DW_FORM_block1: rd.Skip(rd.Read<uint8_t>()); break;
+							case DW_FORM_block2: rd.Skip(rd.Read<uint16_t>()); break;
+							case DW_FORM_block4: rd.Skip(rd.Read<uint32_t>()); break;
+							case DW_FORM_block: rd.Skip(rd.ReadULeb()); break;
+							default:
+								// Unknown size, rest of header can't be parsed.
+								rd.Seek(unitEnd + 1);
+								return;
+						}
+						if (format.first == DW_LNCT_path && strVal != NULL)
+							path = strVal;
+						else if (format.first == DW_LNCT_directory_index)
+							dir = intVal;
+					}
+					if (isFile)
+						files.push_back(addFile(JoinPath(dir < dirs.size() ? dirs[dir].c_str() : "", path)));
+					else
+						dirs.push_back(path);
+				}
+			};
+			readEntries(false);
+			readEntries(true);
+		}
+		if (rd.IsError())
+			return false;
+
+		rd.Seek(programStart);
+		DataReader prog(rd.Pos(), unitEnd - std::min(rd.Pos(), unitEnd));
+		uint64_t address = 0;
+		uint64_t file = 1;
+		int64_t line = 1;
+		uint64_t column = 0;
+		size_t sequenceStart = fLines.size();
+		auto emit = [&](bool endSequence) {
+			fLines.push_back({
+				.address = address,
+				.file = file < files.size() ? files[file] : UINT32_MAX,
+				.line = (uint32_t)line,
+				.column = (uint32_t)column,
+				.endSequence = endSequence
+			});
+		};
+		while (!prog.AtEnd() && !prog.IsError()) {
+			uint8_t opcode = prog.Read<uint8_t>();
+			if (opcode >= opcodeBase) {
+				uint8_t adjusted = opcode - opcodeBase;
+				address += (adjusted / lineRange)*minInstLength;
+				line += lineBase + adjusted % lineRange;
+				emit(false);
+				continue;
+			}
+			switch (opcode) {
+				case 0: {
+					uint64_t length = prog.ReadULeb();
+					if (length == 0 || length > prog.Left()) {
+						prog.Skip(length);
+						break;
+					}
+					const uint8_t *next = prog.Pos() + length;
+					switch (prog.Read<uint8_t>()) {
+						case DW_LNE_end_sequence:
+							emit(true);
+							// Code of functions discarded by linker is left at
+							// address 0 and overlaps real code.
+							if (fLines[sequenceStart].address == 0)
+								fLines.resize(sequenceStart);
+							sequenceStart = fLines.size();
+							address = 0; file = 1; line = 1; column = 0;
+							break;
+						case DW_LNE_set_address:
+							address = prog.ReadSized(addressSize != 0 ? addressSize : length - 1);
+							break;
+						case DW_LNE_define_file: {
+							const char *name = prog.ReadString();
+							uint64_t dir = prog.ReadULeb();
+							files.push_back(addFile(JoinPath(dir < dirs.size() ? dirs[dir].c_str() : "", name)));
+							break;
+						}
+					}
+					prog.Seek(next);
+					break;
+				}
+				case DW_LNS_copy: emit(false); break;
+				case DW_LNS_advance_pc: address += prog.ReadULeb()*minInstLength; break;
+				case DW_LNS_advance_line: line += prog.ReadSLeb(); break;
+				case DW_LNS_set_file: file = prog.ReadULeb(); break;
+				case DW_LNS_set_column: column = prog.ReadULeb(); break;
+				case DW_LNS_const_add_pc: address += ((255 - opcodeBase) / lineRange)*minInstLength; break;
+				case DW_LNS_fixed_advance_pc: address += prog.Read<uint16_t>(); break;
+				case DW_LNS_negate_stmt:
+				case DW_LNS_set_basic_block:
+				case DW_LNS_set_prologue_end:
+				case DW_LNS_set_epilogue_begin:
+					break;
+				default:
+					for (uint32_t i = 0; i < opcodeLengths[opcode]; i++)
+						prog.ReadULeb();
+			}
+		}
+		rd.Seek(unitEnd);
+	}
+
+	// Sequence end goes before sequence start at the same address, rows of
+	// same address keep program order so the last one wins on lookup.
+	std::stable_sort(fLines.begin(), fLines.end(), [](const LineRow &a, const LineRow &b) {
+		if (a.address != b.address)
+			return a.address < b.address;
+		return a.endSequence && !b.endSequence;
+	});
+	fLines.shrink_to_fit();
+	return true;
+}
+
+
+const SymbolImage::Symbol *SymbolImage::LookupSymbol(uint64_t address, bool *exact) const
+{
+	auto it = std::upper_bound(fSymbols.begin(), fSymbols.end(), address, [](uint64_t address, const Symbol &symbol) {
+		return address < symbol.address;
+	});
+	if (it == fSymbols.begin())
+		return NULL;
+	--it;
+	if (exact != NULL)
+		*exact = address < it->address + it->size;
+	return &*it;
+}
+
+bool SymbolImage::LookupLine(uint64_t address, SourceLocation &location) const
+{
+	auto it = std::upper_bound(fLines.begin(), fLines.end(), address, [](uint64_t address, const LineRow &row) {
+		return address < row.address;
+	});
+	if (it == fLines.begin())
+		return false;
+	--it;
+	if (it->endSequence || it->file == UINT32_MAX)
+		return false;
+	location.path = fFiles[it->file].c_str();
+	location.line = it->line;
+	location.column = it->column;
+	return true;
+}
+
+
+//#pragma mark Symbolizer
+
+Symbolizer &Symbolizer::Default()
+{
+	static Symbolizer symbolizer;
+	return symbolizer;
+}
+
+
+bool Symbolizer::Matches(const Entry &entry, const struct stat &st)
+{
+	return entry.device == st.st_dev && entry.node == st.st_ino && entry.modificationTime == st.st_mtime && entry.size == st.st_size;
+}
+
+// Drops least recently used paths over limit and build IDs of images that
+// are no longer used. Must be called with lock held.
+void Symbolizer::Evict()
+{
+	while (fByPath.size() > kMaxImages) {
+		auto oldest = fByPath.begin();
+		for (auto it = fByPath.begin(); it != fByPath.end(); it++) {
+			if (it->second.lastUse < oldest->second.lastUse)
+				oldest = it;
+		}
+		fByPath.erase(oldest);
+	}
+	for (auto it = fByBuildId.begin(); it != fByBuildId.end();) {
+		if (it->second.expired())
+			it = fByBuildId.erase(it);
+		else
+			it++;
+	}
+}
+
+
+std::shared_ptr<const SymbolImage> Symbolizer::Get(const char *path)
+{
+	struct stat st;
+	if (stat(path, &st) < 0)
+		return NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(fLock);
+		auto it = fByPath.find(path);
+		if (it != fByPath.end() && Matches(it->second, st)) {
+			it->second.lastUse = ++fUseCount;
+			return it->second.image;
+		}
+	}
+
+	// Loading may take long, other images can be looked up meanwhile. If
+	// several threads load the same file, the first one inserted is kept.
+	std::shared_ptr<SymbolImage> image = SymbolImage::Load(path);
+	if (!image)
+		return NULL;
+
+	std::lock_guard<std::mutex> lock(fLock);
+	auto it = fByPath.find(path);
+	if (it != fByPath.end() && Matches(it->second, st)) {
+		it->second.lastUse = ++fUseCount;
+		return it->second.image;
+	}
+
+	// Same file reached by other path, keep single copy of tables.
+	if (!image->BuildId().empty()) {
+		std::weak_ptr<SymbolImage> &shared = fByBuildId[image->BuildId()];
+		if (std::shared_ptr<SymbolImage> existing = shared.lock())
+			image = existing;
+		else
+			shared = image;
+	}
+
+	fByPath[path] = {st.st_dev, st.st_ino, st.st_mtime, st.st_size, ++fUseCount, image};
+	Evict();
+	return image;
+}
+
+void Symbolizer::Clear()
+{
+	std::lock_guard<std::mutex> lock(fLock);
+	fByPath.clear();
+	fByBuildId.clear();
+}
@@ -0,0 +1,108 @@
+#ifndef _SYMBOLIZER_H_
+#define _SYMBOLIZER_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+
+// Symbol table and DWARF line table of single ELF file. Tables are read
+// once on load and kept sorted by address, file is not accessed after that.
+// Addresses are ELF virtual addresses.
+class SymbolImage
+{
+public:
+	struct Symbol {
+		uint64_t address;
+		uint64_t size;
+		std::string name;
+	};
+
+	struct SourceLocation {
+		const char *path;
+		uint32_t line;
+		uint32_t column;
+	};
+
+private:
+	struct LineRow {
+		uint64_t address;
+		uint32_t file;
+		uint32_t line;
+		uint32_t column;
+		bool endSequence;
+	};
+
+	std::string fPath;
+	std::string fBuildId;
+	uint64_t fTextBase;
+	std::vector<Symbol> fSymbols;
+	std::vector<std::string> fFiles;
+	std::vector<LineRow> fLines;
+
+	template<typename Elf> bool Parse(const uint8_t *data, size_t size);
+	bool ParseLineTable(const uint8_t *data, size_t size, const uint8_t *lineStr, size_t lineStrSize, const uint8_t *str, size_t strSize);
+
+public:
+	static std::shared_ptr<SymbolImage> Load(const char *path);
+
+	const std::string &Path() const {return fPath;}
+	// Hex string of GNU build ID note, empty if file has none.
+	const std::string &BuildId() const {return fBuildId;}
+	// Virtual address the first loadable segment is mapped at, image text
+	// address in memory corresponds to it.
+	uint64_t TextBase() const {return fTextBase;}
+	bool HasLineInfo() const {return !fLines.empty();}
+
+	// Closest symbol at or below address. exact is set if address is inside
+	// symbol size.
+	const Symbol *LookupSymbol(uint64_t address, bool *exact = NULL) const;
+	bool LookupLine(uint64_t address, SourceLocation &location) const;
+};
+
+
+// Loaded images shared by all users. Image is reloaded if file modification
+// time or size changes, files with the same build ID share one image. Up to
+// kMaxImages least recently used paths are kept, images are loaded without
+// holding lock.
+class Symbolizer
+{
+public:
+	enum {
+		kMaxImages = 64,
+	};
+
+private:
+	struct Entry {
+		dev_t device;
+		ino_t node;
+		time_t modificationTime;
+		off_t size;
+		uint64_t lastUse;
+		std::shared_ptr<SymbolImage> image;
+	};
+
+	std::mutex fLock;
+	uint64_t fUseCount = 0;
+	std::unordered_map<std::string, Entry> fByPath;
+	std::unordered_map<std::string, std::weak_ptr<SymbolImage>> fByBuildId;
+
+	static bool Matches(const Entry &entry, const struct stat &st);
+	void Evict();
+
+public:
+	static Symbolizer &Default();
+
+	// Returns NULL if file can't be loaded.
+	std::shared_ptr<const SymbolImage> Get(const char *path);
+	void Clear();
+};
+
+
+#endif	// _SYMBOLIZER_H_
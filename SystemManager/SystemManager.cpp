@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include <OS.h>
@@ -28,11 +30,17 @@
 #include <Path.h>
 #include <NodeInfo.h>
 #include <FindDirectory.h>
+#include <FilePanel.h>
 
 #include "TeamWindow.h"
+#include "ProfileWindow.h"
 #include "Errors.h"
 #include "Utils.h"
 #include "UIUtils.h"
+#include "RowIndex.h"
+#include "Sampler.h"
+#include "MemoryList.h"
+#include "Stream.h"
 
 enum {
 	invokeMsg = 1,
@@ -40,12 +48,16 @@ enum {
 	updateMsg,
 
 	setLayoutMsg,
+	setIntervalMsg,
+	exportHistoryMsg,
+	exportHistorySaveMsg,
 
 	terminateMsg,
 	suspendMsg,
 	resumeMsg,
 	sendSignalMsg,
 	debugMsg,
+	profileMsg,
 
 	showLocationMsg,
 };
@@ -60,11 +72,19 @@ enum {
 	memAllocCol,
 	userCol,
 	pathCol,
+	cpuCol,
+	cpuHistoryCol,
+	memHistoryCol,
 };
 
 enum {
 	statNameCol = 0,
 	statValueCol,
+	statHistoryCol,
+};
+
+enum {
+	kSparklineLength = 256,
 };
 
 enum ViewLayout {
@@ -74,66 +94,6 @@ enum ViewLayout {
 };
 
 
-struct RowTree
-{
-	ObjectDeleter<RowTree> next, down;
-	ObjectDeleter<BRow> row;
-};
-
-
-static void BuildRowTree(ObjectDeleter<RowTree> &tree, BColumnListView *view, BRow *row)
-{
-	tree.SetTo(new RowTree());
-	tree->row.SetTo(row);
-	RowTree *last = NULL;
-	ObjectDeleter<RowTree> newNode;
-	int32 count = view->CountRows(row);
-	for (int32 i = 0; i < count; i++) {
-		BuildRowTree(newNode, view, view->RowAt(i, row));
-		if (last == NULL) {
-			tree->down.SetTo(newNode.Detach());
-			last = tree->down.Get();
-		} else {
-			last->next.SetTo(newNode.Detach());
-			last = last->next.Get();
-		}
-	}
-}
-
-static void RemoveRow(BColumnListView *view, BRow *row, ObjectDeleter<RowTree> &tree)
-{
-	BuildRowTree(tree, view, row);
-	view->RemoveRow(row);
-}
-
-static void InsertRow(BColumnListView *view, BRow *parent, ObjectDeleter<RowTree> &tree)
-{
-	if (tree.Get() == NULL) return;
-
-	BRow *row = tree->row.Detach();
-	view->AddRow(row, parent);
-	if (parent != NULL)
-		view->ExpandOrCollapse(parent, true);
-	ObjectDeleter<RowTree> list(tree->down.Detach());
-	while (list.Get() != NULL) {
-		ObjectDeleter<RowTree> next(list->next.Detach());
-		InsertRow(view, row, list);
-		list.SetTo(next.Detach());
-	}
-	tree.Unset();
-}
-
-static void SetRowParent(BColumnListView *view, BRow *row, BRow *newParent)
-{
-	BRow *oldParent;
-	view->FindParent(row, &oldParent, NULL);
-	if (newParent != oldParent) {
-		ObjectDeleter<RowTree> tree;
-		RemoveRow(view, row, tree);
-		InsertRow(view, newParent, tree);
-	}
-}
-
 static BRow *FindIntRow(BColumnListView *view, BRow *parent, int32 val)
 {
 	BRow *row, *row2;
@@ -149,16 +109,6 @@ static BRow *FindIntRow(BColumnListView *view, BRow *parent, int32 val)
 	return NULL;
 }
 
-static BRow *FindIntRowList(BList &list, int32 val)
-{
-	for (int32 i = 0; i < list.CountItems(); i++) {
-		BRow *row = (BRow*)list.ItemAt(i);
-		if (((BIntegerField*)row->GetField(idCol))->Value() == val)
-			return row;
-	}
-	return NULL;
-}
-
 static void CollectRowList(BList &list, BColumnListView *view, BRow *parent = NULL)
 {
 	for (int32 i = 0; i < view->CountRows(parent); i++) {
@@ -168,8 +118,9 @@ static void CollectRowList(BList &list, BColumnListView *view, BRow *parent = NU
 	}
 }
 
-static void RelayoutTeams(BColumnListView *view, ViewLayout layout)
+static void RelayoutTeams(RowIndex &rows, ViewLayout layout)
 {
+	BColumnListView *view = rows.View();
 	BList list;
 	CollectRowList(list, view);
 
@@ -184,7 +135,7 @@ static void RelayoutTeams(BColumnListView *view, ViewLayout layout)
 	case treeLayout: {
 		for (int32 i = 0; i < list.CountItems(); i++) {
 			BRow *row = (BRow*)list.ItemAt(i);
-			BRow *parent = FindIntRowList(list, ((BIntegerField*)row->GetField(parentIdCol))->Value());
+			BRow *parent = rows.Find(((BIntegerField*)row->GetField(parentIdCol))->Value());
 			SetRowParent(view, row, parent);
 		}
 		break;
@@ -196,62 +147,20 @@ static void RelayoutTeams(BColumnListView *view, ViewLayout layout)
 
 }
 
-static void GetTeamMemory(size_t &size, size_t &alloc, team_id team)
-{
-	area_info info;
-	ssize_t cookie = 0;
-
-	// TODO: limit max enumerated area count to prevent freezes
-	size = 0; alloc = 0;
-	while (get_next_area_info(team, &cookie, &info) >= B_OK) {
-		size += info.size;
-		alloc += info.ram_size;
-	}
-}
-
-static void ListTeams(BColumnListView *view, ViewLayout layout) {
-	status_t status;
-	team_info info;
-	int32 cookie;
+static void ListTeams(RowIndex &rows, ViewLayout layout, const Snapshot &snapshot) {
+	BColumnListView *view = rows.View();
 	BRow *row;
-	cookie = 0;
-	BList prevRows;
 	BString str;
+	History &history = Sampler::Default().GetHistory();
+	std::vector<double> cpuHistory, memHistory;
 
-	view->ScrollView()->Invalidate();
-
-	CollectRowList(prevRows, view);
+	rows.BeginUpdate();
 
-	while (get_next_team_info(&cookie, &info) == B_OK) {
-		int32 uid = -1, gid = -1;
-		KMessage extInfo;
-		if (get_extended_team_info(info.team, B_TEAM_INFO_BASIC, extInfo) >= B_OK) {
-			if (extInfo.FindInt32("uid", &uid) < B_OK) uid = -1;
-			if (extInfo.FindInt32("gid", &gid) < B_OK) gid = -1;
-		}
-
-		int32 imageCookie = 0;
-		image_info imageInfo;
-		status = get_next_image_info(info.team, &imageCookie, &imageInfo);
-		if (status < B_OK) strcpy(imageInfo.name, "");
-		BPath path(imageInfo.name);
-
-		BBitmap* icon = new BBitmap(BRect(0, 0, B_MINI_ICON - 1, B_MINI_ICON - 1), B_RGBA32);
-		BEntry entry;
-		entry_ref ref;
-		if (status == B_OK) {
-			entry.SetTo(imageInfo.name);
-			status = entry.GetRef(&ref);
-		}
-		if (status == B_OK)
-			status = BNodeInfo::GetTrackerIcon(&ref, icon, B_MINI_ICON);
-		if (status != B_OK) {
-			BMimeType genericAppType(B_APP_MIME_TYPE);
-			status = genericAppType.GetIcon(icon, B_MINI_ICON);
-		}
-
-		row = FindIntRowList(prevRows, info.team);
-		if (row == NULL) {
+	for (const TeamSample &team: snapshot.teams) {
+		row = rows.Touch(team.id);
+		bool isNew = row == NULL;
+		bool changed = false;
+		if (isNew) {
 			row = new BRow();
 			row->SetField(new IconStringField(0), nameCol);
 			row->SetField(new BIntegerField(0), idCol);
@@ -262,35 +171,46 @@ static void ListTeams(BColumnListView *view, ViewLayout layout) {
 			row->SetField(new BStringField(0), memAllocCol);
 			row->SetField(new BStringField(0), userCol);
 			row->SetField(new BStringField(0), pathCol);
-			view->AddRow(row);
-		} else {
-			prevRows.RemoveItem(row);
+			row->SetField(new FloatField(0), cpuCol);
+			row->SetField(new SparklineField(100), cpuHistoryCol);
+			row->SetField(new SparklineField(), memHistoryCol);
+			static_cast<BIntegerField*>(row->GetField(idCol))->SetValue(team.id);
 		}
 
-		static_cast<IconStringField*>(row->GetField(nameCol))->SetIcon(icon);
-		static_cast<IconStringField*>(row->GetField(nameCol))->SetString(path.Leaf());
-		static_cast<BIntegerField*>(row->GetField(idCol))->SetValue(info.team);
-		static_cast<BIntegerField*>(row->GetField(parentIdCol))->SetValue(_kern_process_info(info.team, PARENT_ID));
-		static_cast<BIntegerField*>(row->GetField(sidCol))->SetValue(_kern_process_info(info.team, SESSION_ID));
-		static_cast<BIntegerField*>(row->GetField(gidCol))->SetValue(_kern_process_info(info.team, GROUP_ID));
-		size_t memSize, memAlloc;
-		GetTeamMemory(memSize, memAlloc, info.team);
-		GetSizeString(str, memSize);
-		static_cast<BStringField*>(row->GetField(memSizeCol))->SetString(str);
-		GetSizeString(str, memAlloc);
-		static_cast<BStringField*>(row->GetField(memAllocCol))->SetString(str);
-		GetUserGroupString(str, uid, gid);
-		static_cast<BStringField*>(row->GetField(userCol))->SetString(str);
-		static_cast<BStringField*>(row->GetField(pathCol))->SetString(imageInfo.name);
-	}
+		// Image path changes only on exec, look up icon only then.
+		const char *imagePath = team.path.c_str();
+		if (isNew || strcmp(static_cast<BStringField*>(row->GetField(pathCol))->String(), imagePath) != 0) {
+			BPath path(imagePath);
+			static_cast<IconStringField*>(row->GetField(nameCol))->SetIcon(IconCache::Default().Get(imagePath).Get());
+			static_cast<IconStringField*>(row->GetField(nameCol))->SetString(path.Leaf());
+			static_cast<BStringField*>(row->GetField(pathCol))->SetString(imagePath);
+			changed = true;
+		}
+
+		changed |= SetIntField(row, parentIdCol, team.parent);
+		changed |= SetIntField(row, sidCol, team.session);
+		changed |= SetIntField(row, gidCol, team.group);
+		GetSizeString(str, team.memSize);
+		changed |= SetStringField(row, memSizeCol, str);
+		GetSizeString(str, team.memAlloc);
+		changed |= SetStringField(row, memAllocCol, str);
+		GetUserGroupString(str, team.uid, team.gid);
+		changed |= SetStringField(row, userCol, str);
+		changed |= SetFloatField(row, cpuCol, team.cpuUsage);
+		if (history.ReadTeam(team.id, cpuHistory, memHistory, kSparklineLength)) {
+			changed |= static_cast<SparklineField*>(row->GetField(cpuHistoryCol))->SetValues(cpuHistory);
+			changed |= static_cast<SparklineField*>(row->GetField(memHistoryCol))->SetValues(memHistory);
+		}
 
-	for (int32 i = 0; i < prevRows.CountItems(); i++) {
-		row = (BRow*)prevRows.ItemAt(i);
-		view->RemoveRow(row);
-		delete row;
+		if (isNew)
+			rows.Add(team.id, row);
+		else if (changed)
+			view->UpdateRow(row);
 	}
 
-	RelayoutTeams(view, layout);
+	rows.EndUpdate();
+
+	RelayoutTeams(rows, layout);
 
 #if 0
 	switch (treeLayout) {
@@ -359,75 +279,125 @@ static BColumnListView* NewTeamsView()
 	view->AddColumn(new BStringColumn("Alloc", 64 + 16, 32, 256, B_TRUNCATE_END), memAllocCol);
 	view->AddColumn(new BStringColumn("User", 64 + 16, 32, 128, B_TRUNCATE_END), userCol);
 	view->AddColumn(new BStringColumn("Path", 512, 50, 1024, B_TRUNCATE_MIDDLE), pathCol);
+	view->AddColumn(new PercentColumn("CPU", 64, 32, 128), cpuCol);
+	view->AddColumn(new SparklineColumn("CPU history", 128, 32, 512), cpuHistoryCol);
+	view->AddColumn(new SparklineColumn("Memory history", 128, 32, 512), memHistoryCol);
+	view->MoveColumn(view->ColumnAt(cpuCol), idCol + 1);
+	view->MoveColumn(view->ColumnAt(cpuHistoryCol), idCol + 2);
 	view->SetColumnVisible(parentIdCol, false);
 	return view;
 }
 
 
-static void ListStats(BColumnListView *view)
+static const struct {
+	const char *name;
+	History::Series series;
+} kStatRows[] = {
+	{"Boot time", History::seriesCount},
+	{"CPU count", History::seriesCount},
+	{"CPU usage", History::cpuSeries},
+	{"Pages", History::seriesCount},
+	{"Cached pages", History::cachedSeries},
+	{"Block cache pages", History::seriesCount},
+	{"Ignored pages", History::seriesCount},
+	{"Needed memory", History::seriesCount},
+	{"Memory", History::memorySeries},
+	{"Swap pages", History::swapSeries},
+	{"Page faults", History::pageFaultsSeries},
+	{"Semaphores", History::semsSeries},
+	{"Ports", History::portsSeries},
+	{"Threads", History::threadsSeries},
+	{"Teams", History::teamsSeries},
+	{"Deadlocks", History::seriesCount},
+	{"Kernel name", History::seriesCount},
+	{"Kernel build timestamp", History::seriesCount},
+};
+
+static void ListStats(BColumnListView *view, const Snapshot &snapshot)
 {
 	int32 rowId = 0;
 	BString str;
 
-	system_info info;
+	const SystemSample &info = snapshot.system;
+	if (info.cpuCount == 0)
+		return;
+
+	uint64 pageSize = info.pageSize;
+
+	time_t unixTime = info.bootTime/1000000;
+	struct tm *tm = localtime(&unixTime);
+	str.SetToFormat("%04d.%02d.%02d %02d:%02d:%02d.%06d", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec, (int)(info.bootTime%1000000));
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-	if (get_system_info(&info) >= B_OK) {
-		time_t unixTime = info.boot_time/1000000;
-		struct tm *tm = localtime(&unixTime);
-		str.SetToFormat("%04d.%02d.%02d %02d:%02d:%02d.%06d", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec, (int)(info.boot_time%1000000));
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	str.SetToFormat("%" B_PRIu32, info.cpuCount);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		str.SetToFormat("%" B_PRIu32, info.cpu_count);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	str.SetToFormat("%.1f%%", info.cpuUsage);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetUsedMaxSize(str, info.used_pages * B_PAGE_SIZE, info.max_pages * B_PAGE_SIZE);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetUsedMaxSize(str, info.usedPages * pageSize, info.maxPages * pageSize);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetSizeString(str, info.cached_pages * B_PAGE_SIZE);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetSizeString(str, info.cachedPages * pageSize);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetSizeString(str, info.block_cache_pages * B_PAGE_SIZE);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetSizeString(str, info.blockCachePages * pageSize);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetSizeString(str, info.ignored_pages * B_PAGE_SIZE);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetSizeString(str, info.ignoredPages * pageSize);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetSizeString(str, info.needed_memory);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetSizeString(str, info.neededMemory);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		uint64 totalMemory = info.max_pages * B_PAGE_SIZE;
-		GetUsedMaxSize(str, totalMemory - info.free_memory, totalMemory);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	uint64 totalMemory = info.maxPages * pageSize;
+	GetUsedMaxSize(str, totalMemory - info.freeMemory, totalMemory);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetUsedMaxSize(str, (info.max_swap_pages - info.free_swap_pages) * B_PAGE_SIZE, info.max_swap_pages * B_PAGE_SIZE);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetUsedMaxSize(str, (info.maxSwapPages - info.freeSwapPages) * pageSize, info.maxSwapPages * pageSize);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		str.SetToFormat("%" B_PRIu32, info.page_faults);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	str.SetToFormat("%" B_PRIu32, info.pageFaults);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetUsedMax(str, info.used_sems, info.max_sems);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetUsedMax(str, info.usedSems, info.maxSems);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetUsedMax(str, info.used_ports, info.max_ports);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetUsedMax(str, info.usedPorts, info.maxPorts);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetUsedMax(str, info.used_threads, info.max_threads);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetUsedMax(str, info.usedThreads, info.maxThreads);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		GetUsedMax(str, info.used_teams, info.max_teams);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	GetUsedMax(str, info.usedTeams, info.maxTeams);
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
 
-		view->RowAt(rowId++)->SetField(new BStringField(info.kernel_name), statValueCol);
+	str.SetToFormat("%" B_PRIu32, info.deadlockCount);
+	view->RowAt(rowId++)->SetField(new HighlightStringField(str, info.deadlockCount > 0), statValueCol);
 
-		str.SetToFormat("%s %s", info.kernel_build_date, info.kernel_build_time);
-		view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+	view->RowAt(rowId++)->SetField(new BStringField(info.kernelName.c_str()), statValueCol);
+
+	str.SetToFormat("%s %s", info.kernelBuildDate.c_str(), info.kernelBuildTime.c_str());
+	view->RowAt(rowId++)->SetField(new BStringField(str), statValueCol);
+
+	History &history = Sampler::Default().GetHistory();
+	std::vector<double> values;
+	for (size_t i = 0; i < sizeof(kStatRows)/sizeof(kStatRows[0]); i++) {
+		if (kStatRows[i].series == History::seriesCount)
+			continue;
+		BRow *row = view->RowAt(i);
+		history.Read(kStatRows[i].series, values, kSparklineLength);
+		if (static_cast<SparklineField*>(row->GetField(statHistoryCol))->SetValues(values))
+			view->UpdateRow(row);
 	}
 }
 
-static void NewInfoRow(BColumnListView *view, const char *name)
+static void NewInfoRow(BColumnListView *view, const char *name, History::Series series)
 {
 	BRow *row = new BRow();
 	row->SetField(new BStringField(name), statNameCol);
+	if (series != History::seriesCount)
+		row->SetField(new SparklineField(series == History::cpuSeries ? 100 : 0), statHistoryCol);
 	view->AddRow(row);
 }
 
@@ -436,26 +406,13 @@ static BColumnListView *NewStatsView()
 	BColumnListView *view;
 	view = new BColumnListView("Stats", B_NAVIGABLE);
 	view->AddColumn(new BStringColumn("Name", 150, 50, 500, B_TRUNCATE_END), statNameCol);
-	view->AddColumn(new BStringColumn("Value", 256, 50, 1024, B_TRUNCATE_END, B_ALIGN_RIGHT), statValueCol);
-
-	NewInfoRow(view, "Boot time");
-	NewInfoRow(view, "CPU count");
-	NewInfoRow(view, "Pages");
-	NewInfoRow(view, "Cached pages");
-	NewInfoRow(view, "Block cache pages");
-	NewInfoRow(view, "Ignored pages");
-	NewInfoRow(view, "Needed memory");
-	NewInfoRow(view, "Memory");
-	NewInfoRow(view, "Swap pages");
-	NewInfoRow(view, "Page faults");
-	NewInfoRow(view, "Semaphores");
-	NewInfoRow(view, "Ports");
-	NewInfoRow(view, "Threads");
-	NewInfoRow(view, "Teams");
-	NewInfoRow(view, "Kernel name");
-	NewInfoRow(view, "Kernel build timestamp");
-
-	ListStats(view);
+	view->AddColumn(new HighlightStringColumn("Value", 256, 50, 1024, B_TRUNCATE_END, B_ALIGN_RIGHT), statValueCol);
+	view->AddColumn(new SparklineColumn("History", 256, 50, 1024), statHistoryCol);
+
+	for (size_t i = 0; i < sizeof(kStatRows)/sizeof(kStatRows[0]); i++)
+		NewInfoRow(view, kStatRows[i].name, kStatRows[i].series);
+
+	ListStats(view, *Sampler::Default().Latest());
 	return view;
 }
 
@@ -467,22 +424,51 @@ static BMessage *NewSetLayoutMsg(int32 layout)
 	return msg;
 }
 
+static BMessage *NewExportHistoryMsg(const char *format)
+{
+	BMessage *msg = new BMessage(exportHistoryMsg);
+	msg->SetString("format", format);
+	return msg;
+}
+
+static void ExportHistory(const char *path, const char *format)
+{
+	FILE *file = fopen(path, "w");
+	if (file == NULL)
+		CheckErrno(-1, "Can't create file.");
+	History &history = Sampler::Default().GetHistory();
+	bool ok = strcmp(format, "json") == 0 ? history.WriteJson(file) : history.WriteCsv(file);
+	if (fclose(file) != 0) ok = false;
+	if (!ok)
+		Check(B_IO_ERROR, "Can't write history.");
+}
+
+static BMessage *NewSetIntervalMsg(bigtime_t interval)
+{
+	BMessage *msg = new BMessage(setIntervalMsg);
+	msg->SetInt64("val", interval);
+	return msg;
+}
+
 class TestWindow: public BWindow
 {
 private:
 	BTabView *fTabView;
 	BColumnListView *fTeamsView;
 	BColumnListView *fStatsView;
+	BColumnListView *fMemoryView;
+	RowIndex fTeamRows;
+	RowIndex fMemoryRows;
 	ViewLayout fLayout;
-	BMessageRunner fListUpdater;
+	ObjectDeleter<BFilePanel> fExportPanel;
 
 public:
 	TestWindow(BRect frame): BWindow(frame, "SystemManager", B_DOCUMENT_WINDOW, B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS),
-		fLayout(treeLayout),
-		fListUpdater(BMessenger(this), BMessage(updateMsg), 500000)
+		fLayout(treeLayout)
 	{
 		BMenuBar *menuBar;
 		BMenu *signalMenu;
+		BMenu *intervalMenu;
 		BTab *tab;
 
 		menuBar = new BMenuBar("menu", B_ITEMS_IN_ROW, true);
@@ -499,12 +485,23 @@ public:
 				.AddItem(new BMenuItem("Quit", new BMessage(B_QUIT_REQUESTED), 'Q'))
 			.End()
 */
+			.AddMenu(new BMenu("File"))
+				.AddItem(new BMenuItem("Export history as CSV" B_UTF8_ELLIPSIS, NewExportHistoryMsg("csv")))
+				.AddItem(new BMenuItem("Export history as JSON" B_UTF8_ELLIPSIS, NewExportHistoryMsg("json")))
+			.End()
 			.AddMenu(new BMenu("View"))
 				.AddMenu(new BMenu("Layout"))
 					.AddItem(new BMenuItem("Flat", NewSetLayoutMsg(flatLayout)))
 					.AddItem(new BMenuItem("Tree", NewSetLayoutMsg(treeLayout)))
 					.AddItem(new BMenuItem("Sessions and groups", NewSetLayoutMsg(sessionsLayout)))
 				.End()
+				.AddMenu(intervalMenu = new BMenu("Update interval"))
+					.AddItem(new BMenuItem("0.25 s", NewSetIntervalMsg(250000)))
+					.AddItem(new BMenuItem("0.5 s", NewSetIntervalMsg(500000)))
+					.AddItem(new BMenuItem("1 s", NewSetIntervalMsg(1000000)))
+					.AddItem(new BMenuItem("2 s", NewSetIntervalMsg(2000000)))
+					.AddItem(new BMenuItem("5 s", NewSetIntervalMsg(5000000)))
+				.End()
 			.End()
 			.AddMenu(new BMenu("Action"))
 /*
@@ -517,6 +514,7 @@ public:
 				.AddMenu(signalMenu = new BMenu("Send signal"))
 				.End()
 				.AddItem(new BMenuItem("Debug" B_UTF8_ELLIPSIS, new BMessage(debugMsg)))
+				.AddItem(new BMenuItem("Profile" B_UTF8_ELLIPSIS, new BMessage(profileMsg)))
 				.AddSeparator()
 				.AddItem(new BMenuItem("Show location", new BMessage(showLocationMsg)))
 			.End()
@@ -528,16 +526,27 @@ public:
 			signalMenu->AddItem(new BMenuItem(signals[i].name, msg));
 		}
 
+		intervalMenu->SetRadioMode(true);
+		for (int32 i = 0; i < intervalMenu->CountItems(); i++) {
+			BMenuItem *item = intervalMenu->ItemAt(i);
+			if (item->Message()->GetInt64("val", 0) == Sampler::Default().Interval())
+				item->SetMarked(true);
+		}
+
 		fTabView = new BTabView("tab_view", B_WIDTH_FROM_LABEL);
 		fTabView->SetBorder(B_NO_BORDER);
 
 		//tab = new BTab(); fTabView->AddTab(NewTeamsView("Apps"), tab);
 		tab = new BTab(); fTabView->AddTab(fTeamsView = NewTeamsView(), tab);
+		fTeamRows.SetView(fTeamsView);
+		IconCache::Default().SetTarget(BMessenger(this));
 		//tab = new BTab(); fTabView->AddTab(new TestView(BRect(0, 0, -1, -1), "Services", B_FOLLOW_NONE), tab);
 		//tab = new BTab(); fTabView->AddTab(new TestView(BRect(0, 0, -1, -1), "Sockets", B_FOLLOW_NONE), tab);
 		tab = new BTab(); fTabView->AddTab(fStatsView = NewStatsView(), tab);
+		tab = new BTab(); fTabView->AddTab(fMemoryView = NewMemoryGroupsView(fMemoryRows, true), tab);
 
-		ListTeams(fTeamsView, fLayout);
+		ListTeams(fTeamRows, fLayout, *Sampler::Default().Latest());
+		Sampler::Default().SetTarget(BMessenger(this));
 
 		BLayoutBuilder::Group<>(this, B_VERTICAL, 0)
 			.Add(menuBar)
@@ -567,21 +576,69 @@ public:
 				OpenTeamWindow(team, center);
 				return;
 			}
-			case updateMsg: {
+			case samplerUpdatedMsg: {
+				std::shared_ptr<const Snapshot> snapshot = Sampler::Default().Latest();
 				BTab *tab = fTabView->TabAt(fTabView->Selection());
 				if (tab == NULL) return;
 				BView *view = tab->View();
 				if (view == fTeamsView)
-					ListTeams(fTeamsView, fLayout);
+					ListTeams(fTeamRows, fLayout, *snapshot);
 				else if (view == fStatsView)
-					ListStats(fStatsView);
+					ListStats(fStatsView, *snapshot);
+				else if (view == fMemoryView)
+					ListMemoryGroups(fMemoryRows, snapshot->systemMemoryGroups.data(), snapshot->systemMemoryGroups.size());
+				return;
+			}
+			case iconCacheLoadedMsg: {
+				const char *path;
+				CheckRetVoid(msg->FindString("path", &path));
+				BList list;
+				CollectRowList(list, fTeamsView);
+				for (int32 i = 0; i < list.CountItems(); i++) {
+					BRow *row = (BRow*)list.ItemAt(i);
+					if (strcmp(((BStringField*)row->GetField(pathCol))->String(), path) != 0)
+						continue;
+					((IconStringField*)row->GetField(nameCol))->SetIcon(IconCache::Default().Get(path).Get());
+					fTeamsView->UpdateRow(row);
+				}
 				return;
 			}
 			case setLayoutMsg: {
 				int32 layout;
 				CheckRetVoid(msg->FindInt32("val", &layout));
 				fLayout = (ViewLayout)layout;
-				RelayoutTeams(fTeamsView, fLayout);
+				RelayoutTeams(fTeamRows, fLayout);
+				return;
+			}
+			case exportHistoryMsg: {
+				const char *format;
+				CheckRetVoid(msg->FindString("format", &format));
+				if (!fExportPanel.IsSet())
+					fExportPanel.SetTo(new BFilePanel(B_SAVE_PANEL, new BMessenger(this)));
+				BMessage saveMsg(exportHistorySaveMsg);
+				saveMsg.SetString("format", format);
+				fExportPanel->SetMessage(&saveMsg);
+				BString name;
+				name.SetToFormat("history.%s", format);
+				fExportPanel->SetSaveText(name);
+				fExportPanel->Show();
+				return;
+			}
+			case exportHistorySaveMsg: {
+				entry_ref dirRef;
+				const char *name, *format;
+				CheckRetVoid(msg->FindRef("directory", &dirRef));
+				CheckRetVoid(msg->FindString("name", &name));
+				CheckRetVoid(msg->FindString("format", &format));
+				BPath path(&dirRef);
+				Check(path.Append(name));
+				ExportHistory(path.Path(), format);
+				return;
+			}
+			case setIntervalMsg: {
+				bigtime_t interval;
+				CheckRetVoid(msg->FindInt64("val", &interval));
+				Sampler::Default().SetInterval(interval);
 				return;
 			}
 			case terminateMsg: {
@@ -648,6 +705,13 @@ public:
 				resume_thread(thread);
 				return;
 			}
+			case profileMsg: {
+				team_id team = SelectedTeam();
+				if (team < B_OK) return;
+				BPoint center((Frame().left + Frame().right)/2, (Frame().top + Frame().bottom)/2);
+				OpenProfileWindow(team, center);
+				return;
+			}
 			case showLocationMsg: {
 				BRow *row = fTeamsView->CurrentSelection(NULL);
 				if (row == NULL) return;
@@ -806,8 +870,48 @@ public:
 };
 
 
-int main()
+static void Usage()
 {
+	fprintf(stderr, "usage: SystemManager [--stream [--format json|csv] [--fields <list>] [--interval <ms>] [--delta] [--count <n>] [--team <id>]]\n");
+	fprintf(stderr, "fields: system, teams, threads, memory, images, areas, ports, sems, files or all\n");
+	exit(1);
+}
+
+
+int main(int argc, char **argv)
+{
+	if (argc > 1) {
+		if (strcmp(argv[1], "--stream") != 0)
+			Usage();
+		StreamOptions options;
+		for (int i = 2; i < argc; i++) {
+			if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+				i++;
+				if (strcmp(argv[i], "json") == 0)
+					options.format = SampleWriter::jsonFormat;
+				else if (strcmp(argv[i], "csv") == 0)
+					options.format = SampleWriter::csvFormat;
+				else
+					Usage();
+			} else if (strcmp(argv[i], "--fields") == 0 && i + 1 < argc) {
+				if (!ParseStreamFields(argv[++i], options.fields))
+					Usage();
+			} else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+				options.interval = strtoll(argv[++i], NULL, 10)*1000;
+				if (options.interval <= 0)
+					Usage();
+			} else if (strcmp(argv[i], "--delta") == 0)
+				options.delta = true;
+			else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+				options.count = strtoll(argv[++i], NULL, 10);
+			else if (strcmp(argv[i], "--team") == 0 && i + 1 < argc)
+				options.team = strtol(argv[++i], NULL, 10);
+			else
+				Usage();
+		}
+		return RunStream(options);
+	}
+
 	(new TestApplication())->Run();
 	return 0;
 }
@@ -33,6 +33,10 @@
 #include "Errors.h"
 #include "Utils.h"
 #include "UIUtils.h"
+#include "RowIndex.h"
+#include "Sampler.h"
+#include "Collector.h"
+#include "MemoryList.h"
 
 
 enum {
@@ -54,6 +58,8 @@ enum {
 	threadKernelTimeCol,
 	threadStackBaseCol,
 	threadStackEndCol,
+	threadCpuCol,
+	threadWaitCol,
 };
 
 enum {
@@ -110,21 +116,18 @@ enum {
 };
 
 
-static BRow *FindIntRow(BColumnListView *view, int32 col, BRow *parent, int32 val)
+//#pragma mark Lists
+
+// Objects are collected by sampler thread only for selected tab, NULL is
+// returned until lists in field arrive.
+static std::shared_ptr<const TeamObjects> LatestObjects(TeamWindow *wnd, uint32 field)
 {
-	BRow *row;
-	BString name;
-	for (int32 i = 0; i < view->CountRows(parent); i++) {
-		row = view->RowAt(i, parent);
-		if (((BIntegerField*)row->GetField(col))->Value() == val)
-			return row;
-	}
-	return NULL;
+	std::shared_ptr<const TeamObjects> objects = Sampler::Default().LatestObjects(wnd->fId);
+	if (objects == NULL || (objects->fields & field) == 0)
+		return NULL;
+	return objects;
 }
 
-
-//#pragma mark Lists
-
 static void ListInfo(TeamWindow *wnd, BColumnListView *view)
 {
 	int32 rowId = 0;
@@ -203,25 +206,22 @@ static BColumnListView *NewInfoView(TeamWindow *wnd)
 }
 
 
-static void ListImages(TeamWindow *wnd, BColumnListView *view)
+static bool ListImages(TeamWindow *wnd, RowIndex &rows)
 {
-	int32 cookie = 0;
-	image_info info;
+	BColumnListView *view = rows.View();
 	BString str;
 	BRow *row;
-	BList prevRows;
 
-	view->ScrollView()->Invalidate();
+	std::shared_ptr<const TeamObjects> objects = LatestObjects(wnd, collectImages);
+	if (objects == NULL)
+		return false;
+	rows.BeginUpdate();
 
-	for (int32 i = 0; i < view->CountRows(); i++) {
-		row = view->RowAt(i);
-		prevRows.AddItem((void*)(addr_t)(((BIntegerField*)row->GetField(imageIdCol))->Value()));
-	}
-
-	while (get_next_image_info(wnd->fId, &cookie, &info) >= B_OK) {
-		prevRows.RemoveItem((void*)(addr_t)info.id);
-		row = FindIntRow(view, imageIdCol, NULL, info.id);
-		if (row == NULL) {
+	for (const image_info &info: objects->images) {
+		row = rows.Touch(info.id);
+		bool isNew = row == NULL;
+		bool changed = false;
+		if (isNew) {
 			row = new BRow();
 			row->SetField(new BIntegerField(0), imageIdCol);
 			row->SetField(new BStringField(""), imageTypeCol);
@@ -229,34 +229,31 @@ static void ListImages(TeamWindow *wnd, BColumnListView *view)
 			row->SetField(new Int64Field(0), imageDataCol);
 			row->SetField(new BStringField(""), imageNameCol);
 			row->SetField(new BStringField(""), imagePathCol);
-			view->AddRow(row);
+			static_cast<BIntegerField*>(row->GetField(imageIdCol))->SetValue(info.id);
 		}
 
-		BString imageType;
-		switch (info.type) {
-			case B_APP_IMAGE: imageType.SetTo("app"); break;
-			case B_LIBRARY_IMAGE: imageType.SetTo("lib"); break;
-			case B_ADD_ON_IMAGE: imageType.SetTo("addon"); break;
-			case B_SYSTEM_IMAGE: imageType.SetTo("sys"); break;
-			default: imageType.SetToFormat("?(%d)", info.type);
-		}
-
-		static_cast<BIntegerField*>(row->GetField(imageIdCol))->SetValue(info.id);
-		static_cast<BStringField*>(row->GetField(imageTypeCol))->SetString(imageType);
-		static_cast<Int64Field*>(row->GetField(imageTextCol))->SetValue((uintptr_t)info.text);
-		static_cast<Int64Field*>(row->GetField(imageDataCol))->SetValue((uintptr_t)info.data);
-		static_cast<BStringField*>(row->GetField(imageNameCol))->SetString(GetFileName(info.name));
-		static_cast<BStringField*>(row->GetField(imagePathCol))->SetString(info.name);
+		const char *imageType = ImageTypeName(info.type);
+		if (imageType != NULL)
+			str = imageType;
+		else
+			str.SetToFormat("?(%d)", info.type);
+		changed |= SetStringField(row, imageTypeCol, str);
+		changed |= SetInt64Field(row, imageTextCol, (uintptr_t)info.text);
+		changed |= SetInt64Field(row, imageDataCol, (uintptr_t)info.data);
+		changed |= SetStringField(row, imageNameCol, GetFileName(info.name));
+		changed |= SetStringField(row, imagePathCol, info.name);
+
+		if (isNew)
+			rows.Add(info.id, row);
+		else if (changed)
+			view->UpdateRow(row);
 	}
 
-	for (int32 i = 0; i < prevRows.CountItems(); i++) {
-		row = FindIntRow(view, imageIdCol, NULL, (int32)(addr_t)prevRows.ItemAt(i));
-		view->RemoveRow(row);
-		delete row;
-	}
+	rows.EndUpdate();
+	return true;
 }
 
-static BColumnListView *NewImagesView(TeamWindow *wnd)
+static BColumnListView *NewImagesView(TeamWindow *wnd, RowIndex &rows)
 {
 	BColumnListView *view;
 	view = new BColumnListView("Images", B_NAVIGABLE);
@@ -266,29 +263,30 @@ static BColumnListView *NewImagesView(TeamWindow *wnd)
 	view->AddColumn(new HexIntegerColumn("Data", 128, 50, 500, B_ALIGN_RIGHT), imageDataCol);
 	view->AddColumn(new BStringColumn("Name", 150, 50, 500, B_TRUNCATE_END), imageNameCol);
 	view->AddColumn(new BStringColumn("Path", 500, 50, 1000, B_TRUNCATE_MIDDLE), imagePathCol);
-	ListImages(wnd, view);
+	rows.SetView(view);
+	ListImages(wnd, rows);
 	return view;
 }
 
-static void ListThreads(TeamWindow *wnd, BColumnListView *view)
+static void ListThreads(TeamWindow *wnd, RowIndex &rows)
 {
-	int32 cookie = 0;
-	thread_info info;
+	BColumnListView *view = rows.View();
 	BString str;
 	BRow *row;
-	BList prevRows;
 
-	view->ScrollView()->Invalidate();
+	std::shared_ptr<const Snapshot> snapshot = Sampler::Default().Latest();
+	const TeamSample *team = snapshot->FindTeam(wnd->fId);
+	if (team == NULL)
+		return;
 
-	for (int32 i = 0; i < view->CountRows(); i++) {
-		row = view->RowAt(i);
-		prevRows.AddItem((void*)(addr_t)(((BIntegerField*)row->GetField(threadIdCol))->Value()));
-	}
+	rows.BeginUpdate();
 
-	while (get_next_thread_info(wnd->fId, &cookie, &info) >= B_OK) {
-		prevRows.RemoveItem((void*)(addr_t)info.thread);
-		row = FindIntRow(view, threadIdCol, NULL, info.thread);
-		if (row == NULL) {
+	for (size_t i = team->firstThread; i < team->firstThread + team->threadCount; i++) {
+		const ThreadSample &info = snapshot->threads[i];
+		row = rows.Touch(info.id);
+		bool isNew = row == NULL;
+		bool changed = false;
+		if (isNew) {
 			row = new BRow();
 			row->SetField(new BIntegerField(0), threadIdCol);
 			row->SetField(new BStringField(0), threadNameCol);
@@ -299,42 +297,55 @@ static void ListThreads(TeamWindow *wnd, BColumnListView *view)
 			row->SetField(new BIntegerField(0), threadKernelTimeCol);
 			row->SetField(new Int64Field(0), threadStackBaseCol);
 			row->SetField(new Int64Field(0), threadStackEndCol);
-			view->AddRow(row);
+			row->SetField(new FloatField(0), threadCpuCol);
+			row->SetField(new HighlightStringField(), threadWaitCol);
+			static_cast<BIntegerField*>(row->GetField(threadIdCol))->SetValue(info.id);
 		}
 
-		static_cast<BIntegerField*>(row->GetField(threadIdCol))->SetValue(info.thread);
-		static_cast<BStringField*>(row->GetField(threadNameCol))->SetString(info.name);
-
-		switch (info.state) {
-		case B_THREAD_RUNNING: str = "running"; break;
-		case B_THREAD_READY: str = "ready"; break;
-		case B_THREAD_RECEIVING: str = "receiving"; break;
-		case B_THREAD_ASLEEP: str = "asleep"; break;
-		case B_THREAD_SUSPENDED: str = "suspended"; break;
-		case B_THREAD_WAITING: str = "waiting"; break;
-		default:
-			str.SetToFormat("? (%d)", info.state);
-		}
-		static_cast<BStringField*>(row->GetField(threadStateCol))->SetString(str);
+		changed |= SetStringField(row, threadNameCol, info.name.c_str());
+
+		const char *state = ThreadStateName(info.state);
+		if (state != NULL)
+			str = state;
+		else
+			str.SetToFormat("? (%" B_PRId32 ")", info.state);
+		changed |= SetStringField(row, threadStateCol, str);
 
-		static_cast<BIntegerField*>(row->GetField(threadPriorityCol))->SetValue(info.priority);
+		changed |= SetIntField(row, threadPriorityCol, info.priority);
 		GetSemString(str, info.sem);
 
-		static_cast<BStringField*>(row->GetField(threadSemCol))->SetString(str);
-		static_cast<BIntegerField*>(row->GetField(threadUserTimeCol))->SetValue(info.user_time);
-		static_cast<BIntegerField*>(row->GetField(threadKernelTimeCol))->SetValue(info.kernel_time);
-		static_cast<Int64Field*>(row->GetField(threadStackBaseCol))->SetValue((addr_t)info.stack_base);
-		static_cast<Int64Field*>(row->GetField(threadStackEndCol))->SetValue((addr_t)info.stack_end);
-	}
+		changed |= SetStringField(row, threadSemCol, str);
+		changed |= SetIntField(row, threadUserTimeCol, info.userTime);
+		changed |= SetIntField(row, threadKernelTimeCol, info.kernelTime);
+		changed |= SetInt64Field(row, threadStackBaseCol, info.stackBase);
+		changed |= SetInt64Field(row, threadStackEndCol, info.stackEnd);
+		changed |= SetFloatField(row, threadCpuCol, info.cpuUsage);
+
+		// Convoyed thread is not in cycle itself, its holder can be.
+		switch (info.waitState) {
+		case WaitGraph::waitState: str.SetToFormat("thread %" B_PRId32, info.semHolder); break;
+		case WaitGraph::convoyState: {
+			const ThreadSample *holder = snapshot->FindThread(info.semHolder);
+			bool holderDeadlocked = holder != NULL && holder->waitState == WaitGraph::deadlockState;
+			str.SetToFormat("thread %" B_PRId32 " (%s)", info.semHolder, holderDeadlocked ? "deadlocked" : "convoyed");
+			break;
+		}
+		case WaitGraph::deadlockState: str.SetToFormat("thread %" B_PRId32 " (deadlock)", info.semHolder); break;
+		default: str = "";
+		}
+		changed |= SetStringField(row, threadWaitCol, str);
+		changed |= SetHighlightField(row, threadWaitCol, info.waitState == WaitGraph::convoyState || info.waitState == WaitGraph::deadlockState);
 
-	for (int32 i = 0; i < prevRows.CountItems(); i++) {
-		row = FindIntRow(view, threadIdCol, NULL, (int32)(addr_t)prevRows.ItemAt(i));
-		view->RemoveRow(row);
-		delete row;
+		if (isNew)
+			rows.Add(info.id, row);
+		else if (changed)
+			view->UpdateRow(row);
 	}
+
+	rows.EndUpdate();
 }
 
-static BColumnListView *NewThreadsView(TeamWindow *wnd)
+static BColumnListView *NewThreadsView(TeamWindow *wnd, RowIndex &rows)
 {
 	BColumnListView *view;
 	view = new BColumnListView("Threads", B_NAVIGABLE);
@@ -347,30 +358,33 @@ static BColumnListView *NewThreadsView(TeamWindow *wnd)
 	view->AddColumn(new BIntegerColumn("Kernel time", 96, 32, 128, B_ALIGN_RIGHT), threadKernelTimeCol);
 	view->AddColumn(new HexIntegerColumn("Stack base", 128, 50, 500, B_ALIGN_RIGHT), threadStackBaseCol);
 	view->AddColumn(new HexIntegerColumn("Stack end", 128, 50, 500, B_ALIGN_RIGHT), threadStackEndCol);
+	view->AddColumn(new PercentColumn("CPU", 64, 32, 128), threadCpuCol);
+	view->AddColumn(new HighlightStringColumn("Waits for", 150, 32, 512, B_TRUNCATE_END), threadWaitCol);
+	view->MoveColumn(view->ColumnAt(threadCpuCol), threadStateCol + 1);
+	view->MoveColumn(view->ColumnAt(threadWaitCol), threadSemCol + 2);
 	view->SetInvocationMessage(new BMessage(threadsInvokeMsg));
-	ListThreads(wnd, view);
+	rows.SetView(view);
+	ListThreads(wnd, rows);
 	return view;
 }
 
-static void ListAreas(TeamWindow *wnd, BColumnListView *view)
+static bool ListAreas(TeamWindow *wnd, RowIndex &rows)
 {
-	ssize_t cookie = 0;
-	area_info info;
-	BString str, str2;
+	BColumnListView *view = rows.View();
+	BString str;
+	char protection[16];
 	BRow *row;
-	BList prevRows;
 
-	view->ScrollView()->Invalidate();
+	std::shared_ptr<const TeamObjects> objects = LatestObjects(wnd, collectAreas);
+	if (objects == NULL)
+		return false;
+	rows.BeginUpdate();
 
-	for (int32 i = 0; i < view->CountRows(); i++) {
-		row = view->RowAt(i);
-		prevRows.AddItem((void*)(addr_t)(((BIntegerField*)row->GetField(areaIdCol))->Value()));
-	}
-
-	while (get_next_area_info(wnd->fId, &cookie, &info) >= B_OK) {
-		prevRows.RemoveItem((void*)(addr_t)info.area);
-		row = FindIntRow(view, areaIdCol, NULL, info.area);
-		if (row == NULL) {
+	for (const area_info &info: objects->areas) {
+		row = rows.Touch(info.area);
+		bool isNew = row == NULL;
+		bool changed = false;
+		if (isNew) {
 			row = new BRow();
 			row->SetField(new BIntegerField(0), areaIdCol);
 			row->SetField(new BStringField(""), areaNameCol);
@@ -379,50 +393,35 @@ static void ListAreas(TeamWindow *wnd, BColumnListView *view)
 			row->SetField(new Int64Field(0), areaAllocCol);
 			row->SetField(new BStringField(""), areaProtCol);
 			row->SetField(new BStringField(""), areaLockCol);
-			view->AddRow(row);
+			static_cast<BIntegerField*>(row->GetField(areaIdCol))->SetValue(info.area);
 		}
 
-		static_cast<BIntegerField*>(row->GetField(areaIdCol))->SetValue(info.area);
-		static_cast<BStringField*>(row->GetField(areaNameCol))->SetString(info.name);
-		static_cast<Int64Field*>(row->GetField(areaAdrCol))->SetValue((addr_t)info.address);
-		static_cast<Int64Field*>(row->GetField(areaSizeCol))->SetValue(info.size);
-		static_cast<Int64Field*>(row->GetField(areaAllocCol))->SetValue(info.ram_size);
-
-		str = "";
-		if (B_READ_AREA & info.protection) str += "R";
-		if (B_WRITE_AREA & info.protection) str += "W";
-		if (B_EXECUTE_AREA & info.protection) str += "X";
-		if (B_STACK_AREA & info.protection) str += "S";
-		if (B_KERNEL_READ_AREA & info.protection) str += "r";
-		if (B_KERNEL_WRITE_AREA & info.protection) str += "w";
-		if (B_KERNEL_EXECUTE_AREA & info.protection) str += "x";
-		if (B_KERNEL_STACK_AREA & info.protection) str += "s";
-		if (B_CLONEABLE_AREA & info.protection) str += "C";
-		static_cast<BStringField*>(row->GetField(areaProtCol))->SetString(str);
-
-		switch (info.lock) {
-		case B_NO_LOCK: str = "no"; break;
-		case B_LAZY_LOCK: str = "lazy"; break;
-		case B_FULL_LOCK: str = "full"; break;
-		case B_CONTIGUOUS: str = "contiguous"; break;
-		case B_LOMEM: str = "lomem"; break;
-		case B_32_BIT_FULL_LOCK: str = "32 bit full"; break;
-		case B_32_BIT_CONTIGUOUS: str = "32 bit contiguous"; break;
-		case 7: str = "already wired"; break;
-		default:
+		changed |= SetStringField(row, areaNameCol, info.name);
+		changed |= SetInt64Field(row, areaAdrCol, (addr_t)info.address);
+		changed |= SetInt64Field(row, areaSizeCol, info.size);
+		changed |= SetInt64Field(row, areaAllocCol, info.ram_size);
+
+		GetAreaProtectionString(protection, info.protection);
+		changed |= SetStringField(row, areaProtCol, protection);
+
+		const char *lock = AreaLockName(info.lock);
+		if (lock != NULL)
+			str = lock;
+		else
 			str.SetToFormat("? (%" B_PRIu32 ")", info.lock);
-		}
-		static_cast<BStringField*>(row->GetField(areaLockCol))->SetString(str);
-	}
+		changed |= SetStringField(row, areaLockCol, str);
 
-	for (int32 i = 0; i < prevRows.CountItems(); i++) {
-		row = FindIntRow(view, areaIdCol, NULL, (int32)(addr_t)prevRows.ItemAt(i));
-		view->RemoveRow(row);
-		delete row;
+		if (isNew)
+			rows.Add(info.area, row);
+		else if (changed)
+			view->UpdateRow(row);
 	}
+
+	rows.EndUpdate();
+	return true;
 }
 
-static BColumnListView *NewAreasView(TeamWindow *wnd)
+static BColumnListView *NewAreasView(TeamWindow *wnd, RowIndex &rows)
 {
 	BColumnListView *view;
 	view = new BColumnListView("Areas", B_NAVIGABLE);
@@ -433,53 +432,60 @@ static BColumnListView *NewAreasView(TeamWindow *wnd)
 	view->AddColumn(new HexIntegerColumn("Alloc", 128, 50, 500, B_ALIGN_RIGHT), areaAllocCol);
 	view->AddColumn(new BStringColumn("Prot", 64, 50, 500, B_TRUNCATE_END, B_ALIGN_RIGHT), areaProtCol);
 	view->AddColumn(new BStringColumn("lock", 64, 50, 500, B_TRUNCATE_END, B_ALIGN_RIGHT), areaLockCol);
-	ListAreas(wnd, view);
+	rows.SetView(view);
+	ListAreas(wnd, rows);
 	return view;
 }
 
-static void ListPorts(TeamWindow *wnd, BColumnListView *view)
+static void ListMemory(TeamWindow *wnd, RowIndex &rows)
 {
-	int32 cookie = 0;
-	port_info info;
-	BString str, str2;
+	std::shared_ptr<const Snapshot> snapshot = Sampler::Default().Latest();
+	const TeamSample *team = snapshot->FindTeam(wnd->fId);
+	if (team == NULL)
+		return;
+	ListMemoryGroups(rows, snapshot->memoryGroups.data() + team->firstMemoryGroup, team->memoryGroupCount);
+}
+
+static bool ListPorts(TeamWindow *wnd, RowIndex &rows)
+{
+	BColumnListView *view = rows.View();
 	BRow *row;
-	BList prevRows;
 
-	view->ScrollView()->Invalidate();
+	std::shared_ptr<const TeamObjects> objects = LatestObjects(wnd, collectPorts);
+	if (objects == NULL)
+		return false;
+	rows.BeginUpdate();
 
-	for (int32 i = 0; i < view->CountRows(); i++) {
-		row = view->RowAt(i);
-		prevRows.AddItem((void*)(addr_t)(((BIntegerField*)row->GetField(portIdCol))->Value()));
-	}
-
-	while (get_next_port_info(wnd->fId, &cookie, &info) >= B_OK) {
-		prevRows.RemoveItem((void*)(addr_t)info.port);
-		row = FindIntRow(view, portIdCol, NULL, info.port);
-		if (row == NULL) {
+	for (const port_info &info: objects->ports) {
+		row = rows.Touch(info.port);
+		bool isNew = row == NULL;
+		bool changed = false;
+		if (isNew) {
 			row = new BRow();
 			row->SetField(new BIntegerField(0), portIdCol);
 			row->SetField(new BStringField(""), portNameCol);
 			row->SetField(new BIntegerField(0), portCapacityCol);
 			row->SetField(new BIntegerField(0), portQueuedCol);
 			row->SetField(new BIntegerField(0), portTotalCol);
-			view->AddRow(row);
+			static_cast<BIntegerField*>(row->GetField(portIdCol))->SetValue(info.port);
 		}
 
-		static_cast<BIntegerField*>(row->GetField(portIdCol))->SetValue(info.port);
-		static_cast<BStringField*>(row->GetField(portNameCol))->SetString(info.name);
-		static_cast<BIntegerField*>(row->GetField(portNameCol))->SetValue(info.capacity);
-		static_cast<BIntegerField*>(row->GetField(portCapacityCol))->SetValue(info.queue_count);
-		static_cast<BIntegerField*>(row->GetField(portTotalCol))->SetValue(info.total_count);
-	}
+		changed |= SetStringField(row, portNameCol, info.name);
+		changed |= SetIntField(row, portCapacityCol, info.capacity);
+		changed |= SetIntField(row, portQueuedCol, info.queue_count);
+		changed |= SetIntField(row, portTotalCol, info.total_count);
 
-	for (int32 i = 0; i < prevRows.CountItems(); i++) {
-		row = FindIntRow(view, portIdCol, NULL, (int32)(addr_t)prevRows.ItemAt(i));
-		view->RemoveRow(row);
-		delete row;
+		if (isNew)
+			rows.Add(info.port, row);
+		else if (changed)
+			view->UpdateRow(row);
 	}
+
+	rows.EndUpdate();
+	return true;
 }
 
-static BColumnListView *NewPortsView(TeamWindow *wnd)
+static BColumnListView *NewPortsView(TeamWindow *wnd, RowIndex &rows)
 {
 	BColumnListView *view;
 	view = new BColumnListView("Ports", B_NAVIGABLE);
@@ -488,52 +494,51 @@ static BColumnListView *NewPortsView(TeamWindow *wnd)
 	view->AddColumn(new BIntegerColumn("Capacity", 64, 32, 128, B_ALIGN_RIGHT), portCapacityCol);
 	view->AddColumn(new BIntegerColumn("Queued", 64, 32, 128, B_ALIGN_RIGHT), portQueuedCol);
 	view->AddColumn(new BIntegerColumn("Total", 96, 32, 256, B_ALIGN_RIGHT), portTotalCol);
-	ListPorts(wnd, view);
+	rows.SetView(view);
+	ListPorts(wnd, rows);
 	return view;
 }
 
-static void ListSems(TeamWindow *wnd, BColumnListView *view)
+static bool ListSems(TeamWindow *wnd, RowIndex &rows)
 {
-	int32 cookie = 0;
-	sem_info info;
+	BColumnListView *view = rows.View();
 	BRow *row;
-	BList prevRows;
 	BString str;
 
-	view->ScrollView()->Invalidate();
-
-	for (int32 i = 0; i < view->CountRows(); i++) {
-		row = view->RowAt(i);
-		prevRows.AddItem((void*)(addr_t)(((BIntegerField*)row->GetField(semIdCol))->Value()));
-	}
+	std::shared_ptr<const TeamObjects> objects = LatestObjects(wnd, collectSems);
+	if (objects == NULL)
+		return false;
+	rows.BeginUpdate();
 
-	while (get_next_sem_info(wnd->fId, &cookie, &info) >= B_OK) {
-		prevRows.RemoveItem((void*)(addr_t)info.sem);
-		row = FindIntRow(view, semIdCol, NULL, info.sem);
-		if (row == NULL) {
+	for (const sem_info &info: objects->sems) {
+		row = rows.Touch(info.sem);
+		bool isNew = row == NULL;
+		bool changed = false;
+		if (isNew) {
 			row = new BRow();
 			row->SetField(new BIntegerField(0), semIdCol);
 			row->SetField(new BStringField(""), semNameCol);
 			row->SetField(new BIntegerField(0), semCountCol);
 			row->SetField(new BStringField(""), semLatestHolderCol);
-			view->AddRow(row);
+			static_cast<BIntegerField*>(row->GetField(semIdCol))->SetValue(info.sem);
 		}
 
-		static_cast<BIntegerField*>(row->GetField(semIdCol))->SetValue(info.sem);
-		static_cast<BStringField*>(row->GetField(semNameCol))->SetString(info.name);
-		static_cast<BIntegerField*>(row->GetField(semCountCol))->SetValue(info.count);
+		changed |= SetStringField(row, semNameCol, info.name);
+		changed |= SetIntField(row, semCountCol, info.count);
 		GetThreadString(str, info.latest_holder);
-		static_cast<BStringField*>(row->GetField(semLatestHolderCol))->SetString(str);
-	}
+		changed |= SetStringField(row, semLatestHolderCol, str);
 
-	for (int32 i = 0; i < prevRows.CountItems(); i++) {
-		row = FindIntRow(view, semIdCol, NULL, (int32)(addr_t)prevRows.ItemAt(i));
-		view->RemoveRow(row);
-		delete row;
+		if (isNew)
+			rows.Add(info.sem, row);
+		else if (changed)
+			view->UpdateRow(row);
 	}
+
+	rows.EndUpdate();
+	return true;
 }
 
-static BColumnListView *NewSemsView(TeamWindow *wnd)
+static BColumnListView *NewSemsView(TeamWindow *wnd, RowIndex &rows)
 {
 	BColumnListView *view;
 	view = new BColumnListView("Semaphores", B_NAVIGABLE);
@@ -541,31 +546,27 @@ static BColumnListView *NewSemsView(TeamWindow *wnd)
 	view->AddColumn(new BStringColumn("Name", 150, 50, 500, B_TRUNCATE_END), semNameCol);
 	view->AddColumn(new BIntegerColumn("Count", 64, 32, 128, B_ALIGN_RIGHT), semCountCol);
 	view->AddColumn(new BStringColumn("Latest holder", 96, 32, 1024, B_TRUNCATE_END), semLatestHolderCol);
-	ListSems(wnd, view);
+	rows.SetView(view);
+	ListSems(wnd, rows);
 	return view;
 }
 
-static void ListFiles(TeamWindow *wnd, BColumnListView *view)
+static bool ListFiles(TeamWindow *wnd, RowIndex &rows)
 {
-	uint32 cookie = 0;
-	fd_info info;
-	fs_info fsInfo;
+	BColumnListView *view = rows.View();
 	BRow *row;
-	BList prevRows;
-	BString buf;
-	char path[B_OS_NAME_LENGTH];
-
-	view->ScrollView()->Invalidate();
-
-	for (int32 i = 0; i < view->CountRows(); i++) {
-		row = view->RowAt(i);
-		prevRows.AddItem((void*)(addr_t)(((BIntegerField*)row->GetField(fileIdCol))->Value()));
-	}
 
-	while (_kern_get_next_fd_info(wnd->fId, &cookie, &info, sizeof(fd_info)) >= B_OK) {
-		prevRows.RemoveItem((void*)(addr_t)info.number);
-		row = FindIntRow(view, fileIdCol, NULL, info.number);
-		if (row == NULL) {
+	std::shared_ptr<const TeamObjects> objects = LatestObjects(wnd, collectFiles);
+	if (objects == NULL)
+		return false;
+	rows.BeginUpdate();
+
+	for (const FileSample &file: objects->files) {
+		const fd_info &info = file.info;
+		row = rows.Touch(info.number);
+		bool isNew = row == NULL;
+		bool changed = false;
+		if (isNew) {
 			row = new BRow();
 			row->SetField(new BStringField(0), fileNameCol);
 			row->SetField(new BIntegerField(0), fileIdCol);
@@ -575,37 +576,29 @@ static void ListFiles(TeamWindow *wnd, BColumnListView *view)
 			row->SetField(new BStringField(""), fileDevNameCol);
 			row->SetField(new BStringField(""), fileVolNameCol);
 			row->SetField(new BStringField(""), fileFsNameCol);
-			view->AddRow(row);
+			static_cast<BIntegerField*>(row->GetField(fileIdCol))->SetValue(info.number);
 		}
 
-		if (_kern_entry_ref_to_path(info.device, info.node, NULL, path, B_OS_NAME_LENGTH) == B_OK)
-			static_cast<BStringField*>(row->GetField(fileNameCol))->SetString(path);
-		else
-			static_cast<BStringField*>(row->GetField(fileNameCol))->SetString("?");
-
-		static_cast<BIntegerField*>(row->GetField(fileIdCol))->SetValue(info.number);
-
-		if ((info.open_mode & O_RWMASK) == O_RDONLY) {buf = "R";}
-		if ((info.open_mode & O_RWMASK) == O_WRONLY) {buf = "W";}
-		if ((info.open_mode & O_RWMASK) == O_RDWR  ) {buf = "RW";}
-		static_cast<BStringField*>(row->GetField(fileModeCol))->SetString(buf);
-		static_cast<BIntegerField*>(row->GetField(fileDevCol))->SetValue(info.device);
-		static_cast<BIntegerField*>(row->GetField(fileNodeCol))->SetValue(info.node);
-
-		fs_stat_dev(info.device, &fsInfo);
-		static_cast<BStringField*>(row->GetField(fileDevNameCol))->SetString(fsInfo.device_name);
-		static_cast<BStringField*>(row->GetField(fileVolNameCol))->SetString(fsInfo.volume_name);
-		static_cast<BStringField*>(row->GetField(fileFsNameCol))->SetString(fsInfo.fsh_name);
+		changed |= SetStringField(row, fileNameCol, file.path[0] != '\0' ? file.path : "?");
+		const char *mode = OpenModeName(info.open_mode);
+		changed |= SetStringField(row, fileModeCol, mode != NULL ? mode : "");
+		changed |= SetIntField(row, fileDevCol, info.device);
+		changed |= SetIntField(row, fileNodeCol, info.node);
+		changed |= SetStringField(row, fileDevNameCol, file.fs.device_name);
+		changed |= SetStringField(row, fileVolNameCol, file.fs.volume_name);
+		changed |= SetStringField(row, fileFsNameCol, file.fs.fsh_name);
+
+		if (isNew)
+			rows.Add(info.number, row);
+		else if (changed)
+			view->UpdateRow(row);
 	}
 
-	for (int32 i = 0; i < prevRows.CountItems(); i++) {
-		row = FindIntRow(view, fileIdCol, NULL, (int32)(addr_t)prevRows.ItemAt(i));
-		view->RemoveRow(row);
-		delete row;
-	}
+	rows.EndUpdate();
+	return true;
 }
 
-static BColumnListView *NewFilesView(TeamWindow *wnd)
+static BColumnListView *NewFilesView(TeamWindow *wnd, RowIndex &rows)
 {
 	BColumnListView *view;
 	view = new BColumnListView("Files", B_NAVIGABLE);
@@ -617,7 +610,8 @@ static BColumnListView *NewFilesView(TeamWindow *wnd)
 	view->AddColumn(new BStringColumn("Device", 96, 32, 512, B_TRUNCATE_MIDDLE, B_ALIGN_LEFT), fileDevNameCol);
 	view->AddColumn(new BStringColumn("Volume", 96, 32, 512, B_TRUNCATE_MIDDLE, B_ALIGN_LEFT), fileVolNameCol);
 	view->AddColumn(new BStringColumn("FS", 96, 32, 512, B_TRUNCATE_MIDDLE, B_ALIGN_LEFT), fileFsNameCol);
-	ListFiles(wnd, view);
+	rows.SetView(view);
+	ListFiles(wnd, rows);
 	return view;
 }
 
@@ -661,6 +655,28 @@ TeamWindow *OpenTeamWindow(team_id id, BPoint center)
 	}
 }
 
+static void SelectTab(BTabView *tabView, BView *view)
+{
+	for (int32 i = 0; i < tabView->CountTabs(); i++) {
+		if (tabView->TabAt(i)->View() == view) {
+			tabView->Select(i);
+			return;
+		}
+	}
+}
+
+// Objects of newly selected tab are collected by sampler, so show message is
+// resent until they arrive.
+static void ShowLater(TeamWindow *wnd, BMessage *msg)
+{
+	int32 tries = msg->GetInt32("tries", 0);
+	if (tries >= 20)
+		return;
+	BMessage retryMsg(*msg);
+	retryMsg.SetInt32("tries", tries + 1);
+	BMessageRunner::StartSending(BMessenger(wnd), &retryMsg, 100000, 1);
+}
+
 static BMessage *NewSignalMsg(int32 signal)
 {
 	BMessage *msg = new BMessage(threadsSendSignalMsg);
@@ -733,12 +749,14 @@ TeamWindow::TeamWindow(team_id id): BWindow(BRect(0, 0, 800, 480), "Team", B_DOC
 	fTabView->SetBorder(B_NO_BORDER);
 
 	tab = new BTab(); fTabView->AddTab(fInfoView = NewInfoView(this), tab);
-	tab = new BTab(); fTabView->AddTab(fImagesView = NewImagesView(this), tab);
-	tab = new BTab(); fTabView->AddTab(fThreadsView = NewThreadsView(this), tab);
-	tab = new BTab(); fTabView->AddTab(fAreasView = NewAreasView(this), tab);
-	tab = new BTab(); fTabView->AddTab(fPortsView = NewPortsView(this), tab);
-	tab = new BTab(); fTabView->AddTab(fSemsView = NewSemsView(this), tab);
-	tab = new BTab(); fTabView->AddTab(fFilesView = NewFilesView(this), tab);
+	tab = new BTab(); fTabView->AddTab(fImagesView = NewImagesView(this, fImageRows), tab);
+	tab = new BTab(); fTabView->AddTab(fThreadsView = NewThreadsView(this, fThreadRows), tab);
+	tab = new BTab(); fTabView->AddTab(fAreasView = NewAreasView(this, fAreaRows), tab);
+	tab = new BTab(); fTabView->AddTab(fMemoryView = NewMemoryGroupsView(fMemoryRows, false), tab);
+	ListMemory(this, fMemoryRows);
+	tab = new BTab(); fTabView->AddTab(fPortsView = NewPortsView(this, fPortRows), tab);
+	tab = new BTab(); fTabView->AddTab(fSemsView = NewSemsView(this, fSemRows), tab);
+	tab = new BTab(); fTabView->AddTab(fFilesView = NewFilesView(this, fFileRows), tab);
 
 	BLayoutBuilder::Group<>(this, B_VERTICAL, 0)
 		.Add(fMenuBar)
@@ -754,6 +772,7 @@ TeamWindow::TeamWindow(team_id id): BWindow(BRect(0, 0, 800, 480), "Team", B_DOC
 TeamWindow::~TeamWindow()
 {
 	printf("-TeamWindow\n");
+	Sampler::Default().WatchTeam(fId, 0);
 	AutoLocker<BLocker> locker(teamWindowsLocker);
 	teamWindows.erase(fId);
 }
@@ -761,19 +780,29 @@ TeamWindow::~TeamWindow()
 void TeamWindow::TabChanged()
 {
 	BMenuItem *newMenu = NULL;
+	uint32 fields = 0;
 	BTab *tab = fTabView->TabAt(fTabView->Selection());
 	if (tab != NULL) {
 		BView *view = tab->View();
 		if (view == fInfoView)
 			newMenu = fInfoMenu;
-		else if (view == fImagesView)
+		else if (view == fImagesView) {
 			newMenu = fImagesMenu;
-		else if (view == fThreadsView)
+			fields = collectImages;
+		} else if (view == fThreadsView)
 			newMenu = fThreadsMenu;
-		else if (view == fSemsView)
+		else if (view == fAreasView)
+			fields = collectAreas;
+		else if (view == fPortsView)
+			fields = collectPorts;
+		else if (view == fSemsView) {
 			newMenu = fSemsMenu;
+			fields = collectSems;
+		} else if (view == fFilesView)
+			fields = collectFiles;
 	}
 	SetMenu(newMenu);
+	Sampler::Default().WatchTeam(fId, fields);
 }
 
 void TeamWindow::SetMenu(BMenuItem *menu)
@@ -794,17 +823,19 @@ void TeamWindow::MessageReceived(BMessage *msg)
 			if (view == fInfoView)
 				ListInfo(this, fInfoView);
 			else if (view == fImagesView)
-				ListImages(this, fImagesView);
+				ListImages(this, fImageRows);
 			else if (view == fThreadsView)
-				ListThreads(this, fThreadsView);
+				ListThreads(this, fThreadRows);
 			else if (view == fAreasView)
-				ListAreas(this, fAreasView);
+				ListAreas(this, fAreaRows);
+			else if (view == fMemoryView)
+				ListMemory(this, fMemoryRows);
 			else if (view == fPortsView)
-				ListPorts(this, fPortsView);
+				ListPorts(this, fPortRows);
 			else if (view == fSemsView)
-				ListSems(this, fSemsView);
+				ListSems(this, fSemRows);
 			else if (view == fFilesView)
-				ListFiles(this, fFilesView);
+				ListFiles(this, fFileRows);
 		}
 		return;
 	}
@@ -873,19 +904,10 @@ void TeamWindow::MessageReceived(BMessage *msg)
 		BRow *row = fThreadsView->CurrentSelection(NULL);
 		if (row == NULL) return;
 		int64 stackBase = ((Int64Field*)row->GetField(threadStackBaseCol))->Value();
-		ListAreas(this, fAreasView);
-		for (int32 i = 0; i < fAreasView->CountRows(); i++) {
-			BRow *areaRow = fAreasView->RowAt(i);
-			int64 areaAdr = ((Int64Field*)areaRow->GetField(areaAdrCol))->Value();
-			int64 areaSize = ((Int64Field*)areaRow->GetField(areaSizeCol))->Value();
-			if (stackBase >= areaAdr && stackBase < areaAdr + areaSize) {
-				int32 area = ((BIntegerField*)areaRow->GetField(areaIdCol))->Value();
-				BMessage showMsg(teamWindowShowAreaMsg);
-				CheckRetVoid(showMsg.AddInt32("val", area));
-				CheckRetVoid(showMsg.AddInt32("refresh", false));
-				BMessenger(this).SendMessage(&showMsg);
-			}
-		}
+		BMessage showMsg(teamWindowShowAreaMsg);
+		CheckRetVoid(showMsg.AddInt64("address", stackBase));
+		BMessenger(this).SendMessage(&showMsg);
+		return;
 	}
 	case semsShowThreadMsg: {
 		BTab *tab = fTabView->TabAt(fTabView->Selection());
@@ -905,9 +927,12 @@ void TeamWindow::MessageReceived(BMessage *msg)
 	case teamWindowShowImageMsg: {
 		int32 id;
 		if (msg->FindInt32("val", &id) < B_OK) return;
-		fTabView->Select(1); // TODO: remove hard-coded constant
-		ListImages(this, fImagesView);
-		BRow *itemRow = FindIntRow(fImagesView, imageIdCol, NULL, id);
+		SelectTab(fTabView, fImagesView);
+		if (!ListImages(this, fImageRows)) {
+			ShowLater(this, msg);
+			return;
+		}
+		BRow *itemRow = fImageRows.Find(id);
 		if (itemRow == NULL) return;
 		fImagesView->DeselectAll();
 		fImagesView->SetFocusRow(itemRow, true);
@@ -917,9 +942,9 @@ void TeamWindow::MessageReceived(BMessage *msg)
 	case teamWindowShowThreadMsg: {
 		int32 id;
 		if (msg->FindInt32("val", &id) < B_OK) return;
-		fTabView->Select(2); // TODO: remove hard-coded constant
-		ListThreads(this, fThreadsView);
-		BRow *itemRow = FindIntRow(fThreadsView, threadIdCol, NULL, id);
+		SelectTab(fTabView, fThreadsView);
+		ListThreads(this, fThreadRows);
+		BRow *itemRow = fThreadRows.Find(id);
 		if (itemRow == NULL) return;
 		fThreadsView->DeselectAll();
 		fThreadsView->SetFocusRow(itemRow, true);
@@ -927,13 +952,28 @@ void TeamWindow::MessageReceived(BMessage *msg)
 		return;
 	}
 	case teamWindowShowAreaMsg: {
-		int32 id;
-		bool refresh;
-		if (msg->FindInt32("val", &id) < B_OK) return;
-		if (msg->FindBool("refresh", &refresh) < B_OK) refresh = true;
-		fTabView->Select(3); // TODO: remove hard-coded constant
-		if (refresh) ListAreas(this, fAreasView);
-		BRow *itemRow = FindIntRow(fAreasView, areaIdCol, NULL, id);
+		int32 id = -1;
+		int64 address = 0;
+		if (msg->FindInt32("val", &id) < B_OK && msg->FindInt64("address", &address) < B_OK) return;
+		SelectTab(fTabView, fAreasView);
+		if (!ListAreas(this, fAreaRows)) {
+			ShowLater(this, msg);
+			return;
+		}
+		BRow *itemRow = NULL;
+		if (id >= B_OK)
+			itemRow = fAreaRows.Find(id);
+		else {
+			for (int32 i = 0; i < fAreasView->CountRows(); i++) {
+				BRow *areaRow = fAreasView->RowAt(i);
+				int64 areaAdr = ((Int64Field*)areaRow->GetField(areaAdrCol))->Value();
+				int64 areaSize = ((Int64Field*)areaRow->GetField(areaSizeCol))->Value();
+				if (address >= areaAdr && address < areaAdr + areaSize) {
+					itemRow = areaRow;
+					break;
+				}
+			}
+		}
 		if (itemRow == NULL) return;
 		fAreasView->DeselectAll();
 		fAreasView->SetFocusRow(itemRow, true);
@@ -943,9 +983,12 @@ void TeamWindow::MessageReceived(BMessage *msg)
 	case teamWindowShowPortMsg: {
 		int32 id;
 		if (msg->FindInt32("val", &id) < B_OK) return;
-		fTabView->Select(4); // TODO: remove hard-coded constant
-		ListPorts(this, fPortsView);
-		BRow *itemRow = FindIntRow(fPortsView, portIdCol, NULL, id);
+		SelectTab(fTabView, fPortsView);
+		if (!ListPorts(this, fPortRows)) {
+			ShowLater(this, msg);
+			return;
+		}
+		BRow *itemRow = fPortRows.Find(id);
 		if (itemRow == NULL) return;
 		fPortsView->DeselectAll();
 		fPortsView->SetFocusRow(itemRow, true);
@@ -955,9 +998,12 @@ void TeamWindow::MessageReceived(BMessage *msg)
 	case teamWindowShowSemMsg: {
 		int32 id;
 		if (msg->FindInt32("val", &id) < B_OK) return;
-		fTabView->Select(5); // TODO: remove hard-coded constant
-		ListSems(this, fSemsView);
-		BRow *itemRow = FindIntRow(fSemsView, semIdCol, NULL, id);
+		SelectTab(fTabView, fSemsView);
+		if (!ListSems(this, fSemRows)) {
+			ShowLater(this, msg);
+			return;
+		}
+		BRow *itemRow = fSemRows.Find(id);
 		if (itemRow == NULL) return;
 		fSemsView->DeselectAll();
 		fSemsView->SetFocusRow(itemRow, true);
@@ -967,9 +1013,12 @@ void TeamWindow::MessageReceived(BMessage *msg)
 	case teamWindowShowFileMsg: {
 		int32 id;
 		if (msg->FindInt32("val", &id) < B_OK) return;
-		fTabView->Select(6); // TODO: remove hard-coded constant
-		ListFiles(this, fFilesView);
-		BRow *itemRow = FindIntRow(fFilesView, fileIdCol, NULL, id);
+		SelectTab(fTabView, fFilesView);
+		if (!ListFiles(this, fFileRows)) {
+			ShowLater(this, msg);
+			return;
+		}
+		BRow *itemRow = fFileRows.Find(id);
 		if (itemRow == NULL) return;
 		fFilesView->DeselectAll();
 		fFilesView->SetFocusRow(itemRow, true);
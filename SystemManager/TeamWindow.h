@@ -5,6 +5,8 @@
 #include <OS.h>
 #include <MessageRunner.h>
 
+#include "RowIndex.h"
+
 class BTabView;
 class BColumnListView;
 
@@ -37,6 +39,14 @@ private:
 	BColumnListView *fPortsView;
 	BColumnListView *fSemsView;
 	BColumnListView *fFilesView;
+	BColumnListView *fMemoryView;
+	RowIndex fImageRows;
+	RowIndex fThreadRows;
+	RowIndex fAreaRows;
+	RowIndex fPortRows;
+	RowIndex fSemRows;
+	RowIndex fFileRows;
+	RowIndex fMemoryRows;
 
 public:
 	team_id fId;
@@ -0,0 +1,144 @@
+// Checks merging of stacks in CallTree, totals of inverted tree and folded
+// output.
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "../CallTree.h"
+#include "Check.h"
+
+
+static const uint32_t kNotFound = UINT32_MAX;
+
+
+static void AddStack(CallTree &tree, std::initializer_list<const char*> names, uint64_t weight = 1)
+{
+	std::vector<uint32_t> frames;
+	for (const char *name: names)
+		frames.push_back(tree.AddName(name));
+	tree.AddStack(frames.data(), frames.size(), weight);
+}
+
+// Node reached from root by frame names.
+static uint32_t FindNode(const CallTree &tree, std::initializer_list<const char*> names)
+{
+	uint32_t node = CallTree::kRoot;
+	for (const char *name: names) {
+		uint32_t found = kNotFound;
+		for (const auto &it: tree.NodeAt(node).children) {
+			if (tree.Name(it.first) == name)
+				found = it.second;
+		}
+		if (found == kNotFound)
+			return kNotFound;
+		node = found;
+	}
+	return node;
+}
+
+static bool HasCounts(const CallTree &tree, std::initializer_list<const char*> names, uint64_t total, uint64_t self)
+{
+	uint32_t node = FindNode(tree, names);
+	return node != kNotFound && tree.NodeAt(node).total == total && tree.NodeAt(node).self == self;
+}
+
+static std::vector<std::string> FoldedLines(const CallTree &tree)
+{
+	FILE *file = tmpfile();
+	CHECK(tree.WriteFolded(file));
+	rewind(file);
+	std::vector<std::string> lines;
+	char buf[256];
+	while (fgets(buf, sizeof(buf), file) != NULL)
+		lines.push_back(buf);
+	fclose(file);
+	std::sort(lines.begin(), lines.end());
+	return lines;
+}
+
+static void MakeTree(CallTree &tree)
+{
+	AddStack(tree, {"main", "a", "b"});
+	AddStack(tree, {"main", "a", "b"});
+	AddStack(tree, {"main", "a", "c"}, 2);
+	AddStack(tree, {"main", "d"});
+	AddStack(tree, {"main", "a"});
+	AddStack(tree, {"main", "d", "b"});
+}
+
+
+static void TestMerge()
+{
+	CallTree tree;
+	MakeTree(tree);
+	// Root, main, main;a, main;a;b, main;a;c, main;d, main;d;b.
+	CHECK(tree.CountNodes() == 7);
+	CHECK(tree.TotalSamples() == 7);
+	CHECK(HasCounts(tree, {"main"}, 7, 0));
+	CHECK(HasCounts(tree, {"main", "a"}, 5, 1));
+	CHECK(HasCounts(tree, {"main", "a", "b"}, 2, 2));
+	CHECK(HasCounts(tree, {"main", "a", "c"}, 2, 2));
+	CHECK(HasCounts(tree, {"main", "d"}, 2, 1));
+	CHECK(HasCounts(tree, {"main", "d", "b"}, 1, 1));
+	// Names are interned once.
+	CHECK(tree.AddName("b") == tree.AddName("b"));
+
+	tree.Clear();
+	CHECK(tree.CountNodes() == 1);
+	CHECK(tree.TotalSamples() == 0);
+}
+
+static void TestInverted()
+{
+	CallTree tree;
+	MakeTree(tree);
+	CallTree inverted = tree.Inverted();
+	CHECK(inverted.TotalSamples() == tree.TotalSamples());
+	// Innermost frames are children of root, totals are self samples of
+	// all their occurrences.
+	CHECK(HasCounts(inverted, {"b"}, 3, 0));
+	CHECK(HasCounts(inverted, {"b", "a"}, 2, 0));
+	CHECK(HasCounts(inverted, {"b", "a", "main"}, 2, 2));
+	CHECK(HasCounts(inverted, {"b", "d", "main"}, 1, 1));
+	CHECK(HasCounts(inverted, {"c", "a", "main"}, 2, 2));
+	CHECK(HasCounts(inverted, {"a"}, 1, 0));
+	CHECK(HasCounts(inverted, {"d"}, 1, 0));
+	CHECK(FindNode(inverted, {"main"}) == kNotFound);
+
+	// Inverting twice gives the same stacks.
+	CHECK(FoldedLines(inverted.Inverted()) == FoldedLines(tree));
+}
+
+static void TestFolded()
+{
+	CallTree tree;
+	MakeTree(tree);
+	AddStack(tree, {"main", "std::map<int;int>"});
+	std::vector<std::string> expected = {
+		"main;a 1\n",
+		"main;a;b 2\n",
+		"main;a;c 2\n",
+		"main;d 1\n",
+		"main;d;b 1\n",
+		"main;std::map<int:int> 1\n",
+	};
+	CHECK(FoldedLines(tree) == expected);
+
+	// Frames without samples of their own are not written.
+	CallTree empty;
+	CHECK(FoldedLines(empty).empty());
+}
+
+
+int main()
+{
+	TestMerge();
+	TestInverted();
+	TestFolded();
+	return ReportChecks("CallTreeTest");
+}
@@ -0,0 +1,28 @@
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <stdio.h>
+
+
+// Failed checks are printed and counted, test is single translation unit.
+static int gFailed = 0;
+static int gChecks = 0;
+
+#define CHECK(cond) \
+	do { \
+		gChecks++; \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			gFailed++; \
+		} \
+	} while (0)
+
+// Prints summary line and returns exit code of test.
+static inline int ReportChecks(const char *name)
+{
+	printf("%s: %d checks, %d failed\n", name, gChecks, gFailed);
+	return gFailed == 0 ? 0 : 1;
+}
+
+
+#endif	// _CHECK_H_
@@ -0,0 +1,183 @@
+// Checks History ring wraparound, per-team reads and lock-free reads while
+// writer thread records samples.
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <atomic>
+#include <initializer_list>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../History.h"
+#include "Check.h"
+
+
+struct TeamValue {
+	int32_t id;
+	const char *path;
+	uint64_t memAlloc;
+};
+
+// Sample values are their index, so readers can check continuity.
+static void Record(History &history, int64_t index, std::initializer_list<TeamValue> teams)
+{
+	Snapshot snapshot;
+	snapshot.time = index;
+	snapshot.system.cpuUsage = index;
+	snapshot.system.usedThreads = index;
+	for (const TeamValue &value: teams) {
+		TeamSample team = {};
+		team.id = value.id;
+		team.path = value.path;
+		team.memAlloc = value.memAlloc;
+		snapshot.teams.push_back(team);
+	}
+	snapshot.BuildIndex();
+	history.Record(snapshot);
+}
+
+static bool IsRange(const std::vector<double> &values, double first, double last)
+{
+	if (values.size() != last - first + 1)
+		return false;
+	for (size_t i = 0; i < values.size(); i++) {
+		if (values[i] != first + i)
+			return false;
+	}
+	return true;
+}
+
+static size_t CountLines(FILE *file)
+{
+	rewind(file);
+	size_t count = 0;
+	int c;
+	while ((c = fgetc(file)) != EOF)
+		count += c == '\n';
+	return count;
+}
+
+
+static void TestWraparound()
+{
+	History history(5);
+	std::vector<double> values;
+	history.Read(History::cpuSeries, values, 100);
+	CHECK(values.empty());
+
+	for (int64_t i = 0; i < 3; i++)
+		Record(history, i, {});
+	history.Read(History::cpuSeries, values, 100);
+	CHECK(IsRange(values, 0, 2));
+
+	for (int64_t i = 3; i < 12; i++)
+		Record(history, i, {});
+	history.Read(History::cpuSeries, values, 100);
+	CHECK(IsRange(values, 7, 11));
+	history.Read(History::threadsSeries, values, 3);
+	CHECK(IsRange(values, 9, 11));
+}
+
+static void TestTeams()
+{
+	History history(8);
+	std::vector<double> cpu, memory;
+	for (int64_t i = 0; i < 12; i++) {
+		if (i < 3)
+			Record(history, i, {{1, "/bin/a", (uint64_t)i}, {3, "/bin/old", (uint64_t)i}});
+		else if (i < 6)
+			Record(history, i, {{1, "/bin/a", (uint64_t)i}, {2, "/bin/b", (uint64_t)i}, {3, "/bin/old", (uint64_t)i}});
+		else if (i < 8)
+			Record(history, i, {{1, "/bin/a", (uint64_t)i}, {2, "/bin/b", (uint64_t)i}, {3, "/bin/new", (uint64_t)i}});
+		else
+			Record(history, i, {{1, "/bin/a", (uint64_t)i}, {3, "/bin/new", (uint64_t)i}});
+
+		if (i == 6) {
+			CHECK(history.ReadTeam(2, cpu, memory, 100));
+			CHECK(IsRange(memory, 3, 6));
+			CHECK(cpu.size() == memory.size());
+			// Exec starts new history.
+			CHECK(history.ReadTeam(3, cpu, memory, 100));
+			CHECK(IsRange(memory, 6, 6));
+		}
+	}
+
+	CHECK(history.ReadTeam(1, cpu, memory, 100));
+	CHECK(IsRange(memory, 4, 11));
+	CHECK(!history.ReadTeam(2, cpu, memory, 100));
+	CHECK(cpu.empty() && memory.empty());
+	CHECK(history.ReadTeam(3, cpu, memory, 100));
+	CHECK(IsRange(memory, 6, 11));
+	CHECK(history.ReadTeam(3, cpu, memory, 2));
+	CHECK(IsRange(memory, 10, 11));
+
+	// Header, system series of 8 samples, teams 1 and 3 have 8 and 6
+	// samples of 2 series.
+	FILE *file = tmpfile();
+	CHECK(history.WriteCsv(file));
+	CHECK(CountLines(file) == 1 + 8*History::seriesCount + 8*2 + 6*2);
+	fclose(file);
+}
+
+// Team IDs change every 8 samples, so team tables are replaced and freed
+// while reader uses them.
+static void TestConcurrent()
+{
+	const int64_t kSamples = 200000;
+	History history(64);
+	std::atomic<bool> done(false);
+
+	std::thread writer([&]() {
+		for (int64_t i = 0; i < kSamples; i++) {
+			int32_t id = i/8;
+			Record(history, i, {{id, "/bin/t", (uint64_t)i}, {id + 1, "/bin/t", (uint64_t)i}});
+		}
+		done = true;
+	});
+
+	std::vector<double> values, cpu, memory;
+	int64_t reads = 0, teamReads = 0, exports = 0;
+	bool valuesOk = true, teamsOk = true, exportsOk = true;
+	double last = -1;
+	while (!done) {
+		history.Read(History::threadsSeries, values, 64);
+		reads++;
+		if (values.empty())
+			continue;
+		valuesOk &= values.size() <= 64 && values.front() >= last - 63 && IsRange(values, values.front(), values.back());
+		last = values.back();
+
+		int32_t id = (int64_t)last/8;
+		if (history.ReadTeam(id, cpu, memory, 64)) {
+			teamReads++;
+			teamsOk &= !memory.empty() && IsRange(memory, memory.front(), memory.back()) && (int64_t)memory.front()/8 <= id;
+		}
+
+		if (reads % 1000 == 0) {
+			FILE *file = fopen("/dev/null", "w");
+			exportsOk &= history.WriteJson(file);
+			fclose(file);
+			exports++;
+		}
+	}
+	writer.join();
+
+	CHECK(valuesOk);
+	CHECK(teamsOk);
+	CHECK(exportsOk);
+	history.Read(History::threadsSeries, values, 64);
+	CHECK(IsRange(values, kSamples - 64, kSamples - 1));
+	printf("%" PRId64 " reads, %" PRId64 " team reads, %" PRId64 " exports during %" PRId64 " samples\n",
+		reads, teamReads, exports, kSamples);
+}
+
+
+int main()
+{
+	TestWraparound();
+	TestTeams();
+	TestConcurrent();
+	return ReportChecks("HistoryTest");
+}
@@ -0,0 +1,133 @@
+// Checks that SampleWriter output stays valid for long records and values
+// that are not finite, and delta mode reports changed and removed records.
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+
+#include "../SampleWriter.h"
+#include "Check.h"
+
+
+static std::string FileText(FILE *file)
+{
+	std::string text;
+	rewind(file);
+	char buf[4096];
+	size_t len;
+	while ((len = fread(buf, 1, sizeof(buf), file)) > 0)
+		text.append(buf, len);
+	return text;
+}
+
+static size_t CountLines(const std::string &text)
+{
+	size_t count = 0;
+	for (char c: text)
+		count += c == '\n';
+	return count;
+}
+
+
+// Strings longer than whole buffer must not be cut.
+static void TestLongRecords()
+{
+	std::string name(SampleWriter::kBufferSize*2 + 123, 'a');
+	for (SampleWriter::Format format: {SampleWriter::jsonFormat, SampleWriter::csvFormat}) {
+		FILE *file = tmpfile();
+		{
+			SampleWriter writer(file, format, false);
+			writer.BeginSample(1);
+			for (int i = 0; i < 4; i++) {
+				writer.BeginRecord(threadRecord, 1, i);
+				writer.String("name", name.c_str());
+				writer.Int("priority", 10);
+				writer.EndRecord();
+			}
+			CHECK(writer.EndSample());
+		}
+		std::string text = FileText(file);
+		fclose(file);
+		if (format == SampleWriter::jsonFormat) {
+			std::string record = "{\"time\":1,\"kind\":\"thread\",\"team\":1,\"id\":0,\"name\":\"" + name + "\",\"priority\":10}\n";
+			CHECK(text.size() == 4*record.size());
+			CHECK(text.compare(0, record.size(), record) == 0);
+			CHECK(CountLines(text) == 4);
+		} else {
+			std::string line = "1,thread,1,0,name," + name + "\n";
+			CHECK(text.find(line) != std::string::npos);
+			CHECK(CountLines(text) == 1 + 4*2);
+		}
+	}
+}
+
+static void TestNotFinite()
+{
+	FILE *file = tmpfile();
+	{
+		SampleWriter writer(file, SampleWriter::jsonFormat, false);
+		writer.BeginSample(1);
+		writer.BeginRecord(systemRecord, -1, 0);
+		writer.Float("nan", NAN);
+		writer.Float("inf", INFINITY);
+		writer.Float("cpu", 12.5);
+		writer.EndRecord();
+		writer.EndSample();
+	}
+	CHECK(FileText(file) == "{\"time\":1,\"kind\":\"system\",\"team\":-1,\"id\":0,\"nan\":null,\"inf\":null,\"cpu\":12.5}\n");
+	fclose(file);
+
+	file = tmpfile();
+	{
+		SampleWriter writer(file, SampleWriter::csvFormat, false);
+		writer.BeginSample(1);
+		writer.BeginRecord(systemRecord, -1, 0);
+		writer.Float("nan", -NAN);
+		writer.EndRecord();
+		writer.EndSample();
+	}
+	CHECK(FileText(file) == "time,kind,team,id,field,value\n1,system,-1,0,nan,\n");
+	fclose(file);
+}
+
+static void WriteTeams(SampleWriter &writer, int64_t time, int teamCount, int64_t changedTeam)
+{
+	writer.BeginSample(time);
+	for (int i = 0; i < teamCount; i++) {
+		writer.BeginRecord(teamRecord, i, i);
+		writer.String("path", "/bin/app");
+		writer.Int("userTime", i == changedTeam ? time : 0);
+		writer.EndRecord();
+	}
+	writer.EndSample();
+}
+
+static void TestDelta()
+{
+	FILE *file = tmpfile();
+	{
+		SampleWriter writer(file, SampleWriter::jsonFormat, true);
+		WriteTeams(writer, 1, 3, -1);
+		WriteTeams(writer, 2, 3, 1);
+		WriteTeams(writer, 3, 2, -1);
+	}
+	CHECK(FileText(file) ==
+		"{\"time\":1,\"kind\":\"team\",\"team\":0,\"id\":0,\"path\":\"/bin/app\",\"userTime\":0}\n"
+		"{\"time\":1,\"kind\":\"team\",\"team\":1,\"id\":1,\"path\":\"/bin/app\",\"userTime\":0}\n"
+		"{\"time\":1,\"kind\":\"team\",\"team\":2,\"id\":2,\"path\":\"/bin/app\",\"userTime\":0}\n"
+		"{\"time\":2,\"kind\":\"team\",\"team\":1,\"id\":1,\"userTime\":2}\n"
+		"{\"time\":3,\"kind\":\"team\",\"team\":1,\"id\":1,\"userTime\":0}\n"
+		"{\"time\":3,\"kind\":\"team\",\"team\":2,\"id\":2,\"removed\":true}\n");
+	fclose(file);
+}
+
+
+int main()
+{
+	TestLongRecords();
+	TestNotFinite();
+	TestDelta();
+	return ReportChecks("SampleWriterTest");
+}
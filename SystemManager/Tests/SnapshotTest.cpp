@@ -0,0 +1,121 @@
+// Checks CPU usage computed from snapshot pair recorded in text fixture.
+//
+// Fixture lines:
+//   snapshot <time> <cpuCount>
+//   team <id> <userTime> <kernelTime>
+//   thread <id> <team> <userTime> <kernelTime> <isIdle>
+//   expect system <cpuUsage>
+//   expect team|thread <id> <cpuUsage>
+// Threads follow their team. Expectations refer to last snapshot.
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+#include "../Snapshot.h"
+
+
+struct Expectation
+{
+	std::string kind;
+	int32_t id;
+	float cpuUsage;
+};
+
+
+static bool LoadFixture(const char *path, std::vector<Snapshot> &snapshots, std::vector<Expectation> &expectations)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "can't open %s\n", path);
+		return false;
+	}
+	char line[256];
+	char kind[32];
+	int lineNo = 0;
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), file) != NULL) {
+		lineNo++;
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		long long time, userTime, kernelTime;
+		int id, team, cpuCount, isIdle;
+		float cpuUsage;
+		if (sscanf(line, "snapshot %lld %d", &time, &cpuCount) == 2) {
+			snapshots.emplace_back();
+			snapshots.back().time = time;
+			snapshots.back().system.cpuCount = cpuCount;
+		} else if (!snapshots.empty() && sscanf(line, "team %d %lld %lld", &id, &userTime, &kernelTime) == 3) {
+			Snapshot &snapshot = snapshots.back();
+			TeamSample sample = {};
+			sample.id = id;
+			sample.userTime = userTime;
+			sample.kernelTime = kernelTime;
+			sample.firstThread = snapshot.threads.size();
+			snapshot.teams.push_back(sample);
+		} else if (!snapshots.empty() && !snapshots.back().teams.empty()
+			&& sscanf(line, "thread %d %d %lld %lld %d", &id, &team, &userTime, &kernelTime, &isIdle) == 5) {
+			Snapshot &snapshot = snapshots.back();
+			ThreadSample sample = {};
+			sample.id = id;
+			sample.team = team;
+			sample.userTime = userTime;
+			sample.kernelTime = kernelTime;
+			sample.isIdle = isIdle != 0;
+			snapshot.threads.push_back(sample);
+			snapshot.teams.back().threadCount++;
+		} else if (sscanf(line, "expect system %f", &cpuUsage) == 1) {
+			expectations.push_back({"system", -1, cpuUsage});
+		} else if (sscanf(line, "expect %31s %d %f", kind, &id, &cpuUsage) == 3) {
+			expectations.push_back({kind, id, cpuUsage});
+		} else {
+			fprintf(stderr, "%s:%d: bad line\n", path, lineNo);
+			ok = false;
+		}
+	}
+	fclose(file);
+	for (Snapshot &snapshot: snapshots)
+		snapshot.BuildIndex();
+	return ok && !snapshots.empty();
+}
+
+
+int main(int argc, char **argv)
+{
+	const char *path = argc > 1 ? argv[1] : "SnapshotFixture.txt";
+	std::vector<Snapshot> snapshots;
+	std::vector<Expectation> expectations;
+	if (!LoadFixture(path, snapshots, expectations))
+		return 1;
+
+	Snapshot empty;
+	ComputeCpuUsage(snapshots[0], empty);
+	for (size_t i = 1; i < snapshots.size(); i++)
+		ComputeCpuUsage(snapshots[i], snapshots[i - 1]);
+
+	const Snapshot &last = snapshots.back();
+	int failed = 0;
+	for (const Expectation &expect: expectations) {
+		float actual;
+		if (expect.kind == "system")
+			actual = last.system.cpuUsage;
+		else if (expect.kind == "team" && last.FindTeam(expect.id) != NULL)
+			actual = last.FindTeam(expect.id)->cpuUsage;
+		else if (expect.kind == "thread" && last.FindThread(expect.id) != NULL)
+			actual = last.FindThread(expect.id)->cpuUsage;
+		else {
+			printf("FAIL %s %d: not found\n", expect.kind.c_str(), expect.id);
+			failed++;
+			continue;
+		}
+		if (fabsf(actual - expect.cpuUsage) > 0.01f) {
+			printf("FAIL %s %d: cpu %g, expected %g\n", expect.kind.c_str(), expect.id, actual, expect.cpuUsage);
+			failed++;
+		}
+	}
+	printf("%s: %zu checks, %d failed\n", path, expectations.size(), failed);
+	return failed == 0 ? 0 : 1;
+}
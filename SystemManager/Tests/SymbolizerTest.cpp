@@ -0,0 +1,175 @@
+// Compares symbols and source lines found by SymbolImage with output of nm
+// and addr2line for ELF files given as arguments, own executable by default.
+// Only function symbols are checked.
+//
+// addr2line 2.40 reports primary source file for rows of DWARF 5 sequences
+// that use initial file register value, so test files should be built with
+// -gdwarf-4.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../Symbolizer.h"
+
+
+struct FunctionSymbol
+{
+	uint64_t address;
+	uint64_t size;
+};
+
+
+// Dynamic symbols are used only if file has no symbol table, the same as in
+// SymbolImage.
+static bool ReadFunctions(const char *path, bool dynamic, std::map<uint64_t, std::set<std::string>> &names, std::vector<FunctionSymbol> &functions)
+{
+	std::string command = std::string("nm --defined-only -S ") + (dynamic ? "-D '" : "'") + path + "' 2>/dev/null";
+	FILE *pipe = popen(command.c_str(), "r");
+	if (pipe == NULL)
+		return false;
+	char line[4096];
+	while (fgets(line, sizeof(line), pipe) != NULL) {
+		uint64_t address, size;
+		char type;
+		char name[4096];
+		if (sscanf(line, "%" SCNx64 " %" SCNx64 " %c %4095s", &address, &size, &type, name) != 4)
+			continue;
+		if (type != 'T' && type != 't' && type != 'W')
+			continue;
+		// Version of dynamic symbol is not part of its name.
+		char *version = strchr(name, '@');
+		if (version != NULL)
+			*version = '\0';
+		names[address].insert(name);
+		if (size > 0)
+			functions.push_back({address, size});
+	}
+	return pclose(pipe) == 0;
+}
+
+// Returns "file:line" with directory and discriminator removed, empty if
+// addr2line does not know location.
+static std::string ShortLocation(const char *location)
+{
+	std::string str = location;
+	size_t end = str.find_first_of(" \n");
+	if (end != std::string::npos)
+		str.resize(end);
+	size_t slash = str.rfind('/');
+	if (slash != std::string::npos)
+		str.erase(0, slash + 1);
+	if (str.compare(0, 2, "??") == 0 || str.find(":?") != std::string::npos || (str.size() >= 2 && str.compare(str.size() - 2, 2, ":0") == 0))
+		return "";
+	return str;
+}
+
+static bool ReadLines(const char *path, const std::vector<uint64_t> &addresses, std::vector<std::string> &locations)
+{
+	char tmpPath[] = "/tmp/symbolizer-test-XXXXXX";
+	int fd = mkstemp(tmpPath);
+	if (fd < 0)
+		return false;
+	FILE *file = fdopen(fd, "w");
+	for (uint64_t address: addresses)
+		fprintf(file, "%" PRIx64 "\n", address);
+	fclose(file);
+
+	std::string command = std::string("addr2line -e '") + path + "' < " + tmpPath;
+	FILE *pipe = popen(command.c_str(), "r");
+	if (pipe == NULL) {
+		unlink(tmpPath);
+		return false;
+	}
+	char line[4096];
+	while (fgets(line, sizeof(line), pipe) != NULL)
+		locations.push_back(ShortLocation(line));
+	unlink(tmpPath);
+	return pclose(pipe) == 0 && locations.size() == addresses.size();
+}
+
+
+static int CheckImage(const char *path)
+{
+	std::shared_ptr<const SymbolImage> image = Symbolizer::Default().Get(path);
+	if (!image) {
+		printf("FAIL %s: can't load\n", path);
+		return 1;
+	}
+
+	std::map<uint64_t, std::set<std::string>> names;
+	std::vector<FunctionSymbol> functions;
+	if (!ReadFunctions(path, false, names, functions) || functions.empty()) {
+		names.clear();
+		functions.clear();
+		ReadFunctions(path, true, names, functions);
+	}
+	if (functions.empty()) {
+		printf("FAIL %s: no function symbols\n", path);
+		return 1;
+	}
+
+	int failed = 0;
+	std::vector<uint64_t> addresses;
+	for (const FunctionSymbol &function: functions) {
+		for (uint64_t address: {function.address, function.address + function.size/2}) {
+			addresses.push_back(address);
+			bool exact;
+			const SymbolImage::Symbol *symbol = image->LookupSymbol(address, &exact);
+			if (symbol == NULL || !exact || names[symbol->address].count(symbol->name) == 0) {
+				if (failed++ < 10)
+					printf("FAIL %s: %#" PRIx64 " symbol %s, expected %s\n", path, address,
+						symbol != NULL ? symbol->name.c_str() : "(none)", names[function.address].begin()->c_str());
+			}
+		}
+	}
+
+	size_t lineChecks = 0;
+	if (image->HasLineInfo()) {
+		std::vector<std::string> expected;
+		if (!ReadLines(path, addresses, expected)) {
+			printf("FAIL %s: can't run addr2line\n", path);
+			return 1;
+		}
+		for (size_t i = 0; i < addresses.size(); i++) {
+			if (expected[i].empty())
+				continue;
+			lineChecks++;
+			SymbolImage::SourceLocation location;
+			std::string actual;
+			if (image->LookupLine(addresses[i], location))
+				actual = ShortLocation((std::string(location.path) + ":" + std::to_string(location.line)).c_str());
+			if (actual != expected[i]) {
+				if (failed++ < 10)
+					printf("FAIL %s: %#" PRIx64 " line %s, expected %s\n", path, addresses[i], actual.c_str(), expected[i].c_str());
+			}
+		}
+	}
+
+	printf("%s: %zu symbol checks, %zu line checks, %d failed\n", path, addresses.size(), lineChecks, failed);
+	return failed == 0 ? 0 : 1;
+}
+
+
+int main(int argc, char **argv)
+{
+	int failed = 0;
+	if (argc < 2) {
+		char path[4096];
+		ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+		if (len < 0)
+			return 1;
+		path[len] = '\0';
+		failed += CheckImage(path);
+	}
+	for (int i = 1; i < argc; i++)
+		failed += CheckImage(argv[i]);
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// Measures WaitGraph update time for system with many threads. Each update
+// adds edges of all waiting threads, as sampler does once per interval.
+//
+// usage: WaitGraphBench [thread count] [updates]
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../WaitGraph.h"
+
+
+typedef std::vector<std::pair<int32_t, int32_t>> EdgeList;
+
+// About third of threads wait, mostly for threads with lower IDs so chains
+// are formed. Some waits form small cycles.
+static void MakeEdges(std::mt19937 &random, int32_t threadCount, EdgeList &edges)
+{
+	edges.clear();
+	std::uniform_int_distribution<int32_t> percent(0, 99);
+	for (int32_t thread = 1; thread < threadCount; thread++) {
+		int32_t kind = percent(random);
+		if (kind < 30)
+			edges.emplace_back(thread, std::uniform_int_distribution<int32_t>(0, thread - 1)(random));
+		else if (kind == 30 && thread + 1 < threadCount) {
+			edges.emplace_back(thread, thread + 1);
+			edges.emplace_back(thread + 1, thread);
+		}
+	}
+}
+
+static double Measure(WaitGraph &graph, const EdgeList &edges, int32_t threadCount)
+{
+	auto start = std::chrono::steady_clock::now();
+	graph.BeginUpdate();
+	for (const auto &edge: edges)
+		graph.AddEdge(edge.first, edge.second);
+	graph.EndUpdate();
+	// States are read for every thread.
+	size_t waiting = 0;
+	for (int32_t thread = 0; thread < threadCount; thread++)
+		waiting += graph.StateOf(thread) != WaitGraph::noWaitState;
+	auto end = std::chrono::steady_clock::now();
+	if (waiting == 0)
+		printf("no waiting threads\n");
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+
+int main(int argc, char **argv)
+{
+	int32_t threadCount = argc > 1 ? atoi(argv[1]) : 100000;
+	int32_t updates = argc > 2 ? atoi(argv[2]) : 20;
+	std::mt19937 random(1);
+	WaitGraph graph;
+	EdgeList edges;
+
+	double changedTime = 0, unchangedTime = 0;
+	for (int32_t i = 0; i < updates; i++) {
+		MakeEdges(random, threadCount, edges);
+		changedTime += Measure(graph, edges, threadCount);
+		unchangedTime += Measure(graph, edges, threadCount);
+	}
+	printf("%d threads, %zu edges, %zu cycles, %zu deadlocks\n", threadCount, graph.CountEdges(), graph.Cycles().size(), graph.CountDeadlocks());
+	printf("changed update: %.2f ms\n", changedTime/updates);
+	printf("unchanged update: %.2f ms\n", unchangedTime/updates);
+	return 0;
+}
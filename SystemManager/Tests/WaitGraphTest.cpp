@@ -0,0 +1,139 @@
+// Checks cycle detection and thread states of WaitGraph on synthetic graphs.
+
+#include <stdio.h>
+
+#include <initializer_list>
+#include <utility>
+
+#include "../WaitGraph.h"
+#include "Check.h"
+
+
+static bool Update(WaitGraph &graph, std::initializer_list<std::pair<int32_t, int32_t>> edges)
+{
+	graph.BeginUpdate();
+	for (const auto &edge: edges)
+		graph.AddEdge(edge.first, edge.second);
+	return graph.EndUpdate();
+}
+
+
+static void TestChain()
+{
+	WaitGraph graph;
+	Update(graph, {{1, 2}, {2, 3}});
+	CHECK(graph.CountNodes() == 3);
+	CHECK(graph.Cycles().empty());
+	CHECK(graph.StateOf(1) == WaitGraph::waitState);
+	CHECK(graph.StateOf(2) == WaitGraph::waitState);
+	// Holder at end of chain does not wait.
+	CHECK(graph.StateOf(3) == WaitGraph::noWaitState);
+	CHECK(graph.StateOf(4) == WaitGraph::noWaitState);
+}
+
+static void TestSelfEdge()
+{
+	WaitGraph graph;
+	Update(graph, {{1, 1}});
+	CHECK(graph.CountEdges() == 0);
+	CHECK(graph.Cycles().empty());
+	CHECK(graph.StateOf(1) == WaitGraph::noWaitState);
+}
+
+static void TestConfirmedCycle()
+{
+	WaitGraph graph;
+	CHECK(Update(graph, {{1, 2}, {2, 1}, {3, 1}, {4, 3}}));
+	CHECK(graph.Cycles().size() == 1);
+	// Found once, not confirmed yet.
+	CHECK(graph.CountDeadlocks() == 0);
+	CHECK(graph.StateOf(1) == WaitGraph::waitState);
+	CHECK(graph.StateOf(3) == WaitGraph::waitState);
+
+	// Same edges in other order are not a change.
+	CHECK(!Update(graph, {{4, 3}, {3, 1}, {2, 1}, {1, 2}, {1, 2}}));
+	CHECK(graph.CountDeadlocks() == 1);
+	CHECK(graph.Cycles()[0].age == 2);
+	CHECK(graph.StateOf(1) == WaitGraph::deadlockState);
+	CHECK(graph.StateOf(2) == WaitGraph::deadlockState);
+	// Waiters of cycle are convoyed transitively.
+	CHECK(graph.StateOf(3) == WaitGraph::convoyState);
+	CHECK(graph.StateOf(4) == WaitGraph::convoyState);
+
+	// Cycle survives change of unrelated edges and keeps its age.
+	CHECK(Update(graph, {{1, 2}, {2, 1}, {5, 6}}));
+	CHECK(graph.Cycles().size() == 1);
+	CHECK(graph.Cycles()[0].age == 3);
+	CHECK(graph.StateOf(5) == WaitGraph::waitState);
+	CHECK(graph.StateOf(3) == WaitGraph::noWaitState);
+}
+
+static void TestTransientCycle()
+{
+	WaitGraph graph;
+	Update(graph, {{1, 2}, {2, 1}});
+	CHECK(graph.Cycles().size() == 1);
+	// Cycle seen in one sample only, for example holder released semaphore
+	// between queries, is never reported.
+	Update(graph, {{1, 2}});
+	CHECK(graph.Cycles().empty());
+	CHECK(graph.CountDeadlocks() == 0);
+	Update(graph, {{1, 2}, {2, 1}});
+	CHECK(graph.Cycles()[0].age == 1);
+	CHECK(graph.CountDeadlocks() == 0);
+}
+
+static void TestSeveralCycles()
+{
+	WaitGraph graph;
+	for (int i = 0; i < 2; i++)
+		Update(graph, {{1, 2}, {2, 3}, {3, 1}, {10, 11}, {11, 10}, {20, 10}, {21, 20}, {30, 31}});
+	CHECK(graph.Cycles().size() == 2);
+	CHECK(graph.CountDeadlocks() == 2);
+	CHECK(graph.Cycles()[0].nodes.size() + graph.Cycles()[1].nodes.size() == 5);
+	CHECK(graph.StateOf(3) == WaitGraph::deadlockState);
+	CHECK(graph.StateOf(21) == WaitGraph::convoyState);
+	CHECK(graph.StateOf(30) == WaitGraph::waitState);
+}
+
+static void TestLongChain()
+{
+	// Deep enough to overflow stack with recursive search.
+	WaitGraph graph;
+	for (int i = 0; i < 2; i++) {
+		graph.BeginUpdate();
+		for (int32_t node = 0; node < 1000000; node++)
+			graph.AddEdge(node, node + 1);
+		graph.AddEdge(1000000, 999990);
+		graph.EndUpdate();
+	}
+	CHECK(graph.Cycles().size() == 1);
+	CHECK(graph.Cycles()[0].nodes.size() == 11);
+	CHECK(graph.StateOf(0) == WaitGraph::convoyState);
+	CHECK(graph.StateOf(999995) == WaitGraph::deadlockState);
+}
+
+static void TestClear()
+{
+	WaitGraph graph;
+	Update(graph, {{1, 2}, {2, 1}});
+	Update(graph, {{1, 2}, {2, 1}});
+	graph.Clear();
+	CHECK(graph.CountDeadlocks() == 0);
+	CHECK(graph.StateOf(1) == WaitGraph::noWaitState);
+	Update(graph, {{1, 2}, {2, 1}});
+	CHECK(graph.CountDeadlocks() == 0);
+}
+
+
+int main()
+{
+	TestChain();
+	TestSelfEdge();
+	TestConfirmedCycle();
+	TestTransientCycle();
+	TestSeveralCycles();
+	TestLongChain();
+	TestClear();
+	return ReportChecks("WaitGraphTest");
+}
@@ -2,8 +2,12 @@
 
 #include <stdio.h>
 
+#include <algorithm>
 
-IconStringField::IconStringField(BBitmap *icon, const char *string):
+#include "Utils.h"
+
+
+IconStringField::IconStringField(IconCache::Icon *icon, const char *string):
 	BStringField(string), fIcon(icon)
 {}
 
@@ -39,6 +43,37 @@ bool IconStringColumn::AcceptsField(const BField* field) const
 }
 
 
+HighlightStringField::HighlightStringField(const char *string, bool highlight):
+	BStringField(string), fHighlight(highlight)
+{}
+
+
+HighlightStringColumn::HighlightStringColumn(
+	const char* title, float width,
+	float minWidth, float maxWidth, uint32 truncate,
+	alignment align
+): BStringColumn(title, width, minWidth, maxWidth, truncate, align)
+{}
+
+void HighlightStringColumn::DrawField(BField* _field, BRect rect, BView* parent)
+{
+	HighlightStringField *field = dynamic_cast<HighlightStringField*>(_field);
+	if (field == NULL || !field->Highlight()) {
+		BStringColumn::DrawField(_field, rect, parent);
+		return;
+	}
+	parent->PushState();
+	parent->SetHighColor(ui_color(B_FAILURE_COLOR));
+	BStringColumn::DrawField(_field, rect, parent);
+	parent->PopState();
+}
+
+bool HighlightStringColumn::AcceptsField(const BField* field) const
+{
+	return dynamic_cast<const BStringField*>(field) != NULL;
+}
+
+
 HexIntegerColumn::HexIntegerColumn(
 	const char* title,
 	float width, float minWidth, float maxWidth,
@@ -93,3 +128,155 @@ int64 Int64Field::Value()
 {
 	return fValue;
 }
+
+
+FloatField::FloatField(float value): fValue(value)
+{
+}
+
+
+void FloatField::SetValue(float value)
+{
+	fValue = value;
+}
+
+
+float FloatField::Value()
+{
+	return fValue;
+}
+
+
+PercentColumn::PercentColumn(
+	const char* title,
+	float width, float minWidth, float maxWidth,
+	alignment align
+): BTitledColumn(title, width, minWidth, maxWidth, align)
+{}
+
+void PercentColumn::DrawField(BField *field, BRect rect, BView* parent)
+{
+	float width = rect.Width() - (2 * 8);
+	BString string;
+	string.SetToFormat("%.1f%%", ((FloatField*)field)->Value());
+	parent->TruncateString(&string, B_TRUNCATE_END, width + 2);
+	DrawString(string.String(), parent, rect);
+}
+
+int PercentColumn::CompareFields(BField *field1, BField *field2)
+{
+	float value1 = ((FloatField*)field1)->Value();
+	float value2 = ((FloatField*)field2)->Value();
+	if (value1 == value2)
+		return 0;
+	else if (value1 > value2)
+		return 1;
+	else
+		return -1;
+}
+
+
+SizeDeltaColumn::SizeDeltaColumn(
+	const char* title,
+	float width, float minWidth, float maxWidth,
+	alignment align
+): BTitledColumn(title, width, minWidth, maxWidth, align)
+{}
+
+void SizeDeltaColumn::DrawField(BField *field, BRect rect, BView* parent)
+{
+	float width = rect.Width() - (2 * 8);
+	int64 value = ((Int64Field*)field)->Value();
+	BString string, size;
+	if (value != 0) {
+		GetSizeString(size, value < 0 ? -value : value);
+		string.SetToFormat("%c%s", value < 0 ? '-' : '+', size.String());
+	}
+	parent->TruncateString(&string, B_TRUNCATE_END, width + 2);
+	DrawString(string.String(), parent, rect);
+}
+
+int SizeDeltaColumn::CompareFields(BField *field1, BField *field2)
+{
+	int64 value1 = ((Int64Field*)field1)->Value();
+	int64 value2 = ((Int64Field*)field2)->Value();
+	if (value1 == value2)
+		return 0;
+	else if (value1 > value2)
+		return 1;
+	else
+		return -1;
+}
+
+
+SparklineField::SparklineField(double maxValue): fMaxValue(maxValue)
+{
+}
+
+
+bool SparklineField::SetValues(const std::vector<double> &values)
+{
+	if (fValues == values)
+		return false;
+	fValues = values;
+	return true;
+}
+
+
+SparklineColumn::SparklineColumn(
+	const char* title,
+	float width, float minWidth, float maxWidth
+): BTitledColumn(title, width, minWidth, maxWidth)
+{}
+
+void SparklineColumn::DrawField(BField *_field, BRect rect, BView* parent)
+{
+	SparklineField *field = (SparklineField*)_field;
+	const std::vector<double> &values = field->Values();
+	rect.InsetBy(4, 2);
+	if (!rect.IsValid())
+		return;
+
+	// Draw only values that fit into one pixel per sample.
+	size_t count = std::min<size_t>(values.size(), (size_t)rect.Width() + 1);
+	if (count < 2)
+		return;
+	size_t first = values.size() - count;
+
+	double maxValue = field->MaxValue();
+	if (maxValue <= 0) {
+		maxValue = *std::max_element(values.begin() + first, values.end());
+		if (maxValue <= 0)
+			maxValue = 1;
+	}
+
+	std::vector<BPoint> points(count);
+	for (size_t i = 0; i < count; i++) {
+		double value = std::min(std::max(values[first + i], 0.0), maxValue);
+		points[i].Set(rect.right - (count - 1 - i), rect.bottom - (float)(value/maxValue*rect.Height()));
+	}
+
+	parent->PushState();
+	parent->SetHighColor(ui_color(B_CONTROL_HIGHLIGHT_COLOR));
+	parent->StrokePolygon(points.data(), count, false);
+	parent->PopState();
+}
+
+int SparklineColumn::CompareFields(BField *field1, BField *field2)
+{
+	const std::vector<double> &values1 = ((SparklineField*)field1)->Values();
+	const std::vector<double> &values2 = ((SparklineField*)field2)->Values();
+	double value1 = values1.empty() ? 0 : values1.back();
+	double value2 = values2.empty() ? 0 : values2.back();
+	if (value1 == value2)
+		return 0;
+	else if (value1 > value2)
+		return 1;
+	else
+		return -1;
+}
+
+bool SparklineColumn::AcceptsField(const BField* field) const
+{
+	return dynamic_cast<const SparklineField*>(field) != NULL;
+}
@@ -6,17 +6,21 @@
 #include <private/interface/ColumnTypes.h>
 #include <private/shared/AutoDeleter.h>
 
+#include <vector>
+
+#include "IconCache.h"
+
 
 class IconStringField: public BStringField
 {
 private:
-	ObjectDeleter<BBitmap> fIcon;
+	BReference<IconCache::Icon> fIcon;
 
 public:
-	IconStringField(BBitmap *icon = NULL, const char *string = "");
-	inline BBitmap *Icon() {return fIcon.Get();}
+	IconStringField(IconCache::Icon *icon = NULL, const char *string = "");
+	inline BBitmap *Icon() {return fIcon->Bitmap();}
 
-	inline void SetIcon(BBitmap *icon) {fIcon.SetTo(icon);}
+	inline void SetIcon(IconCache::Icon *icon) {fIcon.SetTo(icon);}
 };
 
 class IconStringColumn: public BStringColumn
@@ -33,6 +37,32 @@ public:
 	bool AcceptsField(const BField* field) const final;
 };
 
+class HighlightStringField: public BStringField
+{
+private:
+	bool fHighlight;
+
+public:
+	HighlightStringField(const char *string = "", bool highlight = false);
+	bool Highlight() const {return fHighlight;}
+	void SetHighlight(bool highlight) {fHighlight = highlight;}
+};
+
+// Highlighted fields are drawn in failure color, plain string fields are
+// also accepted.
+class HighlightStringColumn: public BStringColumn
+{
+public:
+	HighlightStringColumn(
+		const char* title, float width,
+		float minWidth, float maxWidth, uint32 truncate,
+		alignment align = B_ALIGN_LEFT
+	);
+
+	void DrawField(BField* field, BRect rect, BView* parent) final;
+	bool AcceptsField(const BField* field) const final;
+};
+
 class HexIntegerColumn: public BTitledColumn
 {
 public:
@@ -57,5 +87,71 @@ private:
 	int64 fValue;
 };
 
+class FloatField: public BField
+{
+public:
+	FloatField(float value);
+	void SetValue(float value);
+	float Value();
+
+private:
+	float fValue;
+};
+
+class PercentColumn: public BTitledColumn
+{
+public:
+	PercentColumn(
+		const char* title,
+		float width, float minWidth, float maxWidth,
+		alignment align = B_ALIGN_RIGHT
+	);
+
+	void DrawField(BField *field, BRect rect, BView* parent);
+	int CompareFields(BField *field1, BField *field2);
+};
+
+// Signed size change of Int64Field, positive values are drawn with '+'.
+class SizeDeltaColumn: public BTitledColumn
+{
+public:
+	SizeDeltaColumn(
+		const char* title,
+		float width, float minWidth, float maxWidth,
+		alignment align = B_ALIGN_RIGHT
+	);
+
+	void DrawField(BField *field, BRect rect, BView* parent);
+	int CompareFields(BField *field1, BField *field2);
+};
+
+class SparklineField: public BField
+{
+public:
+	// maxValue 0 means scaling to maximum of values.
+	SparklineField(double maxValue = 0);
+	// Returns true if values changed.
+	bool SetValues(const std::vector<double> &values);
+	const std::vector<double> &Values() {return fValues;}
+	double MaxValue() {return fMaxValue;}
+
+private:
+	std::vector<double> fValues;
+	double fMaxValue;
+};
+
+class SparklineColumn: public BTitledColumn
+{
+public:
+	SparklineColumn(
+		const char* title,
+		float width, float minWidth, float maxWidth
+	);
+
+	void DrawField(BField *field, BRect rect, BView* parent);
+	int CompareFields(BField *field1, BField *field2);
+	bool AcceptsField(const BField* field) const;
+};
+
 
 #endif	// _UIUTILS_H_
@@ -0,0 +1,224 @@
+#include "WaitGraph.h"
+
+#include <algorithm>
+#include <map>
+
+
+WaitGraph::WaitGraph():
+	fDeadlockCount(0)
+{}
+
+
+void WaitGraph::Clear()
+{
+	fEdges.clear();
+	fPrevEdges.clear();
+	fNodes.clear();
+	fNodeIndex.clear();
+	fEdgeStart.clear();
+	fEdgeTargets.clear();
+	fCycles.clear();
+	fStates.clear();
+	fDeadlockCount = 0;
+}
+
+
+void WaitGraph::BeginUpdate()
+{
+	fEdges.clear();
+}
+
+void WaitGraph::AddEdge(int32_t waiter, int32_t holder)
+{
+	// Waiting for object acquired by itself is not a cycle, semaphore
+	// can be acquired repeatedly by the same thread.
+	if (waiter == holder)
+		return;
+	fEdges.push_back(Edge(waiter, holder));
+}
+
+bool WaitGraph::EndUpdate()
+{
+	std::sort(fEdges.begin(), fEdges.end());
+	fEdges.erase(std::unique(fEdges.begin(), fEdges.end()), fEdges.end());
+
+	bool changed = fEdges != fPrevEdges;
+	if (changed) {
+		fPrevEdges.swap(fEdges);
+		BuildAdjacency();
+
+		std::vector<Cycle> cycles;
+		FindCycles(cycles);
+		std::map<std::vector<int32_t>, uint32_t> prevAges;
+		for (Cycle &cycle: fCycles)
+			prevAges[cycle.nodes] = cycle.age;
+		for (Cycle &cycle: cycles) {
+			auto it = prevAges.find(cycle.nodes);
+			cycle.age = (it != prevAges.end() ? it->second : 0) + 1;
+		}
+		fCycles.swap(cycles);
+	} else {
+		for (Cycle &cycle: fCycles)
+			cycle.age++;
+	}
+	ComputeStates();
+	return changed;
+}
+
+
+void WaitGraph::BuildAdjacency()
+{
+	fNodes.clear();
+	fNodeIndex.clear();
+	for (const Edge &edge: fPrevEdges) {
+		fNodes.push_back(edge.first);
+		fNodes.push_back(edge.second);
+	}
+	std::sort(fNodes.begin(), fNodes.end());
+	fNodes.erase(std::unique(fNodes.begin(), fNodes.end()), fNodes.end());
+	fNodeIndex.reserve(fNodes.size());
+	for (uint32_t i = 0; i < fNodes.size(); i++)
+		fNodeIndex[fNodes[i]] = i;
+
+	// Edges are sorted by waiter, so targets of each node are contiguous.
+	fEdgeStart.assign(fNodes.size() + 1, 0);
+	fEdgeTargets.resize(fPrevEdges.size());
+	for (size_t i = 0; i < fPrevEdges.size(); i++) {
+		fEdgeStart[fNodeIndex[fPrevEdges[i].first] + 1]++;
+		fEdgeTargets[i] = fNodeIndex[fPrevEdges[i].second];
+	}
+	for (size_t i = 0; i < fNodes.size(); i++)
+		fEdgeStart[i + 1] += fEdgeStart[i];
+}
+
+
+// Tarjan's algorithm with explicit stack, wait chains can be long enough to
+// overflow thread stack if recursion is used.
+void WaitGraph::FindCycles(std::vector<Cycle> &cycles)
+{
+	enum {
+		kUnvisited = UINT32_MAX,
+	};
+
+	struct Frame {
+		uint32_t node;
+		uint32_t edge;
+	};
+
+	size_t nodeCount = fNodes.size();
+	std::vector<uint32_t> index(nodeCount, kUnvisited);
+	std::vector<uint32_t> lowLink(nodeCount, 0);
+	std::vector<bool> onStack(nodeCount, false);
+	std::vector<uint32_t> stack;
+	std::vector<Frame> callStack;
+	uint32_t nextIndex = 0;
+
+	for (uint32_t root = 0; root < nodeCount; root++) {
+		if (index[root] != kUnvisited)
+			continue;
+		callStack.push_back({root, fEdgeStart[root]});
+		index[root] = lowLink[root] = nextIndex++;
+		stack.push_back(root);
+		onStack[root] = true;
+
+		while (!callStack.empty()) {
+			Frame &frame = callStack.back();
+			uint32_t node = frame.node;
+			if (frame.edge < fEdgeStart[node + 1]) {
+				uint32_t target = fEdgeTargets[frame.edge++];
+				if (index[target] == kUnvisited) {
+					index[target] = lowLink[target] = nextIndex++;
+					stack.push_back(target);
+					onStack[target] = true;
+					// frame reference is invalidated here.
+					callStack.push_back({target, fEdgeStart[target]});
+				} else if (onStack[target])
+					lowLink[node] = std::min(lowLink[node], index[target]);
+				continue;
+			}
+
+			callStack.pop_back();
+			if (!callStack.empty()) {
+				uint32_t parent = callStack.back().node;
+				lowLink[parent] = std::min(lowLink[parent], lowLink[node]);
+			}
+			if (lowLink[node] != index[node])
+				continue;
+
+			Cycle cycle;
+			uint32_t member;
+			do {
+				member = stack.back();
+				stack.pop_back();
+				onStack[member] = false;
+				cycle.nodes.push_back(fNodes[member]);
+			} while (member != node);
+			// Self loops are not added, so single node is never a cycle.
+			if (cycle.nodes.size() > 1) {
+				std::sort(cycle.nodes.begin(), cycle.nodes.end());
+				cycle.age = 0;
+				cycles.push_back(std::move(cycle));
+			}
+		}
+	}
+}
+
+
+void WaitGraph::ComputeStates()
+{
+	size_t nodeCount = fNodes.size();
+	fStates.assign(nodeCount, noWaitState);
+	for (uint32_t i = 0; i < nodeCount; i++) {
+		if (fEdgeStart[i + 1] > fEdgeStart[i])
+			fStates[i] = waitState;
+	}
+
+	std::vector<uint32_t> queue;
+	fDeadlockCount = 0;
+	for (const Cycle &cycle: fCycles) {
+		if (cycle.age < kConfirmUpdates)
+			continue;
+		fDeadlockCount++;
+		for (int32_t id: cycle.nodes) {
+			uint32_t node = fNodeIndex[id];
+			fStates[node] = deadlockState;
+			queue.push_back(node);
+		}
+	}
+	if (queue.empty())
+		return;
+
+	// Walk edges backwards from deadlocked threads to find their waiters.
+	std::vector<uint32_t> reverseStart(nodeCount + 1, 0);
+	std::vector<uint32_t> reverseSources(fEdgeTargets.size());
+	for (uint32_t target: fEdgeTargets)
+		reverseStart[target + 1]++;
+	for (size_t i = 0; i < nodeCount; i++)
+		reverseStart[i + 1] += reverseStart[i];
+	std::vector<uint32_t> fill(reverseStart.begin(), reverseStart.end() - 1);
+	for (uint32_t node = 0; node < nodeCount; node++) {
+		for (uint32_t edge = fEdgeStart[node]; edge < fEdgeStart[node + 1]; edge++)
+			reverseSources[fill[fEdgeTargets[edge]]++] = node;
+	}
+
+	while (!queue.empty()) {
+		uint32_t node = queue.back();
+		queue.pop_back();
+		for (uint32_t edge = reverseStart[node]; edge < reverseStart[node + 1]; edge++) {
+			uint32_t waiter = reverseSources[edge];
+			if (fStates[waiter] == waitState) {
+				fStates[waiter] = convoyState;
+				queue.push_back(waiter);
+			}
+		}
+	}
+}
+
+
+WaitGraph::State WaitGraph::StateOf(int32_t node) const
+{
+	auto it = fNodeIndex.find(node);
+	if (it == fNodeIndex.end())
+		return noWaitState;
+	return (State)fStates[it->second];
+}
@@ -0,0 +1,84 @@
+#ifndef _WAITGRAPH_H_
+#define _WAITGRAPH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+#include <unordered_map>
+
+
+// Graph of threads waiting for other threads. Edge waiter -> holder means
+// that waiter is blocked on object that holder is assumed to own, caller
+// decides which holders are reliable enough. Strongly
+// connected components with more than one node are wait cycles. Cycle is
+// reported as deadlock when it is found in kConfirmUpdates consecutive
+// updates, this filters out cycles that come from non-atomic sampling.
+// Threads that are not in deadlock but transitively wait for it are
+// convoyed.
+//
+// Graph is rebuilt on each update. Components are searched again only when
+// edge set has changed, otherwise ages of known cycles are incremented.
+class WaitGraph
+{
+public:
+	enum State {
+		noWaitState,
+		waitState,
+		convoyState,
+		deadlockState,
+	};
+
+	enum {
+		kConfirmUpdates = 2,
+	};
+
+	struct Cycle {
+		// Sorted node IDs.
+		std::vector<int32_t> nodes;
+		// Number of consecutive updates where cycle was found.
+		uint32_t age;
+	};
+
+private:
+	typedef std::pair<int32_t, int32_t> Edge;
+
+	std::vector<Edge> fEdges;
+	std::vector<Edge> fPrevEdges;
+
+	// Dense node numbering and adjacency in compressed row form.
+	std::vector<int32_t> fNodes;
+	std::unordered_map<int32_t, uint32_t> fNodeIndex;
+	std::vector<uint32_t> fEdgeStart;
+	std::vector<uint32_t> fEdgeTargets;
+
+	std::vector<Cycle> fCycles;
+	std::vector<uint8_t> fStates;
+	size_t fDeadlockCount;
+
+	void BuildAdjacency();
+	void FindCycles(std::vector<Cycle> &cycles);
+	void ComputeStates();
+
+public:
+	WaitGraph();
+
+	void Clear();
+
+	void BeginUpdate();
+	void AddEdge(int32_t waiter, int32_t holder);
+	// Returns true if edge set changed and cycles were searched again.
+	bool EndUpdate();
+
+	State StateOf(int32_t node) const;
+	size_t CountNodes() const {return fNodes.size();}
+	size_t CountEdges() const {return fPrevEdges.size();}
+
+	// All wait cycles including not yet confirmed ones.
+	const std::vector<Cycle> &Cycles() const {return fCycles;}
+	size_t CountDeadlocks() const {return fDeadlockCount;}
+};
+
+
+#endif	// _WAITGRAPH_H_
@@ -0,0 +1,171 @@
+#include "AsyncScripting.h"
+
+#include <private/app/MessagePrivate.h>
+#include <private/app/MessengerPrivate.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+
+AsyncScripting::AsyncScripting(bigtime_t timeout):
+	fNextToken(0),
+	fTimeout(timeout)
+{
+	thread_info info;
+	get_thread_info(find_thread(NULL), &info);
+	fTeam = info.team;
+	fPort = create_port(kPortCapacity, "scripting replies");
+}
+
+AsyncScripting::~AsyncScripting()
+{
+	if (fPort >= B_OK)
+		delete_port(fPort);
+}
+
+
+AsyncScripting::Group &AsyncScripting::GetGroup(int32 group)
+{
+	auto it = fGroups.find(group);
+	if (it != fGroups.end())
+		return it->second;
+	Group &newGroup = fGroups[group];
+	newGroup.deadline = system_time() + fTimeout;
+	newGroup.inFlight = 0;
+	return newGroup;
+}
+
+void AsyncScripting::Send(int32 group, const BMessenger &obj, const BMessage &spec, ReplyHandler handler)
+{
+	GetGroup(group).queue.push_back({group, obj, spec, handler});
+}
+
+
+// Returns true if some message can't be sent now because target port is
+// full.
+bool AsyncScripting::Flush()
+{
+	bool blocked = false;
+	BMessage empty;
+	for (auto &it: fGroups) {
+		Group &group = it.second;
+		while (!group.queue.empty() && group.inFlight < kMaxInFlight && fPending.size() < kPortCapacity) {
+			Request request = std::move(group.queue.front());
+			group.queue.pop_front();
+
+			// Token is never negative, so it does not clash with B_NULL_TOKEN
+			// and B_PREFERRED_TOKEN.
+			int32 token = fNextToken;
+			fNextToken = (fNextToken + 1) & INT32_MAX;
+			BMessenger replyTo;
+			BMessenger::Private(replyTo).SetTo(fTeam, fPort, token);
+
+			status_t res = request.obj.SendMessage(&request.spec, replyTo, 0);
+			if (res == B_WOULD_BLOCK) {
+				group.queue.push_front(std::move(request));
+				blocked = true;
+				break;
+			}
+			if (res < B_OK) {
+				request.handler(res, empty);
+				continue;
+			}
+			group.inFlight++;
+			fPending[token] = std::move(request);
+		}
+	}
+	return blocked;
+}
+
+void AsyncScripting::Expire(bigtime_t time)
+{
+	BMessage empty;
+	std::vector<int32> tokens;
+	for (auto &it: fPending) {
+		if (fGroups[it.second.group].deadline <= time)
+			tokens.push_back(it.first);
+	}
+	for (int32 token: tokens) {
+		auto it = fPending.find(token);
+		Request request = std::move(it->second);
+		fPending.erase(it);
+		fGroups[request.group].inFlight--;
+		request.handler(B_TIMED_OUT, empty);
+	}
+
+	// Handlers can queue more requests to expired group, so the queue is
+	// drained until it is empty.
+	for (auto &it: fGroups) {
+		Group &group = it.second;
+		if (group.deadline > time)
+			continue;
+		while (!group.queue.empty()) {
+			Request request = std::move(group.queue.front());
+			group.queue.pop_front();
+			request.handler(B_TIMED_OUT, empty);
+		}
+	}
+}
+
+void AsyncScripting::Dispatch(const void *buffer)
+{
+	BMessage reply;
+	if (reply.Unflatten((const char*)buffer) < B_OK)
+		return;
+	// Replies to timed out requests are ignored.
+	auto it = fPending.find(BMessage::Private(reply).GetTarget());
+	if (it == fPending.end())
+		return;
+	Request request = std::move(it->second);
+	fPending.erase(it);
+	fGroups[request.group].inFlight--;
+	request.handler(B_OK, reply);
+}
+
+
+void AsyncScripting::Run()
+{
+	void *buffer = NULL;
+	ssize_t bufferSize = 0;
+	for (;;) {
+		bigtime_t time = system_time();
+		Expire(time);
+		bool blocked = Flush();
+
+		bigtime_t deadline = B_INFINITE_TIMEOUT;
+		bool done = fPending.empty();
+		for (auto &it: fGroups) {
+			if (it.second.inFlight > 0 || !it.second.queue.empty()) {
+				deadline = std::min(deadline, it.second.deadline);
+				done = false;
+			}
+		}
+		if (done)
+			break;
+		if (blocked)
+			deadline = std::min(deadline, time + kRetryDelay);
+
+		ssize_t size = port_buffer_size_etc(fPort, B_ABSOLUTE_TIMEOUT, deadline);
+		if (size == B_TIMED_OUT || size == B_INTERRUPTED)
+			continue;
+		if (size < B_OK) {
+			printf("[!] AsyncScripting: can't read reply port, error: %s\n", strerror(size));
+			Expire(B_INFINITE_TIMEOUT);
+			break;
+		}
+		if (size > bufferSize) {
+			free(buffer);
+			buffer = malloc(size);
+			bufferSize = size;
+		}
+		int32 code;
+		if (read_port(fPort, &code, buffer, size) < B_OK)
+			continue;
+		Dispatch(buffer);
+	}
+	free(buffer);
+}
@@ -0,0 +1,69 @@
+#ifndef _ASYNCSCRIPTING_H_
+#define _ASYNCSCRIPTING_H_
+
+#include <OS.h>
+#include <Message.h>
+#include <Messenger.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+
+// Sends scripting messages without waiting for replies. Replies of all
+// requests are received on one port and matched to requests by reply
+// target token. Requests are grouped by target application, each group has
+// its own deadline and limit of requests in flight, so one hung application
+// does not delay others.
+class AsyncScripting
+{
+public:
+	typedef std::function<void(status_t res, BMessage &reply)> ReplyHandler;
+
+private:
+	enum {
+		kPortCapacity = 1024,
+		kMaxInFlight = 64,
+		kRetryDelay = 10000,
+	};
+
+	struct Request {
+		int32 group;
+		BMessenger obj;
+		BMessage spec;
+		ReplyHandler handler;
+	};
+
+	struct Group {
+		bigtime_t deadline;
+		int32 inFlight;
+		std::deque<Request> queue;
+	};
+
+	port_id fPort;
+	team_id fTeam;
+	int32 fNextToken;
+	bigtime_t fTimeout;
+	std::map<int32, Group> fGroups;
+	std::unordered_map<int32, Request> fPending;
+
+	Group &GetGroup(int32 group);
+	bool Flush();
+	void Expire(bigtime_t time);
+	void Dispatch(const void *buffer);
+
+public:
+	AsyncScripting(bigtime_t timeout);
+	~AsyncScripting();
+	status_t InitCheck() {return fPort < B_OK ? fPort : B_OK;}
+
+	// Handler is called from Run() with B_OK and reply or with error and
+	// empty message. Handlers can send new requests.
+	void Send(int32 group, const BMessenger &obj, const BMessage &spec, ReplyHandler handler);
+	// Processes replies until all requests are completed or timed out.
+	void Run();
+};
+
+
+#endif	// _ASYNCSCRIPTING_H_
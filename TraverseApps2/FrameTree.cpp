@@ -0,0 +1,274 @@
+#include "FrameTree.h"
+
+#include <private/app/MessengerPrivate.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+
+// Visible frames are flattened in paint order with rectangles clipped by
+// ancestors, so the topmost frame under point is the hit with the largest
+// index. Hits are found with bounding volume hierarchy over clipped
+// rectangles.
+class FrameIndex
+{
+private:
+	enum {
+		kLeafSize = 4,
+	};
+
+	// Inner node has count == 0, its left child follows it.
+	struct Node {
+		BRect bounds;
+		uint32 first;
+		uint32 count;
+		uint32 right;
+	};
+
+	std::vector<FrameTree*> fItems;
+	std::vector<BRect> fRects;
+	std::vector<uint32> fOrder;
+	std::vector<Node> fNodes;
+
+	void Collect(FrameTree *frame, BRect clip);
+	uint32 BuildNode(uint32 first, uint32 count);
+
+public:
+	std::unordered_map<uint64, FrameTree*> objects;
+	bool valid;
+
+	FrameIndex(): valid(false) {}
+
+	static uint64 Key(const BMessenger &obj);
+	void Build(FrameTree *root);
+	FrameTree *Find(BPoint pos);
+};
+
+
+uint64 FrameIndex::Key(const BMessenger &obj)
+{
+	BMessenger::Private objPrivate((BMessenger&)obj);
+	return (uint64)(uint32)objPrivate.Team() << 32 | (uint32)objPrivate.Token();
+}
+
+
+void FrameIndex::Collect(FrameTree *frame, BRect clip)
+{
+	if (!frame->visible)
+		return;
+	BRect rect = frame->rect & clip;
+	if (!rect.IsValid())
+		return;
+	fItems.push_back(frame);
+	fRects.push_back(rect);
+	for (FrameTree *subFrame: frame->frames)
+		Collect(subFrame, rect);
+}
+
+uint32 FrameIndex::BuildNode(uint32 first, uint32 count)
+{
+	uint32 nodeIdx = fNodes.size();
+	fNodes.push_back({fRects[fOrder[first]], first, count, 0});
+	BRect bounds = fRects[fOrder[first]];
+	BRect centers(bounds.LeftTop(), bounds.LeftTop());
+	for (uint32 i = first; i < first + count; i++) {
+		const BRect &rect = fRects[fOrder[i]];
+		bounds = bounds | rect;
+		BPoint center((rect.left + rect.right)/2, (rect.top + rect.bottom)/2);
+		centers = centers | BRect(center, center);
+	}
+	fNodes[nodeIdx].bounds = bounds;
+	if (count <= kLeafSize)
+		return nodeIdx;
+
+	// Split by median of centers along longest axis.
+	bool vertical = centers.Height() > centers.Width();
+	uint32 half = count/2;
+	std::nth_element(fOrder.begin() + first, fOrder.begin() + first + half, fOrder.begin() + first + count, [this, vertical](uint32 a, uint32 b) {
+		const BRect &ra = fRects[a], &rb = fRects[b];
+		return vertical ? ra.top + ra.bottom < rb.top + rb.bottom : ra.left + ra.right < rb.left + rb.right;
+	});
+	fNodes[nodeIdx].count = 0;
+	BuildNode(first, half);
+	uint32 right = BuildNode(first + half, count - half);
+	fNodes[nodeIdx].right = right;
+	return nodeIdx;
+}
+
+void FrameIndex::Build(FrameTree *root)
+{
+	fItems.clear();
+	fRects.clear();
+	fNodes.clear();
+	Collect(root, root->rect);
+	fOrder.resize(fItems.size());
+	for (uint32 i = 0; i < fOrder.size(); i++)
+		fOrder[i] = i;
+	if (!fItems.empty())
+		BuildNode(0, fItems.size());
+	valid = true;
+}
+
+FrameTree *FrameIndex::Find(BPoint pos)
+{
+	if (fNodes.empty())
+		return NULL;
+	int32 best = -1;
+	uint32 stack[64];
+	int32 stackLen = 0;
+	stack[stackLen++] = 0;
+	while (stackLen > 0) {
+		const Node &node = fNodes[stack[--stackLen]];
+		if (!node.bounds.Contains(pos))
+			continue;
+		if (node.count == 0) {
+			stack[stackLen++] = &node - fNodes.data() + 1;
+			stack[stackLen++] = node.right;
+			continue;
+		}
+		for (uint32 i = node.first; i < node.first + node.count; i++) {
+			int32 item = fOrder[i];
+			if (item > best && fRects[item].Contains(pos))
+				best = item;
+		}
+	}
+	return best < 0 ? NULL : fItems[best];
+}
+
+
+FrameTree::FrameTree(const BMessenger &obj, BRect rect, bool visible):
+	fParent(NULL), fIndex(NULL), obj(obj), rect(rect), offset(0, 0), visible(visible)
+{
+}
+
+FrameTree::~FrameTree()
+{
+	for (FrameTree *frame: frames)
+		delete frame;
+	delete fIndex;
+}
+
+
+FrameTree *FrameTree::Root()
+{
+	FrameTree *root = this;
+	while (root->fParent != NULL)
+		root = root->fParent;
+	return root;
+}
+
+FrameIndex *FrameTree::Index()
+{
+	if (fIndex == NULL) {
+		fIndex = new FrameIndex();
+		AddObjects(fIndex);
+	}
+	return fIndex;
+}
+
+void FrameTree::AddObjects(FrameIndex *index)
+{
+	index->objects.emplace(FrameIndex::Key(obj), this);
+	for (FrameTree *frame: frames)
+		frame->AddObjects(index);
+}
+
+void FrameTree::RemoveObjects(FrameIndex *index)
+{
+	auto it = index->objects.find(FrameIndex::Key(obj));
+	if (it != index->objects.end() && it->second == this)
+		index->objects.erase(it);
+	for (FrameTree *frame: frames)
+		frame->RemoveObjects(index);
+}
+
+void FrameTree::Changed()
+{
+	FrameTree *root = Root();
+	if (root->fIndex != NULL)
+		root->fIndex->valid = false;
+}
+
+
+void FrameTree::Clear()
+{
+	FrameIndex *index = Root()->fIndex;
+	for (FrameTree *frame: frames) {
+		if (index != NULL)
+			frame->RemoveObjects(index);
+		delete frame;
+	}
+	frames.clear();
+	Changed();
+}
+
+void FrameTree::Insert(FrameTree *frame)
+{
+	frame->fParent = this;
+	frames.push_back(frame);
+	FrameIndex *index = Root()->fIndex;
+	if (index != NULL)
+		frame->AddObjects(index);
+	Changed();
+}
+
+FrameTree *FrameTree::Remove(FrameTree *frame)
+{
+	std::vector<FrameTree*>::iterator it = std::find(frames.begin(), frames.end(), frame);
+	if (it == frames.end())
+		return NULL;
+	frames.erase(it);
+	FrameIndex *index = Root()->fIndex;
+	if (index != NULL)
+		frame->RemoveObjects(index);
+	frame->fParent = NULL;
+	Changed();
+	return frame;
+}
+
+
+FrameTree *FrameTree::FindThis(BPoint pos)
+{
+	if (!visible || !rect.Contains(pos))
+		return NULL;
+	for (std::vector<FrameTree*>::reverse_iterator it = frames.rbegin(); it != frames.rend(); ++it) {
+		FrameTree *subFrame = (*it)->FindThis(pos);
+		if (subFrame != NULL)
+			return subFrame;
+	}
+	return this;
+}
+
+FrameTree *FrameTree::FindThisObject(const BMessenger &_obj)
+{
+	if (obj == _obj)
+		return this;
+	for (FrameTree *frame: frames) {
+		FrameTree *subFrame = frame->FindThisObject(_obj);
+		if (subFrame != NULL)
+			return subFrame;
+	}
+	return NULL;
+}
+
+// Subtrees are searched directly, only root keeps index.
+FrameTree *FrameTree::This(BPoint pos)
+{
+	if (fParent != NULL)
+		return FindThis(pos);
+	FrameIndex *index = Index();
+	if (!index->valid)
+		index->Build(this);
+	return index->Find(pos);
+}
+
+FrameTree *FrameTree::ThisObject(const BMessenger &_obj)
+{
+	if (fParent != NULL)
+		return FindThisObject(_obj);
+	FrameIndex *index = Index();
+	auto it = index->objects.find(FrameIndex::Key(_obj));
+	if (it == index->objects.end())
+		return NULL;
+	return it->second;
+}
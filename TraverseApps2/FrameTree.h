@@ -0,0 +1,51 @@
+#ifndef _FRAMETREE_H_
+#define _FRAMETREE_H_
+
+#include <Messenger.h>
+#include <Rect.h>
+
+#include <vector>
+
+
+class FrameIndex;
+
+// Screen rectangles of windows and views. Root node keeps index for point
+// and object queries: object map is updated on each Insert/Remove, spatial
+// index is rebuilt on first point query after tree was changed.
+class FrameTree
+{
+private:
+	FrameTree *fParent;
+	FrameIndex *fIndex;
+
+	FrameTree *Root();
+	FrameIndex *Index();
+	void AddObjects(FrameIndex *index);
+	void RemoveObjects(FrameIndex *index);
+	void Changed();
+
+	FrameTree *FindThis(BPoint pos);
+	FrameTree *FindThisObject(const BMessenger &obj);
+
+public:
+	std::vector<FrameTree*> frames;
+	BMessenger obj;
+	BRect rect;
+	BPoint offset;
+	bool visible;
+
+	FrameTree(const BMessenger &obj, BRect rect, bool visible);
+	~FrameTree();
+
+	void Clear();
+	void Insert(FrameTree *frame);
+	FrameTree *Remove(FrameTree *frame);
+
+	// Topmost visible frame that contains point, children are clipped by
+	// parent.
+	FrameTree *This(BPoint pos);
+	FrameTree *ThisObject(const BMessenger &obj);
+};
+
+
+#endif	// _FRAMETREE_H_
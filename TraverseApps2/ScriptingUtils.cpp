@@ -73,38 +73,91 @@ void WriteError(BString &dst, status_t res)
 	dst += ">";
 }
 
-void WriteStringProp(BString &dst, BMessenger &obj, const char *field)
+status_t WriteStringReply(BString &dst, status_t res, const BMessage &reply)
 {
-	BMessage spec;
-	BString str;
-	status_t res;
-	spec.what = B_GET_PROPERTY;
-	spec.AddSpecifier(field);
-	if ((res = GetString(str, obj, spec)) != B_OK) {
+	const char *str;
+	if (res == B_OK)
+		res = reply.FindString("result", &str);
+	if (res != B_OK) {
 		WriteError(dst, res);
 	} else {
 		dst += str;
 	}
+	return res;
 }
 
-void WriteSuites(BString &dst, BMessenger &obj)
+status_t WriteSuitesReply(BString &dst, status_t res, const BMessage &reply)
 {
-	BMessage spec, reply;
 	type_code type;
 	int32 count;
 	const char *str;
-	status_t res;
-	spec = BMessage(B_GET_SUPPORTED_SUITES);
-	if (
-		((res = SendScriptingMessage(obj, spec, reply)) != B_OK)
-	) {
+	if (res != B_OK) {
 		WriteError(dst, res);
 	} else {
-		reply.GetInfo("suites", &type, &count);
+		if (reply.GetInfo("suites", &type, &count) != B_OK) count = 0;
 		for (int32 i = 0; i < count; i++) {
 			if (i > 0) {dst += ", ";}
 			reply.FindString("suites", i, &str);
 			dst += str;
 		}
 	}
+	return res;
+}
+
+void WriteStringProp(BString &dst, BMessenger &obj, const char *field)
+{
+	BMessage spec, reply;
+	spec.what = B_GET_PROPERTY;
+	spec.AddSpecifier(field);
+	WriteStringReply(dst, SendScriptingMessage(obj, spec, reply), reply);
+}
+
+void WriteSuites(BString &dst, BMessenger &obj)
+{
+	BMessage spec(B_GET_SUPPORTED_SUITES), reply;
+	WriteSuitesReply(dst, SendScriptingMessage(obj, spec, reply), reply);
+}
+
+
+ScriptingCache::ScriptingCache():
+	fGeneration(0)
+{}
+
+void ScriptingCache::BeginRefresh()
+{
+	fGeneration++;
+}
+
+ScriptingCache::Entry &ScriptingCache::Get(const BMessenger &obj)
+{
+	BMessenger::Private objPrivate((BMessenger&)obj);
+	int32 token = objPrivate.Token();
+	uint64 key = (uint64)(uint32)objPrivate.Team() << 32 | (uint32)token;
+	auto it = fEntries.find(key);
+	if (it == fEntries.end()) {
+		Entry &entry = fEntries[key];
+		entry.pendingChildren = 0;
+		entry.hasSuites = false;
+		entry.hasName = false;
+		entry.hasChildren = false;
+		entry.generation = fGeneration;
+		return entry;
+	}
+	Entry &entry = it->second;
+	entry.generation = fGeneration;
+	if ((fGeneration + (uint32)token) % kRevalidateInterval == 0) {
+		entry.hasName = false;
+		entry.hasChildren = false;
+	}
+	return entry;
+}
+
+void ScriptingCache::EndRefresh()
+{
+	for (auto it = fEntries.begin(); it != fEntries.end();) {
+		if (it->second.generation != fGeneration)
+			it = fEntries.erase(it);
+		else
+			it++;
+	}
 }
@@ -2,11 +2,54 @@
 #define _SCRIPTINGUTILS_H_
 
 #include <SupportDefs.h>
+#include <Messenger.h>
+#include <String.h>
+
+#include <unordered_map>
+#include <vector>
 
 class BMessage;
-class BMessenger;
 class BRect;
-class BString;
+
+
+// Memoizes scripting results that do not change during object lifetime:
+// supported suites depend only on object class and internal name is rarely
+// changed. Objects are identified by team and handler token, tokens are not
+// reused by BTokenSpace, so new object never gets stale entry. Names and
+// child messengers are revalidated every kRevalidateInterval refreshes,
+// objects are spread over refreshes by token. Entries of objects that were
+// not visited during refresh are removed.
+class ScriptingCache
+{
+public:
+	struct Entry {
+		BString suites;
+		BString name;
+		std::vector<BMessenger> children;
+		// Child replies that are not received yet.
+		int32 pendingChildren;
+		bool hasSuites;
+		bool hasName;
+		bool hasChildren;
+		uint32 generation;
+	};
+
+private:
+	enum {
+		kRevalidateInterval = 16,
+	};
+
+	std::unordered_map<uint64, Entry> fEntries;
+	uint32 fGeneration;
+
+public:
+	ScriptingCache();
+
+	void BeginRefresh();
+	// Returned reference is valid until EndRefresh().
+	Entry &Get(const BMessenger &obj);
+	void EndRefresh();
+};
 
 
 void DumpMessenger(const BMessenger &handle);
@@ -17,6 +60,8 @@ status_t GetString(BString &val, const BMessenger &obj, BMessage &spec);
 status_t GetMessenger(BMessenger &val, const BMessenger &obj, BMessage &spec);
 status_t GetRect(BRect &val, const BMessenger &obj, BMessage &spec);
 void WriteError(BString &dst, status_t res);
+status_t WriteStringReply(BString &dst, status_t res, const BMessage &reply);
+status_t WriteSuitesReply(BString &dst, status_t res, const BMessage &reply);
 void WriteStringProp(BString &dst, BMessenger &obj, const char *field);
 void WriteSuites(BString &dst, BMessenger &obj);
 
@@ -0,0 +1,158 @@
+// Checks UISnapshot file round trip, rejection of damaged files and
+// DiffSnapshots.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../UISnapshot.h"
+#include "../../SystemManager/Tests/Check.h"
+
+
+static void AddNode(UISnapshot &snapshot, int32_t team, int32_t token, int32_t parent, uint8_t type, const char *name, const char *suites)
+{
+	UINode node;
+	memset(&node, 0, sizeof(node));
+	node.team = team;
+	node.token = token;
+	node.parent = parent;
+	node.type = type;
+	node.flags = uiHasFrameFlag;
+	node.frame[2] = 100;
+	node.frame[3] = 50;
+	node.name = snapshot.AddString(name);
+	node.suites = snapshot.AddString(suites);
+	snapshot.nodes.push_back(node);
+}
+
+static void MakeSnapshot(UISnapshot &snapshot)
+{
+	snapshot.Clear();
+	AddNode(snapshot, 10, 0, -1, uiAppNode, "application/x-vnd.Test", "suite/vnd.Be-application");
+	AddNode(snapshot, 10, 1, 0, uiWindowNode, "Main", "suite/vnd.Be-window");
+	AddNode(snapshot, 10, 2, 1, uiViewNode, "top", "suite/vnd.Be-view");
+	AddNode(snapshot, 10, 3, 2, uiViewNode, "button", "suite/vnd.Be-view");
+}
+
+static bool Same(const UISnapshot &a, const UISnapshot &b)
+{
+	if (a.nodes.size() != b.nodes.size())
+		return false;
+	for (size_t i = 0; i < a.nodes.size(); i++) {
+		const UINode &na = a.nodes[i], &nb = b.nodes[i];
+		if (na.team != nb.team || na.token != nb.token || na.parent != nb.parent || na.type != nb.type || na.flags != nb.flags
+			|| memcmp(na.frame, nb.frame, sizeof(na.frame)) != 0
+			|| a.String(na.name) != b.String(nb.name) || a.String(na.suites) != b.String(nb.suites))
+			return false;
+	}
+	return true;
+}
+
+// Returns file with contents of data.
+static FILE *MemoryFile(const std::vector<char> &data)
+{
+	FILE *file = tmpfile();
+	if (!data.empty())
+		fwrite(data.data(), 1, data.size(), file);
+	rewind(file);
+	return file;
+}
+
+static std::vector<char> FileData(FILE *file)
+{
+	std::vector<char> data;
+	rewind(file);
+	char buf[256];
+	size_t len;
+	while ((len = fread(buf, 1, sizeof(buf), file)) > 0)
+		data.insert(data.end(), buf, buf + len);
+	return data;
+}
+
+static bool ReadData(UISnapshot &snapshot, const std::vector<char> &data)
+{
+	FILE *file = MemoryFile(data);
+	bool result = snapshot.Read(file);
+	fclose(file);
+	return result;
+}
+
+
+static void TestRoundTrip(std::vector<char> &data)
+{
+	UISnapshot snapshot, loaded;
+	MakeSnapshot(snapshot);
+	FILE *file = tmpfile();
+	CHECK(snapshot.Write(file));
+	data = FileData(file);
+	fclose(file);
+
+	CHECK(ReadData(loaded, data));
+	CHECK(Same(snapshot, loaded));
+	CHECK(loaded.Path(3) == "application/x-vnd.Test > Main > top > button");
+
+	// Same snapshot is always written to same bytes.
+	file = tmpfile();
+	loaded.Write(file);
+	CHECK(FileData(file) == data);
+	fclose(file);
+}
+
+static void TestDamaged(const std::vector<char> &data)
+{
+	UISnapshot snapshot;
+	bool truncatedOk = true;
+	for (size_t len = 0; len < data.size(); len++) {
+		std::vector<char> truncated(data.begin(), data.begin() + len);
+		truncatedOk &= !ReadData(snapshot, truncated) && snapshot.nodes.empty();
+	}
+	CHECK(truncatedOk);
+
+	// Header is magic, version, string count and node count, first string
+	// length follows.
+	const size_t kStringCountOffset = 8, kNodeCountOffset = 12, kFirstLenOffset = 16;
+	uint32_t huge = 0xffffffff;
+	std::vector<char> damaged = data;
+	memcpy(&damaged[kFirstLenOffset], &huge, sizeof(huge));
+	CHECK(!ReadData(snapshot, damaged));
+	damaged = data;
+	memcpy(&damaged[kNodeCountOffset], &huge, sizeof(huge));
+	CHECK(!ReadData(snapshot, damaged));
+	damaged = data;
+	memcpy(&damaged[kStringCountOffset], &huge, sizeof(huge));
+	CHECK(!ReadData(snapshot, damaged));
+	damaged = data;
+	damaged[0] = 'X';
+	CHECK(!ReadData(snapshot, damaged));
+}
+
+static void TestDiff()
+{
+	UISnapshot prev, cur;
+	MakeSnapshot(prev);
+	MakeSnapshot(cur);
+	std::vector<UIDiffEntry> diff;
+	DiffSnapshots(prev, cur, diff);
+	CHECK(diff.empty());
+
+	cur.nodes[2].flags |= uiHiddenFlag;
+	cur.nodes[3].name = cur.AddString("renamed");
+	AddNode(cur, 10, 4, 1, uiViewNode, "new", "suite/vnd.Be-view");
+	DiffSnapshots(prev, cur, diff);
+	CHECK(diff.size() == 4);
+	if (diff.size() == 4) {
+		CHECK(diff[0].kind == uiNodeChanged && diff[0].changes == uiHiddenChanged && diff[0].curNode == 2);
+		CHECK(diff[1].kind == uiNodeAdded && diff[1].curNode == 3);
+		CHECK(diff[2].kind == uiNodeAdded && diff[2].curNode == 4);
+		CHECK(diff[3].kind == uiNodeRemoved && diff[3].prevNode == 3);
+	}
+}
+
+
+int main()
+{
+	std::vector<char> data;
+	TestRoundTrip(data);
+	TestDamaged(data);
+	TestDiff();
+	return ReportChecks("UISnapshotTest");
+}
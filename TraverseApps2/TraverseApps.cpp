@@ -1,4 +1,7 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <String.h>
 #include <Application.h>
 #include <Messenger.h>
@@ -21,13 +24,16 @@
 #include <private/shared/AutoDeleter.h>
 
 #include <vector>
-#include <set>
+#include <map>
 #include <algorithm>
 
 #include "Resources.h"
 #include "HighlightRect.h"
+#include "FrameTree.h"
 #include "SuiteEditor.h"
 #include "ScriptingUtils.h"
+#include "UITree.h"
+#include "UISnapshot.h"
 
 enum {
 	invokeMsg = 1,
@@ -45,78 +51,6 @@ enum {
 };
 
 
-class FrameTree
-{
-public:
-	std::vector<FrameTree*> frames;
-	BMessenger obj;
-	BRect rect;
-	BPoint offset;
-	bool visible;
-
-	FrameTree(const BMessenger &obj, BRect rect, bool visible): obj(obj), rect(rect), offset(0, 0), visible(visible)
-	{
-	}
-
-	~FrameTree()
-	{
-		for (std::vector<FrameTree*>::iterator it = frames.begin(); it != frames.end(); ++it)
-			delete *it;
-	}
-
-	void Clear()
-	{
-		for (std::vector<FrameTree*>::iterator it = frames.begin(); it != frames.end(); ++it)
-			delete *it;
-		frames.clear();
-	}
-
-	void Insert(FrameTree *frame)
-	{
-		frames.push_back(frame);
-	}
-
-	FrameTree *Remove(FrameTree *frame)
-	{
-		std::vector<FrameTree*>::iterator it = std::find(frames.begin(), frames.end(), frame);
-		if (it != frames.end()) {
-			FrameTree *frame = *it;
-			frames.erase(it);
-			return frame;
-		}
-		return NULL;
-	}
-
-	FrameTree *This(BPoint pos)
-	{
-		if (!visible || !rect.Contains(pos))
-			return NULL;
-		for (std::vector<FrameTree*>::reverse_iterator it = frames.rbegin(); it != frames.rend(); ++it) {
-			FrameTree *frame = *it;
-			FrameTree *subFrame = frame->This(pos);
-			if (subFrame != NULL)
-				return subFrame;
-		}
-		return this;
-	}
-
-	FrameTree *ThisObject(const BMessenger &_obj)
-	{
-		if (obj == _obj)
-			return this;
-
-		for (std::vector<FrameTree*>::iterator it = frames.begin(); it != frames.end(); ++it) {
-			FrameTree *frame = *it;
-			FrameTree *subFrame = frame->ThisObject(_obj);
-			if (subFrame != NULL)
-				return subFrame;
-		}
-		return NULL;
-	}
-
-};
-
-
 class HandleRow: public BRow
 {
 public:
@@ -138,140 +72,6 @@ static BRow *FindIntRow(BColumnListView *view, BRow *parent, int32 val)
 	return NULL;
 }
 
-static void ListViews(BColumnListView *listView, FrameTree *frames, BRow *parent, BMessenger &wnd) {
-	BMessage spec;
-	int32 count;
-	BMessenger view;
-	BString buf;
-	BRow *row;
-	std::set<int32> prevViews;
-
-	for (int32 i = 0; i < listView->CountRows(parent); i++) {
-		row = listView->RowAt(i, parent);
-		prevViews.insert(((BIntegerField*)row->GetField(idCol))->Value());
-	}
-
-	spec = BMessage(B_COUNT_PROPERTIES);
-	spec.AddSpecifier("View");
-	if (GetInt32(count, wnd, spec) != B_OK)
-		count = 0;
-
-	for (int i = 0; i < count; i++) {
-		spec = BMessage(B_GET_PROPERTY);
-		spec.AddSpecifier("View", i);
-
-		if (GetMessenger(view, wnd, spec) != B_OK)
-			continue;
-
-		team_id token = BMessenger::Private(view).Token();
-
-		prevViews.erase(token);
-
-		row = FindIntRow(listView, parent, token);
-
-		if (row == NULL) {
-			row = new HandleRow(view);
-			listView->AddRow(row, parent);
-		}
-
-		row->SetField(new BStringField("BView"), typeCol);
-		buf = ""; WriteStringProp(buf, view, "InternalName");
-		row->SetField(new BStringField(buf), nameCol);
-		row->SetField(new BIntegerField(token), idCol);
-		buf = ""; WriteSuites(buf, view);
-		row->SetField(new BStringField(buf), suitesCol);
-
-		FrameTree *frame = NULL;
-		if (frames != NULL) {
-			BRect rect;
-			bool hidden;
-			status_t res;
-			{
-				BMessage spec(B_GET_PROPERTY);
-				spec.AddSpecifier("Frame");
-				res = GetRect(rect, view, spec);
-			}
-			if (res >= B_OK) {
-				{
-					BMessage spec(B_GET_PROPERTY);
-					spec.AddSpecifier("Hidden");
-					res = GetBool(hidden, view, spec);
-				}
-			}
-			if (res >= B_OK) {
-				frame = new FrameTree(view, rect.OffsetByCopy(frames->rect.LeftTop() + frames->offset), !hidden);
-				frames->Insert(frame);
-			} else {
-				printf("[!] ListViews: reading frame failed\n");
-			}
-		} else {
-			printf("[!] ListViews: frames == NULL\n");
-		}
-
-		ListViews(listView, frame, row, view);
-	}
-
-	for (std::set<int32>::iterator it = prevViews.begin(); it != prevViews.end(); ++it) {
-		row = FindIntRow(listView, parent, *it);
-		listView->RemoveRow(row);
-		delete row;
-	}
-}
-
-static void ListWindows(BColumnListView *listView, FrameTree *frames, BRow *parent, BMessenger &app) {
-	BMessage spec;
-	int32 count;
-	BMessenger wnd;
-	BString buf;
-	BRow *row;
-	std::set<int32> prevWnds;
-
-	for (int32 i = 0; i < listView->CountRows(parent); i++) {
-		row = listView->RowAt(i, parent);
-		prevWnds.insert(((BIntegerField*)row->GetField(idCol))->Value());
-	}
-
-	spec = BMessage(B_COUNT_PROPERTIES);
-	spec.AddSpecifier("Window");
-	if (GetInt32(count, app, spec) != B_OK)
-		count = 0;
-
-	for (int i = 0; i < count; i++) {
-		spec = BMessage(B_GET_PROPERTY);
-		spec.AddSpecifier("Window", i);
-
-		if (GetMessenger(wnd, app, spec) != B_OK)
-			continue;
-
-		team_id token = BMessenger::Private(wnd).Token();
-
-		prevWnds.erase(token);
-
-		row = FindIntRow(listView, parent, token);
-
-		if (row == NULL) {
-			row = new HandleRow(wnd);
-			listView->AddRow(row, parent);
-		}
-
-		row->SetField(new BStringField("BWindow"), typeCol);
-		buf = ""; WriteStringProp(buf, wnd, "InternalName");
-		row->SetField(new BStringField(buf), nameCol);
-		row->SetField(new BIntegerField(token), idCol);
-		buf = ""; WriteSuites(buf, wnd);
-		row->SetField(new BStringField(buf), suitesCol);
-
-		FrameTree *frame = frames->ThisObject(wnd);
-		ListViews(listView, frame, row, wnd);
-	}
-
-	for (std::set<int32>::iterator it = prevWnds.begin(); it != prevWnds.end(); ++it) {
-		row = FindIntRow(listView, parent, *it);
-		listView->RemoveRow(row);
-		delete row;
-	}
-}
-
 static void ListWindowFrames(FrameTree *frames)
 {
 	frames->Clear();
@@ -293,55 +93,72 @@ static void ListWindowFrames(FrameTree *frames)
 	}
 }
 
-static void ListApps(BColumnListView *listView, FrameTree *frames) {
-	BList appList;
-	app_info info;
-	BMessenger app;
-	BString buf;
+static void SyncRows(BColumnListView *listView, BRow *parent, FrameTree *frames, int32 level, const std::vector<ScriptObject> &objects)
+{
 	BRow *row;
-	std::set<int32> prevApps;
+	std::map<int32, BRow*> prevRows;
 
-	for (int32 i = 0; i < listView->CountRows(); i++) {
-		row = listView->RowAt(i);
-		prevApps.insert(((BIntegerField*)row->GetField(idCol))->Value());
+	for (int32 i = 0; i < listView->CountRows(parent); i++) {
+		row = listView->RowAt(i, parent);
+		prevRows[((BIntegerField*)row->GetField(idCol))->Value()] = row;
 	}
 
-	ListWindowFrames(frames);
-
-	be_roster->GetAppList(&appList);
-	for (int i = 0; i < appList.CountItems(); i++) {
-		team_id team = (team_id)(intptr_t)appList.ItemAt(i);
-
-		if (team == be_app->Team())
+	for (const ScriptObject &object: objects) {
+		if (!object.valid)
 			continue;
 
-		be_roster->GetRunningAppInfo(team, &info);
-		app = BMessenger(NULL, team);
-
-		prevApps.erase(team);
+		auto it = prevRows.find(object.id);
+		if (it != prevRows.end()) {
+			row = it->second;
+			prevRows.erase(it);
+		} else {
+			row = new HandleRow(object.obj);
+			listView->AddRow(row, parent);
+		}
 
-		row = FindIntRow(listView, NULL, team);
+		row->SetField(new BStringField(LevelTypeName(level)), typeCol);
+		row->SetField(new BStringField(object.name), nameCol);
+		row->SetField(new BIntegerField(object.id), idCol);
+		row->SetField(new BStringField(object.suites), suitesCol);
 
-		if (row == NULL) {
-			row = new HandleRow(app);
-			listView->AddRow(row);
+		FrameTree *frame = NULL;
+		switch (level) {
+			case appLevel:
+				frame = frames;
+				break;
+			case windowLevel:
+				frame = frames->ThisObject(object.obj);
+				break;
+			case viewLevel:
+				if (frames == NULL)
+					break;
+				if (!object.hasFrame || !object.hasHidden) {
+					printf("[!] SyncRows: reading frame failed\n");
+					break;
+				}
+				frame = new FrameTree(object.obj, object.frame.OffsetByCopy(frames->rect.LeftTop() + frames->offset), !object.hidden);
+				frames->Insert(frame);
+				break;
 		}
 
-		row->SetField(new BStringField("BApplication"), typeCol);
-		row->SetField(new BStringField(info.signature), nameCol);
-		row->SetField(new BIntegerField(team), idCol);
-		buf = ""; WriteSuites(buf, app);
-		row->SetField(new BStringField(buf), suitesCol);
-		ListWindows(listView, frames, row, app);
+		SyncRows(listView, row, frame, level == appLevel ? windowLevel : viewLevel, object.children);
 	}
 
-	for (std::set<int32>::iterator it = prevApps.begin(); it != prevApps.end(); ++it) {
-		row = FindIntRow(listView, NULL, *it);
-		listView->RemoveRow(row);
-		delete row;
+	for (auto &it: prevRows) {
+		listView->RemoveRow(it.second);
+		delete it.second;
 	}
 }
 
+static void ListApps(BColumnListView *listView, FrameTree *frames, ScriptingCache &cache) {
+	std::vector<ScriptObject> apps;
+
+	ListWindowFrames(frames);
+	if (CollectApps(apps, cache, be_app->Team()) < B_OK)
+		return;
+	SyncRows(listView, NULL, frames, appLevel, apps);
+}
+
 static void ExpandAll(BColumnListView *view, BRow *row)
 {
 	int32 count;
@@ -564,6 +381,7 @@ private:
 	BMenuBar *fMenuBar;
 	BMenuBar *fToolBar;
 	FrameTree fFrames;
+	ScriptingCache fScriptingCache;
 	//BMessageRunner listUpdater;
 public:
 	TestWindow(BRect frame):
@@ -579,7 +397,7 @@ public:
 		fView->AddColumn(new BIntegerColumn("ID", 64, 32, 128, B_ALIGN_RIGHT), idCol);
 		fView->AddColumn(new BStringColumn("Suites", 256, 50, 512, B_TRUNCATE_MIDDLE), suitesCol);
 
-		ListApps(fView, &fFrames);
+		ListApps(fView, &fFrames, fScriptingCache);
 
 		BMenu *menu2;
 
@@ -626,7 +444,7 @@ public:
 		case selectMsg:
 			break;
 		case updateMsg:
-			ListApps(fView, &fFrames);
+			ListApps(fView, &fFrames, fScriptingCache);
 			break;
 		case expandAllMsg: ExpandAll(fView, NULL); break;
 		case collapseAllMsg: CollapseAll(fView, NULL); break;
@@ -652,9 +470,145 @@ public:
 	}
 };
 
+static void AddSnapshotNodes(UISnapshot &snapshot, int32 parent, int32 level, const std::vector<ScriptObject> &objects)
+{
+	for (const ScriptObject &object: objects) {
+		if (!object.valid)
+			continue;
+		UINode node = {};
+		node.team = BMessenger::Private((BMessenger&)object.obj).Team();
+		node.token = object.id;
+		node.parent = parent;
+		node.type = level;
+		if (object.hasFrame) {
+			node.flags |= uiHasFrameFlag;
+			node.frame[0] = object.frame.left;
+			node.frame[1] = object.frame.top;
+			node.frame[2] = object.frame.right;
+			node.frame[3] = object.frame.bottom;
+		}
+		if (object.hasHidden && object.hidden)
+			node.flags |= uiHiddenFlag;
+		node.name = snapshot.AddString(object.name);
+		node.suites = snapshot.AddString(object.suites);
+		int32 idx = snapshot.nodes.size();
+		snapshot.nodes.push_back(node);
+		AddSnapshotNodes(snapshot, idx, level == appLevel ? windowLevel : viewLevel, object.children);
+	}
+}
+
+static int RunSnapshot(const char *path)
+{
+	bigtime_t startTime = system_time();
+	std::vector<ScriptObject> apps;
+	ScriptingCache cache;
+	if (CollectApps(apps, cache, -1) < B_OK)
+		return 1;
+	UISnapshot snapshot;
+	AddSnapshotNodes(snapshot, -1, appLevel, apps);
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		fprintf(stderr, "can't open \"%s\": %s\n", path, strerror(errno));
+		return 1;
+	}
+	bool written = snapshot.Write(file);
+	if (fclose(file) != 0)
+		written = false;
+	if (!written) {
+		fprintf(stderr, "can't write \"%s\"\n", path);
+		return 1;
+	}
+	printf("%" B_PRIuSIZE " nodes of %" B_PRIuSIZE " applications in %" B_PRId64 " ms\n",
+		snapshot.nodes.size(), apps.size(), (system_time() - startTime)/1000);
+	return 0;
+}
+
+static bool ReadSnapshot(UISnapshot &snapshot, const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "can't open \"%s\": %s\n", path, strerror(errno));
+		return false;
+	}
+	bool read = snapshot.Read(file);
+	fclose(file);
+	if (!read) {
+		fprintf(stderr, "\"%s\" is not a valid snapshot\n", path);
+		return false;
+	}
+	return true;
+}
+
+static void PrintDiffNode(char kind, const UISnapshot &snapshot, int32 idx, uint8 changes)
+{
+	const UINode &node = snapshot.nodes[idx];
+	printf("%c %-12s %6" B_PRId32 ":%-8" B_PRId32 " %s", kind, LevelTypeName(node.type), node.team, node.token, snapshot.Path(idx).c_str());
+	if (changes != 0) {
+		printf(" [");
+		const char *sep = "";
+		if ((changes & uiFrameChanged) != 0) {printf("%sframe", sep); sep = ", ";}
+		if ((changes & uiHiddenChanged) != 0) {printf("%shidden", sep); sep = ", ";}
+		if ((changes & uiSuitesChanged) != 0) {printf("%ssuites", sep); sep = ", ";}
+		printf("]");
+	}
+	printf("\n");
+}
 
-int main()
+static void CountTeamNodes(const UISnapshot &snapshot, std::map<int32, std::pair<BString, int32> > &teams, bool cur)
 {
+	for (const UINode &node: snapshot.nodes) {
+		std::pair<BString, int32> &team = teams[node.team];
+		if (node.type == uiAppNode)
+			team.first = snapshot.String(node.name).c_str();
+		team.second += cur ? 1 : -1;
+	}
+}
+
+static int RunDiff(const char *prevPath, const char *curPath)
+{
+	UISnapshot prev, cur;
+	if (!ReadSnapshot(prev, prevPath) || !ReadSnapshot(cur, curPath))
+		return 1;
+
+	std::vector<UIDiffEntry> diff;
+	DiffSnapshots(prev, cur, diff);
+	for (const UIDiffEntry &entry: diff) {
+		switch (entry.kind) {
+			case uiNodeAdded: PrintDiffNode('+', cur, entry.curNode, 0); break;
+			case uiNodeRemoved: PrintDiffNode('-', prev, entry.prevNode, 0); break;
+			case uiNodeChanged: PrintDiffNode('~', cur, entry.curNode, entry.changes); break;
+		}
+	}
+
+	// Growing node count of long running team usually means views that are
+	// never deleted.
+	std::map<int32, std::pair<BString, int32> > teams;
+	CountTeamNodes(prev, teams, false);
+	CountTeamNodes(cur, teams, true);
+	for (auto &it: teams) {
+		if (it.second.second != 0)
+			printf("team %" B_PRId32 " %s: %+" B_PRId32 " nodes\n", it.first, it.second.first.String(), it.second.second);
+	}
+	return diff.empty() ? 0 : 2;
+}
+
+static void Usage()
+{
+	fprintf(stderr, "usage: TraverseApps [--snapshot <file> | --diff <old> <new>]\n");
+	exit(1);
+}
+
+
+int main(int argc, char **argv)
+{
+	if (argc == 3 && strcmp(argv[1], "--snapshot") == 0)
+		return RunSnapshot(argv[2]);
+	if (argc == 4 && strcmp(argv[1], "--diff") == 0)
+		return RunDiff(argv[2], argv[3]);
+	if (argc > 1)
+		Usage();
+
 	TestApplication app;
 	app.Run();
 	return 0;
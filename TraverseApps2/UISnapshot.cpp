@@ -0,0 +1,254 @@
+#include "UISnapshot.h"
+
+#include <string.h>
+
+
+static const char kMagic[4] = {'U', 'I', 'T', 'S'};
+
+enum {
+	kVersion = 2,
+	// Node fields are stored one after another without padding.
+	kNodeSize = 3*sizeof(int32_t) + 2*sizeof(uint8_t) + 4*sizeof(float) + 2*sizeof(uint32_t),
+};
+
+struct FileHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t stringCount;
+	uint32_t nodeCount;
+};
+
+
+void UISnapshot::Clear()
+{
+	fStrings.clear();
+	fStringIndex.clear();
+	nodes.clear();
+}
+
+uint32_t UISnapshot::AddString(const char *str)
+{
+	auto it = fStringIndex.find(str);
+	if (it != fStringIndex.end())
+		return it->second;
+	uint32_t idx = fStrings.size();
+	fStrings.push_back(str);
+	fStringIndex[fStrings.back()] = idx;
+	return idx;
+}
+
+static uint8_t *Put(uint8_t *dst, const void *src, size_t size)
+{
+	memcpy(dst, src, size);
+	return dst + size;
+}
+
+static const uint8_t *Get(const uint8_t *src, void *dst, size_t size)
+{
+	memcpy(dst, src, size);
+	return src + size;
+}
+
+static void EncodeNode(uint8_t *dst, const UINode &node)
+{
+	dst = Put(dst, &node.team, sizeof(node.team));
+	dst = Put(dst, &node.token, sizeof(node.token));
+	dst = Put(dst, &node.parent, sizeof(node.parent));
+	dst = Put(dst, &node.type, sizeof(node.type));
+	dst = Put(dst, &node.flags, sizeof(node.flags));
+	dst = Put(dst, node.frame, sizeof(node.frame));
+	dst = Put(dst, &node.name, sizeof(node.name));
+	Put(dst, &node.suites, sizeof(node.suites));
+}
+
+static void DecodeNode(const uint8_t *src, UINode &node)
+{
+	src = Get(src, &node.team, sizeof(node.team));
+	src = Get(src, &node.token, sizeof(node.token));
+	src = Get(src, &node.parent, sizeof(node.parent));
+	src = Get(src, &node.type, sizeof(node.type));
+	src = Get(src, &node.flags, sizeof(node.flags));
+	src = Get(src, node.frame, sizeof(node.frame));
+	src = Get(src, &node.name, sizeof(node.name));
+	Get(src, &node.suites, sizeof(node.suites));
+}
+
+// Counts in file are checked against its size before allocating memory.
+static bool RemainingSize(FILE *file, uint64_t &size)
+{
+	long pos = ftell(file);
+	if (pos < 0 || fseek(file, 0, SEEK_END) != 0)
+		return false;
+	long end = ftell(file);
+	if (end < pos || fseek(file, pos, SEEK_SET) != 0)
+		return false;
+	size = end - pos;
+	return true;
+}
+
+
+std::string UISnapshot::Path(uint32_t node) const
+{
+	std::vector<uint32_t> chain;
+	for (int32_t i = node; i >= 0; i = nodes[i].parent)
+		chain.push_back(i);
+	std::string path;
+	for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+		if (!path.empty())
+			path += " > ";
+		path += fStrings[nodes[*it].name];
+	}
+	return path;
+}
+
+
+bool UISnapshot::Write(FILE *file) const
+{
+	FileHeader header;
+	memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kVersion;
+	header.stringCount = fStrings.size();
+	header.nodeCount = nodes.size();
+	if (fwrite(&header, sizeof(header), 1, file) != 1)
+		return false;
+	for (const std::string &str: fStrings) {
+		uint32_t len = str.size();
+		if (fwrite(&len, sizeof(len), 1, file) != 1 || fwrite(str.data(), 1, len, file) != len)
+			return false;
+	}
+	std::vector<uint8_t> data(nodes.size()*kNodeSize);
+	for (size_t i = 0; i < nodes.size(); i++)
+		EncodeNode(&data[i*kNodeSize], nodes[i]);
+	if (!data.empty() && fwrite(data.data(), 1, data.size(), file) != data.size())
+		return false;
+	return true;
+}
+
+bool UISnapshot::Read(FILE *file)
+{
+	Clear();
+	FileHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1)
+		return false;
+	if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion)
+		return false;
+	uint64_t remaining;
+	if (!RemainingSize(file, remaining))
+		return false;
+
+	std::string str;
+	for (uint32_t i = 0; i < header.stringCount; i++) {
+		uint32_t len;
+		if (remaining < sizeof(len) || fread(&len, sizeof(len), 1, file) != 1) {
+			Clear();
+			return false;
+		}
+		remaining -= sizeof(len);
+		if (len > remaining) {
+			Clear();
+			return false;
+		}
+		str.resize(len);
+		if (len > 0 && fread(&str[0], 1, len, file) != len) {
+			Clear();
+			return false;
+		}
+		remaining -= len;
+		fStringIndex[str] = fStrings.size();
+		fStrings.push_back(str);
+	}
+
+	if (header.nodeCount > remaining/kNodeSize) {
+		Clear();
+		return false;
+	}
+	std::vector<uint8_t> data((size_t)header.nodeCount*kNodeSize);
+	if (!data.empty() && fread(data.data(), 1, data.size(), file) != data.size()) {
+		Clear();
+		return false;
+	}
+	nodes.resize(header.nodeCount);
+	for (uint32_t i = 0; i < nodes.size(); i++) {
+		UINode &node = nodes[i];
+		DecodeNode(&data[i*kNodeSize], node);
+		if (node.parent < -1 || node.parent >= (int32_t)i || node.name >= fStrings.size() || node.suites >= fStrings.size()) {
+			Clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+
+struct NodeKey {
+	int32_t team;
+	int32_t token;
+	uint64_t path;
+
+	bool operator==(const NodeKey &other) const {return team == other.team && token == other.token && path == other.path;}
+};
+
+struct NodeKeyHash {
+	size_t operator()(const NodeKey &key) const {return key.path ^ ((uint64_t)(uint32_t)key.team << 32 | (uint32_t)key.token);}
+};
+
+// Path hash of node combines hash of parent path and hash of name, so keys
+// of all nodes are computed in one pass.
+static void ComputeKeys(const UISnapshot &snapshot, std::vector<NodeKey> &keys)
+{
+	std::hash<std::string> hashString;
+	std::vector<uint64_t> nameHashes;
+	std::vector<bool> hasNameHash;
+	keys.resize(snapshot.nodes.size());
+	for (size_t i = 0; i < snapshot.nodes.size(); i++) {
+		const UINode &node = snapshot.nodes[i];
+		if (node.name >= nameHashes.size()) {
+			nameHashes.resize(node.name + 1);
+			hasNameHash.resize(node.name + 1);
+		}
+		if (!hasNameHash[node.name]) {
+			nameHashes[node.name] = hashString(snapshot.String(node.name));
+			hasNameHash[node.name] = true;
+		}
+		uint64_t parentPath = node.parent >= 0 ? keys[node.parent].path : 0;
+		keys[i] = {node.team, node.token, parentPath*1099511628211ULL ^ nameHashes[node.name]};
+	}
+}
+
+void DiffSnapshots(const UISnapshot &prev, const UISnapshot &cur, std::vector<UIDiffEntry> &diff)
+{
+	std::vector<NodeKey> prevKeys, curKeys;
+	ComputeKeys(prev, prevKeys);
+	ComputeKeys(cur, curKeys);
+
+	std::unordered_map<NodeKey, int32_t, NodeKeyHash> prevIndex;
+	prevIndex.reserve(prevKeys.size());
+	for (size_t i = 0; i < prevKeys.size(); i++)
+		prevIndex.emplace(prevKeys[i], i);
+
+	diff.clear();
+	std::vector<bool> matched(prev.nodes.size(), false);
+	for (size_t i = 0; i < cur.nodes.size(); i++) {
+		auto it = prevIndex.find(curKeys[i]);
+		if (it == prevIndex.end()) {
+			diff.push_back({uiNodeAdded, 0, -1, (int32_t)i});
+			continue;
+		}
+		matched[it->second] = true;
+		const UINode &prevNode = prev.nodes[it->second];
+		const UINode &curNode = cur.nodes[i];
+		uint8_t changes = 0;
+		if ((prevNode.flags & uiHasFrameFlag) != (curNode.flags & uiHasFrameFlag) || memcmp(prevNode.frame, curNode.frame, sizeof(curNode.frame)) != 0)
+			changes |= uiFrameChanged;
+		if ((prevNode.flags & uiHiddenFlag) != (curNode.flags & uiHiddenFlag))
+			changes |= uiHiddenChanged;
+		if (prev.String(prevNode.suites) != cur.String(curNode.suites))
+			changes |= uiSuitesChanged;
+		if (changes != 0)
+			diff.push_back({uiNodeChanged, changes, it->second, (int32_t)i});
+	}
+	for (size_t i = 0; i < prev.nodes.size(); i++) {
+		if (!matched[i])
+			diff.push_back({uiNodeRemoved, 0, (int32_t)i, -1});
+	}
+}
@@ -0,0 +1,83 @@
+#ifndef _UISNAPSHOT_H_
+#define _UISNAPSHOT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+
+enum {
+	uiAppNode,
+	uiWindowNode,
+	uiViewNode,
+};
+
+enum {
+	uiHasFrameFlag = 1 << 0,
+	uiHiddenFlag   = 1 << 1,
+};
+
+// Nodes are stored in pre-order, parent always precedes its children.
+// Strings are interned, suites and names repeat for most of views.
+struct UINode {
+	int32_t team;
+	int32_t token;
+	int32_t parent;
+	uint8_t type;
+	uint8_t flags;
+	float frame[4];
+	uint32_t name;
+	uint32_t suites;
+};
+
+// Snapshot of all applications, windows and views. It is saved in compact
+// binary format in host byte order.
+class UISnapshot
+{
+private:
+	std::vector<std::string> fStrings;
+	std::unordered_map<std::string, uint32_t> fStringIndex;
+
+public:
+	std::vector<UINode> nodes;
+
+	void Clear();
+	uint32_t AddString(const char *str);
+	const std::string &String(uint32_t idx) const {return fStrings[idx];}
+	std::string Path(uint32_t node) const;
+
+	bool Write(FILE *file) const;
+	bool Read(FILE *file);
+};
+
+
+enum {
+	uiNodeAdded,
+	uiNodeRemoved,
+	uiNodeChanged,
+};
+
+enum {
+	uiFrameChanged  = 1 << 0,
+	uiHiddenChanged = 1 << 1,
+	uiSuitesChanged = 1 << 2,
+};
+
+struct UIDiffEntry {
+	uint8_t kind;
+	uint8_t changes;
+	int32_t prevNode;
+	int32_t curNode;
+};
+
+// Nodes are matched by team, token and path of names, so renamed or moved
+// view is reported as removed and added. Added and changed nodes are
+// ordered as in cur, removed nodes follow in prev order.
+void DiffSnapshots(const UISnapshot &prev, const UISnapshot &cur, std::vector<UIDiffEntry> &diff);
+
+
+#endif	// _UISNAPSHOT_H_
@@ -0,0 +1,156 @@
+#include "UITree.h"
+
+#include <Roster.h>
+#include <private/app/MessengerPrivate.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "AsyncScripting.h"
+#include "ScriptingUtils.h"
+
+
+enum {
+	// Whole tree of one application must be received within this time.
+	kAppTimeout = 500000,
+};
+
+static const char *kLevelTypes[] = {"BApplication", "BWindow", "BView"};
+
+
+const char *LevelTypeName(int32 level)
+{
+	if (level < appLevel || level > viewLevel)
+		return "?";
+	return kLevelTypes[level];
+}
+
+
+// All queries of object are sent at once and children are requested as soon
+// as count reply arrives, so round trips of different objects and
+// applications overlap. Children vector is sized only once, so references
+// captured by handlers stay valid. Children of windows and views are taken
+// from cache when possible, windows of application come and go too often.
+static void QueryObject(AsyncScripting &scripting, ScriptingCache &cache, team_id team, ScriptObject &object, int32 level, ScriptingCache::Entry *cachedBy = NULL)
+{
+	ScriptingCache::Entry &entry = cache.Get(object.obj);
+	if (level != appLevel) {
+		if (entry.hasName)
+			object.name = entry.name;
+		else {
+			BMessage spec(B_GET_PROPERTY);
+			spec.AddSpecifier("InternalName");
+			scripting.Send(team, object.obj, spec, [&object, &entry](status_t res, BMessage &reply) {
+				if (WriteStringReply(object.name, res, reply) == B_OK) {
+					entry.name = object.name;
+					entry.hasName = true;
+				}
+			});
+		}
+	}
+	if (entry.hasSuites)
+		object.suites = entry.suites;
+	else {
+		scripting.Send(team, object.obj, BMessage(B_GET_SUPPORTED_SUITES), [&object, &entry](status_t res, BMessage &reply) {
+			if (WriteSuitesReply(object.suites, res, reply) == B_OK) {
+				entry.suites = object.suites;
+				entry.hasSuites = true;
+			}
+		});
+	}
+	if (level != appLevel) {
+		BMessage spec(B_GET_PROPERTY);
+		spec.AddSpecifier("Frame");
+		scripting.Send(team, object.obj, spec, [&object, cachedBy](status_t res, BMessage &reply) {
+			object.hasFrame = res == B_OK && reply.FindRect("result", &object.frame) == B_OK;
+			// Cached child is probably deleted, refetch children of parent.
+			if (!object.hasFrame && cachedBy != NULL) {
+				object.valid = false;
+				cachedBy->hasChildren = false;
+			}
+		});
+		spec = BMessage(B_GET_PROPERTY);
+		spec.AddSpecifier("Hidden");
+		scripting.Send(team, object.obj, spec, [&object](status_t res, BMessage &reply) {
+			object.hasHidden = res == B_OK && reply.FindBool("result", &object.hidden) == B_OK;
+		});
+	}
+
+	const char *childProperty = level == appLevel ? "Window" : "View";
+	int32 childLevel = level == appLevel ? windowLevel : viewLevel;
+	if (level != appLevel && entry.hasChildren) {
+		object.children.resize(entry.children.size());
+		for (size_t i = 0; i < entry.children.size(); i++) {
+			ScriptObject &child = object.children[i];
+			child.obj = entry.children[i];
+			child.valid = true;
+			child.id = BMessenger::Private(child.obj).Token();
+			QueryObject(scripting, cache, team, child, childLevel, &entry);
+		}
+		return;
+	}
+	BMessage spec(B_COUNT_PROPERTIES);
+	spec.AddSpecifier(childProperty);
+	scripting.Send(team, object.obj, spec, [&scripting, &cache, team, &object, &entry, childProperty, childLevel](status_t res, BMessage &reply) {
+		int32 count;
+		if (res != B_OK || reply.FindInt32("result", &count) != B_OK || count < 0)
+			return;
+		entry.children.assign(count, BMessenger());
+		entry.pendingChildren = count;
+		entry.hasChildren = count == 0;
+		object.children.resize(count);
+		for (int32 i = 0; i < count; i++) {
+			BMessage spec(B_GET_PROPERTY);
+			spec.AddSpecifier(childProperty, i);
+			ScriptObject &child = object.children[i];
+			scripting.Send(team, object.obj, spec, [&scripting, &cache, team, &entry, &child, i, childLevel](status_t res, BMessage &reply) {
+				if (res != B_OK || reply.FindMessenger("result", &child.obj) != B_OK)
+					return;
+				child.valid = true;
+				child.id = BMessenger::Private(child.obj).Token();
+				// Cache is complete only if all children replied.
+				entry.children[i] = child.obj;
+				if (--entry.pendingChildren == 0)
+					entry.hasChildren = true;
+				QueryObject(scripting, cache, team, child, childLevel);
+			});
+		}
+	});
+}
+
+
+status_t CollectApps(std::vector<ScriptObject> &apps, ScriptingCache &cache, team_id skipTeam)
+{
+	BList appList;
+	app_info info;
+
+	apps.clear();
+	be_roster->GetAppList(&appList);
+	apps.reserve(appList.CountItems());
+	for (int i = 0; i < appList.CountItems(); i++) {
+		team_id team = (team_id)(intptr_t)appList.ItemAt(i);
+
+		if (team == skipTeam)
+			continue;
+
+		be_roster->GetRunningAppInfo(team, &info);
+		apps.push_back(ScriptObject());
+		ScriptObject &app = apps.back();
+		app.obj = BMessenger(NULL, team);
+		app.id = team;
+		app.valid = true;
+		app.name = info.signature;
+	}
+
+	AsyncScripting scripting(kAppTimeout);
+	if (scripting.InitCheck() < B_OK) {
+		printf("[!] CollectApps: can't create reply port, error: %s\n", strerror(scripting.InitCheck()));
+		return scripting.InitCheck();
+	}
+	cache.BeginRefresh();
+	for (ScriptObject &app: apps)
+		QueryObject(scripting, cache, app.id, app, appLevel);
+	scripting.Run();
+	cache.EndRefresh();
+	return B_OK;
+}
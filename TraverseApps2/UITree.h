@@ -0,0 +1,43 @@
+#ifndef _UITREE_H_
+#define _UITREE_H_
+
+#include <Messenger.h>
+#include <Rect.h>
+#include <String.h>
+
+#include <vector>
+
+class ScriptingCache;
+
+
+enum {
+	appLevel,
+	windowLevel,
+	viewLevel,
+};
+
+const char *LevelTypeName(int32 level);
+
+// Application, window or view collected by scripting. Frame is in parent
+// coordinates as reported by "Frame" property.
+struct ScriptObject
+{
+	BMessenger obj;
+	int32 id;
+	bool valid;
+	BString name;
+	BString suites;
+	bool hasFrame, hasHidden;
+	BRect frame;
+	bool hidden;
+	std::vector<ScriptObject> children;
+
+	ScriptObject(): id(-1), valid(false), hasFrame(false), hasHidden(false), hidden(false) {}
+};
+
+// Collects windows and views of all running applications except skipTeam.
+// Applications that do not reply within timeout get incomplete subtrees.
+status_t CollectApps(std::vector<ScriptObject> &apps, ScriptingCache &cache, team_id skipTeam);
+
+
+#endif	// _UITREE_H_
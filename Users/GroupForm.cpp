@@ -20,9 +20,11 @@
 #include <StringView.h>
 #include <SeparatorView.h>
 #include <LayoutBuilder.h>
+#include <Autolock.h>
 
 #include <private/kernel/util/KMessage.h>
 #include "UserDB.h"
+#include "UserIndex.h"
 #include "UIUtils.h"
 #include "Resources.h"
 
@@ -141,17 +143,15 @@ public:
 			.End()
 		.End();
 
-		{
-			KMessage usersReply;
-			int32 userCnt;
-			passwd **users;
-			if (GetUsers(usersReply, userCnt, users) < B_OK) userCnt = 0;
-			for (int32 i = 0; i < userCnt; i++) {
-				BMessage *msg = new BMessage(addMemberMsg);
-				BMenuItem *item;
-				msg->AddString("val", users[i]->pw_name);
-				fAddMemberMenu->AddItem(item = new BMenuItem(users[i]->pw_name, msg));
-			}
+		UserCache &cache = UserCache::Default();
+		BAutolock lock(cache.Locker());
+		const UserIndex *index = cache.Get();
+		uint32 userCnt = index != NULL ? index->CountUsers() : 0;
+		for (uint32 i = 0; i < userCnt; i++) {
+			const char *userName = index->String(index->UserAt(i).name);
+			BMessage *msg = new BMessage(addMemberMsg);
+			msg->AddString("val", userName);
+			fAddMemberMenu->AddItem(new BMenuItem(userName, msg));
 		}
 
 		if (false && fGid < 0) {
@@ -161,15 +161,13 @@ public:
 			passwordLayout->SetVisible(false);
 		}
 
-		if (fGid >= 0) {
-			KMessage groupInfo;
-			if (GetGroup(groupInfo, fGid, NULL) >= B_OK) {
-				const char *name;
-				if (groupInfo.FindString("name", &name) >= B_OK) {
-					fGroupNameView->SetText(name);
-				}
-				for (int32 i = 0; groupInfo.FindString("members", i, &name) >= B_OK; i++)
-					AddMember(name);
+		if (fGid >= 0 && index != NULL) {
+			uint32 groupIdx = index->FindGroup(fGid);
+			if (groupIdx != UserIndex::kNotFound) {
+				const UserIndex::Group &group = index->GroupAt(groupIdx);
+				fGroupNameView->SetText(index->String(group.name));
+				for (uint32 i = 0; i < group.memberCount; i++)
+					AddMember(index->MemberAt(group, i));
 			}
 		}
 
@@ -183,7 +181,15 @@ public:
 		case okMsg: {
 			if (fGid < 0) {
 				gid_t gid = 100;
-				while (getgrgid(gid) != NULL) gid++;
+				{
+					UserCache &cache = UserCache::Default();
+					BAutolock lock(cache.Locker());
+					const UserIndex *index = cache.Get();
+					if (index != NULL)
+						gid = index->FreeGroupId(gid);
+					else
+						while (getgrgid(gid) != NULL) gid++;
+				}
 
 				KMessage message;
 				CheckRetVoid(message.AddInt32("gid", gid));
@@ -0,0 +1,306 @@
+// Checks UserIndex against brute force search and getpwnam()/getgrnam() of
+// host system, and measures loading and lookups of synthetic passwd and
+// group files: UserIndexTest [<user count>].
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pwd.h>
+#include <grp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../UserIndex.h"
+#include "../../SystemManager/Tests/Check.h"
+
+
+class Timer
+{
+private:
+	std::chrono::steady_clock::time_point fStart;
+
+public:
+	Timer(): fStart(std::chrono::steady_clock::now()) {}
+	double Ms() const {return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - fStart).count();}
+};
+
+
+// Splits line at ':' in place, line must not have newline.
+static void SplitLine(char *line, std::vector<char*> &fields)
+{
+	fields.clear();
+	fields.push_back(line);
+	for (char *p = line; *p != '\0'; p++) {
+		if (*p == ':') {
+			*p = '\0';
+			fields.push_back(p + 1);
+		}
+	}
+}
+
+static void SplitMembers(char *str, std::vector<char*> &members)
+{
+	members.clear();
+	if (*str != '\0') {
+		members.push_back(str);
+		for (char *p = str; *p != '\0'; p++) {
+			if (*p == ',') {
+				*p = '\0';
+				members.push_back(p + 1);
+			}
+		}
+	}
+	members.push_back(NULL);
+}
+
+static bool LoadFiles(UserIndex &index, const char *passwdPath, const char *groupPath)
+{
+	index.Clear();
+	std::vector<char*> fields, members;
+	char *line = NULL;
+	size_t size = 0;
+	ssize_t len;
+
+	FILE *file = fopen(passwdPath, "r");
+	if (file == NULL)
+		return false;
+	while ((len = getline(&line, &size, file)) > 0) {
+		if (line[len - 1] == '\n')
+			line[len - 1] = '\0';
+		SplitLine(line, fields);
+		if (fields.size() < 7)
+			continue;
+		index.AddUser(fields[0], fields[1], atoi(fields[2]), atoi(fields[3]), fields[5], fields[6], fields[4]);
+	}
+	fclose(file);
+
+	file = fopen(groupPath, "r");
+	if (file == NULL) {
+		free(line);
+		return false;
+	}
+	while ((len = getline(&line, &size, file)) > 0) {
+		if (line[len - 1] == '\n')
+			line[len - 1] = '\0';
+		SplitLine(line, fields);
+		if (fields.size() < 4)
+			continue;
+		SplitMembers(fields[3], members);
+		index.AddGroup(fields[0], fields[1], atoi(fields[2]), members.data());
+	}
+	fclose(file);
+	free(line);
+
+	index.BuildIndexes();
+	return true;
+}
+
+
+// Some names and IDs are repeated, so first entry must be found. Each user
+// is member of several groups.
+static void WriteSyntheticFiles(const char *passwdPath, const char *groupPath, int userCount)
+{
+	int groupCount = std::max(userCount/10, 1);
+	FILE *file = fopen(passwdPath, "w");
+	for (int i = 0; i < userCount; i++) {
+		int uid = i % 97 == 96 ? 1000 + i - 1 : 1000 + i;
+		fprintf(file, "user%d:x:%d:%d:User %d:/home/user%d:/bin/bash\n", i % 89 == 88 ? i - 1 : i, uid, 1000 + i % groupCount, i, i);
+	}
+	fclose(file);
+	file = fopen(groupPath, "w");
+	for (int i = 0; i < groupCount; i++) {
+		fprintf(file, "group%d:x:%d:", i, 1000 + i);
+		for (int j = 0; j < 8; j++)
+			fprintf(file, "%suser%d", j == 0 ? "" : ",", (i*7 + j*userCount/8) % userCount);
+		fprintf(file, "\n");
+	}
+	fclose(file);
+}
+
+
+static uint32_t BruteFindUser(const UserIndex &index, int32_t uid)
+{
+	for (uint32_t i = 0; i < index.CountUsers(); i++) {
+		if (index.UserAt(i).uid == uid)
+			return i;
+	}
+	return UserIndex::kNotFound;
+}
+
+static uint32_t BruteFindUser(const UserIndex &index, const char *name)
+{
+	for (uint32_t i = 0; i < index.CountUsers(); i++) {
+		if (strcmp(index.String(index.UserAt(i).name), name) == 0)
+			return i;
+	}
+	return UserIndex::kNotFound;
+}
+
+static uint32_t BruteFindGroup(const UserIndex &index, int32_t gid)
+{
+	for (uint32_t i = 0; i < index.CountGroups(); i++) {
+		if (index.GroupAt(i).gid == gid)
+			return i;
+	}
+	return UserIndex::kNotFound;
+}
+
+static uint32_t BruteFindGroup(const UserIndex &index, const char *name)
+{
+	for (uint32_t i = 0; i < index.CountGroups(); i++) {
+		if (strcmp(index.String(index.GroupAt(i).name), name) == 0)
+			return i;
+	}
+	return UserIndex::kNotFound;
+}
+
+static void BruteGroupsOfMember(const UserIndex &index, const char *name, std::vector<uint32_t> &groups)
+{
+	groups.clear();
+	for (uint32_t i = 0; i < index.CountGroups(); i++) {
+		const UserIndex::Group &group = index.GroupAt(i);
+		for (uint32_t j = 0; j < group.memberCount; j++) {
+			if (strcmp(index.MemberAt(group, j), name) == 0) {
+				groups.push_back(i);
+				break;
+			}
+		}
+	}
+}
+
+// Brute force is quadratic, so only some entries are checked for large
+// files.
+static void CheckIndex(const UserIndex &index)
+{
+	uint32_t step = std::max<uint32_t>(index.CountUsers()/1000, 1);
+	bool usersOk = true, membersOk = true;
+	std::vector<uint32_t> expected;
+	for (uint32_t i = 0; i < index.CountUsers(); i += step) {
+		const UserIndex::User &user = index.UserAt(i);
+		const char *name = index.String(user.name);
+		usersOk &= index.FindUser(user.uid) == BruteFindUser(index, user.uid);
+		usersOk &= index.FindUser(name) == BruteFindUser(index, name);
+		uint32_t count;
+		const uint32_t *groups = index.GroupsOfMember(name, count);
+		BruteGroupsOfMember(index, name, expected);
+		membersOk &= count == expected.size() && std::equal(expected.begin(), expected.end(), groups);
+		for (uint32_t group: expected)
+			membersOk &= index.IsMember(group, name);
+	}
+	CHECK(usersOk);
+	CHECK(membersOk);
+
+	step = std::max<uint32_t>(index.CountGroups()/1000, 1);
+	bool groupsOk = true;
+	for (uint32_t i = 0; i < index.CountGroups(); i += step) {
+		const UserIndex::Group &group = index.GroupAt(i);
+		groupsOk &= index.FindGroup(group.gid) == BruteFindGroup(index, group.gid);
+		groupsOk &= index.FindGroup(index.String(group.name)) == BruteFindGroup(index, index.String(group.name));
+	}
+	CHECK(groupsOk);
+
+	CHECK(index.FindUser("no such user") == UserIndex::kNotFound);
+	CHECK(index.FindUser(-12345) == UserIndex::kNotFound);
+	CHECK(index.FindGroup("no such group") == UserIndex::kNotFound);
+	uint32_t count;
+	CHECK(index.GroupsOfMember("no such user", count) == NULL && count == 0);
+
+	int32_t freeUid = index.FreeUserId(0);
+	CHECK(BruteFindUser(index, freeUid) == UserIndex::kNotFound);
+	CHECK(freeUid == 0 || BruteFindUser(index, freeUid - 1) != UserIndex::kNotFound);
+	int32_t freeGid = index.FreeGroupId(0);
+	CHECK(BruteFindGroup(index, freeGid) == UserIndex::kNotFound);
+}
+
+// Host C library reads same files, only names are compared because IDs of
+// duplicated entries may differ between implementations.
+static void CheckHost(const UserIndex &index)
+{
+	bool ok = true;
+	for (uint32_t i = 0; i < index.CountUsers(); i++) {
+		const UserIndex::User &user = index.UserAt(i);
+		passwd *pw = getpwnam(index.String(user.name));
+		ok &= pw != NULL && index.FindUser(pw->pw_name) != UserIndex::kNotFound
+			&& index.UserAt(index.FindUser(pw->pw_name)).uid == (int32_t)pw->pw_uid;
+	}
+	for (uint32_t i = 0; i < index.CountGroups(); i++) {
+		const UserIndex::Group &group = index.GroupAt(i);
+		struct group *gr = getgrnam(index.String(group.name));
+		ok &= gr != NULL && index.GroupAt(index.FindGroup(gr->gr_name)).gid == (int32_t)gr->gr_gid;
+	}
+	CHECK(ok);
+}
+
+static void CheckEmpty()
+{
+	UserIndex index;
+	CHECK(index.FindUser(0) == UserIndex::kNotFound);
+	CHECK(index.FindUser("root") == UserIndex::kNotFound);
+	index.BuildIndexes();
+	CHECK(index.FindGroup(0) == UserIndex::kNotFound);
+	CHECK(index.FreeUserId(100) == 100);
+}
+
+
+static volatile uint32_t gSink;
+
+
+int main(int argc, char **argv)
+{
+	int userCount = argc > 1 ? atoi(argv[1]) : 2000;
+
+	CheckEmpty();
+
+	UserIndex index;
+	if (LoadFiles(index, "/etc/passwd", "/etc/group")) {
+		CheckIndex(index);
+		CheckHost(index);
+	}
+
+	char passwdPath[] = "/tmp/user-index-passwd-XXXXXX";
+	char groupPath[] = "/tmp/user-index-group-XXXXXX";
+	close(mkstemp(passwdPath));
+	close(mkstemp(groupPath));
+	WriteSyntheticFiles(passwdPath, groupPath, userCount);
+
+	Timer loadTimer;
+	CHECK(LoadFiles(index, passwdPath, groupPath));
+	double loadMs = loadTimer.Ms();
+	CHECK(index.CountUsers() == (size_t)userCount);
+	CheckIndex(index);
+	unlink(passwdPath);
+	unlink(groupPath);
+
+	const int kLookups = 1000000;
+	uint32_t sum = 0;
+	Timer uidTimer;
+	for (int i = 0; i < kLookups; i++)
+		sum += index.FindUser(1000 + i % userCount);
+	double uidMs = uidTimer.Ms();
+
+	std::vector<std::string> names(userCount);
+	for (int i = 0; i < userCount; i++)
+		names[i] = "user" + std::to_string(i);
+	Timer nameTimer;
+	for (int i = 0; i < kLookups; i++)
+		sum += index.FindUser(names[i % userCount].c_str());
+	double nameMs = nameTimer.Ms();
+
+	Timer memberTimer;
+	for (int i = 0; i < userCount; i++) {
+		uint32_t count;
+		index.GroupsOfMember(names[i].c_str(), count);
+		sum += count;
+	}
+	double memberMs = memberTimer.Ms();
+
+	printf("%d users, %zu groups: load %.1f ms, %d uid lookups %.1f ms, %d name lookups %.1f ms, groups of all members %.1f ms\n",
+		userCount, index.CountGroups(), loadMs, kLookups, uidMs, kLookups, nameMs, memberMs);
+	gSink = sum;
+
+	return ReportChecks("UserIndexTest");
+}
@@ -2,11 +2,16 @@
 
 #include <pwd.h>
 #include <grp.h>
+#include <sys/stat.h>
+
+#include <Autolock.h>
 
 #include <private/app/RegistrarDefs.h>
 #include <private/libroot/user_group.h>
 #include <private/kernel/util/KMessage.h>
 
+#include "UserIndex.h"
+
 
 #define CheckRet(err) {status_t _err = (err); if (_err < B_OK) {/* debugger(strerror(_err)); */ return _err;}}
 
@@ -59,6 +64,93 @@ status_t GetGroups(KMessage &reply, int32 &count, group**& entries)
 	return B_OK;
 }
 
+static const char *kPasswdFile = "/etc/passwd";
+static const char *kGroupFile = "/etc/group";
+
+
+UserCache::UserCache():
+	fLocker("UserCache"),
+	fIndex(new UserIndex()),
+	fValid(false),
+	fGeneration(0),
+	fPasswdTime(),
+	fGroupTime()
+{
+}
+
+UserCache::~UserCache()
+{
+	delete fIndex;
+}
+
+UserCache &UserCache::Default()
+{
+	static UserCache cache;
+	return cache;
+}
+
+// Registrar writes database files after each change, so modification time
+// serves as generation number of databases.
+bool UserCache::FilesChanged(timespec &passwdTime, timespec &groupTime)
+{
+	struct stat st;
+	passwdTime = stat(kPasswdFile, &st) == 0 ? st.st_mtim : timespec();
+	groupTime = stat(kGroupFile, &st) == 0 ? st.st_mtim : timespec();
+	return
+		passwdTime.tv_sec != fPasswdTime.tv_sec || passwdTime.tv_nsec != fPasswdTime.tv_nsec ||
+		groupTime.tv_sec != fGroupTime.tv_sec || groupTime.tv_nsec != fGroupTime.tv_nsec;
+}
+
+status_t UserCache::Fetch(UserIndex &index)
+{
+	KMessage usersReply, groupsReply;
+	int32 userCnt, groupCnt;
+	passwd **users;
+	group **groups;
+	CheckRet(GetUsers(usersReply, userCnt, users));
+	CheckRet(GetGroups(groupsReply, groupCnt, groups));
+
+	index.Clear();
+	index.Reserve(userCnt, groupCnt, usersReply.ContentSize() + groupsReply.ContentSize());
+	for (int32 i = 0; i < userCnt; i++) {
+		passwd *entry = users[i];
+		index.AddUser(entry->pw_name, entry->pw_passwd, entry->pw_uid, entry->pw_gid, entry->pw_dir, entry->pw_shell, entry->pw_gecos);
+	}
+	for (int32 i = 0; i < groupCnt; i++) {
+		group *entry = groups[i];
+		index.AddGroup(entry->gr_name, entry->gr_passwd, entry->gr_gid, entry->gr_mem);
+	}
+	index.BuildIndexes();
+	return B_OK;
+}
+
+const UserIndex *UserCache::Get()
+{
+	// Stamps are taken before fetching, so change made during fetch causes
+	// another fetch.
+	timespec passwdTime, groupTime;
+	if (FilesChanged(passwdTime, groupTime))
+		fValid = false;
+	if (fValid)
+		return fIndex;
+	if (Fetch(*fIndex) < B_OK) {
+		fIndex->Clear();
+		return NULL;
+	}
+	fPasswdTime = passwdTime;
+	fGroupTime = groupTime;
+	fValid = true;
+	fGeneration++;
+	return fIndex;
+}
+
+void UserCache::Invalidate()
+{
+	BAutolock lock(fLocker);
+	fValid = false;
+}
+
+
 status_t DeleteUser(uid_t id, const char *name)
 {
 	KMessage message(BPrivate::B_REG_DELETE_USER), reply;
@@ -66,7 +158,9 @@ status_t DeleteUser(uid_t id, const char *name)
 		CheckRet(message.AddInt32("uid", id));
 	if (name != NULL)
 		CheckRet(message.AddString("name", name));
-	CheckRet(send_authentication_request_to_registrar(message, reply));
+	status_t res = send_authentication_request_to_registrar(message, reply);
+	UserCache::Default().Invalidate();
+	CheckRet(res);
 	return reply.What();
 }
 
@@ -77,7 +171,9 @@ status_t DeleteGroup(gid_t id, const char *name)
 		CheckRet(message.AddInt32("gid", id));
 	if (name != NULL)
 		CheckRet(message.AddString("name", name));
-	CheckRet(send_authentication_request_to_registrar(message, reply));
+	status_t res = send_authentication_request_to_registrar(message, reply);
+	UserCache::Default().Invalidate();
+	CheckRet(res);
 	return reply.What();
 }
 
@@ -85,7 +181,9 @@ status_t UpdateUser(KMessage &message)
 {
 	KMessage reply;
 	message.SetWhat(BPrivate::B_REG_UPDATE_USER);
-	CheckRet(send_authentication_request_to_registrar(message, reply));
+	status_t res = send_authentication_request_to_registrar(message, reply);
+	UserCache::Default().Invalidate();
+	CheckRet(res);
 	return reply.What();
 }
 
@@ -93,10 +191,38 @@ status_t UpdateGroup(KMessage &message)
 {
 	KMessage reply;
 	message.SetWhat(BPrivate::B_REG_UPDATE_GROUP);
-	CheckRet(send_authentication_request_to_registrar(message, reply));
+	status_t res = send_authentication_request_to_registrar(message, reply);
+	UserCache::Default().Invalidate();
+	CheckRet(res);
 	return reply.What();
 }
 
+static status_t SendUpdates(uint32 what, KMessage *messages, int32 count)
+{
+	status_t res = B_OK;
+	for (int32 i = 0; i < count; i++) {
+		KMessage reply;
+		messages[i].SetWhat(what);
+		status_t itemRes = send_authentication_request_to_registrar(messages[i], reply);
+		if (itemRes >= B_OK)
+			itemRes = reply.What();
+		if (itemRes < B_OK && res >= B_OK)
+			res = itemRes;
+	}
+	UserCache::Default().Invalidate();
+	return res;
+}
+
+status_t UpdateUsers(KMessage *messages, int32 count)
+{
+	return SendUpdates(BPrivate::B_REG_UPDATE_USER, messages, count);
+}
+
+status_t UpdateGroups(KMessage *messages, int32 count)
+{
+	return SendUpdates(BPrivate::B_REG_UPDATE_GROUP, messages, count);
+}
+
 status_t GetUser(KMessage &reply, uid_t id, const char *name, bool shadow)
 {
 	KMessage message(BPrivate::B_REG_GET_USER);
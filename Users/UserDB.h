@@ -2,21 +2,58 @@
 #define _USERDB_H_
 
 #include <SupportDefs.h>
+#include <Locker.h>
+#include <time.h>
 
 namespace BPrivate {
 	class KMessage;
 }
 struct passwd;
 struct group;
+class UserIndex;
 
 using BPrivate::KMessage;
 
+
+// Client side copy of users and groups databases shared by all windows.
+// It is fetched from registrar again only if database files were modified
+// or after update requests sent by this application.
+class UserCache
+{
+private:
+	BLocker fLocker;
+	UserIndex *fIndex;
+	bool fValid;
+	uint32 fGeneration;
+	timespec fPasswdTime, fGroupTime;
+
+	bool FilesChanged(timespec &passwdTime, timespec &groupTime);
+	status_t Fetch(UserIndex &index);
+
+public:
+	UserCache();
+	~UserCache();
+	static UserCache &Default();
+
+	BLocker *Locker() {return &fLocker;}
+	// Must be called with locker held, returns NULL if databases can't be
+	// fetched. Returned index is valid until next call or unlock.
+	const UserIndex *Get();
+	// Incremented each time databases are fetched.
+	uint32 Generation() {return fGeneration;}
+	void Invalidate();
+};
+
 status_t GetUsers(KMessage &reply, int32 &count, passwd**& entries);
 status_t GetGroups(KMessage &reply, int32 &count, group**& entries);
 status_t DeleteUser(uid_t id, const char *name);
 status_t DeleteGroup(gid_t id, const char *name);
 status_t UpdateUser(KMessage &message);
 status_t UpdateGroup(KMessage &message);
+// Registrar accepts one entry per request, so entries are sent one by one,
+// but cache is invalidated once.
+status_t UpdateUsers(KMessage *messages, int32 count);
+status_t UpdateGroups(KMessage *messages, int32 count);
 status_t GetUser(KMessage &reply, uid_t id, const char *name, bool shadow = false);
 status_t GetGroup(KMessage &reply, gid_t id, const char *name);
 
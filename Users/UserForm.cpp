@@ -16,9 +16,11 @@
 #include <Box.h>
 #include <SeparatorView.h>
 #include <LayoutBuilder.h>
+#include <Autolock.h>
 
 #include <private/kernel/util/KMessage.h>
 #include "UserDB.h"
+#include "UserIndex.h"
 
 
 #define CheckRetVoid(err) {status_t _err = (err); if (_err < B_OK) return;}
@@ -82,18 +84,20 @@ public:
 	{
 		BMenu *menu = new BPopUpMenu("groupMenu");
 
-		int32 count;
-		group** entries;
-
-		KMessage reply;
-		if (GetGroups(reply, count, entries) < B_OK) count = 0;
-		for (int32 i = 0; i < count; i++) {
-			BMessage *msg = new BMessage(groupMsg);
-			BMenuItem *item;
-			msg->AddInt32("val", entries[i]->gr_gid);
-			menu->AddItem(item = new BMenuItem(entries[i]->gr_name, msg));
-			if (entries[i]->gr_gid == 100)
-				item->SetMarked(true);
+		{
+			UserCache &cache = UserCache::Default();
+			BAutolock lock(cache.Locker());
+			const UserIndex *index = cache.Get();
+			uint32 count = index != NULL ? index->CountGroups() : 0;
+			for (uint32 i = 0; i < count; i++) {
+				const UserIndex::Group &entry = index->GroupAt(i);
+				BMessage *msg = new BMessage(groupMsg);
+				BMenuItem *item;
+				msg->AddInt32("val", entry.gid);
+				menu->AddItem(item = new BMenuItem(index->String(entry.name), msg));
+				if (entry.gid == 100)
+					item->SetMarked(true);
+			}
 		}
 		
 		BGroupLayout *passwordLayout;
@@ -182,7 +186,15 @@ public:
 					encryptedPassword = crypt(fPasswordView->Text(), NULL);
 
 				uid_t uid = 1000;
-				while (getpwuid(uid) != NULL) uid++;
+				{
+					UserCache &cache = UserCache::Default();
+					BAutolock lock(cache.Locker());
+					const UserIndex *index = cache.Get();
+					if (index != NULL)
+						uid = index->FreeUserId(uid);
+					else
+						while (getpwuid(uid) != NULL) uid++;
+				}
 
 				BMenuItem *item = fGroupView->Menu()->FindMarked();
 				if (item != NULL) {
@@ -0,0 +1,255 @@
+#include "UserIndex.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+
+enum {
+	kEmptySlot = UINT32_MAX,
+};
+
+static const int64_t kEmptyId = INT64_MIN;
+
+
+static uint32_t HashString(const char *str)
+{
+	uint32_t hash = 2166136261U;
+	for (; *str != '\0'; str++)
+		hash = (hash ^ (uint8_t)*str)*16777619U;
+	return hash;
+}
+
+static uint32_t HashId(int32_t id)
+{
+	uint32_t hash = (uint32_t)id*2654435761U;
+	return hash ^ (hash >> 16);
+}
+
+// Capacity is power of two at least twice as large as count, so probe
+// sequences stay short.
+static size_t TableSize(size_t count)
+{
+	size_t size = 16;
+	while (size < 2*count)
+		size *= 2;
+	return size;
+}
+
+
+void NameIndex::Init(size_t count)
+{
+	size_t size = TableSize(count);
+	fKeys.assign(size, kEmptySlot);
+	fValues.assign(size, 0);
+}
+
+uint32_t NameIndex::Insert(const char *arena, uint32_t offset, uint32_t value)
+{
+	size_t mask = fKeys.size() - 1;
+	for (size_t i = HashString(arena + offset) & mask;; i = (i + 1) & mask) {
+		if (fKeys[i] == kEmptySlot) {
+			fKeys[i] = offset;
+			fValues[i] = value;
+			return value;
+		}
+		if (strcmp(arena + fKeys[i], arena + offset) == 0)
+			return fValues[i];
+	}
+}
+
+uint32_t NameIndex::Find(const char *arena, const char *name) const
+{
+	if (fKeys.empty())
+		return kNotFound;
+	size_t mask = fKeys.size() - 1;
+	for (size_t i = HashString(name) & mask;; i = (i + 1) & mask) {
+		if (fKeys[i] == kEmptySlot)
+			return kNotFound;
+		if (strcmp(arena + fKeys[i], name) == 0)
+			return fValues[i];
+	}
+}
+
+
+void IdIndex::Init(size_t count)
+{
+	size_t size = TableSize(count);
+	fKeys.assign(size, kEmptyId);
+	fValues.assign(size, 0);
+}
+
+uint32_t IdIndex::Insert(int32_t id, uint32_t value)
+{
+	size_t mask = fKeys.size() - 1;
+	for (size_t i = HashId(id) & mask;; i = (i + 1) & mask) {
+		if (fKeys[i] == kEmptyId) {
+			fKeys[i] = id;
+			fValues[i] = value;
+			return value;
+		}
+		if (fKeys[i] == id)
+			return fValues[i];
+	}
+}
+
+uint32_t IdIndex::Find(int32_t id) const
+{
+	if (fKeys.empty())
+		return kNotFound;
+	size_t mask = fKeys.size() - 1;
+	for (size_t i = HashId(id) & mask;; i = (i + 1) & mask) {
+		if (fKeys[i] == kEmptyId)
+			return kNotFound;
+		if (fKeys[i] == id)
+			return fValues[i];
+	}
+}
+
+
+void UserIndex::Clear()
+{
+	fStrings.clear();
+	fUsers.clear();
+	fGroups.clear();
+	fMembers.clear();
+	fUserIds = IdIndex();
+	fUserNames = NameIndex();
+	fGroupIds = IdIndex();
+	fGroupNames = NameIndex();
+	fMemberIds = NameIndex();
+	fMemberGroupStart.clear();
+	fMemberGroups.clear();
+}
+
+void UserIndex::Reserve(size_t userCount, size_t groupCount, size_t stringSize)
+{
+	fUsers.reserve(userCount);
+	fGroups.reserve(groupCount);
+	fStrings.reserve(stringSize);
+}
+
+uint32_t UserIndex::AddString(const char *str)
+{
+	if (str == NULL)
+		str = "";
+	uint32_t offset = fStrings.size();
+	fStrings.insert(fStrings.end(), str, str + strlen(str) + 1);
+	return offset;
+}
+
+uint32_t UserIndex::AddUser(const char *name, const char *passwd, int32_t uid, int32_t gid, const char *dir, const char *shell, const char *gecos)
+{
+	User user;
+	user.name = AddString(name);
+	user.passwd = AddString(passwd);
+	user.dir = AddString(dir);
+	user.shell = AddString(shell);
+	user.gecos = AddString(gecos);
+	user.uid = uid;
+	user.gid = gid;
+	fUsers.push_back(user);
+	return fUsers.size() - 1;
+}
+
+uint32_t UserIndex::AddGroup(const char *name, const char *passwd, int32_t gid, const char *const *members)
+{
+	Group group;
+	group.name = AddString(name);
+	group.passwd = AddString(passwd);
+	group.gid = gid;
+	group.firstMember = fMembers.size();
+	for (; members != NULL && *members != NULL; members++)
+		fMembers.push_back(AddString(*members));
+	group.memberCount = fMembers.size() - group.firstMember;
+	fGroups.push_back(group);
+	return fGroups.size() - 1;
+}
+
+void UserIndex::BuildIndexes()
+{
+	const char *arena = fStrings.data();
+
+	fUserIds.Init(fUsers.size());
+	fUserNames.Init(fUsers.size());
+	for (uint32_t i = 0; i < fUsers.size(); i++) {
+		fUserIds.Insert(fUsers[i].uid, i);
+		fUserNames.Insert(arena, fUsers[i].name, i);
+	}
+
+	fGroupIds.Init(fGroups.size());
+	fGroupNames.Init(fGroups.size());
+	for (uint32_t i = 0; i < fGroups.size(); i++) {
+		fGroupIds.Insert(fGroups[i].gid, i);
+		fGroupNames.Insert(arena, fGroups[i].name, i);
+	}
+
+	// Member IDs are assigned in order of first appearance, groups of each
+	// member are collected by counting sort, so they come out sorted.
+	fMemberIds.Init(fMembers.size());
+	std::vector<uint32_t> memberIds(fMembers.size());
+	uint32_t memberCount = 0;
+	for (size_t i = 0; i < fMembers.size(); i++) {
+		memberIds[i] = fMemberIds.Insert(arena, fMembers[i], memberCount);
+		if (memberIds[i] == memberCount)
+			memberCount++;
+	}
+	fMemberGroupStart.assign(memberCount + 1, 0);
+	for (uint32_t id: memberIds)
+		fMemberGroupStart[id + 1]++;
+	for (uint32_t i = 0; i < memberCount; i++)
+		fMemberGroupStart[i + 1] += fMemberGroupStart[i];
+	fMemberGroups.resize(fMembers.size());
+	std::vector<uint32_t> fill(fMemberGroupStart.begin(), fMemberGroupStart.end() - 1);
+	for (uint32_t i = 0; i < fGroups.size(); i++) {
+		const Group &group = fGroups[i];
+		for (uint32_t j = 0; j < group.memberCount; j++)
+			fMemberGroups[fill[memberIds[group.firstMember + j]]++] = i;
+	}
+}
+
+
+uint32_t UserIndex::FindUser(const char *name) const
+{
+	return fUserNames.Find(fStrings.data(), name);
+}
+
+uint32_t UserIndex::FindGroup(const char *name) const
+{
+	return fGroupNames.Find(fStrings.data(), name);
+}
+
+const uint32_t *UserIndex::GroupsOfMember(const char *name, uint32_t &count) const
+{
+	uint32_t id = fMemberIds.Find(fStrings.data(), name);
+	if (id == NameIndex::kNotFound) {
+		count = 0;
+		return NULL;
+	}
+	count = fMemberGroupStart[id + 1] - fMemberGroupStart[id];
+	return fMemberGroups.data() + fMemberGroupStart[id];
+}
+
+bool UserIndex::IsMember(uint32_t group, const char *name) const
+{
+	uint32_t count;
+	const uint32_t *groups = GroupsOfMember(name, count);
+	return count > 0 && std::binary_search(groups, groups + count, group);
+}
+
+
+int32_t UserIndex::FreeUserId(int32_t start) const
+{
+	int32_t id = start;
+	while (FindUser(id) != kNotFound)
+		id++;
+	return id;
+}
+
+int32_t UserIndex::FreeGroupId(int32_t start) const
+{
+	int32_t id = start;
+	while (FindGroup(id) != kNotFound)
+		id++;
+	return id;
+}
@@ -0,0 +1,126 @@
+#ifndef _USERINDEX_H_
+#define _USERINDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+
+// Open addressing hash table that maps strings stored in external arena to
+// values. Keys are arena offsets, so arena can grow while table is built.
+class NameIndex
+{
+private:
+	std::vector<uint32_t> fKeys;
+	std::vector<uint32_t> fValues;
+
+public:
+	enum {
+		kNotFound = UINT32_MAX,
+	};
+
+	void Init(size_t count);
+	// Returns existing value if name is already present.
+	uint32_t Insert(const char *arena, uint32_t offset, uint32_t value);
+	uint32_t Find(const char *arena, const char *name) const;
+};
+
+class IdIndex
+{
+private:
+	std::vector<int64_t> fKeys;
+	std::vector<uint32_t> fValues;
+
+public:
+	enum {
+		kNotFound = UINT32_MAX,
+	};
+
+	void Init(size_t count);
+	uint32_t Insert(int32_t id, uint32_t value);
+	uint32_t Find(int32_t id) const;
+};
+
+
+// Users and groups database. All strings are stored in one arena and
+// referenced by offsets. Users and groups are indexed by ID and name, group
+// members are indexed in both directions. Indexes are built once by
+// BuildIndexes() after all entries are added. If several entries have the
+// same key, the first one is found, as in getpwuid().
+class UserIndex
+{
+public:
+	struct User {
+		uint32_t name;
+		uint32_t passwd;
+		uint32_t dir;
+		uint32_t shell;
+		uint32_t gecos;
+		int32_t uid;
+		int32_t gid;
+	};
+
+	struct Group {
+		uint32_t name;
+		uint32_t passwd;
+		int32_t gid;
+		uint32_t firstMember;
+		uint32_t memberCount;
+	};
+
+	enum {
+		kNotFound = UINT32_MAX,
+	};
+
+private:
+	std::vector<char> fStrings;
+	std::vector<User> fUsers;
+	std::vector<Group> fGroups;
+	// Offsets of member names, each group references contiguous range.
+	std::vector<uint32_t> fMembers;
+
+	IdIndex fUserIds;
+	NameIndex fUserNames;
+	IdIndex fGroupIds;
+	NameIndex fGroupNames;
+
+	// Groups of each distinct member name, ranges are indexed by member ID.
+	NameIndex fMemberIds;
+	std::vector<uint32_t> fMemberGroupStart;
+	std::vector<uint32_t> fMemberGroups;
+
+	uint32_t AddString(const char *str);
+
+public:
+	void Clear();
+	void Reserve(size_t userCount, size_t groupCount, size_t stringSize);
+	uint32_t AddUser(const char *name, const char *passwd, int32_t uid, int32_t gid, const char *dir, const char *shell, const char *gecos);
+	// Members list is NULL terminated.
+	uint32_t AddGroup(const char *name, const char *passwd, int32_t gid, const char *const *members);
+	void BuildIndexes();
+
+	const char *String(uint32_t offset) const {return &fStrings[offset];}
+
+	size_t CountUsers() const {return fUsers.size();}
+	const User &UserAt(uint32_t idx) const {return fUsers[idx];}
+	size_t CountGroups() const {return fGroups.size();}
+	const Group &GroupAt(uint32_t idx) const {return fGroups[idx];}
+	const char *MemberAt(const Group &group, uint32_t idx) const {return String(fMembers[group.firstMember + idx]);}
+
+	uint32_t FindUser(int32_t uid) const {return fUserIds.Find(uid);}
+	uint32_t FindUser(const char *name) const;
+	uint32_t FindGroup(int32_t gid) const {return fGroupIds.Find(gid);}
+	uint32_t FindGroup(const char *name) const;
+
+	// Returns sorted indexes of groups that list name as member.
+	const uint32_t *GroupsOfMember(const char *name, uint32_t &count) const;
+	bool IsMember(uint32_t group, const char *name) const;
+
+	// Lowest ID not less than start that is not used.
+	int32_t FreeUserId(int32_t start) const;
+	int32_t FreeGroupId(int32_t start) const;
+};
+
+
+#endif	// _USERINDEX_H_
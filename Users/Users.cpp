@@ -13,12 +13,16 @@
 #include <Rect.h>
 #include <IconUtils.h>
 #include <Resources.h>
+#include <Autolock.h>
 
 #include <private/interface/ColumnListView.h>
 #include <private/interface/ColumnTypes.h>
 
 #include <pwd.h>
 #include <grp.h>
+#include <string.h>
+
+#include <unordered_map>
 
 #include <private/kernel/util/KMessage.h>
 
@@ -27,6 +31,7 @@
 #include "GroupForm.h"
 #include "PasswordForm.h"
 #include "UserDB.h"
+#include "UserIndex.h"
 #include "UIUtils.h"
 
 
@@ -58,62 +63,52 @@ enum {
 };
 
 
-static BRow *FindIntRow(BColumnListView *view, int32 col, BRow *parent, int32 val)
+static void ListUsers(BColumnListView *view, uint32 &generation)
 {
 	BRow *row;
-	BString name;
-	for (int32 i = 0; i < view->CountRows(parent); i++) {
-		row = view->RowAt(i, parent);
-		if (((BIntegerField*)row->GetField(col))->Value() == val)
-			return row;
-	}
-	return NULL;
-}
+	std::unordered_map<int32, BRow*> prevRows;
 
-
-static void ListUsers(BColumnListView *view)
-{
-	BRow *row;
-	BList prevRows;
-
-	int32 count;
-	passwd** entries;
-
-	KMessage reply;
-	if (GetUsers(reply, count, entries) < B_OK) count = 0;
+	UserCache &cache = UserCache::Default();
+	BAutolock lock(cache.Locker());
+	const UserIndex *index = cache.Get();
+	if (index != NULL && cache.Generation() == generation)
+		return;
+	generation = index != NULL ? cache.Generation() : 0;
+	uint32 count = index != NULL ? index->CountUsers() : 0;
 
 	for (int32 i = 0; i < view->CountRows(); i++) {
 		row = view->RowAt(i);
-		prevRows.AddItem((void*)(addr_t)(((BIntegerField*)row->GetField(userIdCol))->Value()));
+		prevRows[((BIntegerField*)row->GetField(userIdCol))->Value()] = row;
 	}
 
-	for (int32 i = 0; i < count; i++) {
-		passwd *entry = entries[i];
+	for (uint32 i = 0; i < count; i++) {
+		const UserIndex::User &entry = index->UserAt(i);
 
-		prevRows.RemoveItem((void*)(addr_t)entry->pw_uid);
-		row = FindIntRow(view, userIdCol, NULL, entry->pw_uid);
-		if (row == NULL) {
+		auto it = prevRows.find(entry.uid);
+		if (it != prevRows.end()) {
+			row = it->second;
+			prevRows.erase(it);
+		} else {
 			row = new BRow();
 			view->AddRow(row);
 		}
 
-		row->SetField(new BStringField(entry->pw_name), userNameCol);
-		row->SetField(new BIntegerField(entry->pw_uid), userIdCol);
-		row->SetField(new BIntegerField(entry->pw_gid), userGroupIdCol);
-		row->SetField(new BStringField(entry->pw_passwd), userPasswdCol);
-		row->SetField(new BStringField(entry->pw_dir), userDirCol);
-		row->SetField(new BStringField(entry->pw_shell), userShellCol);
-		row->SetField(new BStringField(entry->pw_gecos), userGecosCol);
+		row->SetField(new BStringField(index->String(entry.name)), userNameCol);
+		row->SetField(new BIntegerField(entry.uid), userIdCol);
+		row->SetField(new BIntegerField(entry.gid), userGroupIdCol);
+		row->SetField(new BStringField(index->String(entry.passwd)), userPasswdCol);
+		row->SetField(new BStringField(index->String(entry.dir)), userDirCol);
+		row->SetField(new BStringField(index->String(entry.shell)), userShellCol);
+		row->SetField(new BStringField(index->String(entry.gecos)), userGecosCol);
 	}
 
-	for (int32 i = 0; i < prevRows.CountItems(); i++) {
-		row = FindIntRow(view, userIdCol, NULL, (int32)(addr_t)prevRows.ItemAt(i));
-		view->RemoveRow(row);
-		delete row;
+	for (auto &it: prevRows) {
+		view->RemoveRow(it.second);
+		delete it.second;
 	}
 }
 
-static BColumnListView *NewUsersView()
+static BColumnListView *NewUsersView(uint32 &generation)
 {
 	BColumnListView *view;
 	view = new BColumnListView("Users", B_NAVIGABLE);
@@ -126,56 +121,59 @@ static BColumnListView *NewUsersView()
 	view->AddColumn(new BStringColumn("Shell", 150, 50, 500, B_TRUNCATE_END), userShellCol);
 	view->AddColumn(new BStringColumn("Real name", 150, 50, 500, B_TRUNCATE_END), userGecosCol);
 	view->SetColumnVisible(userPasswdCol, false);
-	ListUsers(view);
+	ListUsers(view, generation);
 	return view;
 }
 
-static void ListGroups(BColumnListView *view)
+static void ListGroups(BColumnListView *view, uint32 &generation)
 {
 	BRow *row;
-	BList prevRows;
-
-	int32 count;
-	group** entries;
+	std::unordered_map<int32, BRow*> prevRows;
 
-	KMessage reply;
-	if (GetGroups(reply, count, entries) < B_OK) count = 0;
+	UserCache &cache = UserCache::Default();
+	BAutolock lock(cache.Locker());
+	const UserIndex *index = cache.Get();
+	if (index != NULL && cache.Generation() == generation)
+		return;
+	generation = index != NULL ? cache.Generation() : 0;
+	uint32 count = index != NULL ? index->CountGroups() : 0;
 
 	for (int32 i = 0; i < view->CountRows(); i++) {
 		row = view->RowAt(i);
-		prevRows.AddItem((void*)(addr_t)(((BIntegerField*)row->GetField(groupIdCol))->Value()));
+		prevRows[((BIntegerField*)row->GetField(groupIdCol))->Value()] = row;
 	}
 
-	for (int32 i = 0; i < count; i++) {
-		group* entry = entries[i];
+	for (uint32 i = 0; i < count; i++) {
+		const UserIndex::Group &entry = index->GroupAt(i);
 
-		prevRows.RemoveItem((void*)(addr_t)entry->gr_gid);
-		row = FindIntRow(view, userIdCol, NULL, entry->gr_gid);
-		if (row == NULL) {
+		auto it = prevRows.find(entry.gid);
+		if (it != prevRows.end()) {
+			row = it->second;
+			prevRows.erase(it);
+		} else {
 			row = new BRow();
 			view->AddRow(row);
 		}
 
-		row->SetField(new BStringField(entry->gr_name), groupNameCol);
-		row->SetField(new BIntegerField(entry->gr_gid), groupIdCol);
-		row->SetField(new BStringField(entry->gr_passwd), groupPasswdCol);
+		row->SetField(new BStringField(index->String(entry.name)), groupNameCol);
+		row->SetField(new BIntegerField(entry.gid), groupIdCol);
+		row->SetField(new BStringField(index->String(entry.passwd)), groupPasswdCol);
 
 		BString str;
-		for (int j = 0; entry->gr_mem[j] != NULL; j++) {
+		for (uint32 j = 0; j < entry.memberCount; j++) {
 			if (j > 0) str += ", ";
-			str += entry->gr_mem[j];
+			str += index->MemberAt(entry, j);
 		}
 		row->SetField(new BStringField(str), groupMembersCol);
 	}
 
-	for (int32 i = 0; i < prevRows.CountItems(); i++) {
-		row = FindIntRow(view, groupIdCol, NULL, (int32)(addr_t)prevRows.ItemAt(i));
-		view->RemoveRow(row);
-		delete row;
+	for (auto &it: prevRows) {
+		view->RemoveRow(it.second);
+		delete it.second;
 	}
 }
 
-static BColumnListView *NewGroupsView()
+static BColumnListView *NewGroupsView(uint32 &generation)
 {
 	BColumnListView *view;
 	view = new BColumnListView("Groups", B_NAVIGABLE);
@@ -185,7 +183,7 @@ static BColumnListView *NewGroupsView()
 	view->AddColumn(new BStringColumn("passwd", 48, 50, 500, B_TRUNCATE_END), groupPasswdCol);
 	view->AddColumn(new BStringColumn("Members", 128, 50, 500, B_TRUNCATE_END), groupMembersCol);
 	view->SetColumnVisible(groupPasswdCol, false);
-	ListGroups(view);
+	ListGroups(view, generation);
 	return view;
 }
 
@@ -197,13 +195,17 @@ private:
 	BTabView *fTabView;
 	BColumnListView *fUsersView;
 	BColumnListView *fGroupsView;
+	uint32 fUsersGeneration;
+	uint32 fGroupsGeneration;
 
 	BMenu *fAddMemberMenu;
 	BMenu *fRemoveMemberMenu;
 
 public:
 	TestWindow(BRect frame): BWindow(frame, "Users", B_DOCUMENT_WINDOW_LOOK, B_NORMAL_WINDOW_FEEL, B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS),
-		fListUpdater(BMessenger(this), BMessage(updateMsg), 500000)
+		fListUpdater(BMessenger(this), BMessage(updateMsg), 500000),
+		fUsersGeneration(0),
+		fGroupsGeneration(0)
 	{
 		BMenuBar *menuBar = new BMenuBar("menu", B_ITEMS_IN_ROW, true);
 		BLayoutBuilder::Menu<>(menuBar)
@@ -235,8 +237,8 @@ public:
 		fTabView = new BTabView("tabView", B_WIDTH_FROM_LABEL);
 		fTabView->SetBorder(B_NO_BORDER);
 
-		BTab *tab = new BTab(); fTabView->AddTab(fUsersView = NewUsersView(), tab);
-		tab = new BTab(); fTabView->AddTab(fGroupsView = NewGroupsView(), tab);
+		BTab *tab = new BTab(); fTabView->AddTab(fUsersView = NewUsersView(fUsersGeneration), tab);
+		tab = new BTab(); fTabView->AddTab(fGroupsView = NewGroupsView(fGroupsGeneration), tab);
 
 		BLayoutBuilder::Group<>(this, B_VERTICAL, 0)
 			.Add(menuBar)
@@ -253,13 +255,6 @@ public:
 
 	void MenusBeginning()
 	{
-		KMessage usersReply, groupsReply;
-		int32 userCnt, groupCnt;
-		passwd **users;
-		group** groups;
-		group *curGroup = NULL;
-		int32 curGroupId;
-
 		fAddMemberMenu->Superitem()->SetEnabled(false);
 		fRemoveMemberMenu->Superitem()->SetEnabled(false);
 		fAddMemberMenu->RemoveItems(0, fAddMemberMenu->CountItems(), true);
@@ -275,39 +270,64 @@ public:
 		fAddMemberMenu->Superitem()->SetEnabled(true);
 		fRemoveMemberMenu->Superitem()->SetEnabled(true);
 
-		if (GetUsers(usersReply, userCnt, users) < B_OK) return;
-		if (GetGroups(groupsReply, groupCnt, groups) < B_OK) return;
+		UserCache &cache = UserCache::Default();
+		BAutolock lock(cache.Locker());
+		const UserIndex *index = cache.Get();
+		if (index == NULL) return;
 
-		curGroupId = ((BIntegerField*)row->GetField(groupIdCol))->Value();
+		int32 curGroupId = ((BIntegerField*)row->GetField(groupIdCol))->Value();
+		uint32 groupIdx = index->FindGroup(curGroupId);
+		if (groupIdx == UserIndex::kNotFound) return;
+		const UserIndex::Group &curGroup = index->GroupAt(groupIdx);
 
-		{
-			int32 i = 0;
-			while ((i < groupCnt) && !((int32)groups[i]->gr_gid == curGroupId)) i++;
-			if (i < groupCnt)
-				curGroup = groups[i];
-			else
-				return;
-		}
-
-		for (int32 i = 0; i < userCnt; i++) {
-			int j = 0;
-			while ((curGroup->gr_mem[j] != NULL) && !(strcmp(users[i]->pw_name, curGroup->gr_mem[j]) == 0)) j++;
-			if (curGroup->gr_mem[j] == NULL) {
+		for (uint32 i = 0; i < index->CountUsers(); i++) {
+			const char *userName = index->String(index->UserAt(i).name);
+			if (!index->IsMember(groupIdx, userName)) {
 				BMessage *msg = new BMessage(addMemberMsg);
-				BMenuItem *item;
-				msg->AddString("val", users[i]->pw_name);
-				fAddMemberMenu->AddItem(item = new BMenuItem(users[i]->pw_name, msg));
+				msg->AddString("val", userName);
+				fAddMemberMenu->AddItem(new BMenuItem(userName, msg));
 			}
 		}
 
-		for (int32 i = 0; curGroup->gr_mem[i] != NULL; i++) {
+		for (uint32 i = 0; i < curGroup.memberCount; i++) {
+			const char *memberName = index->MemberAt(curGroup, i);
 			BMessage *msg = new BMessage(removeMemberMsg);
-			BMenuItem *item;
-			msg->AddString("val", curGroup->gr_mem[i]);
-			fRemoveMemberMenu->AddItem(item = new BMenuItem(curGroup->gr_mem[i], msg));
+			msg->AddString("val", memberName);
+			fRemoveMemberMenu->AddItem(new BMenuItem(memberName, msg));
 		}
 	}
 
+	// Registrar keeps group membership of deleted user.
+	void RemoveFromGroups(const char *userName)
+	{
+		KMessage *messages;
+		uint32 count;
+		{
+			UserCache &cache = UserCache::Default();
+			BAutolock lock(cache.Locker());
+			const UserIndex *index = cache.Get();
+			if (index == NULL) return;
+			const uint32 *groups = index->GroupsOfMember(userName, count);
+			if (count == 0) return;
+			messages = new KMessage[count];
+			for (uint32 i = 0; i < count; i++) {
+				const UserIndex::Group &group = index->GroupAt(groups[i]);
+				bool isEmpty = true;
+				messages[i].AddInt32("gid", group.gid);
+				for (uint32 j = 0; j < group.memberCount; j++) {
+					if (strcmp(userName, index->MemberAt(group, j)) != 0) {
+						isEmpty = false;
+						messages[i].AddString("members", index->MemberAt(group, j));
+					}
+				}
+				if (isEmpty)
+					messages[i].AddString("members", "");
+			}
+		}
+		ArrayDeleter<KMessage> messagesDeleter(messages);
+		UpdateGroups(messages, count);
+	}
+
 	void MenusEnded()
 	{
 	}
@@ -316,8 +336,8 @@ public:
 	{
 		switch (msg->what) {
 		case updateMsg: {
-			ListUsers(fUsersView);
-			ListGroups(fGroupsView);
+			ListUsers(fUsersView, fUsersGeneration);
+			ListGroups(fGroupsView, fGroupsGeneration);
 			return;
 		}
 		case addMsg: {
@@ -356,8 +376,11 @@ public:
 					}
 					if (which != 0) return;
 				}
-				if (DeleteUser(-1, userName) < B_OK) return;
-				ListUsers(fUsersView);
+				BString name(userName);
+				if (DeleteUser(-1, name) < B_OK) return;
+				RemoveFromGroups(name);
+				ListUsers(fUsersView, fUsersGeneration);
+				ListGroups(fGroupsView, fGroupsGeneration);
 			} else if (view == fGroupsView) {
 				BRow *row = fGroupsView->CurrentSelection(NULL);
 				if (row == NULL) return;
@@ -380,7 +403,7 @@ public:
 					if (which != 0) return;
 				}
 				if (DeleteGroup(-1, groupName) < B_OK) return;
-				ListGroups(fGroupsView);
+				ListGroups(fGroupsView, fGroupsGeneration);
 			}
 			return;
 		}
@@ -428,44 +451,42 @@ public:
 			const char *memberName;
 			if (msg->FindString("val", &memberName) < B_OK) return;
 
-			KMessage groupsReply, updateGroupMsg;
-			int32 groupCnt;
-			group **groups;
-			group *curGroup;
-			if (GetGroups(groupsReply, groupCnt, groups) < B_OK) return;
+			KMessage updateGroupMsg;
 			{
-				int32 i = 0;
-				while ((i < groupCnt) && !((int32)groups[i]->gr_gid == groupId)) i++;
-				if (i < groupCnt)
-					curGroup = groups[i];
-				else
-					return;
-			}
-			updateGroupMsg.AddInt32("gid", groupId);
-			switch (msg->what) {
-			case addMemberMsg: {
-				for (int32 i = 0; curGroup->gr_mem[i] != NULL; i++)
-					updateGroupMsg.AddString("members", curGroup->gr_mem[i]);
-
-				updateGroupMsg.AddString("members", memberName);
-				break;
-			}
-			case removeMemberMsg: {
-				bool isEmpty = true;
-				for (int32 i = 0; curGroup->gr_mem[i] != NULL; i++) {
-					if (strcmp(memberName, curGroup->gr_mem[i]) != 0) {
-						isEmpty = false;
-						updateGroupMsg.AddString("members", curGroup->gr_mem[i]);
-					}
+				UserCache &cache = UserCache::Default();
+				BAutolock lock(cache.Locker());
+				const UserIndex *index = cache.Get();
+				if (index == NULL) return;
+				uint32 groupIdx = index->FindGroup(groupId);
+				if (groupIdx == UserIndex::kNotFound) return;
+				const UserIndex::Group &curGroup = index->GroupAt(groupIdx);
+
+				updateGroupMsg.AddInt32("gid", groupId);
+				switch (msg->what) {
+				case addMemberMsg: {
+					for (uint32 i = 0; i < curGroup.memberCount; i++)
+						updateGroupMsg.AddString("members", index->MemberAt(curGroup, i));
+
+					updateGroupMsg.AddString("members", memberName);
+					break;
 				}
-				if (isEmpty)
-					updateGroupMsg.AddString("members", "");
+				case removeMemberMsg: {
+					bool isEmpty = true;
+					for (uint32 i = 0; i < curGroup.memberCount; i++) {
+						if (strcmp(memberName, index->MemberAt(curGroup, i)) != 0) {
+							isEmpty = false;
+							updateGroupMsg.AddString("members", index->MemberAt(curGroup, i));
+						}
+					}
+					if (isEmpty)
+						updateGroupMsg.AddString("members", "");
 
-				break;
-			}
+					break;
+				}
+				}
 			}
 			UpdateGroup(updateGroupMsg);
-			ListGroups(fGroupsView);
+			ListGroups(fGroupsView, fGroupsGeneration);
 			return;
 		}
 		}